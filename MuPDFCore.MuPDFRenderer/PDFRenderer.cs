@@ -251,7 +251,7 @@ namespace MuPDFCore.MuPDFRenderer
         /// Set up the <see cref="PDFRenderer"/> to display a page of a <see cref="MuPDFDocument"/>.
         /// </summary>
         /// <param name="document">The <see cref="MuPDFDocument"/> to render.</param>
-        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, this must be factorisable using only powers of 2, 3, 5 or 7. If this is not the case, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, the specified number of threads is used.</param>
         /// <param name="pageNumber">The index of the page that should be rendered. The first page has index 0.</param>
         /// <param name="resolutionMultiplier">This value can be used to increase or decrease the resolution at which the static renderisation of the page will be produced. If <paramref name="resolutionMultiplier"/> is 1, the resolution will match the size (in screen units) of the <see cref="PDFRenderer"/>.</param>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the rendering. Otherwise, only the page contents are included.</param>
@@ -275,7 +275,7 @@ namespace MuPDFCore.MuPDFRenderer
         /// Set up the <see cref="PDFRenderer"/> to display a page of a <see cref="MuPDFDocument"/>. The OCR step is run asynchronously, in order not to block the UI thread.
         /// </summary>
         /// <param name="document">The <see cref="MuPDFDocument"/> to render.</param>
-        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, this must be factorisable using only powers of 2, 3, 5 or 7. If this is not the case, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, the specified number of threads is used.</param>
         /// <param name="pageNumber">The index of the page that should be rendered. The first page has index 0.</param>
         /// <param name="resolutionMultiplier">This value can be used to increase or decrease the resolution at which the static renderisation of the page will be produced. If <paramref name="resolutionMultiplier"/> is 1, the resolution will match the size (in screen units) of the <see cref="PDFRenderer"/>.</param>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the rendering. Otherwise, only the page contents are included.</param>
@@ -301,7 +301,7 @@ namespace MuPDFCore.MuPDFRenderer
         /// Set up the <see cref="PDFRenderer"/> to display a page of a document that will be loaded from disk.
         /// </summary>
         /// <param name="fileName">The path to the document that should be opened.</param>
-        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, this must be factorisable using only powers of 2, 3, 5 or 7. If this is not the case, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, the specified number of threads is used.</param>
         /// <param name="pageNumber">The index of the page that should be rendered. The first page has index 0.</param>
         /// <param name="resolutionMultiplier">This value can be used to increase or decrease the resolution at which the static renderisation of the page will be produced. If <paramref name="resolutionMultiplier"/> is 1, the resolution will match the size (in screen units) of the <see cref="PDFRenderer"/>.</param>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the rendering. Otherwise, only the page contents are included.</param>
@@ -325,7 +325,7 @@ namespace MuPDFCore.MuPDFRenderer
         /// Set up the <see cref="PDFRenderer"/> to display a page of a document that will be loaded from disk. The OCR step is run asynchronously, in order not to block the UI thread.
         /// </summary>
         /// <param name="fileName">The path to the document that should be opened.</param>
-        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, this must be factorisable using only powers of 2, 3, 5 or 7. If this is not the case, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, the specified number of threads is used.</param>
         /// <param name="pageNumber">The index of the page that should be rendered. The first page has index 0.</param>
         /// <param name="resolutionMultiplier">This value can be used to increase or decrease the resolution at which the static renderisation of the page will be produced. If <paramref name="resolutionMultiplier"/> is 1, the resolution will match the size (in screen units) of the <see cref="PDFRenderer"/>.</param>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the rendering. Otherwise, only the page contents are included.</param>
@@ -352,7 +352,7 @@ namespace MuPDFCore.MuPDFRenderer
         /// </summary>
         /// <param name="ms">The <see cref="MemoryStream"/> containing the document that should be opened. This can be safely disposed after this method returns.</param>
         /// <param name="fileType">The format of the document.</param>
-        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, this must be factorisable using only powers of 2, 3, 5 or 7. If this is not the case, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, the specified number of threads is used.</param>
         /// <param name="pageNumber">The index of the page that should be rendered. The first page has index 0.</param>
         /// <param name="resolutionMultiplier">This value can be used to increase or decrease the resolution at which the static renderisation of the page will be produced. If <paramref name="resolutionMultiplier"/> is 1, the resolution will match the size (in screen units) of the <see cref="PDFRenderer"/>.</param>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the rendering. Otherwise, only the page contents are included.</param>
@@ -372,7 +372,7 @@ namespace MuPDFCore.MuPDFRenderer
         /// </summary>
         /// <param name="ms">The <see cref="MemoryStream"/> containing the document that should be opened. This can be safely disposed after this method returns.</param>
         /// <param name="fileType">The format of the document.</param>
-        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, this must be factorisable using only powers of 2, 3, 5 or 7. If this is not the case, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, the specified number of threads is used.</param>
         /// <param name="pageNumber">The index of the page that should be rendered. The first page has index 0.</param>
         /// <param name="resolutionMultiplier">This value can be used to increase or decrease the resolution at which the static renderisation of the page will be produced. If <paramref name="resolutionMultiplier"/> is 1, the resolution will match the size (in screen units) of the <see cref="PDFRenderer"/>.</param>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the rendering. Otherwise, only the page contents are included.</param>
@@ -396,7 +396,7 @@ namespace MuPDFCore.MuPDFRenderer
         /// <param name="fileType">The format of the document.</param>
         /// <param name="offset">The offset in the byte array at which the document starts.</param>
         /// <param name="length">The length of the document in bytes. If this is &lt; 0, the whole array is used.</param>
-        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, this must be factorisable using only powers of 2, 3, 5 or 7. If this is not the case, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, the specified number of threads is used.</param>
         /// <param name="pageNumber">The index of the page that should be rendered. The first page has index 0.</param>
         /// <param name="resolutionMultiplier">This value can be used to increase or decrease the resolution at which the static renderisation of the page will be produced. If <paramref name="resolutionMultiplier"/> is 1, the resolution will match the size (in screen units) of the <see cref="PDFRenderer"/>.</param>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the rendering. Otherwise, only the page contents are included.</param>
@@ -437,7 +437,7 @@ namespace MuPDFCore.MuPDFRenderer
         /// <param name="fileType">The format of the document.</param>
         /// <param name="offset">The offset in the byte array at which the document starts.</param>
         /// <param name="length">The length of the document in bytes. If this is &lt; 0, the whole array is used.</param>
-        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, this must be factorisable using only powers of 2, 3, 5 or 7. If this is not the case, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, the specified number of threads is used.</param>
         /// <param name="pageNumber">The index of the page that should be rendered. The first page has index 0.</param>
         /// <param name="resolutionMultiplier">This value can be used to increase or decrease the resolution at which the static renderisation of the page will be produced. If <paramref name="resolutionMultiplier"/> is 1, the resolution will match the size (in screen units) of the <see cref="PDFRenderer"/>.</param>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the rendering. Otherwise, only the page contents are included.</param>
@@ -476,7 +476,7 @@ namespace MuPDFCore.MuPDFRenderer
         /// <summary>
         /// Common steps in the initialization process that will be performed regardless of how the <see cref="Document"/> was obtained.
         /// </summary>
-        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, this must be factorisable using only powers of 2, 3, 5 or 7. If this is not the case, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, the specified number of threads is used.</param>
         /// <param name="pageNumber">The index of the page that should be rendered. The first page has index 0.</param>
         /// <param name="resolutionMultiplier">This value can be used to increase or decrease the resolution at which the static renderisation of the page will be produced. If <paramref name="resolutionMultiplier"/> is 1, the resolution will match the size (in screen units) of the <see cref="PDFRenderer"/>.</param>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the rendering. Otherwise, only the page contents are included.</param>
@@ -547,7 +547,7 @@ namespace MuPDFCore.MuPDFRenderer
         /// <summary>
         /// Common steps in the initialization process that will be performed regardless of how the <see cref="Document"/> was obtained. The OCR step is run asynchronously, in order not to block the UI thread.
         /// </summary>
-        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, this must be factorisable using only powers of 2, 3, 5 or 7. If this is not the case, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. If this is 0, an appropriate number of threads based on the number of processors in the computer will be used. Otherwise, the specified number of threads is used.</param>
         /// <param name="pageNumber">The index of the page that should be rendered. The first page has index 0.</param>
         /// <param name="resolutionMultiplier">This value can be used to increase or decrease the resolution at which the static renderisation of the page will be produced. If <paramref name="resolutionMultiplier"/> is 1, the resolution will match the size (in screen units) of the <see cref="PDFRenderer"/>.</param>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the rendering. Otherwise, only the page contents are included.</param>
@@ -0,0 +1,110 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2024  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+using System;
+using System.IO;
+using System.Runtime.ExceptionServices;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+namespace MuPDFCore
+{
+    /// <summary>
+    /// Provides the data of a seekable managed <see cref="System.IO.Stream"/> to a native stream, one block at a time, so that the whole stream never needs to be held in memory.
+    /// </summary>
+    internal class InputStreamCallback
+    {
+        /// <summary>
+        /// The stream from which the data is read.
+        /// </summary>
+        private readonly Stream Stream;
+
+        /// <summary>
+        /// Used to serialise the reads, without locking on the <see cref="Stream"/> (which is owned by the caller).
+        /// </summary>
+        private readonly object StreamLock = new object();
+
+        /// <summary>
+        /// The buffer used to copy data from the stream to native memory.
+        /// </summary>
+        private byte[] Buffer;
+
+        /// <summary>
+        /// The exception that was thrown while reading from the stream, if any.
+        /// </summary>
+        private ExceptionDispatchInfo Exception;
+
+        /// <summary>
+        /// The delegate that should be passed to the native method. The caller must make sure that this object stays alive until the native stream is disposed.
+        /// </summary>
+        public NativeMethods.ReadCallback Callback { get; }
+
+        /// <summary>
+        /// Create a new <see cref="InputStreamCallback"/> that reads data from the specified <paramref name="stream"/>.
+        /// </summary>
+        /// <param name="stream">The stream from which the data will be read. This must be readable and seekable.</param>
+        public InputStreamCallback(Stream stream)
+        {
+            this.Stream = stream;
+            this.Buffer = new byte[0];
+            this.Callback = this.Read;
+        }
+
+        /// <summary>
+        /// Copy a chunk of data from the stream to native memory. Exceptions cannot propagate through native code, thus they are turned into a read error, and stored so that they can be rethrown by <see cref="ThrowIfFailed"/>.
+        /// </summary>
+        /// <param name="buffer">A pointer to the native buffer.</param>
+        /// <param name="offset">The position in the stream from which the data should be read.</param>
+        /// <param name="count">The maximum number of bytes to read.</param>
+        /// <returns>The number of bytes that have been read, or -1 if an error occurred.</returns>
+        private int Read(IntPtr buffer, long offset, int count)
+        {
+            try
+            {
+                //MuPDF may access the document from different threads (one at a time).
+                lock (this.StreamLock)
+                {
+                    if (this.Buffer.Length < count)
+                    {
+                        this.Buffer = new byte[count];
+                    }
+
+                    this.Stream.Seek(offset, SeekOrigin.Begin);
+
+                    int read = this.Stream.Read(this.Buffer, 0, count);
+
+                    Marshal.Copy(this.Buffer, 0, buffer, read);
+
+                    return read;
+                }
+            }
+            catch (Exception ex)
+            {
+                this.Exception = ExceptionDispatchInfo.Capture(ex);
+                return -1;
+            }
+        }
+
+        /// <summary>
+        /// If reading from the stream failed since the last time this method was called, rethrow the exception that caused the failure.
+        /// </summary>
+        public void ThrowIfFailed()
+        {
+            Interlocked.Exchange(ref this.Exception, null)?.Throw();
+        }
+    }
+}
@@ -336,6 +336,60 @@ namespace MuPDFCore
         BGRA = 3
     }
 
+    /// <summary>
+    /// Post-processing steps that are performed by the native rendering code.
+    /// </summary>
+    [Flags]
+    internal enum RenderFlags
+    {
+        /// <summary>
+        /// No post-processing.
+        /// </summary>
+        None = 0,
+
+        /// <summary>
+        /// Convert the colour values of images with an alpha channel from premultiplied to straight alpha.
+        /// </summary>
+        Unpremultiply = 1,
+
+        /// <summary>
+        /// Clear the pixels outside of the clip rectangle.
+        /// </summary>
+        Clip = 2
+    }
+
+    /// <summary>
+    /// Text encodings that can be produced by the native text extraction code.
+    /// </summary>
+    internal enum TextEncodings
+    {
+        /// <summary>
+        /// UTF-8 (one byte per code unit).
+        /// </summary>
+        UTF8 = 0,
+
+        /// <summary>
+        /// UTF-16 (two bytes per code unit, in the native byte order).
+        /// </summary>
+        UTF16 = 1
+    }
+
+    /// <summary>
+    /// Allocators that can be used by the native MuPDF context.
+    /// </summary>
+    public enum NativeAllocators
+    {
+        /// <summary>
+        /// Use the system allocator (malloc/realloc/free).
+        /// </summary>
+        System = 0,
+
+        /// <summary>
+        /// Use a pooled allocator: small blocks are recycled from per-thread free lists grouped by size class, instead of being returned to the system. This reduces the cost of the many short-lived allocations performed while rendering.
+        /// </summary>
+        Pool = 1
+    }
+
     /// <summary>
     /// Possible document encryption states.
     /// </summary>
@@ -357,6 +411,27 @@ namespace MuPDFCore
         Unlocked = 2
     }
 
+    /// <summary>
+    /// Describes whether an accelerator file was used when opening a document.
+    /// </summary>
+    public enum AcceleratorState
+    {
+        /// <summary>
+        /// No accelerator file was used, either because no accelerator cache directory was specified, or because the document type does not support accelerators.
+        /// </summary>
+        NotUsed = 0,
+
+        /// <summary>
+        /// The document was opened using an existing accelerator file.
+        /// </summary>
+        Loaded = 1,
+
+        /// <summary>
+        /// The document was opened normally, and a new accelerator file was created for the next time it is opened.
+        /// </summary>
+        Created = 2
+    }
+
     /// <summary>
     /// Possible document restriction states.
     /// </summary>
@@ -1205,6 +1280,22 @@ namespace MuPDFCore
         [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
         internal static extern int CreateContext(ulong store_size, ref IntPtr out_ctx);
 
+        /// <summary>
+        /// Create a MuPDF context object with the specified store size, using the specified allocator for all of its (and its clones') allocations.
+        /// </summary>
+        /// <param name="store_size">Maximum size in bytes of the resource store.</param>
+        /// <param name="allocator">An integer equivalent to <see cref="NativeAllocators"/>, specifying the allocator to use.</param>
+        /// <param name="out_ctx">A pointer to the native context object.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CreateContextWithAllocator(ulong store_size, int allocator, ref IntPtr out_ctx);
+
+        /// <summary>
+        /// Return to the system all the memory blocks that are cached by the pooled allocator for the calling thread.
+        /// </summary>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void ReleasePooledMemory();
+
         /// <summary>
         /// Free a context and its global store.
         /// </summary>
@@ -1281,6 +1372,39 @@ namespace MuPDFCore
         [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
         internal static extern int GetDisplayList(IntPtr ctx, IntPtr page, int annotations, ref IntPtr out_display_list, ref float out_x0, ref float out_y0, ref float out_x1, ref float out_y1);
 
+        /// <summary>
+        /// Create a display list from a page, without computing its bounds.
+        /// </summary>
+        /// <param name="ctx">A pointer to the context used to create the document.</param>
+        /// <param name="page">A pointer to the page that should be used to create the display list.</param>
+        /// <param name="annotations">An integer indicating whether annotations should be included in the display list (1) or not (any other value).</param>
+        /// <param name="out_display_list">A pointer to the newly-created display list.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CreateDisplayList(IntPtr ctx, IntPtr page, int annotations, ref IntPtr out_display_list);
+
+        /// <summary>
+        /// Compute the bounds of the contents of a display list.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="list">The display list whose bounds should be computed.</param>
+        /// <param name="out_x0">The left coordinate of the display list's bounds.</param>
+        /// <param name="out_y0">The top coordinate of the display list's bounds.</param>
+        /// <param name="out_x1">The right coordinate of the display list's bounds.</param>
+        /// <param name="out_y1">The bottom coordinate of the display list's bounds.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetDisplayListBounds(IntPtr ctx, IntPtr list, ref float out_x0, ref float out_y0, ref float out_x1, ref float out_y1);
+
+        /// <summary>
+        /// Estimate the amount of memory used by a display list. Resources that are shared with other objects (e.g., images and fonts) are not included.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="list">The display list whose size should be estimated.</param>
+        /// <returns>The estimated size of the display list in bytes, or 0 if the size cannot be estimated with this version of MuPDF.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern ulong GetDisplayListSize(IntPtr ctx, IntPtr list);
+
         /// <summary>
         /// Free a display list.
         /// </summary>
@@ -1298,6 +1422,10 @@ namespace MuPDFCore
         /// <param name="data_length">The length in bytes of the data that makes up the document.</param>
         /// <param name="file_type">The type (extension) of the document.</param>
         /// <param name="get_image_resolution">If this is not 0, try opening the stream as an image and return the actual resolution (in DPI) of the image. Otherwise (or if trying to open the stream as an image fails), the returned resolution will be -1.</param>
+        /// <param name="layout_width">The page width used to lay out reflowable documents after they have been opened. If this is &lt; 0, the document is not laid out.</param>
+        /// <param name="layout_height">The page height used to lay out reflowable documents after they have been opened.</param>
+        /// <param name="layout_em">The default font size (in points) used to lay out reflowable documents after they have been opened.</param>
+        /// <param name="count_pages">If this is 0, the pages are not counted, and <paramref name="out_page_count"/> is set to -1.</param>
         /// <param name="out_doc">The newly created document.</param>
         /// <param name="out_str">The newly created stream (so that it can be disposed later).</param>
         /// <param name="out_page_count">The number of pages in the document.</param>
@@ -1305,7 +1433,69 @@ namespace MuPDFCore
         /// <param name="out_image_yres">If the document is an image file, the vertical resolution of the image.</param>
         /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
         [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
-        internal static extern int CreateDocumentFromStream(IntPtr ctx, IntPtr data, ulong data_length, string file_type, int get_image_resolution, ref IntPtr out_doc, ref IntPtr out_str, ref int out_page_count, ref float out_image_xres, ref float out_image_yres);
+        internal static extern int CreateDocumentFromStream(IntPtr ctx, IntPtr data, ulong data_length, string file_type, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, ref IntPtr out_doc, ref IntPtr out_str, ref int out_page_count, ref float out_image_xres, ref float out_image_yres);
+
+        /// <summary>
+        /// Create a new document from a file, by mapping the file in memory (read-only) and opening the mapped data.
+        /// </summary>
+        /// <param name="ctx">The context to which the document will belong.</param>
+        /// <param name="file_name">The path of the file to open, UTF-8 encoded. This is also used to determine the type of the document.</param>
+        /// <param name="get_image_resolution">If this is not 0, try opening the file as an image and return the actual resolution (in DPI) of the image. Otherwise (or if trying to open the file as an image fails), the returned resolution will be -1.</param>
+        /// <param name="layout_width">The page width used to lay out reflowable documents after they have been opened. If this is &lt; 0, the document is not laid out.</param>
+        /// <param name="layout_height">The page height used to lay out reflowable documents after they have been opened.</param>
+        /// <param name="layout_em">The default font size (in points) used to lay out reflowable documents after they have been opened.</param>
+        /// <param name="count_pages">If this is 0, the pages are not counted, and <paramref name="out_page_count"/> is set to -1.</param>
+        /// <param name="out_doc">The newly created document.</param>
+        /// <param name="out_str">The newly created stream (so that it can be disposed later).</param>
+        /// <param name="out_page_count">The number of pages in the document.</param>
+        /// <param name="out_image_xres">If the document is an image file, the horizontal resolution of the image.</param>
+        /// <param name="out_image_yres">If the document is an image file, the vertical resolution of the image.</param>
+        /// <param name="out_mapping">The file mapping, which must be freed using <see cref="DisposeMappedFile"/> after the document and the stream have been disposed.</param>
+        /// <param name="out_data">The address of the mapped data.</param>
+        /// <param name="out_length">The length of the mapped data.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CreateDocumentFromMappedFile(IntPtr ctx, IntPtr file_name, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, ref IntPtr out_doc, ref IntPtr out_str, ref int out_page_count, ref float out_image_xres, ref float out_image_yres, ref IntPtr out_mapping, ref IntPtr out_data, ref ulong out_length);
+
+        /// <summary>
+        /// Free a file mapping created by <see cref="CreateDocumentFromMappedFile"/>.
+        /// </summary>
+        /// <param name="mapping">The mapping to free.</param>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void DisposeMappedFile(IntPtr mapping);
+
+        /// <summary>
+        /// Delegate defining a callback function that is invoked by the unmanaged MuPDF library to read a chunk of the data of a document.
+        /// </summary>
+        /// <param name="buffer">A pointer to the buffer where the data should be copied.</param>
+        /// <param name="offset">The position of the first byte to read.</param>
+        /// <param name="count">The maximum number of bytes to read.</param>
+        /// <returns>This function should return the number of bytes that have been copied to the buffer, or -1 if an error occurred.</returns>
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate int ReadCallback(IntPtr buffer, long offset, int count);
+
+        /// <summary>
+        /// Create a new document from data that is read on demand through a callback.
+        /// </summary>
+        /// <param name="ctx">The context to which the document will belong.</param>
+        /// <param name="read">The callback used to read the data. This must remain valid until the stream is disposed.</param>
+        /// <param name="length">The total length in bytes of the data.</param>
+        /// <param name="block_size">The size in bytes of each block.</param>
+        /// <param name="block_count">The maximum number of blocks that are cached.</param>
+        /// <param name="file_type">The type (extension) of the document.</param>
+        /// <param name="get_image_resolution">If this is not 0, the whole stream is read in memory, the actual resolution (in DPI) of the image is read from its header, and the document is opened from the data in memory. Otherwise (or if the data is not an image), the returned resolution will be -1.</param>
+        /// <param name="layout_width">The page width used to lay out reflowable documents after they have been opened. If this is &lt; 0, the document is not laid out.</param>
+        /// <param name="layout_height">The page height used to lay out reflowable documents after they have been opened.</param>
+        /// <param name="layout_em">The default font size (in points) used to lay out reflowable documents after they have been opened.</param>
+        /// <param name="count_pages">If this is 0, the pages are not counted, and <paramref name="out_page_count"/> is set to -1.</param>
+        /// <param name="out_doc">The newly created document.</param>
+        /// <param name="out_str">The newly created stream (so that it can be disposed later).</param>
+        /// <param name="out_page_count">The number of pages in the document.</param>
+        /// <param name="out_image_xres">If the document is an image file, the horizontal resolution of the image.</param>
+        /// <param name="out_image_yres">If the document is an image file, the vertical resolution of the image.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CreateDocumentFromCallbackStream(IntPtr ctx, ReadCallback read, long length, int block_size, int block_count, string file_type, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, ref IntPtr out_doc, ref IntPtr out_str, ref int out_page_count, ref float out_image_xres, ref float out_image_yres);
 
         /// <summary>
         /// Create a new document from a file name.
@@ -1321,6 +1511,27 @@ namespace MuPDFCore
         [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
         internal static extern int CreateDocumentFromFile(IntPtr ctx, IntPtr file_name, int get_image_resolution, ref IntPtr out_doc, ref int out_page_count, ref float out_image_xres, ref float out_image_yres);
 
+        /// <summary>
+        /// Create a new document from a file name, using an accelerator file to speed up opening it. If the accelerator file exists, the document is opened using it;
+        /// otherwise, the document is opened normally and, if the document type supports it, the accelerator file is created.
+        /// </summary>
+        /// <param name="ctx">The context to which the document will belong.</param>
+        /// <param name="file_name">The path of the file to open, UTF-8 encoded.</param>
+        /// <param name="accelerator_file">The path of the accelerator file, UTF-8 encoded, or <see cref="IntPtr.Zero"/> to open the document without an accelerator.</param>
+        /// <param name="get_image_resolution">If this is not 0, try opening the file as an image and return the actual resolution (in DPI) of the image. Otherwise (or if trying to open the file as an image fails), the returned resolution will be -1.</param>
+        /// <param name="layout_width">The page width used to lay out reflowable documents after they have been opened. If this is &lt; 0, the document is not laid out.</param>
+        /// <param name="layout_height">The page height used to lay out reflowable documents after they have been opened.</param>
+        /// <param name="layout_em">The default font size (in points) used to lay out reflowable documents after they have been opened.</param>
+        /// <param name="count_pages">If this is 0, the pages are not counted, and <paramref name="out_page_count"/> is set to -1.</param>
+        /// <param name="out_doc">The newly created document.</param>
+        /// <param name="out_page_count">The number of pages in the document.</param>
+        /// <param name="out_image_xres">If the document is an image file, the horizontal resolution of the image.</param>
+        /// <param name="out_image_yres">If the document is an image file, the vertical resolution of the image.</param>
+        /// <param name="out_accelerator_state">An integer equivalent to <see cref="AcceleratorState"/> describing whether the accelerator file was used.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CreateDocumentFromFileWithAccelerator(IntPtr ctx, IntPtr file_name, IntPtr accelerator_file, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, ref IntPtr out_doc, ref int out_page_count, ref float out_image_xres, ref float out_image_yres, ref int out_accelerator_state);
+
         /// <summary>
         /// Free a stream and its associated resources.
         /// </summary>
@@ -1351,10 +1562,39 @@ namespace MuPDFCore
         /// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
         /// <param name="colorFormat">The pixel data format.</param>
         /// <param name="pixel_storage">A pointer indicating where the pixel bytes will be written. There must be enough space available!</param>
+        /// <param name="flags">An integer equivalent to a combination of <see cref="RenderFlags"/>, specifying the post-processing steps to perform.</param>
+        /// <param name="clip_x0">The left coordinate in page units of the clip rectangle (only used with <see cref="RenderFlags.Clip"/>).</param>
+        /// <param name="clip_y0">The top coordinate in page units of the clip rectangle (only used with <see cref="RenderFlags.Clip"/>).</param>
+        /// <param name="clip_x1">The right coordinate in page units of the clip rectangle (only used with <see cref="RenderFlags.Clip"/>).</param>
+        /// <param name="clip_y1">The bottom coordinate in page units of the clip rectangle (only used with <see cref="RenderFlags.Clip"/>).</param>
+        /// <param name="cookie">A pointer to a cookie object that can be used to track progress and/or abort rendering. Can be null.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int RenderSubDisplayList(IntPtr ctx, IntPtr list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, IntPtr pixel_storage, int flags, float clip_x0, float clip_y0, float clip_x1, float clip_y1, IntPtr cookie);
+
+        /// <summary>
+        /// Render (part of) a page to an array of bytes starting at the specified pointer, running the page directly into the draw device without creating a display list.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="page">The page to render.</param>
+        /// <param name="annotations">An integer indicating whether annotations should be rendered (1) or not (any other value).</param>
+        /// <param name="x0">The left coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="y0">The top coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="x1">The right coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="y1">The bottom coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+        /// <param name="colorFormat">The pixel data format.</param>
+        /// <param name="pixel_storage">A pointer indicating where the pixel bytes will be written. There must be enough space available!</param>
+        /// <param name="flags">An integer equivalent to a combination of <see cref="RenderFlags"/>, specifying the post-processing steps to perform.</param>
+        /// <param name="clip_x0">The left coordinate in page units of the clip rectangle (only used with <see cref="RenderFlags.Clip"/>).</param>
+        /// <param name="clip_y0">The top coordinate in page units of the clip rectangle (only used with <see cref="RenderFlags.Clip"/>).</param>
+        /// <param name="clip_x1">The right coordinate in page units of the clip rectangle (only used with <see cref="RenderFlags.Clip"/>).</param>
+        /// <param name="clip_y1">The bottom coordinate in page units of the clip rectangle (only used with <see cref="RenderFlags.Clip"/>).</param>
+        /// <param name="band_height">If this is greater than 0, the page is rendered in horizontal bands of this height (in pixels).</param>
         /// <param name="cookie">A pointer to a cookie object that can be used to track progress and/or abort rendering. Can be null.</param>
         /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
         [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
-        internal static extern int RenderSubDisplayList(IntPtr ctx, IntPtr list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, IntPtr pixel_storage, IntPtr cookie);
+        internal static extern int RenderPage(IntPtr ctx, IntPtr page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, IntPtr pixel_storage, int flags, float clip_x0, float clip_y0, float clip_x1, float clip_y1, int band_height, IntPtr cookie);
 
         /// <summary>
         /// Get the specified bounding box from a page.
@@ -1407,6 +1647,49 @@ namespace MuPDFCore
         [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
         internal static extern int LayoutDocument(IntPtr ctx, IntPtr doc, float width, float height, float em, out int out_page_count);
 
+        /// <summary>
+        /// Count the pages in a document, using its current layout.
+        /// </summary>
+        /// <param name="ctx">The context to which the document belongs.</param>
+        /// <param name="doc">The document whose pages should be counted.</param>
+        /// <param name="out_page_count">The number of pages in the document.</param>
+        /// <returns>An integer detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CountPages(IntPtr ctx, IntPtr doc, out int out_page_count);
+
+        /// <summary>
+        /// Set the layout of a reflowable document, without counting its pages.
+        /// </summary>
+        /// <param name="ctx">The context to which the document belongs.</param>
+        /// <param name="doc">The document to layout.</param>
+        /// <param name="width">The page width.</param>
+        /// <param name="height">The page height.</param>
+        /// <param name="em">The default font size, in points.</param>
+        /// <returns>An integer detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SetDocumentLayout(IntPtr ctx, IntPtr doc, float width, float height, float em);
+
+        /// <summary>
+        /// Count the chapters in a document.
+        /// </summary>
+        /// <param name="ctx">The context to which the document belongs.</param>
+        /// <param name="doc">The document whose chapters should be counted.</param>
+        /// <param name="out_chapter_count">The number of chapters in the document.</param>
+        /// <returns>An integer detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CountChapters(IntPtr ctx, IntPtr doc, out int out_chapter_count);
+
+        /// <summary>
+        /// Count the pages in a chapter of a document, using its current layout. For document types that lay out their chapters on demand (e.g., EPUB), this only lays out the specified chapter.
+        /// </summary>
+        /// <param name="ctx">The context to which the document belongs.</param>
+        /// <param name="doc">The document containing the chapter.</param>
+        /// <param name="chapter">The index of the chapter (starting at 0).</param>
+        /// <param name="out_page_count">The number of pages in the chapter.</param>
+        /// <returns>An integer detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CountChapterPages(IntPtr ctx, IntPtr doc, int chapter, out int out_page_count);
+
         /// <summary>
         /// Create cloned contexts that can be used in multithreaded rendering.
         /// </summary>
@@ -1435,6 +1718,129 @@ namespace MuPDFCore
         [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
         internal static extern int SaveImage(IntPtr ctx, IntPtr list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, IntPtr file_name, int output_format, int quality);
 
+        /// <summary>
+        /// Save (part of) a page to an image file in the specified format, running the page directly into the draw device without creating a display list.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="page">The page to render.</param>
+        /// <param name="annotations">An integer indicating whether annotations should be rendered (1) or not (any other value).</param>
+        /// <param name="x0">The left coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="y0">The top coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="x1">The right coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="y1">The bottom coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+        /// <param name="colorFormat">The pixel data format.</param>
+        /// <param name="file_name">The path to the output file, UTF-8 encoded.</param>
+        /// <param name="output_format">An integer equivalent to <see cref="RasterOutputFileTypes"/> specifying the output format.</param>
+        /// <param name="quality">Quality level for the output format (where applicable).</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SavePageImage(IntPtr ctx, IntPtr page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, IntPtr file_name, int output_format, int quality);
+
+        /// <summary>
+        /// Save (part of) a display list to an image file in the specified format, rendering and encoding it one band of rows at a time.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="list">The display list to render.</param>
+        /// <param name="x0">The left coordinate in page units of the region of the display list that should be rendererd.</param>
+        /// <param name="y0">The top coordinate in page units of the region of the display list that should be rendererd.</param>
+        /// <param name="x1">The right coordinate in page units of the region of the display list that should be rendererd.</param>
+        /// <param name="y1">The bottom coordinate in page units of the region of the display list that should be rendererd.</param>
+        /// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+        /// <param name="colorFormat">The pixel data format.</param>
+        /// <param name="file_name">The path to the output file, UTF-8 encoded.</param>
+        /// <param name="output_format">An integer equivalent to <see cref="RasterOutputFileTypes"/> specifying the output format. JPEG is not supported.</param>
+        /// <param name="band_height">The height in pixels of each band.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SaveImageBanded(IntPtr ctx, IntPtr list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, IntPtr file_name, int output_format, int band_height);
+
+        /// <summary>
+        /// Save (part of) a page to an image file in the specified format, running the page directly into the draw device one band of rows at a time.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="page">The page to render.</param>
+        /// <param name="annotations">An integer indicating whether annotations should be rendered (1) or not (any other value).</param>
+        /// <param name="x0">The left coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="y0">The top coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="x1">The right coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="y1">The bottom coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+        /// <param name="colorFormat">The pixel data format.</param>
+        /// <param name="file_name">The path to the output file, UTF-8 encoded.</param>
+        /// <param name="output_format">An integer equivalent to <see cref="RasterOutputFileTypes"/> specifying the output format. JPEG is not supported.</param>
+        /// <param name="band_height">The height in pixels of each band.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SavePageImageBanded(IntPtr ctx, IntPtr page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, IntPtr file_name, int output_format, int band_height);
+
+        /// <summary>
+        /// Create a writer that saves an image to a file band by band, with the bands being supplied by the caller.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="file_name">The path to the output file, UTF-8 encoded.</param>
+        /// <param name="output_format">An integer equivalent to <see cref="RasterOutputFileTypes"/> specifying the output format. JPEG is not supported.</param>
+        /// <param name="x0">The left coordinate in page units of the region that will be rendered.</param>
+        /// <param name="y0">The top coordinate in page units of the region that will be rendered.</param>
+        /// <param name="x1">The right coordinate in page units of the region that will be rendered.</param>
+        /// <param name="y1">The bottom coordinate in page units of the region that will be rendered.</param>
+        /// <param name="zoom">How much the region will be scaled when rendering.</param>
+        /// <param name="colorFormat">The pixel data format.</param>
+        /// <param name="out_writer">The newly created writer.</param>
+        /// <param name="out_width">The width in pixels of the image.</param>
+        /// <param name="out_height">The height in pixels of the image.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CreateBandedImageWriter(IntPtr ctx, IntPtr file_name, int output_format, float x0, float y0, float x1, float y1, float zoom, int colorFormat, ref IntPtr out_writer, ref int out_width, ref int out_height);
+
+        /// <summary>
+        /// Render a band of rows of (part of) a display list. The rows are counted from the top of the rendered region.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="list">The display list to render.</param>
+        /// <param name="x0">The left coordinate in page units of the region being rendered.</param>
+        /// <param name="y0">The top coordinate in page units of the region being rendered.</param>
+        /// <param name="x1">The right coordinate in page units of the region being rendered.</param>
+        /// <param name="y1">The bottom coordinate in page units of the region being rendered.</param>
+        /// <param name="zoom">How much the region is scaled when rendering.</param>
+        /// <param name="colorFormat">The pixel data format.</param>
+        /// <param name="first_row">The first row of the band.</param>
+        /// <param name="row_count">The number of rows in the band.</param>
+        /// <param name="pixel_storage">The address of the buffer where the pixel data will be written.</param>
+        /// <param name="cookie">A cookie object that can be used to track progress and/or abort rendering. Can be <see cref="IntPtr.Zero"/>.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int RenderImageBand(IntPtr ctx, IntPtr list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int first_row, int row_count, IntPtr pixel_storage, IntPtr cookie);
+
+        /// <summary>
+        /// Encode the next band of an image. Bands must be written in order, from the top of the image to the bottom.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="writer">The writer created by <see cref="CreateBandedImageWriter"/>.</param>
+        /// <param name="row_count">The number of rows in the band.</param>
+        /// <param name="pixel_storage">The pixel data of the band, with premultiplied alpha.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int WriteImageBand(IntPtr ctx, IntPtr writer, int row_count, IntPtr pixel_storage);
+
+        /// <summary>
+        /// Finish writing a banded image and close the output file.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="writer">The writer created by <see cref="CreateBandedImageWriter"/>.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int CloseBandedImageWriter(IntPtr ctx, IntPtr writer);
+
+        /// <summary>
+        /// Free a banded image writer and its associated resources.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="writer">The writer created by <see cref="CreateBandedImageWriter"/>.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int DisposeBandedImageWriter(IntPtr ctx, IntPtr writer);
+
         /// <summary>
         /// Write (part of) a display list to an image buffer in the specified format.
         /// </summary>
@@ -1455,6 +1861,73 @@ namespace MuPDFCore
         [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
         internal static extern int WriteImage(IntPtr ctx, IntPtr list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, ref IntPtr out_buffer, ref IntPtr out_data, ref ulong out_length);
 
+        /// <summary>
+        /// Write (part of) a page to an image buffer in the specified format, running the page directly into the draw device without creating a display list.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="page">The page to render.</param>
+        /// <param name="annotations">An integer indicating whether annotations should be rendered (1) or not (any other value).</param>
+        /// <param name="x0">The left coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="y0">The top coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="x1">The right coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="y1">The bottom coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+        /// <param name="colorFormat">The pixel data format.</param>
+        /// <param name="output_format">An integer equivalent to <see cref="RasterOutputFileTypes"/> specifying the output format.</param>
+        /// <param name="quality">Quality level for the output format (where applicable).</param>
+        /// <param name="out_buffer">The address of the buffer on which the data has been written (only useful for disposing the buffer later).</param>
+        /// <param name="out_data">The address of the byte array where the data has been actually written.</param>
+        /// <param name="out_length">The length in bytes of the image data.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int WritePageImage(IntPtr ctx, IntPtr page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, ref IntPtr out_buffer, ref IntPtr out_data, ref ulong out_length);
+
+        /// <summary>
+        /// Delegate defining a callback function that is invoked by the unmanaged MuPDF library to pass chunks of encoded data as they are written.
+        /// </summary>
+        /// <param name="data">A pointer to the data, which is only valid for the duration of the call.</param>
+        /// <param name="length">The length in bytes of the data.</param>
+        /// <returns>This function should return 0 if the data has been written successfully, or 1 to indicate that writing should be stopped.</returns>
+        [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+        internal delegate int WriteCallback(IntPtr data, ulong length);
+
+        /// <summary>
+        /// Write (part of) a display list as an image in the specified format, passing the encoded data to a callback in chunks as it is produced.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="list">The display list to render.</param>
+        /// <param name="x0">The left coordinate in page units of the region of the display list that should be rendererd.</param>
+        /// <param name="y0">The top coordinate in page units of the region of the display list that should be rendererd.</param>
+        /// <param name="x1">The right coordinate in page units of the region of the display list that should be rendererd.</param>
+        /// <param name="y1">The bottom coordinate in page units of the region of the display list that should be rendererd.</param>
+        /// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+        /// <param name="colorFormat">The pixel data format.</param>
+        /// <param name="output_format">An integer equivalent to <see cref="RasterOutputFileTypes"/> specifying the output format.</param>
+        /// <param name="quality">Quality level for the output format (where applicable).</param>
+        /// <param name="callback">The function that receives the encoded data.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int WriteImageToStream(IntPtr ctx, IntPtr list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, [MarshalAs(UnmanagedType.FunctionPtr)] WriteCallback callback);
+
+        /// <summary>
+        /// Write (part of) a page as an image in the specified format, running the page directly into the draw device and passing the encoded data to a callback in chunks as it is produced.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="page">The page to render.</param>
+        /// <param name="annotations">An integer indicating whether annotations should be rendered (1) or not (any other value).</param>
+        /// <param name="x0">The left coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="y0">The top coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="x1">The right coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="y1">The bottom coordinate in page units of the region of the page that should be rendererd.</param>
+        /// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+        /// <param name="colorFormat">The pixel data format.</param>
+        /// <param name="output_format">An integer equivalent to <see cref="RasterOutputFileTypes"/> specifying the output format.</param>
+        /// <param name="quality">Quality level for the output format (where applicable).</param>
+        /// <param name="callback">The function that receives the encoded data.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int WritePageImageToStream(IntPtr ctx, IntPtr page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, [MarshalAs(UnmanagedType.FunctionPtr)] WriteCallback callback);
+
         /// <summary>
         /// Free a native buffer and its associated resources.
         /// </summary>
@@ -1688,6 +2161,96 @@ namespace MuPDFCore
         [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
         internal static extern int DisposeStructuredTextPage(IntPtr ctx, IntPtr page);
 
+        /// <summary>
+        /// Serialise the text blocks, lines and characters of a structured text page into a single flat buffer (see <see cref="StructuredText.StructuredTextPageDataHeader"/>). Each distinct font is kept once and stored in a font table.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="page">The structured text page to serialise.</param>
+        /// <param name="out_data">The address of the buffer, which must be freed using <see cref="DisposeStructuredTextPageData"/>.</param>
+        /// <param name="out_length">The length in bytes of the buffer.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetStructuredTextPageData(IntPtr ctx, IntPtr page, ref IntPtr out_data, ref long out_length);
+
+        /// <summary>
+        /// Free a buffer produced by <see cref="GetStructuredTextPageData"/>. This does not drop the fonts in the font table.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="data">The buffer to free.</param>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void DisposeStructuredTextPageData(IntPtr ctx, IntPtr data);
+
+        /// <summary>
+        /// Extract the plain text of a page as UTF-8, without creating a structured text representation for the caller. Text lines that are empty or only contain white space are skipped.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="page">The page whose text should be extracted.</param>
+        /// <param name="annotations">If this is 1, the text of the annotations is included. Otherwise, only the page contents are used.</param>
+        /// <param name="flags">An integer equivalent to <see cref="StructuredText.StructuredTextFlags"/>, specifying flags for the structured text creation.</param>
+        /// <param name="separator">A null-terminated UTF-8 string that is written between consecutive text lines.</param>
+        /// <param name="cookie">A cookie that can be used to abort the operation (can be <see cref="IntPtr.Zero"/>).</param>
+        /// <param name="out_buffer">The address of the buffer containing the text, which must be freed using <see cref="DisposeBuffer"/>.</param>
+        /// <param name="out_data">The address of the text data within the buffer (not null-terminated).</param>
+        /// <param name="out_length">The length in bytes of the text data.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int ExtractPageTextUTF8(IntPtr ctx, IntPtr page, int annotations, int flags, IntPtr separator, IntPtr cookie, ref IntPtr out_buffer, ref IntPtr out_data, ref ulong out_length);
+
+        /// <summary>
+        /// Extract the plain text of a display list directly into a buffer provided by the caller, without creating a structured text representation for the caller. Text lines that are empty or only contain white space are skipped.
+        /// If the buffer is too small, only the text that fits (up to the last whole character) is written; the returned length is always the length of the full text.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="list">The display list whose text should be extracted.</param>
+        /// <param name="flags">An integer equivalent to <see cref="StructuredText.StructuredTextFlags"/>, specifying flags for the structured text creation.</param>
+        /// <param name="separator">A null-terminated UTF-8 string that is written between consecutive text lines.</param>
+        /// <param name="encoding">An integer equivalent to <see cref="TextEncodings"/>, specifying the encoding of the text.</param>
+        /// <param name="buffer">The buffer where the text is written (not null-terminated). This can be <see cref="IntPtr.Zero"/>, to determine the length of the text.</param>
+        /// <param name="buffer_length">The size of the buffer, in code units (bytes for UTF-8, <see cref="char"/>s for UTF-16).</param>
+        /// <param name="out_length">The length of the full text, in code units.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int GetPageText(IntPtr ctx, IntPtr list, int flags, IntPtr separator, int encoding, IntPtr buffer, long buffer_length, ref long out_length);
+
+        /// <summary>
+        /// Search for the occurrences of a string in a structured text page, using <c>fz_search_stext_page_cb</c>. The hits, their quads and their addresses are returned in a single buffer (see <see cref="StructuredText.StructuredTextSearchHit"/>).
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="page">The structured text page to search.</param>
+        /// <param name="needle">The null-terminated UTF-8 string to search for.</param>
+        /// <param name="options">A combination of <see cref="StructuredText.SearchOptions"/>.</param>
+        /// <param name="max_hits">The maximum number of hits to return, or 0 to return all of them.</param>
+        /// <param name="out_data">The address of the buffer containing the hits, which must be freed using <see cref="DisposeSearchHits"/>. This is <see cref="IntPtr.Zero"/> if there are no hits.</param>
+        /// <param name="out_hit_count">The number of hits.</param>
+        /// <param name="out_quad_count">The total number of quads.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SearchStructuredTextPage(IntPtr ctx, IntPtr page, IntPtr needle, int options, int max_hits, ref IntPtr out_data, ref int out_hit_count, ref int out_quad_count);
+
+        /// <summary>
+        /// Create a structured text page from a display list, search it for the occurrences of a string (see <see cref="SearchStructuredTextPage"/>), and free it.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="list">The display list to search.</param>
+        /// <param name="flags">An integer equivalent to <see cref="StructuredText.StructuredTextFlags"/>, specifying flags for the structured text creation.</param>
+        /// <param name="needle">The null-terminated UTF-8 string to search for.</param>
+        /// <param name="options">A combination of <see cref="StructuredText.SearchOptions"/>.</param>
+        /// <param name="max_hits">The maximum number of hits to return, or 0 to return all of them.</param>
+        /// <param name="out_data">The address of the buffer containing the hits, which must be freed using <see cref="DisposeSearchHits"/>. This is <see cref="IntPtr.Zero"/> if there are no hits.</param>
+        /// <param name="out_hit_count">The number of hits.</param>
+        /// <param name="out_quad_count">The total number of quads.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int SearchDisplayListText(IntPtr ctx, IntPtr list, int flags, IntPtr needle, int options, int max_hits, ref IntPtr out_data, ref int out_hit_count, ref int out_quad_count);
+
+        /// <summary>
+        /// Free a buffer produced by <see cref="SearchStructuredTextPage"/> or <see cref="SearchDisplayListText"/>.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="data">The buffer to free.</param>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern void DisposeSearchHits(IntPtr ctx, IntPtr data);
+
         /// <summary>
         /// Redirect the standard output and standard error to named pipes with the specified names. On Windows, these are actually named pipes; on Linux and macOS, these are Unix sockets (matching the behaviour of System.IO.Pipes). Note that this has side-effects.
         /// </summary>
@@ -1789,6 +2352,19 @@ namespace MuPDFCore
         [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
         internal static extern int WriteRasterImage(IntPtr ctx, IntPtr image, int output_format, int quality, ref IntPtr out_buffer, ref IntPtr out_data, ref ulong out_length, int convert_to_rgb);
 
+        /// <summary>
+        /// Write an image in the specified format, passing the encoded data to a callback in chunks as it is produced.
+        /// </summary>
+        /// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+        /// <param name="image">A pointer to the image.</param>
+        /// <param name="output_format">The output format.</param>
+        /// <param name="quality">For JPEG output, the quality value.</param>
+        /// <param name="convert_to_rgb">If this is 1, the image is converted to the RGB colour space before being exported.</param>
+        /// <param name="callback">The function that receives the encoded data.</param>
+        /// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+        [DllImport("MuPDFWrapper", CallingConvention = CallingConvention.Cdecl)]
+        internal static extern int WriteRasterImageToStream(IntPtr ctx, IntPtr image, int output_format, int quality, int convert_to_rgb, [MarshalAs(UnmanagedType.FunctionPtr)] WriteCallback callback);
+
         /// <summary>
         /// Save an image to a file in the specified format.
         /// </summary>
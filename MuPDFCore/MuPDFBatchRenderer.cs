@@ -0,0 +1,812 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2020  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+using MuPDFCore.StructuredText;
+using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.IO;
+using System.Runtime.InteropServices;
+using System.Text;
+using System.Threading;
+
+namespace MuPDFCore
+{
+    /// <summary>
+    /// The outcome of rendering a single page using a <see cref="MuPDFBatchRenderer"/>.
+    /// </summary>
+    public class MuPDFBatchRenderResult
+    {
+        /// <summary>
+        /// The number of the page (starting at 0).
+        /// </summary>
+        public int PageNumber { get; }
+
+        /// <summary>
+        /// The size in pixels of the rendered image. If the page could not be loaded, this is an empty size.
+        /// </summary>
+        public RoundedSize Size { get; internal set; }
+
+        /// <summary>
+        /// The raw values for the pixels of the rendered image. This is only set by <see cref="MuPDFBatchRenderer.Render(int, int, double, PixelFormats, CancellationToken)"/>
+        /// and is <see langword="null"/> if rendering failed or if the image was written to a caller-provided buffer or stream.
+        /// </summary>
+        public byte[] Data { get; internal set; }
+
+        /// <summary>
+        /// The exception that occurred while rendering the page, or <see langword="null"/> if the page was rendered successfully.
+        /// </summary>
+        public Exception Error { get; internal set; }
+
+        /// <summary>
+        /// Whether the page was rendered successfully.
+        /// </summary>
+        public bool Succeeded => Error == null;
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFBatchRenderResult"/> for the specified page.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page (starting at 0).</param>
+        internal MuPDFBatchRenderResult(int pageNumber)
+        {
+            this.PageNumber = pageNumber;
+        }
+    }
+
+    /// <summary>
+    /// The text extracted from a single page using a <see cref="MuPDFBatchRenderer"/>.
+    /// </summary>
+    public class MuPDFBatchTextResult
+    {
+        /// <summary>
+        /// The number of the page (starting at 0).
+        /// </summary>
+        public int PageNumber { get; }
+
+        /// <summary>
+        /// The text of the page, or <see langword="null"/> if the text could not be extracted.
+        /// </summary>
+        public string Text { get; internal set; }
+
+        /// <summary>
+        /// The exception that occurred while extracting the text, or <see langword="null"/> if the text was extracted successfully.
+        /// </summary>
+        public Exception Error { get; internal set; }
+
+        /// <summary>
+        /// Whether the text was extracted successfully.
+        /// </summary>
+        public bool Succeeded => Error == null;
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFBatchTextResult"/> for the specified page.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page (starting at 0).</param>
+        internal MuPDFBatchTextResult(int pageNumber)
+        {
+            this.PageNumber = pageNumber;
+        }
+    }
+
+    /// <summary>
+    /// Renders ranges of pages (or extracts their text) from a document using multiple threads. The document is opened once more for each worker, using a cloned MuPDF context, so that
+    /// the workers never need to share any native object and whole pages can be processed concurrently. The document must have been opened from a file or from memory,
+    /// and the <see cref="MuPDFBatchRenderer"/> must be disposed before the <see cref="MuPDFDocument"/> it was created from.
+    /// </summary>
+    public class MuPDFBatchRenderer : IDisposable
+    {
+        /// <summary>
+        /// The native resources used by a single worker.
+        /// </summary>
+        private class Worker
+        {
+            /// <summary>
+            /// The cloned context used by the worker.
+            /// </summary>
+            public MuPDFContext Context;
+
+            /// <summary>
+            /// The worker's own handle to the document.
+            /// </summary>
+            public IntPtr NativeDocument;
+
+            /// <summary>
+            /// The native stream from which <see cref="NativeDocument"/> was opened (if any).
+            /// </summary>
+            public IntPtr NativeStream;
+
+            /// <summary>
+            /// The cookie used to abort the rendering operation performed by the worker.
+            /// </summary>
+            public IntPtr Cookie;
+        }
+
+        /// <summary>
+        /// The document whose pages are rendered.
+        /// </summary>
+        private readonly MuPDFDocument Document;
+
+        /// <summary>
+        /// The resources used by each worker.
+        /// </summary>
+        private readonly Worker[] Workers;
+
+        /// <summary>
+        /// 1 while pages are being rendered, 2 after the renderer has been disposed, 0 otherwise.
+        /// </summary>
+        private int running = 0;
+
+        /// <summary>
+        /// The number of threads (and document handles) that are used to render the pages.
+        /// </summary>
+        public int WorkerCount { get; }
+
+        /// <summary>
+        /// The maximum number of pages that can be rendered before they are consumed. When this limit is reached, the workers wait until the caller has processed some of the results.
+        /// </summary>
+        public int MaxPendingResults { get; }
+
+        /// <summary>
+        /// If this is <see langword="true" /> (the default), annotations (e.g. signatures) are included in the rendered images. Otherwise, only the page contents are included.
+        /// </summary>
+        public bool IncludeAnnotations { get; set; } = true;
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFBatchRenderer"/> for the specified <paramref name="document"/>.
+        /// </summary>
+        /// <param name="document">The document whose pages will be rendered. This must have been opened from a file or from memory, and it must not be disposed before the <see cref="MuPDFBatchRenderer"/>.</param>
+        /// <param name="workerCount">The number of rendering threads. If this is 0, a number of threads equal to the number of processors in the computer is used.</param>
+        /// <param name="maxPendingResults">The maximum number of rendered pages that can be waiting to be consumed. If this is 0, twice the number of workers is used.</param>
+        public MuPDFBatchRenderer(MuPDFDocument document, int workerCount = 0, int maxPendingResults = 0)
+        {
+            if (workerCount < 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(workerCount), workerCount, "The number of workers must be greater than or equal to 0!");
+            }
+
+            if (maxPendingResults < 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(maxPendingResults), maxPendingResults, "The maximum number of pending results must be greater than or equal to 0!");
+            }
+
+            if (document.EncryptionState == EncryptionState.Encrypted)
+            {
+                throw new DocumentLockedException("A password is necessary to render the document!");
+            }
+
+            if (document.SourceFileName == null && document.SourceDataAddress == IntPtr.Zero)
+            {
+                throw new NotSupportedException("The batch renderer can only be used with documents that have been opened from a file or from memory!");
+            }
+
+            if (workerCount == 0)
+            {
+                workerCount = Environment.ProcessorCount;
+            }
+
+            if (maxPendingResults == 0)
+            {
+                maxPendingResults = 2 * workerCount;
+            }
+
+            this.Document = document;
+            this.WorkerCount = workerCount;
+            this.MaxPendingResults = maxPendingResults;
+
+            IntPtr[] contexts = new IntPtr[workerCount];
+            GCHandle contextsHandle = GCHandle.Alloc(contexts, GCHandleType.Pinned);
+
+            try
+            {
+                ExitCodes result = (ExitCodes)NativeMethods.CloneContext(document.OwnerContext.NativeContext, workerCount, contextsHandle.AddrOfPinnedObject());
+
+                switch (result)
+                {
+                    case ExitCodes.EXIT_SUCCESS:
+                        break;
+                    case ExitCodes.ERR_CANNOT_INIT_MUTEX:
+                        throw new MuPDFException("Cannot initalize mutex objects", result);
+                    case ExitCodes.ERR_CANNOT_CREATE_CONTEXT:
+                        throw new MuPDFException("Cannot create master context", result);
+                    case ExitCodes.ERR_CANNOT_CLONE_CONTEXT:
+                        throw new MuPDFException("Cannot create context clones", result);
+                    default:
+                        throw new MuPDFException("Unknown error", result);
+                }
+            }
+            finally
+            {
+                contextsHandle.Free();
+            }
+
+            //Apply the deferred layout of the document (if any), so that the workers can be laid out in the same way.
+            _ = document.Pages;
+
+            this.Workers = new Worker[workerCount];
+
+            for (int i = 0; i < workerCount; i++)
+            {
+                this.Workers[i] = new Worker() { Context = new MuPDFContext(document.OwnerContext, contexts[i]) };
+            }
+
+            try
+            {
+                for (int i = 0; i < workerCount; i++)
+                {
+                    OpenDocument(this.Workers[i]);
+                }
+            }
+            catch
+            {
+                DisposeWorkers();
+                throw;
+            }
+        }
+
+        /// <summary>
+        /// Open the worker's own handle to the document, and bring it to the same state as the <see cref="Document"/> (unlocked and laid out).
+        /// </summary>
+        /// <param name="worker">The worker whose document should be opened.</param>
+        private void OpenDocument(Worker worker)
+        {
+            Document.OpenSourceDocument(worker.Context, ref worker.NativeDocument, ref worker.NativeStream);
+
+            worker.Cookie = Marshal.AllocHGlobal(Marshal.SizeOf<Cookie>());
+        }
+
+        /// <summary>
+        /// Render a range of pages to arrays of bytes. The pages are rendered concurrently, and the results are returned in the order in which rendering completes, which may differ from the page order.
+        /// Rendering starts when the enumeration begins; if the enumeration is abandoned before it completes, the pages that are still being rendered are aborted.
+        /// </summary>
+        /// <param name="firstPage">The number of the first page to render (starting at 0).</param>
+        /// <param name="pageCount">The number of pages to render.</param>
+        /// <param name="zoom">The scale at which the pages will be rendered. This will determine the size in pixel of the images.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <param name="cancellationToken">A <see cref="CancellationToken"/> that can be used to abort the rendering. When it is cancelled, the enumeration throws an <see cref="OperationCanceledException"/>.</param>
+        /// <returns>A lazy sequence containing one <see cref="MuPDFBatchRenderResult"/> for each page. Errors that occur while rendering a page are reported in the <see cref="MuPDFBatchRenderResult.Error"/> property, rather than being thrown.</returns>
+        public IEnumerable<MuPDFBatchRenderResult> Render(int firstPage, int pageCount, double zoom, PixelFormats pixelFormat, CancellationToken cancellationToken = default)
+        {
+            CheckArguments(firstPage, pageCount, zoom);
+
+            return RenderPages(firstPage, pageCount, zoom, (worker, page, region, pageBounds, fzoom, pageResult) =>
+            {
+                pageResult.Data = new byte[MuPDFDocument.GetRenderedSize(pageBounds, zoom, pixelFormat)];
+
+                GCHandle dataHandle = GCHandle.Alloc(pageResult.Data, GCHandleType.Pinned);
+
+                try
+                {
+                    return RenderPage(worker, page, region, pageBounds, fzoom, pixelFormat, dataHandle.AddrOfPinnedObject());
+                }
+                finally
+                {
+                    dataHandle.Free();
+                }
+            }, cancellationToken);
+        }
+
+        /// <summary>
+        /// Render a range of pages to buffers provided by the caller. The pages are rendered concurrently, and the results are returned in the order in which rendering completes, which may differ from the page order.
+        /// Rendering starts when the enumeration begins; if the enumeration is abandoned before it completes, the pages that are still being rendered are aborted.
+        /// </summary>
+        /// <param name="firstPage">The number of the first page to render (starting at 0).</param>
+        /// <param name="pageCount">The number of pages to render.</param>
+        /// <param name="zoom">The scale at which the pages will be rendered. This will determine the size in pixel of the images.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <param name="getDestination">A method that, given the page number and the size in pixels of the rendered image, returns the address of the buffer where the pixel data will be written.
+        /// This is called concurrently from multiple threads. There must be enough space available to write the values for all the pixels, otherwise this will fail catastrophically!</param>
+        /// <param name="cancellationToken">A <see cref="CancellationToken"/> that can be used to abort the rendering. When it is cancelled, the enumeration throws an <see cref="OperationCanceledException"/>.</param>
+        /// <returns>A lazy sequence containing one <see cref="MuPDFBatchRenderResult"/> for each page. Once a result has been returned, the corresponding buffer is no longer used.
+        /// Errors that occur while rendering a page are reported in the <see cref="MuPDFBatchRenderResult.Error"/> property, rather than being thrown.</returns>
+        public IEnumerable<MuPDFBatchRenderResult> Render(int firstPage, int pageCount, double zoom, PixelFormats pixelFormat, Func<int, RoundedSize, IntPtr> getDestination, CancellationToken cancellationToken = default)
+        {
+            CheckArguments(firstPage, pageCount, zoom);
+
+            if (getDestination == null)
+            {
+                throw new ArgumentNullException(nameof(getDestination));
+            }
+
+            return RenderPages(firstPage, pageCount, zoom, (worker, page, region, pageBounds, fzoom, pageResult) =>
+            {
+                IntPtr destination = getDestination(pageResult.PageNumber, pageResult.Size);
+                return RenderPage(worker, page, region, pageBounds, fzoom, pixelFormat, destination);
+            }, cancellationToken);
+        }
+
+        /// <summary>
+        /// Render a range of pages and write them as encoded images to streams provided by the caller. The pages are rendered concurrently, and the results are returned in the order in which rendering completes, which may differ from the page order.
+        /// Rendering starts when the enumeration begins; if the enumeration is abandoned before it completes, the pages that are still being rendered are aborted.
+        /// </summary>
+        /// <param name="firstPage">The number of the first page to render (starting at 0).</param>
+        /// <param name="pageCount">The number of pages to render.</param>
+        /// <param name="zoom">The scale at which the pages will be rendered. This will determine the size in pixel of the images.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <param name="fileType">The output format of the images.</param>
+        /// <param name="getOutputStream">A method that, given the page number, returns the stream where the image will be written. This is called concurrently from multiple threads, and each page must be written to a different stream.
+        /// The stream is not closed after the image has been written.</param>
+        /// <param name="quality">The quality of the JPEG images (ranging from 0 to 100). This is ignored for other formats.</param>
+        /// <param name="cancellationToken">A <see cref="CancellationToken"/> that can be used to abort the rendering. When it is cancelled, the enumeration throws an <see cref="OperationCanceledException"/>.</param>
+        /// <returns>A lazy sequence containing one <see cref="MuPDFBatchRenderResult"/> for each page. Errors that occur while rendering or writing a page are reported in the <see cref="MuPDFBatchRenderResult.Error"/> property, rather than being thrown.</returns>
+        public IEnumerable<MuPDFBatchRenderResult> WriteImages(int firstPage, int pageCount, double zoom, PixelFormats pixelFormat, RasterOutputFileTypes fileType, Func<int, Stream> getOutputStream, int quality = 90, CancellationToken cancellationToken = default)
+        {
+            CheckArguments(firstPage, pageCount, zoom);
+
+            if (getOutputStream == null)
+            {
+                throw new ArgumentNullException(nameof(getOutputStream));
+            }
+
+            if (pixelFormat == PixelFormats.RGBA && fileType == RasterOutputFileTypes.PNM)
+            {
+                throw new ArgumentException("Cannot save an image with alpha channel in PNM format!", nameof(fileType));
+            }
+
+            if (pixelFormat != PixelFormats.RGB && fileType == RasterOutputFileTypes.JPEG)
+            {
+                throw new ArgumentException("The JPEG format only supports RGB pixel data without an alpha channel!", nameof(fileType));
+            }
+
+            if ((pixelFormat != PixelFormats.RGB && pixelFormat != PixelFormats.RGBA) && fileType == RasterOutputFileTypes.PNG)
+            {
+                throw new ArgumentException("The PNG format only supports RGB or RGBA pixel data!", nameof(fileType));
+            }
+
+            if (quality < 0 || quality > 100)
+            {
+                throw new ArgumentOutOfRangeException(nameof(quality), quality, "The JPEG quality must range between 0 and 100 (inclusive)!");
+            }
+
+            return RenderPages(firstPage, pageCount, zoom, (worker, page, region, pageBounds, fzoom, pageResult) =>
+            {
+                OutputStreamCallback output = new OutputStreamCallback(getOutputStream(pageResult.PageNumber));
+
+                ExitCodes result = (ExitCodes)NativeMethods.WritePageImageToStream(worker.Context.NativeContext, page, IncludeAnnotations ? 1 : 0, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, (int)fileType, quality, output.Callback);
+
+                GC.KeepAlive(output);
+                output.ThrowIfFailed();
+
+                return result;
+            }, cancellationToken);
+        }
+
+        /// <summary>
+        /// Extract the text from a range of pages. The pages are processed concurrently, and the results are returned in the order in which extraction completes, which may differ from the page order.
+        /// The text is produced as UTF-8 by the native code and only converted once to a <see cref="string"/>, without creating a <see cref="MuPDFStructuredTextPage"/> for each page.
+        /// Extraction starts when the enumeration begins; if the enumeration is abandoned before it completes, the pages that are still being processed are aborted.
+        /// </summary>
+        /// <param name="firstPage">The number of the first page to process (starting at 0).</param>
+        /// <param name="pageCount">The number of pages to process.</param>
+        /// <param name="separator">The character(s) used to separate the text lines obtained from each page. If this is <see langword="null" />, <see cref="Environment.NewLine"/> is used as a default separator.
+        /// Lines that are empty or only contain white space are skipped.</param>
+        /// <param name="flags">Flags determining which elements are included in the structured text representation from which the text is extracted.</param>
+        /// <param name="cancellationToken">A <see cref="CancellationToken"/> that can be used to abort the extraction. When it is cancelled, the enumeration throws an <see cref="OperationCanceledException"/>.</param>
+        /// <returns>A lazy sequence containing one <see cref="MuPDFBatchTextResult"/> for each page. Errors that occur while processing a page are reported in the <see cref="MuPDFBatchTextResult.Error"/> property, rather than being thrown.</returns>
+        public IEnumerable<MuPDFBatchTextResult> ExtractText(int firstPage, int pageCount, string separator = null, StructuredTextFlags flags = StructuredTextFlags.None, CancellationToken cancellationToken = default)
+        {
+            CheckArguments(firstPage, pageCount, 1);
+
+            return ExtractTextPages(firstPage, pageCount, separator ?? Environment.NewLine, flags, cancellationToken);
+        }
+
+        /// <summary>
+        /// Extract the text from a range of pages using all the workers.
+        /// </summary>
+        private IEnumerable<MuPDFBatchTextResult> ExtractTextPages(int firstPage, int pageCount, string separator, StructuredTextFlags flags, CancellationToken cancellationToken)
+        {
+            using (UTF8EncodedString encodedSeparator = new UTF8EncodedString(separator))
+            {
+                foreach (MuPDFBatchTextResult result in Run(firstPage, pageCount, (worker, pageNumber) => ExtractPageText(worker, pageNumber, encodedSeparator, flags), cancellationToken))
+                {
+                    yield return result;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Validate the arguments that are common to all the rendering methods.
+        /// </summary>
+        private void CheckArguments(int firstPage, int pageCount, double zoom)
+        {
+            if (disposedValue)
+            {
+                throw new ObjectDisposedException(nameof(MuPDFBatchRenderer));
+            }
+
+            if (firstPage < 0 || firstPage >= Document.Pages.Count)
+            {
+                throw new ArgumentOutOfRangeException(nameof(firstPage), firstPage, "The first page must be between 0 and the number of pages in the document!");
+            }
+
+            if (pageCount < 0 || firstPage + pageCount > Document.Pages.Count)
+            {
+                throw new ArgumentOutOfRangeException(nameof(pageCount), pageCount, "The range of pages must not extend beyond the end of the document!");
+            }
+
+            if (zoom < 0.000001)
+            {
+                throw new ArgumentOutOfRangeException(nameof(zoom), zoom, "The zoom factor is too small!");
+            }
+        }
+
+        /// <summary>
+        /// Render a page that has been loaded by a worker to the specified destination.
+        /// </summary>
+        /// <returns>The exit code of the native rendering function.</returns>
+        private ExitCodes RenderPage(Worker worker, IntPtr page, Rectangle region, Rectangle pageBounds, float fzoom, PixelFormats pixelFormat, IntPtr destination)
+        {
+            RenderFlags flags = Utils.GetRenderFlags(region, pageBounds, Document.ClipToPageBounds, Document.PremultipliedAlpha);
+            return (ExitCodes)NativeMethods.RenderPage(worker.Context.NativeContext, page, IncludeAnnotations ? 1 : 0, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, destination, (int)flags, pageBounds.X0, pageBounds.Y0, pageBounds.X1, pageBounds.Y1, 0, worker.Cookie);
+        }
+
+        /// <summary>
+        /// A method that processes a page that has been loaded by a worker.
+        /// </summary>
+        /// <param name="worker">The worker that has loaded the page.</param>
+        /// <param name="page">The native page.</param>
+        /// <param name="region">The region of the page to render, in the units used by the native page.</param>
+        /// <param name="pageBounds">The bounds of the page, as reported by <see cref="MuPDFPage.Bounds"/>.</param>
+        /// <param name="fzoom">The zoom factor to pass to the native rendering function.</param>
+        /// <param name="pageResult">The result for the page. Its <see cref="MuPDFBatchRenderResult.Size"/> has already been set.</param>
+        /// <returns>The exit code of the native rendering function.</returns>
+        private delegate ExitCodes PageProcessor(Worker worker, IntPtr page, Rectangle region, Rectangle pageBounds, float fzoom, MuPDFBatchRenderResult pageResult);
+
+        /// <summary>
+        /// Render a range of pages using all the workers.
+        /// </summary>
+        private IEnumerable<MuPDFBatchRenderResult> RenderPages(int firstPage, int pageCount, double zoom, PageProcessor processPage, CancellationToken cancellationToken)
+        {
+            return Run(firstPage, pageCount, (worker, pageNumber) => ProcessPage(worker, pageNumber, zoom, processPage), cancellationToken);
+        }
+
+        /// <summary>
+        /// Process a range of pages using all the workers.
+        /// </summary>
+        /// <typeparam name="T">The type of the result produced for each page.</typeparam>
+        /// <param name="firstPage">The number of the first page to process.</param>
+        /// <param name="pageCount">The number of pages to process.</param>
+        /// <param name="processPage">The method that processes a single page. This is called concurrently by the workers, and it must not throw exceptions.</param>
+        /// <param name="cancellationToken">A <see cref="CancellationToken"/> that can be used to abort the operation.</param>
+        private IEnumerable<T> Run<T>(int firstPage, int pageCount, Func<Worker, int, T> processPage, CancellationToken cancellationToken)
+        {
+            int state = Interlocked.CompareExchange(ref running, 1, 0);
+
+            if (state == 2)
+            {
+                throw new ObjectDisposedException(nameof(MuPDFBatchRenderer));
+            }
+            else if (state != 0)
+            {
+                throw new InvalidOperationException("The batch renderer is already processing another range of pages!");
+            }
+
+            using (CancellationTokenSource cancellation = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken))
+            using (BlockingCollection<T> results = new BlockingCollection<T>(this.MaxPendingResults))
+            {
+                CancellationToken workerToken = cancellation.Token;
+
+                int nextPage = firstPage - 1;
+                int activeWorkers = this.WorkerCount;
+
+                Thread[] threads = new Thread[this.WorkerCount];
+
+                //Abort the pages that are being rendered as soon as the enumeration is cancelled or abandoned.
+                CancellationTokenRegistration registration = workerToken.Register(() =>
+                {
+                    for (int i = 0; i < this.Workers.Length; i++)
+                    {
+                        AbortCookie(this.Workers[i].Cookie);
+                    }
+                });
+
+                try
+                {
+                    for (int i = 0; i < this.WorkerCount; i++)
+                    {
+                        Worker worker = this.Workers[i];
+
+                        threads[i] = new Thread(() =>
+                        {
+                            try
+                            {
+                                while (true)
+                                {
+                                    int pageNumber = Interlocked.Increment(ref nextPage);
+
+                                    if (pageNumber >= firstPage + pageCount || workerToken.IsCancellationRequested)
+                                    {
+                                        break;
+                                    }
+
+                                    //Blocks if the consumer is too far behind.
+                                    results.Add(processPage(worker, pageNumber), workerToken);
+                                }
+                            }
+                            catch (OperationCanceledException)
+                            {
+                            }
+                            finally
+                            {
+                                if (Interlocked.Decrement(ref activeWorkers) == 0)
+                                {
+                                    results.CompleteAdding();
+                                }
+                            }
+                        })
+                        {
+                            IsBackground = true,
+                            Name = "MuPDF batch render worker " + i.ToString()
+                        };
+
+                        threads[i].Start();
+                    }
+
+                    foreach (T result in results.GetConsumingEnumerable(cancellationToken))
+                    {
+                        yield return result;
+                    }
+                }
+                finally
+                {
+                    cancellation.Cancel();
+
+                    for (int i = 0; i < threads.Length; i++)
+                    {
+                        threads[i]?.Join();
+                    }
+
+                    registration.Dispose();
+
+                    Interlocked.Exchange(ref running, 0);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Signal to the native code that the operation using the specified cookie should be aborted.
+        /// </summary>
+        /// <param name="cookie">The cookie to signal.</param>
+        private static void AbortCookie(IntPtr cookie)
+        {
+            unsafe
+            {
+                ((Cookie*)cookie)->abort = 1;
+            }
+        }
+
+        /// <summary>
+        /// Load a page using the worker's document handle.
+        /// </summary>
+        /// <param name="worker">The worker whose document handle should be used.</param>
+        /// <param name="pageNumber">The number of the page to load.</param>
+        /// <param name="page">When this method returns, this contains the native page, which must be freed by the caller.</param>
+        /// <returns>The bounds of the page, as reported by <see cref="MuPDFPage.Bounds"/>.</returns>
+        private Rectangle LoadPage(Worker worker, int pageNumber, ref IntPtr page)
+        {
+            float x = 0;
+            float y = 0;
+            float w = 0;
+            float h = 0;
+
+            ExitCodes result = (ExitCodes)NativeMethods.LoadPage(worker.Context.NativeContext, worker.NativeDocument, pageNumber, ref page, ref x, ref y, ref w, ref h);
+
+            switch (result)
+            {
+                case ExitCodes.EXIT_SUCCESS:
+                    break;
+                case ExitCodes.ERR_CANNOT_LOAD_PAGE:
+                    throw new MuPDFException("Cannot load page", result);
+                case ExitCodes.ERR_CANNOT_COMPUTE_BOUNDS:
+                    throw new MuPDFException("Cannot compute bounds", result);
+                default:
+                    throw new MuPDFException("Unknown error", result);
+            }
+
+            //Same as MuPDFPage.Bounds.
+            double sX = Math.Round(x * Document.ImageXRes / 72.0 * 1000) / 1000;
+            double sY = Math.Round(y * Document.ImageYRes / 72.0 * 1000) / 1000;
+            double sW = Math.Round(w * Document.ImageXRes / 72.0 * 1000) / 1000;
+            double sH = Math.Round(h * Document.ImageYRes / 72.0 * 1000) / 1000;
+
+            return new Rectangle(sX, sY, sX + sW, sY + sH);
+        }
+
+        /// <summary>
+        /// Extract the text of a page using the worker's document handle. Any exception is stored in the result, rather than being thrown.
+        /// </summary>
+        private MuPDFBatchTextResult ExtractPageText(Worker worker, int pageNumber, UTF8EncodedString separator, StructuredTextFlags flags)
+        {
+            MuPDFBatchTextResult pageResult = new MuPDFBatchTextResult(pageNumber);
+
+            IntPtr page = IntPtr.Zero;
+            IntPtr buffer = IntPtr.Zero;
+
+            try
+            {
+                RenderingThread.ResetCookie(worker.Cookie);
+
+                LoadPage(worker, pageNumber, ref page);
+
+                IntPtr data = IntPtr.Zero;
+                ulong length = 0;
+
+                ExitCodes result = (ExitCodes)NativeMethods.ExtractPageTextUTF8(worker.Context.NativeContext, page, IncludeAnnotations ? 1 : 0, (int)flags, separator.Address, worker.Cookie, ref buffer, ref data, ref length);
+
+                switch (result)
+                {
+                    case ExitCodes.EXIT_SUCCESS:
+                        break;
+                    case ExitCodes.ERR_CANNOT_POPULATE_PAGE:
+                        throw new MuPDFException("Cannot populate page", result);
+                    case ExitCodes.ERR_CANNOT_CREATE_BUFFER:
+                        throw new MuPDFException("Cannot create the output buffer", result);
+                    default:
+                        throw new MuPDFException("Unknown error", result);
+                }
+
+                unsafe
+                {
+                    pageResult.Text = Encoding.UTF8.GetString((byte*)data, (int)length);
+                }
+            }
+            catch (Exception ex)
+            {
+                pageResult.Text = null;
+                pageResult.Error = ex;
+            }
+            finally
+            {
+                if (buffer != IntPtr.Zero)
+                {
+                    NativeMethods.DisposeBuffer(worker.Context.NativeContext, buffer);
+                }
+
+                if (page != IntPtr.Zero)
+                {
+                    NativeMethods.DisposePage(worker.Context.NativeContext, page);
+                }
+            }
+
+            return pageResult;
+        }
+
+        /// <summary>
+        /// Load a page using the worker's document handle and process it. Any exception is stored in the result, rather than being thrown.
+        /// </summary>
+        private MuPDFBatchRenderResult ProcessPage(Worker worker, int pageNumber, double zoom, PageProcessor processPage)
+        {
+            MuPDFBatchRenderResult pageResult = new MuPDFBatchRenderResult(pageNumber);
+
+            IntPtr page = IntPtr.Zero;
+
+            try
+            {
+                RenderingThread.ResetCookie(worker.Cookie);
+
+                Rectangle pageBounds = LoadPage(worker, pageNumber, ref page);
+
+                if (zoom * pageBounds.Width <= 0.001 || zoom * pageBounds.Height <= 0.001)
+                {
+                    throw new ArgumentOutOfRangeException(nameof(zoom), zoom, "The zoom factor is too small!");
+                }
+
+                RoundedRectangle roundedBounds = pageBounds.Round(zoom);
+                pageResult.Size = new RoundedSize(roundedBounds.Width, roundedBounds.Height);
+
+                Rectangle region = pageBounds;
+                double pageZoom = zoom;
+
+                if (Document.ImageXRes != 72 || Document.ImageYRes != 72)
+                {
+                    pageZoom *= Math.Sqrt(Document.ImageXRes * Document.ImageYRes) / 72;
+                    region = new Rectangle(region.X0 * 72 / Document.ImageXRes, region.Y0 * 72 / Document.ImageYRes, region.X1 * 72 / Document.ImageXRes, region.Y1 * 72 / Document.ImageYRes);
+                }
+
+                ExitCodes result = processPage(worker, page, region, pageBounds, (float)pageZoom, pageResult);
+
+                switch (result)
+                {
+                    case ExitCodes.EXIT_SUCCESS:
+                        break;
+                    case ExitCodes.ERR_CANNOT_RENDER:
+                        throw new MuPDFException("Cannot render page", result);
+                    case ExitCodes.ERR_CANNOT_CREATE_BUFFER:
+                        throw new MuPDFException("Cannot create the output buffer", result);
+                    case ExitCodes.ERR_CANNOT_SAVE:
+                        throw new MuPDFException("Cannot write the image", result);
+                    default:
+                        throw new MuPDFException("Unknown error", result);
+                }
+            }
+            catch (Exception ex)
+            {
+                pageResult.Data = null;
+                pageResult.Error = ex;
+            }
+            finally
+            {
+                if (page != IntPtr.Zero)
+                {
+                    NativeMethods.DisposePage(worker.Context.NativeContext, page);
+                }
+            }
+
+            return pageResult;
+        }
+
+        /// <summary>
+        /// Free the native resources used by the workers.
+        /// </summary>
+        private void DisposeWorkers()
+        {
+            for (int i = 0; i < this.Workers.Length; i++)
+            {
+                Worker worker = this.Workers[i];
+
+                if (worker.NativeDocument != IntPtr.Zero)
+                {
+                    NativeMethods.DisposeDocument(worker.Context.NativeContext, worker.NativeDocument);
+                    worker.NativeDocument = IntPtr.Zero;
+                }
+
+                if (worker.NativeStream != IntPtr.Zero)
+                {
+                    NativeMethods.DisposeStream(worker.Context.NativeContext, worker.NativeStream);
+                    worker.NativeStream = IntPtr.Zero;
+                }
+
+                if (worker.Cookie != IntPtr.Zero)
+                {
+                    Marshal.FreeHGlobal(worker.Cookie);
+                    worker.Cookie = IntPtr.Zero;
+                }
+
+                worker.Context.Dispose();
+            }
+        }
+
+        private bool disposedValue;
+
+        ///<inheritdoc/>
+        protected virtual void Dispose(bool disposing)
+        {
+            if (!disposedValue)
+            {
+                //The workers' native resources are in use while a range of pages is being processed, so they cannot be freed until the enumeration has been disposed.
+                if (Interlocked.CompareExchange(ref running, 2, 0) == 1)
+                {
+                    throw new InvalidOperationException("The batch renderer cannot be disposed while it is processing a range of pages! Dispose the enumeration of the results first.");
+                }
+
+                disposedValue = true;
+
+                if (disposing)
+                {
+                    DisposeWorkers();
+                }
+            }
+        }
+
+        ///<inheritdoc/>
+        /// <exception cref="InvalidOperationException">Thrown if the enumeration of the results of <see cref="Render(int, int, double, PixelFormats, CancellationToken)"/>, <see cref="WriteImages"/> or <see cref="ExtractText"/> is still in progress.</exception>
+        public void Dispose()
+        {
+            Dispose(disposing: true);
+            GC.SuppressFinalize(this);
+        }
+    }
+}
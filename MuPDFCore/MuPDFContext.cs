@@ -30,11 +30,21 @@ namespace MuPDFCore
         /// </summary>
         private MuPDFContext ParentContext { get; } = null;
 
+        /// <summary>
+        /// The context from which this context was (directly or indirectly) cloned, or this context if it is not a clone.
+        /// </summary>
+        internal MuPDFContext RootContext => this.ParentContext == null ? this : this.ParentContext.RootContext;
+
         /// <summary>
         /// A pointer to the native context object.
         /// </summary>
         internal readonly IntPtr NativeContext;
 
+        /// <summary>
+        /// The allocator used by the native context.
+        /// </summary>
+        public NativeAllocators Allocator { get; }
+
         /// <summary>
         /// The current size in bytes of the resource cache store. Read-only.
         /// </summary>
@@ -148,9 +158,18 @@ namespace MuPDFCore
         /// Create a new <see cref="MuPDFContext"/> instance with the specified cache store size.
         /// </summary>
         /// <param name="storeSize">The maximum size in bytes of the resource cache store. The default value is 256 MiB.</param>
-        public MuPDFContext(uint storeSize = 256 << 20)
+        public MuPDFContext(uint storeSize = 256 << 20) : this(storeSize, NativeAllocators.System) { }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFContext"/> instance with the specified cache store size, using the specified native allocator.
+        /// </summary>
+        /// <param name="storeSize">The maximum size in bytes of the resource cache store.</param>
+        /// <param name="allocator">The allocator used for all native allocations performed by this context (and by the contexts cloned from it).</param>
+        public MuPDFContext(uint storeSize, NativeAllocators allocator)
         {
-            ExitCodes result = (ExitCodes)NativeMethods.CreateContext((ulong)storeSize, ref NativeContext);
+            this.Allocator = allocator;
+
+            ExitCodes result = (ExitCodes)NativeMethods.CreateContextWithAllocator((ulong)storeSize, (int)allocator, ref NativeContext);
 
             switch (result)
             {
@@ -174,6 +193,16 @@ namespace MuPDFCore
         {
             this.NativeContext = nativeContext;
             this.ParentContext = parentContext;
+            this.Allocator = parentContext.Allocator;
+        }
+
+        /// <summary>
+        /// Return to the system the memory that the <see cref="NativeAllocators.Pool"/> allocator keeps cached for the calling thread (e.g., after a burst of renders).
+        /// Memory that is still in use is not affected, and the cache is also released automatically when a thread exits.
+        /// </summary>
+        public static void ReleasePooledMemory()
+        {
+            NativeMethods.ReleasePooledMemory();
         }
 
         /// <summary>
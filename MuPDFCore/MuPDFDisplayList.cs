@@ -35,9 +35,64 @@ namespace MuPDFCore
         readonly internal IntPtr NativeDisplayList;
 
         /// <summary>
-        /// The display list's bounds in page units. Read-only.
+        /// The horizontal resolution of the document, used to convert the bounds of the display list into page units.
         /// </summary>
-        public Rectangle Bounds { get; }
+        private readonly double XRes;
+
+        /// <summary>
+        /// The vertical resolution of the document, used to convert the bounds of the display list into page units.
+        /// </summary>
+        private readonly double YRes;
+
+        /// <summary>
+        /// Used to ensure that the bounds of the display list are only computed once.
+        /// </summary>
+        private readonly object BoundsLock = new object();
+
+        /// <summary>
+        /// The bounds of the display list, or <see langword="null"/> if they have not been computed yet.
+        /// </summary>
+        private Rectangle? bounds;
+
+        /// <summary>
+        /// The estimated size of the display list in bytes, excluding shared resources such as images and fonts.
+        /// </summary>
+        internal long Size { get; }
+
+        /// <summary>
+        /// Used to synchronise access to <see cref="PinCount"/> and <see cref="Evicted"/>.
+        /// </summary>
+        private readonly object PinLock = new object();
+
+        /// <summary>
+        /// The number of users of the display list that have not released it yet.
+        /// </summary>
+        private int PinCount;
+
+        /// <summary>
+        /// Whether the display list has been removed from the document's cache.
+        /// </summary>
+        private bool Evicted;
+
+        /// <summary>
+        /// Whether the display list is currently in use.
+        /// </summary>
+        internal bool IsPinned
+        {
+            get
+            {
+                lock (PinLock)
+                {
+                    return PinCount > 0;
+                }
+            }
+        }
+
+        /// <summary>
+        /// The display list's bounds in page units. Read-only. Computing the bounds requires running the whole display list,
+        /// thus this is only done the first time that they are needed.
+        /// </summary>
+        public Rectangle Bounds => GetBounds(OwnerContext.NativeContext);
 
         /// <summary>
         /// Create a new <see cref="MuPDFDisplayList"/> instance from the specified page.
@@ -48,13 +103,15 @@ namespace MuPDFCore
         public MuPDFDisplayList(MuPDFContext context, MuPDFPage page, bool includeAnnotations = true)
         {
             this.OwnerContext = context;
+            this.XRes = page.OwnerDocument.ImageXRes;
+            this.YRes = page.OwnerDocument.ImageYRes;
 
-            float x0 = 0;
-            float y0 = 0;
-            float x1 = 0;
-            float y1 = 0;
+            ExitCodes result = (ExitCodes)NativeMethods.CreateDisplayList(context.NativeContext, page.NativePage, includeAnnotations ? 1 : 0, ref NativeDisplayList);
 
-            ExitCodes result = (ExitCodes)NativeMethods.GetDisplayList(context.NativeContext, page.NativePage, includeAnnotations ? 1 : 0, ref NativeDisplayList, ref x0, ref y0, ref x1, ref y1);
+            if (result != ExitCodes.EXIT_SUCCESS)
+            {
+                page.OwnerDocument.ThrowIfInputFailed();
+            }
 
             switch (result)
             {
@@ -66,7 +123,91 @@ namespace MuPDFCore
                     throw new MuPDFException("Unknown error", result);
             }
 
-            this.Bounds = new Rectangle(Math.Round(x0 * page.OwnerDocument.ImageXRes / 72.0 * 1000) / 1000, Math.Round(y0 * page.OwnerDocument.ImageYRes / 72.0 * 1000) / 1000, Math.Round(x1 * page.OwnerDocument.ImageXRes / 72.0 * 1000) / 1000, Math.Round(y1 * page.OwnerDocument.ImageYRes / 72.0 * 1000) / 1000);
+            this.Size = (long)NativeMethods.GetDisplayListSize(context.NativeContext, NativeDisplayList);
+        }
+
+        /// <summary>
+        /// Signal that the display list is being used, so that it is not freed if it is evicted from the cache.
+        /// </summary>
+        internal void Pin()
+        {
+            lock (PinLock)
+            {
+                PinCount++;
+            }
+        }
+
+        /// <summary>
+        /// Signal that the display list is not being used any more. If the display list has been evicted from the cache and this was its last user, it is freed.
+        /// </summary>
+        internal void Unpin()
+        {
+            bool dispose;
+
+            lock (PinLock)
+            {
+                PinCount--;
+                dispose = Evicted && PinCount == 0;
+            }
+
+            if (dispose)
+            {
+                this.Dispose();
+            }
+        }
+
+        /// <summary>
+        /// Signal that the display list has been removed from the cache. The display list is freed immediately if it is not being used, or as soon as its last user releases it.
+        /// </summary>
+        internal void Evict()
+        {
+            bool dispose;
+
+            lock (PinLock)
+            {
+                Evicted = true;
+                dispose = PinCount == 0;
+            }
+
+            if (dispose)
+            {
+                this.Dispose();
+            }
+        }
+
+        /// <summary>
+        /// Get the display list's bounds in page units, computing them if this has not been done yet.
+        /// </summary>
+        /// <param name="nativeContext">The native context that should be used to compute the bounds. This must be the context that owns the document or one of its clones, and must not be in use by another thread.</param>
+        /// <returns>The display list's bounds in page units.</returns>
+        internal Rectangle GetBounds(IntPtr nativeContext)
+        {
+            lock (BoundsLock)
+            {
+                if (bounds == null)
+                {
+                    float x0 = 0;
+                    float y0 = 0;
+                    float x1 = 0;
+                    float y1 = 0;
+
+                    ExitCodes result = (ExitCodes)NativeMethods.GetDisplayListBounds(nativeContext, NativeDisplayList, ref x0, ref y0, ref x1, ref y1);
+
+                    switch (result)
+                    {
+                        case ExitCodes.EXIT_SUCCESS:
+                            break;
+                        case ExitCodes.ERR_CANNOT_COMPUTE_BOUNDS:
+                            throw new MuPDFException("Cannot compute bounds", result);
+                        default:
+                            throw new MuPDFException("Unknown error", result);
+                    }
+
+                    bounds = new Rectangle(Math.Round(x0 * XRes / 72.0 * 1000) / 1000, Math.Round(y0 * YRes / 72.0 * 1000) / 1000, Math.Round(x1 * XRes / 72.0 * 1000) / 1000, Math.Round(y1 * YRes / 72.0 * 1000) / 1000);
+                }
+
+                return bounds.Value;
+            }
         }
 
         private bool disposedValue;
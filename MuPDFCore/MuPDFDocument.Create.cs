@@ -1252,11 +1252,6 @@ namespace MuPDFCore
                     MuPDFDocument doc = pag.page.OwnerDocument;
                     int pageNum = pag.page.PageNumber;
 
-                    if (doc.DisplayLists[pageNum] == null)
-                    {
-                        doc.DisplayLists[pageNum] = new MuPDFDisplayList(doc.OwnerContext, doc.Pages[pageNum], includeAnnotations);
-                    }
-
                     Rectangle region = pag.region;
                     double zoom = pag.zoom;
 
@@ -1266,7 +1261,16 @@ namespace MuPDFCore
                         region = new Rectangle(region.X0 * 72 / pag.page.OwnerDocument.ImageXRes, region.Y0 * 72 / pag.page.OwnerDocument.ImageYRes, region.X1 * 72 / pag.page.OwnerDocument.ImageXRes, region.Y1 * 72 / pag.page.OwnerDocument.ImageYRes);
                     }
 
-                    result = (ExitCodes)NativeMethods.WriteSubDisplayListAsPage(context.NativeContext, doc.DisplayLists[pageNum].NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, (float)zoom, documentWriter);
+                    MuPDFDisplayList displayList = doc.Cache.GetDisplayList(pageNum, includeAnnotations);
+
+                    try
+                    {
+                        result = (ExitCodes)NativeMethods.WriteSubDisplayListAsPage(context.NativeContext, displayList.NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, (float)zoom, documentWriter);
+                    }
+                    finally
+                    {
+                        displayList.Unpin();
+                    }
 
                     switch (result)
                     {
@@ -17,8 +17,11 @@
 
 using MuPDFCore.StructuredText;
 using System;
+using System.Collections.Generic;
 using System.IO;
+using System.Runtime.ExceptionServices;
 using System.Runtime.InteropServices;
+using System.Security.Cryptography;
 using System.Text;
 using System.Threading;
 using System.Threading.Tasks;
@@ -90,13 +93,58 @@ namespace MuPDFCore
         /// A pointer to a native document object, cast to the PDF type.
         /// This may be <see cref="IntPtr.Zero"/> if the document is not a PDF document.
         /// </summary>
-        internal readonly IntPtr NativePDFDocument;
+        internal IntPtr NativePDFDocument;
 
         /// <summary>
         /// A pointer to the native stream that was used to create this document (if any).
         /// </summary>
         private readonly IntPtr NativeStream = IntPtr.Zero;
 
+        /// <summary>
+        /// A pointer to the native file mapping that was used to create this document (if any).
+        /// </summary>
+        private readonly IntPtr NativeMapping = IntPtr.Zero;
+
+        /// <summary>
+        /// The callback used by the native stream to read data from a managed <see cref="Stream"/> (if any).
+        /// </summary>
+        private readonly InputStreamCallback InputCallback = null;
+
+        /// <summary>
+        /// The name of the file from which the document was opened, or <see langword="null"/> if the document was not opened from a file.
+        /// </summary>
+        internal readonly string SourceFileName = null;
+
+        /// <summary>
+        /// The accelerator file that can be used to reopen the document, or <see langword="null"/> if there is none.
+        /// </summary>
+        internal readonly string AcceleratorFileName = null;
+
+        /// <summary>
+        /// The address of the data from which the document was opened, or <see cref="IntPtr.Zero"/> if the document was not opened from memory.
+        /// </summary>
+        internal readonly IntPtr SourceDataAddress = IntPtr.Zero;
+
+        /// <summary>
+        /// The number of bytes at <see cref="SourceDataAddress"/>.
+        /// </summary>
+        internal readonly ulong SourceDataLength = 0;
+
+        /// <summary>
+        /// The file type (as one of the <see cref="FileTypeMagics"/>) that was used to open the document from memory.
+        /// </summary>
+        internal readonly string SourceFileType = null;
+
+        /// <summary>
+        /// The password that was used to successfully unlock the document, if any.
+        /// </summary>
+        internal string UnlockPassword { get; private set; } = null;
+
+        /// <summary>
+        /// The page width, page height and font size that were last used to lay out the document, or <see langword="null"/> if the document still has the default layout (an A4 page with a font size of 11).
+        /// </summary>
+        internal (float Width, float Height, float Em)? LastLayout { get; private set; } = null;
+
         /// <summary>
         /// The number of pages in the document.
         /// </summary>
@@ -113,25 +161,101 @@ namespace MuPDFCore
         private GCHandle? DataHandle = null;
 
         /// <summary>
-        /// An array of <see cref="MuPDFDisplayList"/>, one for each page in the document.
+        /// The layout that will be applied when the pages are first needed, if the layout was deferred when the document was opened.
+        /// </summary>
+        private (float Width, float Height, float Em)? PendingLayout = null;
+
+        /// <summary>
+        /// The options used when a document is opened without specifying any.
+        /// </summary>
+        private static readonly MuPDFDocumentOpenOptions DefaultOpenOptions = new MuPDFDocumentOpenOptions();
+
+        /// <summary>
+        /// The incremental layout that is currently being computed (see <see cref="LayoutIncrementally"/>), or <see langword="null"/> if there is none.
+        /// </summary>
+        private MuPDFIncrementalLayout IncrementalLayout = null;
+
+        private MuPDFPageCollection pages;
+
+        /// <summary>
+        /// The pages contained in the document. If the pages were not counted when the document was opened (see <see cref="MuPDFDocumentOpenOptions"/>), they are counted the first time this is accessed.
+        /// While the document is being laid out incrementally (see <see cref="LayoutIncrementally"/>), this only contains the pages that have been counted so far, and it grows each time it is accessed.
         /// </summary>
-        internal MuPDFDisplayList[] DisplayLists;
+        public MuPDFPageCollection Pages
+        {
+            get
+            {
+                if (this.pages == null)
+                {
+                    this.LoadPages();
+                }
+                else if (this.IncrementalLayout != null)
+                {
+                    this.UpdateIncrementalPages();
+                }
+
+                return this.pages;
+            }
+        }
 
         /// <summary>
-        /// The pages contained in the document.
+        /// The cache holding the native pages and display lists that have been loaded from the document. Set its <see cref="MuPDFDocumentCache.MaxSize"/> to limit the amount of memory used when processing large documents.
         /// </summary>
-        public MuPDFPageCollection Pages { get; private set; }
+        public MuPDFDocumentCache Cache { get; private set; }
 
         /// <summary>
         /// Defines whether the images resulting from rendering operations should be clipped to the page boundaries.
         /// </summary>
         public bool ClipToPageBounds { get; set; } = true;
 
+        /// <summary>
+        /// Defines whether the images with an alpha channel (<see cref="PixelFormats.RGBA"/> or <see cref="PixelFormats.BGRA"/>) resulting from rendering operations should contain premultiplied colour values.
+        /// If this is <see langword="false"/> (the default), the colour values are converted to straight alpha after rendering; setting this to <see langword="true"/> skips this step.
+        /// </summary>
+        public bool PremultipliedAlpha { get; set; } = false;
+
+        /// <summary>
+        /// Defines whether rendering operations (<see cref="Render(int, Rectangle, double, PixelFormats, IntPtr, bool)"/>, <see cref="SaveImage(int, Rectangle, double, PixelFormats, string, RasterOutputFileTypes, bool)"/>, <see cref="WriteImage(int, Rectangle, double, PixelFormats, Stream, RasterOutputFileTypes, bool)"/>
+        /// and their overloads) should run the page directly into the renderer, instead of creating a display list and storing it in the <see cref="Cache"/>.
+        /// This is faster if each page is only rendered once (e.g., when creating thumbnails), but slower if the same page is rendered multiple times.
+        /// Multi-threaded rendering and text extraction always use display lists.
+        /// </summary>
+        public bool DirectRendering { get; set; } = false;
+
+        private int directRenderingBandHeight = 0;
+
+        /// <summary>
+        /// When <see cref="DirectRendering"/> is enabled, <see cref="Render(int, Rectangle, double, PixelFormats, IntPtr, bool)"/> and its overloads render the page in horizontal bands of this height (in pixels),
+        /// which reduces the amount of memory used by the renderer for large images, at the cost of processing the page once for each band. If this is 0 (the default), the whole region is rendered at once.
+        /// </summary>
+        public int DirectRenderingBandHeight
+        {
+            get
+            {
+                return directRenderingBandHeight;
+            }
+
+            set
+            {
+                if (value < 0)
+                {
+                    throw new ArgumentOutOfRangeException(nameof(value), value, "The band height must be greater than or equal to 0!");
+                }
+
+                directRenderingBandHeight = value;
+            }
+        }
+
         /// <summary>
         /// Describes the encryption state of the document.
         /// </summary>
         public EncryptionState EncryptionState { get; private set; }
 
+        /// <summary>
+        /// Describes whether an accelerator file was used or created when opening the document (see <see cref="MuPDFDocument(MuPDFContext, string, string)"/>).
+        /// </summary>
+        public AcceleratorState AcceleratorState { get; } = AcceleratorState.NotUsed;
+
         /// <summary>
         /// Describes the restriction state of the document.
         /// </summary>
@@ -191,7 +315,17 @@ namespace MuPDFCore
         /// <param name="dataAddress">A pointer to the data bytes that make up the document.</param>
         /// <param name="dataLength">The number of bytes to read from the specified address.</param>
         /// <param name="fileType">The type of the document to read.</param>
-        public MuPDFDocument(MuPDFContext context, IntPtr dataAddress, long dataLength, InputFileTypes fileType) : this(context, dataAddress, dataLength, fileType, ref NullDataHolder) { }
+        public MuPDFDocument(MuPDFContext context, IntPtr dataAddress, long dataLength, InputFileTypes fileType) : this(context, dataAddress, dataLength, fileType, ref NullDataHolder, null) { }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from data bytes accessible through the specified pointer, using the specified options.
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="dataAddress">A pointer to the data bytes that make up the document.</param>
+        /// <param name="dataLength">The number of bytes to read from the specified address.</param>
+        /// <param name="fileType">The type of the document to read.</param>
+        /// <param name="options">Options determining the initial layout of the document and when its pages are counted. If this is <see langword="null"/>, the default options are used.</param>
+        public MuPDFDocument(MuPDFContext context, IntPtr dataAddress, long dataLength, InputFileTypes fileType, MuPDFDocumentOpenOptions options) : this(context, dataAddress, dataLength, fileType, ref NullDataHolder, options) { }
 
         /// <summary>
         /// Create a new <see cref="MuPDFDocument"/> from data bytes accessible through the specified pointer.
@@ -201,7 +335,18 @@ namespace MuPDFCore
         /// <param name="dataLength">The number of bytes to read from the specified address.</param>
         /// <param name="fileType">The type of the document to read.</param>
         /// <param name="dataHolder">An <see cref="IDisposable"/> that will be disposed when the <see cref="MuPDFDocument"/> is disposed.</param>
-        public MuPDFDocument(MuPDFContext context, IntPtr dataAddress, long dataLength, InputFileTypes fileType, ref IDisposable dataHolder)
+        public MuPDFDocument(MuPDFContext context, IntPtr dataAddress, long dataLength, InputFileTypes fileType, ref IDisposable dataHolder) : this(context, dataAddress, dataLength, fileType, ref dataHolder, null) { }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from data bytes accessible through the specified pointer, using the specified options.
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="dataAddress">A pointer to the data bytes that make up the document.</param>
+        /// <param name="dataLength">The number of bytes to read from the specified address.</param>
+        /// <param name="fileType">The type of the document to read.</param>
+        /// <param name="dataHolder">An <see cref="IDisposable"/> that will be disposed when the <see cref="MuPDFDocument"/> is disposed.</param>
+        /// <param name="options">Options determining the initial layout of the document and when its pages are counted. If this is <see langword="null"/>, the default options are used.</param>
+        public MuPDFDocument(MuPDFContext context, IntPtr dataAddress, long dataLength, InputFileTypes fileType, ref IDisposable dataHolder, MuPDFDocumentOpenOptions options)
         {
             bool isImage = fileType == InputFileTypes.BMP || fileType == InputFileTypes.GIF || fileType == InputFileTypes.JPEG || fileType == InputFileTypes.PAM || fileType == InputFileTypes.PNG || fileType == InputFileTypes.PNM || fileType == InputFileTypes.TIFF;
 
@@ -210,249 +355,419 @@ namespace MuPDFCore
             float xRes = 0;
             float yRes = 0;
 
-            ExitCodes result = (ExitCodes)NativeMethods.CreateDocumentFromStream(context.NativeContext, dataAddress, (ulong)dataLength, FileTypeMagics[(int)fileType], isImage ? 1 : 0, ref NativeDocument, ref NativeStream, ref PageCount, ref xRes, ref yRes);
+            (options ?? DefaultOpenOptions).GetNativeLayout(out float layoutWidth, out float layoutHeight, out float layoutEm, out int countPages);
 
-            if (xRes > 72)
-            {
-                this.ImageXRes = xRes;
-            }
-            else
-            {
-                this.ImageXRes = 72;
-            }
+            ExitCodes result = (ExitCodes)NativeMethods.CreateDocumentFromStream(context.NativeContext, dataAddress, (ulong)dataLength, FileTypeMagics[(int)fileType], isImage ? 1 : 0, layoutWidth, layoutHeight, layoutEm, countPages, ref NativeDocument, ref NativeStream, ref PageCount, ref xRes, ref yRes);
 
-            if (yRes > 72)
-            {
-                this.ImageYRes = yRes;
-            }
-            else
-            {
-                this.ImageYRes = 72;
-            }
+            this.SourceDataAddress = dataAddress;
+            this.SourceDataLength = (ulong)dataLength;
+            this.SourceFileType = FileTypeMagics[(int)fileType];
 
             this.DataHolder = dataHolder;
 
-            switch (result)
-            {
-                case ExitCodes.EXIT_SUCCESS:
-                    break;
-                case ExitCodes.ERR_CANNOT_OPEN_STREAM:
-                    throw new MuPDFException("Cannot open data stream", result);
-                case ExitCodes.ERR_CANNOT_OPEN_FILE:
-                    throw new MuPDFException("Cannot open document", result);
-                case ExitCodes.ERR_CANNOT_COUNT_PAGES:
-                    throw new MuPDFException("Cannot count pages", result);
-                default:
-                    throw new MuPDFException("Unknown error", result);
-            }
+            InitialiseDocument(result, xRes, yRes, options);
+        }
 
-            if (NativeMethods.CheckIfPasswordNeeded(context.NativeContext, this.NativeDocument) != 0)
-            {
-                this.EncryptionState = EncryptionState.Encrypted;
-            }
-            else
-            {
-                this.EncryptionState = EncryptionState.Unencrypted;
-            }
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from an array of bytes.
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="data">An array containing the data bytes that make up the document. This must not be altered until after the <see cref="MuPDFDocument"/> has been disposed!
+        /// The address of the array will be pinned, which may cause degradation in the Garbage Collector's performance, and is thus only advised for short-lived documents. To avoid this issue, marshal the bytes to unmanaged memory and use one of the <see cref="IntPtr"/> constructors.</param>
+        /// <param name="fileType">The type of the document to read.</param>
+        public MuPDFDocument(MuPDFContext context, byte[] data, InputFileTypes fileType) : this(context, data, fileType, null) { }
 
-            int permissions = NativeMethods.GetPermissions(context.NativeContext, this.NativeDocument);
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from an array of bytes, using the specified options.
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="data">An array containing the data bytes that make up the document. This must not be altered until after the <see cref="MuPDFDocument"/> has been disposed!
+        /// The address of the array will be pinned, which may cause degradation in the Garbage Collector's performance, and is thus only advised for short-lived documents. To avoid this issue, marshal the bytes to unmanaged memory and use one of the <see cref="IntPtr"/> constructors.</param>
+        /// <param name="fileType">The type of the document to read.</param>
+        /// <param name="options">Options determining the initial layout of the document and when its pages are counted. If this is <see langword="null"/>, the default options are used.</param>
+        public MuPDFDocument(MuPDFContext context, byte[] data, InputFileTypes fileType, MuPDFDocumentOpenOptions options)
+        {
+            bool isImage = fileType == InputFileTypes.BMP || fileType == InputFileTypes.GIF || fileType == InputFileTypes.JPEG || fileType == InputFileTypes.PAM || fileType == InputFileTypes.PNG || fileType == InputFileTypes.PNM || fileType == InputFileTypes.TIFF;
 
-            int restrictions = 0;
+            this.OwnerContext = context;
 
-            if ((permissions & 1) == 0)
-            {
-                restrictions |= 1;
-            }
+            DataHandle = GCHandle.Alloc(data, GCHandleType.Pinned);
+            IntPtr dataAddress = DataHandle.Value.AddrOfPinnedObject();
+            ulong dataLength = (ulong)data.Length;
 
-            if ((permissions & 2) == 0)
+            float xRes = 0;
+            float yRes = 0;
+
+            (options ?? DefaultOpenOptions).GetNativeLayout(out float layoutWidth, out float layoutHeight, out float layoutEm, out int countPages);
+
+            ExitCodes result = (ExitCodes)NativeMethods.CreateDocumentFromStream(context.NativeContext, dataAddress, dataLength, FileTypeMagics[(int)fileType], isImage ? 1 : 0, layoutWidth, layoutHeight, layoutEm, countPages, ref NativeDocument, ref NativeStream, ref PageCount, ref xRes, ref yRes);
+
+            this.SourceDataAddress = dataAddress;
+            this.SourceDataLength = dataLength;
+            this.SourceFileType = FileTypeMagics[(int)fileType];
+
+            InitialiseDocument(result, xRes, yRes, options);
+        }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from a <see cref="MemoryStream"/>.
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="data">The <see cref="MemoryStream"/> containing the data that makes up the document. This will be disposed when the <see cref="MuPDFDocument"/> has been disposed and must not be disposed externally!
+        /// The address of the <see cref="MemoryStream"/>'s buffer will be pinned, which may cause degradation in the Garbage Collector's performance, and is thus only advised for short-lived documents. To avoid this issue, marshal the bytes to unmanaged memory and use one of the <see cref="IntPtr"/> constructors.</param>
+        /// <param name="fileType">The type of the document to read.</param>
+        public MuPDFDocument(MuPDFContext context, ref MemoryStream data, InputFileTypes fileType) : this(context, ref data, fileType, null) { }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from a <see cref="MemoryStream"/>, using the specified options.
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="data">The <see cref="MemoryStream"/> containing the data that makes up the document. This will be disposed when the <see cref="MuPDFDocument"/> has been disposed and must not be disposed externally!
+        /// The address of the <see cref="MemoryStream"/>'s buffer will be pinned, which may cause degradation in the Garbage Collector's performance, and is thus only advised for short-lived documents. To avoid this issue, marshal the bytes to unmanaged memory and use one of the <see cref="IntPtr"/> constructors.</param>
+        /// <param name="fileType">The type of the document to read.</param>
+        /// <param name="options">Options determining the initial layout of the document and when its pages are counted. If this is <see langword="null"/>, the default options are used.</param>
+        public MuPDFDocument(MuPDFContext context, ref MemoryStream data, InputFileTypes fileType, MuPDFDocumentOpenOptions options)
+        {
+            bool isImage = fileType == InputFileTypes.BMP || fileType == InputFileTypes.GIF || fileType == InputFileTypes.JPEG || fileType == InputFileTypes.PAM || fileType == InputFileTypes.PNG || fileType == InputFileTypes.PNM || fileType == InputFileTypes.TIFF;
+
+            this.OwnerContext = context;
+
+            int origin = (int)data.Seek(0, SeekOrigin.Begin);
+            ulong dataLength = (ulong)data.Length;
+            byte[] dataBytes = data.GetBuffer();
+
+            DataHandle = GCHandle.Alloc(dataBytes, GCHandleType.Pinned);
+            IntPtr dataAddress = IntPtr.Add(DataHandle.Value.AddrOfPinnedObject(), origin);
+
+            DataHolder = data;
+
+            float xRes = 0;
+            float yRes = 0;
+
+            (options ?? DefaultOpenOptions).GetNativeLayout(out float layoutWidth, out float layoutHeight, out float layoutEm, out int countPages);
+
+            ExitCodes result = (ExitCodes)NativeMethods.CreateDocumentFromStream(context.NativeContext, dataAddress, dataLength, FileTypeMagics[(int)fileType], isImage ? 1 : 0, layoutWidth, layoutHeight, layoutEm, countPages, ref NativeDocument, ref NativeStream, ref PageCount, ref xRes, ref yRes);
+
+            this.SourceDataAddress = dataAddress;
+            this.SourceDataLength = dataLength;
+            this.SourceFileType = FileTypeMagics[(int)fileType];
+
+            InitialiseDocument(result, xRes, yRes, options);
+        }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from a seekable <see cref="Stream"/>, without loading the whole stream in memory. The data is read on demand in blocks of
+        /// <paramref name="blockSize"/> bytes, and at most <paramref name="maxCachedBlocks"/> blocks are kept in memory; thus, only the parts of the document that are actually
+        /// used (e.g. the objects making up the pages that are rendered) are read. This is useful e.g. for large files, or for streams whose data is fetched from a remote server.
+        /// Image files are always read in full when the document is opened, because they are decoded as a whole; the resolution of the image is read from its header.
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="stream">The <see cref="Stream"/> containing the data that makes up the document. This must be readable and seekable, and its contents must not change while the document is open.</param>
+        /// <param name="fileType">The type of the document to read.</param>
+        /// <param name="leaveOpen">If this is <see langword="false"/>, the <paramref name="stream"/> is disposed when the <see cref="MuPDFDocument"/> is disposed. Otherwise, the <paramref name="stream"/> must be kept open while the document is in use, and disposed externally.</param>
+        /// <param name="blockSize">The size in bytes of each block that is read from the <paramref name="stream"/>.</param>
+        /// <param name="maxCachedBlocks">The maximum number of blocks that are kept in memory.</param>
+        /// <param name="options">Options determining the initial layout of the document and when its pages are counted. If this is <see langword="null"/>, the default options are used.</param>
+        public MuPDFDocument(MuPDFContext context, Stream stream, InputFileTypes fileType, bool leaveOpen = false, int blockSize = 65536, int maxCachedBlocks = 64, MuPDFDocumentOpenOptions options = null)
+        {
+            if (stream == null)
             {
-                restrictions |= 2;
+                throw new ArgumentNullException(nameof(stream));
             }
 
-            if ((permissions & 4) == 0)
+            if (!stream.CanRead || !stream.CanSeek)
             {
-                restrictions |= 4;
+                throw new ArgumentException("The stream must be readable and seekable!", nameof(stream));
             }
 
-            if ((permissions & 8) == 0)
+            if (blockSize <= 0)
             {
-                restrictions |= 8;
+                throw new ArgumentOutOfRangeException(nameof(blockSize), blockSize, "The block size must be greater than 0!");
             }
 
-            if (restrictions == 0)
+            if (maxCachedBlocks <= 0)
             {
-                this.Restrictions = DocumentRestrictions.None;
-                this.RestrictionState = RestrictionState.Unrestricted;
+                throw new ArgumentOutOfRangeException(nameof(maxCachedBlocks), maxCachedBlocks, "The maximum number of cached blocks must be greater than 0!");
             }
-            else
+
+            bool isImage = fileType == InputFileTypes.BMP || fileType == InputFileTypes.GIF || fileType == InputFileTypes.JPEG || fileType == InputFileTypes.PAM || fileType == InputFileTypes.PNG || fileType == InputFileTypes.PNM || fileType == InputFileTypes.TIFF;
+
+            this.OwnerContext = context;
+
+            //The delegate must stay alive until the native stream is disposed.
+            this.InputCallback = new InputStreamCallback(stream);
+
+            if (!leaveOpen)
             {
-                this.Restrictions = (DocumentRestrictions)restrictions;
-                this.RestrictionState = RestrictionState.Restricted;
+                this.DataHolder = stream;
             }
 
-            Pages = new MuPDFPageCollection(context, this, PageCount);
-            DisplayLists = new MuPDFDisplayList[PageCount];
+            (options ?? DefaultOpenOptions).GetNativeLayout(out float layoutWidth, out float layoutHeight, out float layoutEm, out int countPages);
 
-            IntPtr pdfDocument = IntPtr.Zero;
-            result = (ExitCodes)NativeMethods.GetPDFDocument(context.NativeContext, this.NativeDocument, ref pdfDocument);
+            float xRes = 0;
+            float yRes = 0;
 
-            switch (result)
+            ExitCodes result = (ExitCodes)NativeMethods.CreateDocumentFromCallbackStream(context.NativeContext, this.InputCallback.Callback, stream.Length, blockSize, maxCachedBlocks, FileTypeMagics[(int)fileType], isImage ? 1 : 0, layoutWidth, layoutHeight, layoutEm, countPages, ref NativeDocument, ref NativeStream, ref PageCount, ref xRes, ref yRes);
+
+            if (result != ExitCodes.EXIT_SUCCESS)
             {
-                case ExitCodes.EXIT_SUCCESS:
-                    this.NativePDFDocument = pdfDocument;
-                    break;
-                case ExitCodes.ERR_CANNOT_CONVERT_TO_PDF:
-                    this.NativePDFDocument = IntPtr.Zero;
-                    break;
-                default:
-                    throw new MuPDFException("Unknown error", result);
+                this.ThrowIfInputFailed();
             }
+
+            InitialiseDocument(result, xRes, yRes, options);
         }
 
         /// <summary>
-        /// Create a new <see cref="MuPDFDocument"/> from an array of bytes.
+        /// Create a new <see cref="MuPDFDocument"/> from a file.
         /// </summary>
         /// <param name="context">The context that will own this document.</param>
-        /// <param name="data">An array containing the data bytes that make up the document. This must not be altered until after the <see cref="MuPDFDocument"/> has been disposed!
-        /// The address of the array will be pinned, which may cause degradation in the Garbage Collector's performance, and is thus only advised for short-lived documents. To avoid this issue, marshal the bytes to unmanaged memory and use one of the <see cref="IntPtr"/> constructors.</param>
-        /// <param name="fileType">The type of the document to read.</param>
-        public MuPDFDocument(MuPDFContext context, byte[] data, InputFileTypes fileType)
+        /// <param name="fileName">The path to the file to open.</param>
+        public MuPDFDocument(MuPDFContext context, string fileName) : this(context, fileName, null) { }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from a file, using an accelerator cache to speed up opening it. The first time a file is opened, an accelerator
+        /// file is saved in the <paramref name="acceleratorCacheDirectory"/>; the following times, the document is opened using the accelerator, which avoids laying out
+        /// the whole document again to count its pages. Only EPUB documents support accelerators; other document types (including PDF) are opened normally, and
+        /// <see cref="AcceleratorState"/> is <see cref="AcceleratorState.NotUsed"/>. Accelerator files are named after the length and last modification time of the file
+        /// and a hash of its first and last megabyte, so they are not used for a file that has been modified. Use <see cref="AcceleratorState"/> to determine whether the
+        /// accelerator was used.
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="fileName">The path to the file to open.</param>
+        /// <param name="acceleratorCacheDirectory">The directory where the accelerator files are stored. This is created if it does not exist. If this is <see langword="null"/>, no accelerator is used.</param>
+        public MuPDFDocument(MuPDFContext context, string fileName, string acceleratorCacheDirectory) : this(context, fileName, acceleratorCacheDirectory, null) { }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from a file, using the specified options and optionally an accelerator cache (see <see cref="MuPDFDocument(MuPDFContext, string, string)"/>).
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="fileName">The path to the file to open.</param>
+        /// <param name="acceleratorCacheDirectory">The directory where the accelerator files are stored. This is created if it does not exist. If this is <see langword="null"/>, no accelerator is used.</param>
+        /// <param name="options">Options determining the initial layout of the document and when its pages are counted. If this is <see langword="null"/>, the default options are used.</param>
+        public MuPDFDocument(MuPDFContext context, string fileName, string acceleratorCacheDirectory, MuPDFDocumentOpenOptions options) : this(context, fileName, acceleratorCacheDirectory, options, false) { }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from a file, optionally mapping the file in memory (read-only) rather than reading it through a file stream.
+        /// With a memory-mapped file, the data is read directly from the operating system's page cache when it is needed, without copies and without having to load the
+        /// whole file in memory; this is useful for very large documents. The mapping is released when the <see cref="MuPDFDocument"/> is disposed. The file should not be
+        /// modified while the document is open.
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="fileName">The path to the file to open.</param>
+        /// <param name="memoryMapped">If this is <see langword="true"/>, the file is mapped in memory. Otherwise, this is equivalent to <see cref="MuPDFDocument(MuPDFContext, string, string, MuPDFDocumentOpenOptions)"/>.</param>
+        /// <param name="options">Options determining the initial layout of the document and when its pages are counted. If this is <see langword="null"/>, the default options are used.</param>
+        public MuPDFDocument(MuPDFContext context, string fileName, bool memoryMapped, MuPDFDocumentOpenOptions options = null) : this(context, fileName, (string)null, options, memoryMapped) { }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocument"/> from a file, either mapping it in memory or reading it through a file stream (optionally with an accelerator cache).
+        /// </summary>
+        /// <param name="context">The context that will own this document.</param>
+        /// <param name="fileName">The path to the file to open.</param>
+        /// <param name="acceleratorCacheDirectory">The directory where the accelerator files are stored, or <see langword="null"/> if no accelerator should be used. This is ignored if <paramref name="memoryMapped"/> is <see langword="true"/>.</param>
+        /// <param name="options">Options determining the initial layout of the document and when its pages are counted. If this is <see langword="null"/>, the default options are used.</param>
+        /// <param name="memoryMapped">If this is <see langword="true"/>, the file is mapped in memory.</param>
+        private MuPDFDocument(MuPDFContext context, string fileName, string acceleratorCacheDirectory, MuPDFDocumentOpenOptions options, bool memoryMapped)
         {
-            bool isImage = fileType == InputFileTypes.BMP || fileType == InputFileTypes.GIF || fileType == InputFileTypes.JPEG || fileType == InputFileTypes.PAM || fileType == InputFileTypes.PNG || fileType == InputFileTypes.PNM || fileType == InputFileTypes.TIFF;
+            bool isImage = IsImageFileName(fileName);
 
             this.OwnerContext = context;
 
-            DataHandle = GCHandle.Alloc(data, GCHandleType.Pinned);
-            IntPtr dataAddress = DataHandle.Value.AddrOfPinnedObject();
-            ulong dataLength = (ulong)data.Length;
-
             float xRes = 0;
             float yRes = 0;
 
-            ExitCodes result = (ExitCodes)NativeMethods.CreateDocumentFromStream(context.NativeContext, dataAddress, dataLength, FileTypeMagics[(int)fileType], isImage ? 1 : 0, ref NativeDocument, ref NativeStream, ref PageCount, ref xRes, ref yRes);
+            (options ?? DefaultOpenOptions).GetNativeLayout(out float layoutWidth, out float layoutHeight, out float layoutEm, out int countPages);
 
-            if (xRes > 72)
+            ExitCodes result;
+
+            if (memoryMapped)
             {
-                this.ImageXRes = xRes;
+                IntPtr data = IntPtr.Zero;
+                ulong length = 0;
+
+                using (UTF8EncodedString encodedFileName = new UTF8EncodedString(fileName))
+                {
+                    result = (ExitCodes)NativeMethods.CreateDocumentFromMappedFile(context.NativeContext, encodedFileName.Address, isImage ? 1 : 0, layoutWidth, layoutHeight, layoutEm, countPages, ref NativeDocument, ref NativeStream, ref PageCount, ref xRes, ref yRes, ref NativeMapping, ref data, ref length);
+                }
+
+                //The batch renderer can reopen the document from the same mapping.
+                this.SourceDataAddress = data;
+                this.SourceDataLength = length;
+                this.SourceFileType = fileName;
             }
-            else
+            else if (acceleratorCacheDirectory == null)
             {
-                this.ImageXRes = 72;
-            }
+                int acceleratorState = 0;
 
-            if (yRes > 72)
-            {
-                this.ImageYRes = yRes;
+                using (UTF8EncodedString encodedFileName = new UTF8EncodedString(fileName))
+                {
+                    result = (ExitCodes)NativeMethods.CreateDocumentFromFileWithAccelerator(context.NativeContext, encodedFileName.Address, IntPtr.Zero, isImage ? 1 : 0, layoutWidth, layoutHeight, layoutEm, countPages, ref NativeDocument, ref PageCount, ref xRes, ref yRes, ref acceleratorState);
+                }
             }
             else
             {
-                this.ImageYRes = 72;
-            }
+                Directory.CreateDirectory(acceleratorCacheDirectory);
+                string acceleratorFileName = Path.Combine(acceleratorCacheDirectory, GetAcceleratorName(fileName));
 
-            switch (result)
-            {
-                case ExitCodes.EXIT_SUCCESS:
-                    break;
-                case ExitCodes.ERR_CANNOT_OPEN_STREAM:
-                    throw new MuPDFException("Cannot open data stream", result);
-                case ExitCodes.ERR_CANNOT_OPEN_FILE:
-                    throw new MuPDFException("Cannot open document", result);
-                case ExitCodes.ERR_CANNOT_COUNT_PAGES:
-                    throw new MuPDFException("Cannot count pages", result);
-                default:
-                    throw new MuPDFException("Unknown error", result);
-            }
+                int acceleratorState = 0;
 
-            if (NativeMethods.CheckIfPasswordNeeded(context.NativeContext, this.NativeDocument) != 0)
-            {
-                this.EncryptionState = EncryptionState.Encrypted;
+                using (UTF8EncodedString encodedFileName = new UTF8EncodedString(fileName))
+                using (UTF8EncodedString encodedAcceleratorFileName = new UTF8EncodedString(acceleratorFileName))
+                {
+                    result = (ExitCodes)NativeMethods.CreateDocumentFromFileWithAccelerator(context.NativeContext, encodedFileName.Address, encodedAcceleratorFileName.Address, isImage ? 1 : 0, layoutWidth, layoutHeight, layoutEm, countPages, ref NativeDocument, ref PageCount, ref xRes, ref yRes, ref acceleratorState);
+                }
+
+                this.AcceleratorState = (AcceleratorState)acceleratorState;
+
+                if (this.AcceleratorState != AcceleratorState.NotUsed)
+                {
+                    this.AcceleratorFileName = acceleratorFileName;
+                }
             }
-            else
+
+            if (!memoryMapped)
             {
-                this.EncryptionState = EncryptionState.Unencrypted;
+                this.SourceFileName = fileName;
             }
 
-            int permissions = NativeMethods.GetPermissions(context.NativeContext, this.NativeDocument);
+            InitialiseDocument(result, xRes, yRes, options);
+        }
 
-            int restrictions = 0;
+        /// <summary>
+        /// Determines whether a file should be opened as an image, based on its extension.
+        /// </summary>
+        /// <param name="fileName">The path to the file.</param>
+        /// <returns><see langword="true"/> if the file extension corresponds to an image format.</returns>
+        private static bool IsImageFileName(string fileName)
+        {
+            bool isImage;
 
-            if ((permissions & 1) == 0)
-            {
-                restrictions |= 1;
-            }
+            string extension = Path.GetExtension(fileName).ToLowerInvariant();
 
-            if ((permissions & 2) == 0)
+            switch (extension)
             {
-                restrictions |= 2;
-            }
+                case ".bmp":
+                case ".dib":
 
-            if ((permissions & 4) == 0)
-            {
-                restrictions |= 4;
-            }
+                case ".gif":
 
-            if ((permissions & 8) == 0)
-            {
-                restrictions |= 8;
-            }
+                case ".jpg":
+                case ".jpeg":
+                case ".jpe":
+                case ".jif":
+                case ".jfif":
+                case ".jfi":
 
-            if (restrictions == 0)
-            {
-                this.Restrictions = DocumentRestrictions.None;
-                this.RestrictionState = RestrictionState.Unrestricted;
-            }
-            else
-            {
-                this.Restrictions = (DocumentRestrictions)restrictions;
-                this.RestrictionState = RestrictionState.Restricted;
+                case ".pam":
+                case ".pbm":
+                case ".pgm":
+                case ".ppm":
+                case ".pnm":
+
+                case ".png":
+
+                case ".tif":
+                case ".tiff":
+                    isImage = true;
+                    break;
+                default:
+                    isImage = false;
+                    break;
             }
 
-            Pages = new MuPDFPageCollection(context, this, PageCount);
-            DisplayLists = new MuPDFDisplayList[PageCount];
+            return isImage;
+        }
 
-            IntPtr pdfDocument = IntPtr.Zero;
-            result = (ExitCodes)NativeMethods.GetPDFDocument(context.NativeContext, this.NativeDocument, ref pdfDocument);
+        /// <summary>
+        /// Computes the name of the accelerator file for a document. To keep opening large files fast, the hash only covers the length of the file, its last modification time,
+        /// and its first and last megabyte, rather than the whole file. The modification time ensures that a file that has been edited in the middle does not reuse a stale accelerator.
+        /// </summary>
+        /// <param name="fileName">The path to the document.</param>
+        /// <returns>The name of the accelerator file.</returns>
+        private static string GetAcceleratorName(string fileName)
+        {
+            const int chunkSize = 1 << 20;
 
-            switch (result)
+            using (FileStream stream = new FileStream(fileName, FileMode.Open, FileAccess.Read, FileShare.ReadWrite))
+            using (SHA256 sha = SHA256.Create())
             {
-                case ExitCodes.EXIT_SUCCESS:
-                    this.NativePDFDocument = pdfDocument;
-                    break;
-                case ExitCodes.ERR_CANNOT_CONVERT_TO_PDF:
-                    this.NativePDFDocument = IntPtr.Zero;
-                    break;
-                default:
-                    throw new MuPDFException("Unknown error", result);
+                long length = stream.Length;
+                byte[] buffer = new byte[(int)Math.Min(length, 2 * chunkSize)];
+
+                int firstCount = (int)Math.Min(length, chunkSize);
+                ReadFully(stream, buffer, 0, firstCount);
+
+                if (length > firstCount)
+                {
+                    int lastCount = (int)Math.Min(length - firstCount, chunkSize);
+                    stream.Seek(length - lastCount, SeekOrigin.Begin);
+                    ReadFully(stream, buffer, firstCount, lastCount);
+                }
+
+                sha.TransformBlock(BitConverter.GetBytes(length), 0, 8, null, 0);
+                sha.TransformBlock(BitConverter.GetBytes(File.GetLastWriteTimeUtc(fileName).Ticks), 0, 8, null, 0);
+                sha.TransformFinalBlock(buffer, 0, buffer.Length);
+
+                StringBuilder builder = new StringBuilder(sha.Hash.Length * 2 + 6);
+
+                for (int i = 0; i < sha.Hash.Length; i++)
+                {
+                    builder.Append(sha.Hash[i].ToString("x2"));
+                }
+
+                builder.Append(".accel");
+
+                return builder.ToString();
             }
         }
 
         /// <summary>
-        /// Create a new <see cref="MuPDFDocument"/> from a <see cref="MemoryStream"/>.
+        /// Reads exactly <paramref name="count"/> bytes from a <see cref="Stream"/>.
         /// </summary>
-        /// <param name="context">The context that will own this document.</param>
-        /// <param name="data">The <see cref="MemoryStream"/> containing the data that makes up the document. This will be disposed when the <see cref="MuPDFDocument"/> has been disposed and must not be disposed externally!
-        /// The address of the <see cref="MemoryStream"/>'s buffer will be pinned, which may cause degradation in the Garbage Collector's performance, and is thus only advised for short-lived documents. To avoid this issue, marshal the bytes to unmanaged memory and use one of the <see cref="IntPtr"/> constructors.</param>
-        /// <param name="fileType">The type of the document to read.</param>
-        public MuPDFDocument(MuPDFContext context, ref MemoryStream data, InputFileTypes fileType)
+        private static void ReadFully(Stream stream, byte[] buffer, int offset, int count)
         {
-            bool isImage = fileType == InputFileTypes.BMP || fileType == InputFileTypes.GIF || fileType == InputFileTypes.JPEG || fileType == InputFileTypes.PAM || fileType == InputFileTypes.PNG || fileType == InputFileTypes.PNM || fileType == InputFileTypes.TIFF;
-
-            this.OwnerContext = context;
-
-            int origin = (int)data.Seek(0, SeekOrigin.Begin);
-            ulong dataLength = (ulong)data.Length;
-            byte[] dataBytes = data.GetBuffer();
+            while (count > 0)
+            {
+                int read = stream.Read(buffer, offset, count);
 
-            DataHandle = GCHandle.Alloc(dataBytes, GCHandleType.Pinned);
-            IntPtr dataAddress = IntPtr.Add(DataHandle.Value.AddrOfPinnedObject(), origin);
+                if (read <= 0)
+                {
+                    throw new EndOfStreamException();
+                }
 
-            DataHolder = data;
+                offset += read;
+                count -= read;
+            }
+        }
 
-            float xRes = 0;
-            float yRes = 0;
+        /// <summary>
+        /// Discard all the display lists that have been loaded from the document, possibly freeing some memory in the case of a huge document.
+        /// Display lists that are currently in use (e.g., by a <see cref="MuPDFMultiThreadedPageRenderer"/>) are freed as soon as they are no longer needed.
+        /// </summary>
+        public void ClearCache()
+        {
+            Cache.ClearDisplayLists();
+        }
 
-            ExitCodes result = (ExitCodes)NativeMethods.CreateDocumentFromStream(context.NativeContext, dataAddress, dataLength, FileTypeMagics[(int)fileType], isImage ? 1 : 0, ref NativeDocument, ref NativeStream, ref PageCount, ref xRes, ref yRes);
+        /// <summary>
+        /// If the document was opened from a <see cref="Stream"/> and reading from it failed during a native call, rethrow the exception that caused the failure.
+        /// This should be called after the native calls that may read data from the document (e.g., loading pages or display lists, laying out the document, or rendering directly from a page);
+        /// for calls that create a native object, it should only be called if the call failed, so that the object is not leaked.
+        /// </summary>
+        internal void ThrowIfInputFailed()
+        {
+            this.InputCallback?.ThrowIfFailed();
+        }
 
+        /// <summary>
+        /// Completes the initialisation of the document after it has been opened by one of the constructors: checks the result of the native call, and sets up the image resolution,
+        /// the encryption and restriction state, the cache, the pages and the PDF document.
+        /// </summary>
+        /// <param name="result">The result of the native call that opened the document.</param>
+        /// <param name="xRes">The horizontal resolution of the image (if the document is an image), or 0.</param>
+        /// <param name="yRes">The vertical resolution of the image (if the document is an image), or 0.</param>
+        /// <param name="options">The options that were used to open the document.</param>
+        private void InitialiseDocument(ExitCodes result, float xRes, float yRes, MuPDFDocumentOpenOptions options)
+        {
             if (xRes > 72)
             {
                 this.ImageXRes = xRes;
@@ -471,7 +786,6 @@ namespace MuPDFCore
                 this.ImageYRes = 72;
             }
 
-
             switch (result)
             {
                 case ExitCodes.EXIT_SUCCESS:
@@ -486,7 +800,7 @@ namespace MuPDFCore
                     throw new MuPDFException("Unknown error", result);
             }
 
-            if (NativeMethods.CheckIfPasswordNeeded(context.NativeContext, this.NativeDocument) != 0)
+            if (NativeMethods.CheckIfPasswordNeeded(this.OwnerContext.NativeContext, this.NativeDocument) != 0)
             {
                 this.EncryptionState = EncryptionState.Encrypted;
             }
@@ -495,7 +809,7 @@ namespace MuPDFCore
                 this.EncryptionState = EncryptionState.Unencrypted;
             }
 
-            int permissions = NativeMethods.GetPermissions(context.NativeContext, this.NativeDocument);
+            int permissions = NativeMethods.GetPermissions(this.OwnerContext.NativeContext, this.NativeDocument);
 
             int restrictions = 0;
 
@@ -530,11 +844,11 @@ namespace MuPDFCore
                 this.RestrictionState = RestrictionState.Restricted;
             }
 
-            Pages = new MuPDFPageCollection(context, this, PageCount);
-            DisplayLists = new MuPDFDisplayList[PageCount];
+            Cache = new MuPDFDocumentCache(this);
+            InitialisePages(options);
 
             IntPtr pdfDocument = IntPtr.Zero;
-            result = (ExitCodes)NativeMethods.GetPDFDocument(context.NativeContext, this.NativeDocument, ref pdfDocument);
+            result = (ExitCodes)NativeMethods.GetPDFDocument(this.OwnerContext.NativeContext, this.NativeDocument, ref pdfDocument);
 
             switch (result)
             {
@@ -550,162 +864,159 @@ namespace MuPDFCore
         }
 
         /// <summary>
-        /// Create a new <see cref="MuPDFDocument"/> from a file.
+        /// Sets up the pages after the document has been opened. If the pages have not been counted yet, the collection is created the first time it is needed.
         /// </summary>
-        /// <param name="context">The context that will own this document.</param>
-        /// <param name="fileName">The path to the file to open.</param>
-        public MuPDFDocument(MuPDFContext context, string fileName)
+        /// <param name="options">The options that were used to open the document.</param>
+        private void InitialisePages(MuPDFDocumentOpenOptions options)
         {
-            bool isImage;
-
-            string extension = Path.GetExtension(fileName).ToLowerInvariant();
-
-            switch (extension)
+            if (options != null)
             {
-                case ".bmp":
-                case ".dib":
-
-                case ".gif":
-
-                case ".jpg":
-                case ".jpeg":
-                case ".jpe":
-                case ".jif":
-                case ".jfif":
-                case ".jfi":
-
-                case ".pam":
-                case ".pbm":
-                case ".pgm":
-                case ".ppm":
-                case ".pnm":
-
-                case ".png":
-
-                case ".tif":
-                case ".tiff":
-                    isImage = true;
-                    break;
-                default:
-                    isImage = false;
-                    break;
+                if (options.DeferLayout)
+                {
+                    this.PendingLayout = (options.LayoutWidth, options.LayoutHeight, options.LayoutEm);
+                }
+                else
+                {
+                    this.LastLayout = (options.LayoutWidth, options.LayoutHeight, options.LayoutEm);
+                }
             }
 
-
-            this.OwnerContext = context;
-
-            float xRes = 0;
-            float yRes = 0;
-
-            ExitCodes result;
-
-            using (UTF8EncodedString encodedFileName = new UTF8EncodedString(fileName))
+            if (this.PageCount >= 0)
             {
-                result = (ExitCodes)NativeMethods.CreateDocumentFromFile(context.NativeContext, encodedFileName.Address, isImage ? 1 : 0, ref NativeDocument, ref PageCount, ref xRes, ref yRes);
+                this.pages = new MuPDFPageCollection(this.OwnerContext, this, this.PageCount);
             }
+        }
 
-            if (xRes > 72)
+        /// <summary>
+        /// Counts the pages (applying the deferred layout, if any) and creates the page collection.
+        /// </summary>
+        private void LoadPages()
+        {
+            ExitCodes result;
+            int pageCount;
+            bool layoutChanged = false;
+
+            if (this.PendingLayout != null)
             {
-                this.ImageXRes = xRes;
+                (float width, float height, float em) = this.PendingLayout.Value;
+                result = (ExitCodes)NativeMethods.LayoutDocument(this.OwnerContext.NativeContext, this.NativeDocument, width, height, em, out pageCount);
+                this.LastLayout = this.PendingLayout;
+                this.PendingLayout = null;
+                layoutChanged = true;
             }
             else
             {
-                this.ImageXRes = 72;
+                result = (ExitCodes)NativeMethods.CountPages(this.OwnerContext.NativeContext, this.NativeDocument, out pageCount);
             }
 
-            if (yRes > 72)
-            {
-                this.ImageYRes = yRes;
-            }
-            else
+            if (result != ExitCodes.EXIT_SUCCESS)
             {
-                this.ImageYRes = 72;
+                this.ThrowIfInputFailed();
             }
 
             switch (result)
             {
                 case ExitCodes.EXIT_SUCCESS:
                     break;
-                case ExitCodes.ERR_CANNOT_OPEN_FILE:
-                    throw new MuPDFException("Cannot open document", result);
                 case ExitCodes.ERR_CANNOT_COUNT_PAGES:
                     throw new MuPDFException("Cannot count pages", result);
                 default:
                     throw new MuPDFException("Unknown error", result);
             }
 
-            if (NativeMethods.CheckIfPasswordNeeded(context.NativeContext, this.NativeDocument) != 0)
-            {
-                this.EncryptionState = EncryptionState.Encrypted;
-            }
-            else
+            this.PageCount = pageCount;
+            this.pages = new MuPDFPageCollection(this.OwnerContext, this, pageCount);
+
+            if (layoutChanged)
             {
-                this.EncryptionState = EncryptionState.Unencrypted;
+                this.LayoutChanged?.Invoke(this, EventArgs.Empty);
             }
+        }
 
-            int permissions = NativeMethods.GetPermissions(context.NativeContext, this.NativeDocument);
-
-            int restrictions = 0;
+        /// <summary>
+        /// Adds to the page collection the pages that have been counted by the incremental layout since the last time the collection was accessed.
+        /// </summary>
+        private void UpdateIncrementalPages()
+        {
+            //Read this before the page count, so that the pages counted by the last chapter are not missed.
+            bool completed = this.IncrementalLayout.IsCompleted;
+            int knownPageCount = this.IncrementalLayout.KnownPageCount;
 
-            if ((permissions & 1) == 0)
+            if (knownPageCount > this.pages.Count)
             {
-                restrictions |= 1;
+                this.pages.Extend(knownPageCount);
+                this.PageCount = knownPageCount;
             }
 
-            if ((permissions & 2) == 0)
+            if (completed)
             {
-                restrictions |= 2;
+                this.IncrementalLayout.Dispose();
+                this.IncrementalLayout = null;
             }
+        }
 
-            if ((permissions & 4) == 0)
-            {
-                restrictions |= 4;
-            }
+        /// <summary>
+        /// Open a new native handle to the document, from the file or memory from which the document was opened, and bring it to the same state as this document (unlocked and laid out).
+        /// The pages of the new handle are not counted.
+        /// </summary>
+        /// <param name="context">The context that will own the new handle (usually a clone of <see cref="OwnerContext"/>).</param>
+        /// <param name="nativeDocument">When this method returns, the new native document.</param>
+        /// <param name="nativeStream">When this method returns, the native stream from which the document was opened (if any), which must be disposed after the document.</param>
+        internal void OpenSourceDocument(MuPDFContext context, ref IntPtr nativeDocument, ref IntPtr nativeStream)
+        {
+            IntPtr nativeContext = context.NativeContext;
 
-            if ((permissions & 8) == 0)
+            int pageCount = 0;
+            float xRes = 0;
+            float yRes = 0;
+
+            //The new handle is laid out directly when it is opened, and it does not need to count the pages.
+            (float layoutWidth, float layoutHeight, float layoutEm) = this.LastLayout ?? (595, 842, 11);
+
+            ExitCodes result;
+
+            if (this.SourceFileName != null && this.AcceleratorFileName != null)
             {
-                restrictions |= 8;
-            }
+                int acceleratorState = 0;
 
-            if (restrictions == 0)
+                //The accelerator file has already been created when the document was opened, so the file does not need to be parsed again.
+                using (UTF8EncodedString encodedFileName = new UTF8EncodedString(this.SourceFileName))
+                using (UTF8EncodedString encodedAcceleratorFileName = new UTF8EncodedString(this.AcceleratorFileName))
+                {
+                    result = (ExitCodes)NativeMethods.CreateDocumentFromFileWithAccelerator(nativeContext, encodedFileName.Address, encodedAcceleratorFileName.Address, 0, layoutWidth, layoutHeight, layoutEm, 0, ref nativeDocument, ref pageCount, ref xRes, ref yRes, ref acceleratorState);
+                }
+            }
+            else if (this.SourceFileName != null)
             {
-                this.Restrictions = DocumentRestrictions.None;
-                this.RestrictionState = RestrictionState.Unrestricted;
+                int acceleratorState = 0;
+
+                using (UTF8EncodedString encodedFileName = new UTF8EncodedString(this.SourceFileName))
+                {
+                    result = (ExitCodes)NativeMethods.CreateDocumentFromFileWithAccelerator(nativeContext, encodedFileName.Address, IntPtr.Zero, 0, layoutWidth, layoutHeight, layoutEm, 0, ref nativeDocument, ref pageCount, ref xRes, ref yRes, ref acceleratorState);
+                }
             }
             else
             {
-                this.Restrictions = (DocumentRestrictions)restrictions;
-                this.RestrictionState = RestrictionState.Restricted;
+                result = (ExitCodes)NativeMethods.CreateDocumentFromStream(nativeContext, this.SourceDataAddress, this.SourceDataLength, this.SourceFileType, 0, layoutWidth, layoutHeight, layoutEm, 0, ref nativeDocument, ref nativeStream, ref pageCount, ref xRes, ref yRes);
             }
 
-            Pages = new MuPDFPageCollection(context, this, PageCount);
-            DisplayLists = new MuPDFDisplayList[PageCount];
-
-            IntPtr pdfDocument = IntPtr.Zero;
-            result = (ExitCodes)NativeMethods.GetPDFDocument(context.NativeContext, this.NativeDocument, ref pdfDocument);
-
             switch (result)
             {
                 case ExitCodes.EXIT_SUCCESS:
-                    this.NativePDFDocument = pdfDocument;
-                    break;
-                case ExitCodes.ERR_CANNOT_CONVERT_TO_PDF:
-                    this.NativePDFDocument = IntPtr.Zero;
                     break;
+                case ExitCodes.ERR_CANNOT_OPEN_STREAM:
+                    throw new MuPDFException("Cannot open data stream", result);
+                case ExitCodes.ERR_CANNOT_OPEN_FILE:
+                    throw new MuPDFException("Cannot open document", result);
+                case ExitCodes.ERR_CANNOT_COUNT_PAGES:
+                    throw new MuPDFException("Cannot count pages", result);
                 default:
                     throw new MuPDFException("Unknown error", result);
             }
-        }
 
-        /// <summary>
-        /// Discard all the display lists that have been loaded from the document, possibly freeing some memory in the case of a huge document.
-        /// </summary>
-        public void ClearCache()
-        {
-            for (int i = 0; i < PageCount; i++)
+            if (this.UnlockPassword != null)
             {
-                DisplayLists[i]?.Dispose();
-                DisplayLists[i] = null;
+                NativeMethods.UnlockWithPassword(nativeContext, nativeDocument, this.UnlockPassword);
             }
         }
 
@@ -727,16 +1038,22 @@ namespace MuPDFCore
                 throw new ArgumentOutOfRangeException(nameof(height), height, "The page height must be greater than 0!");
             }
 
+            this.IncrementalLayout?.Dispose();
+            this.IncrementalLayout = null;
+
             this.ClearCache();
-            this.Pages.Dispose();
+            this.pages?.Dispose();
+            this.PendingLayout = null;
 
             NativeMethods.LayoutDocument(this.OwnerContext.NativeContext, this.NativeDocument, width, height, em, out int pageCount);
+            this.LastLayout = (width, height, em);
 
             this.PageCount = pageCount;
-            this.Pages = new MuPDFPageCollection(this.OwnerContext, this, PageCount);
-            this.DisplayLists = new MuPDFDisplayList[PageCount];
+            this.pages = new MuPDFPageCollection(this.OwnerContext, this, PageCount);
 
             this.LayoutChanged?.Invoke(this, EventArgs.Empty);
+
+            this.ThrowIfInputFailed();
         }
 
         /// <summary>
@@ -752,16 +1069,94 @@ namespace MuPDFCore
                 throw new ArgumentOutOfRangeException(nameof(width), width, "The page width must be greater than 0!");
             }
 
+            this.IncrementalLayout?.Dispose();
+            this.IncrementalLayout = null;
+
             this.ClearCache();
-            this.Pages.Dispose();
+            this.pages?.Dispose();
+            this.PendingLayout = null;
 
             NativeMethods.LayoutDocument(this.OwnerContext.NativeContext, this.NativeDocument, width, 0, em, out int pageCount);
+            this.LastLayout = (width, 0, em);
 
             this.PageCount = pageCount;
-            this.Pages = new MuPDFPageCollection(this.OwnerContext, this, PageCount);
-            this.DisplayLists = new MuPDFDisplayList[PageCount];
+            this.pages = new MuPDFPageCollection(this.OwnerContext, this, PageCount);
 
             this.LayoutChanged?.Invoke(this, EventArgs.Empty);
+
+            this.ThrowIfInputFailed();
+        }
+
+        /// <summary>
+        /// Sets the document layout for reflowable document types (e.g., EPUB), laying out the document one chapter at a time. The first chapter is laid out before this method returns,
+        /// and the remaining chapters are laid out in the background (on a separate context), so that the first pages can be rendered without waiting for the whole document
+        /// to be laid out. <see cref="Pages"/> initially contains the pages of the first chapter, and grows as more chapters are laid out; the returned
+        /// <see cref="MuPDFIncrementalLayout"/> reports the number of pages that are known at any time, and its <see cref="MuPDFIncrementalLayout.Completion"/> completes
+        /// when the whole document has been laid out. Documents that consist of a single chapter (e.g., HTML, FB2) are laid out completely before this method returns.
+        /// Calling <see cref="Layout(float, float, float)"/>, <see cref="LayoutSinglePage(float, float)"/> or this method again cancels the incremental layout.
+        /// </summary>
+        /// <param name="width">The width of each page, in points. Must be &gt; 0.</param>
+        /// <param name="height">The height of each page, in points. Must be &gt; 0.</param>
+        /// <param name="em">The default font size, in points.</param>
+        /// <param name="cancellationToken">A <see cref="CancellationToken"/> used to cancel the layout. If the layout is cancelled, <see cref="Pages"/> only contains the pages of
+        /// the chapters that had been laid out.</param>
+        /// <param name="progress">An <see cref="IProgress{T}"/> that is notified each time a chapter has been laid out. Note that this may be called on a background thread.</param>
+        /// <returns>A <see cref="MuPDFIncrementalLayout"/> that can be used to monitor the progress of the layout.</returns>
+        public MuPDFIncrementalLayout LayoutIncrementally(float width, float height, float em, CancellationToken cancellationToken = default, IProgress<LayoutProgressInfo> progress = null)
+        {
+            if (width <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(width), width, "The page width must be greater than 0!");
+            }
+
+            if (height <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(height), height, "The page height must be greater than 0!");
+            }
+
+            this.IncrementalLayout?.Dispose();
+            this.IncrementalLayout = null;
+
+            this.ClearCache();
+            this.pages?.Dispose();
+            this.PendingLayout = null;
+
+            ExitCodes result = (ExitCodes)NativeMethods.SetDocumentLayout(this.OwnerContext.NativeContext, this.NativeDocument, width, height, em);
+
+            if (result == ExitCodes.EXIT_SUCCESS)
+            {
+                this.LastLayout = (width, height, em);
+                result = (ExitCodes)NativeMethods.CountChapters(this.OwnerContext.NativeContext, this.NativeDocument, out int chapterCount);
+
+                int firstChapterPageCount = 0;
+
+                if (result == ExitCodes.EXIT_SUCCESS && chapterCount > 0)
+                {
+                    result = (ExitCodes)NativeMethods.CountChapterPages(this.OwnerContext.NativeContext, this.NativeDocument, 0, out firstChapterPageCount);
+                }
+
+                if (result == ExitCodes.EXIT_SUCCESS)
+                {
+                    this.PageCount = firstChapterPageCount;
+                    this.pages = new MuPDFPageCollection(this.OwnerContext, this, firstChapterPageCount);
+
+                    this.IncrementalLayout = new MuPDFIncrementalLayout(this, chapterCount, firstChapterPageCount, cancellationToken, progress);
+
+                    this.LayoutChanged?.Invoke(this, EventArgs.Empty);
+
+                    return this.IncrementalLayout;
+                }
+            }
+
+            this.ThrowIfInputFailed();
+
+            switch (result)
+            {
+                case ExitCodes.ERR_CANNOT_COUNT_PAGES:
+                    throw new MuPDFException("Cannot count pages", result);
+                default:
+                    throw new MuPDFException("Unknown error", result);
+            }
         }
 
         /// <summary>
@@ -834,11 +1229,6 @@ namespace MuPDFCore
                 throw new DocumentLockedException("A password is necessary to render the document!");
             }
 
-            if (DisplayLists[pageNumber] == null)
-            {
-                DisplayLists[pageNumber] = new MuPDFDisplayList(this.OwnerContext, this.Pages[pageNumber], includeAnnotations);
-            }
-
             if (zoom < 0.000001 | zoom * region.Width <= 0.001 || zoom * region.Height <= 0.001)
             {
                 throw new ArgumentOutOfRangeException(nameof(zoom), zoom, "The zoom factor is too small!");
@@ -852,7 +1242,30 @@ namespace MuPDFCore
 
             float fzoom = (float)zoom;
 
-            ExitCodes result = (ExitCodes)NativeMethods.RenderSubDisplayList(OwnerContext.NativeContext, DisplayLists[pageNumber].NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, destination, IntPtr.Zero);
+            Rectangle pageBounds = Pages[pageNumber].Bounds;
+
+            ExitCodes result;
+
+            if (this.DirectRendering)
+            {
+                RenderFlags flags = Utils.GetRenderFlags(region, pageBounds, this.ClipToPageBounds, this.PremultipliedAlpha);
+                result = (ExitCodes)NativeMethods.RenderPage(OwnerContext.NativeContext, Pages[pageNumber].NativePage, includeAnnotations ? 1 : 0, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, destination, (int)flags, pageBounds.X0, pageBounds.Y0, pageBounds.X1, pageBounds.Y1, this.DirectRenderingBandHeight, IntPtr.Zero);
+                this.ThrowIfInputFailed();
+            }
+            else
+            {
+                MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+                try
+                {
+                    RenderFlags flags = Utils.GetRenderFlags(region, displayList, OwnerContext.NativeContext, pageBounds, this.ClipToPageBounds, this.PremultipliedAlpha);
+                    result = (ExitCodes)NativeMethods.RenderSubDisplayList(OwnerContext.NativeContext, displayList.NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, destination, (int)flags, pageBounds.X0, pageBounds.Y0, pageBounds.X1, pageBounds.Y1, IntPtr.Zero);
+                }
+                finally
+                {
+                    displayList.Unpin();
+                }
+            }
 
             switch (result)
             {
@@ -863,19 +1276,6 @@ namespace MuPDFCore
                 default:
                     throw new MuPDFException("Unknown error", result);
             }
-
-            RoundedRectangle roundedRegion = region.Round(fzoom);
-            RoundedSize roundedSize = new RoundedSize(roundedRegion.Width, roundedRegion.Height);
-
-            if (pixelFormat == PixelFormats.RGBA || pixelFormat == PixelFormats.BGRA)
-            {
-                Utils.UnpremultiplyAlpha(destination, roundedSize);
-            }
-
-            if (this.ClipToPageBounds && !Pages[pageNumber].Bounds.Contains(DisplayLists[pageNumber].Bounds.Intersect(region)))
-            {
-                Utils.ClipImage(destination, roundedSize, region, Pages[pageNumber].Bounds, pixelFormat);
-            }
         }
 
         /// <summary>
@@ -941,31 +1341,63 @@ namespace MuPDFCore
                 throw new DocumentLockedException("A password is necessary to render the document!");
             }
 
-            Rectangle region = this.Pages[pageNumber].Bounds;
-            return Render(pageNumber, region, zoom, pixelFormat, out disposable, includeAnnotations);
-        }
+            Rectangle region = this.Pages[pageNumber].Bounds;
+            return Render(pageNumber, region, zoom, pixelFormat, out disposable, includeAnnotations);
+        }
+
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFMultiThreadedPageRenderer"/> that renders the specified page with the specified number of threads.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page to render (starting at 0).</param>
+        /// <param name="threadCount">The number of threads to use. This can be any number greater than 0.</param>
+        /// <returns>A <see cref="MuPDFMultiThreadedPageRenderer"/> that can be used to render the specified page with the specified number of threads.</returns>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the display list that is generated. Otherwise, only the page contents are included.</param>
+        public MuPDFMultiThreadedPageRenderer GetMultiThreadedRenderer(int pageNumber, int threadCount, bool includeAnnotations = true)
+        {
+            if (this.EncryptionState == EncryptionState.Encrypted)
+            {
+                throw new DocumentLockedException("A password is necessary to render the document!");
+            }
+
+            MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
 
+            try
+            {
+                return new MuPDFMultiThreadedPageRenderer(OwnerContext, displayList, threadCount, Pages[pageNumber].Bounds, this.ClipToPageBounds, this.ImageXRes, this.ImageYRes, this.PremultipliedAlpha);
+            }
+            catch
+            {
+                displayList.Unpin();
+                throw;
+            }
+        }
 
         /// <summary>
-        /// Create a new <see cref="MuPDFMultiThreadedPageRenderer"/> that renders the specified page with the specified number of threads.
+        /// Create a new <see cref="MuPDFMultiThreadedPageRenderer"/> that renders the specified page using a shared <see cref="MuPDFRenderWorkerPool"/>, rather than starting its own threads.
         /// </summary>
         /// <param name="pageNumber">The number of the page to render (starting at 0).</param>
-        /// <param name="threadCount">The number of threads to use. This must be factorisable using only powers of 2, 3, 5 or 7. Otherwise, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
-        /// <returns>A <see cref="MuPDFMultiThreadedPageRenderer"/> that can be used to render the specified page with the specified number of threads.</returns>
+        /// <param name="workerPool">The worker pool that performs the rendering. This must have been created using the same context as this document.</param>
+        /// <returns>A <see cref="MuPDFMultiThreadedPageRenderer"/> that can be used to render the specified page using the <paramref name="workerPool"/>.</returns>
         /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the display list that is generated. Otherwise, only the page contents are included.</param>
-        public MuPDFMultiThreadedPageRenderer GetMultiThreadedRenderer(int pageNumber, int threadCount, bool includeAnnotations = true)
+        public MuPDFMultiThreadedPageRenderer GetMultiThreadedRenderer(int pageNumber, MuPDFRenderWorkerPool workerPool, bool includeAnnotations = true)
         {
             if (this.EncryptionState == EncryptionState.Encrypted)
             {
                 throw new DocumentLockedException("A password is necessary to render the document!");
             }
 
-            if (DisplayLists[pageNumber] == null)
+            MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+            try
             {
-                DisplayLists[pageNumber] = new MuPDFDisplayList(this.OwnerContext, this.Pages[pageNumber], includeAnnotations);
+                return new MuPDFMultiThreadedPageRenderer(OwnerContext, displayList, workerPool, Pages[pageNumber].Bounds, this.ClipToPageBounds, this.ImageXRes, this.ImageYRes, this.PremultipliedAlpha);
+            }
+            catch
+            {
+                displayList.Unpin();
+                throw;
             }
-
-            return new MuPDFMultiThreadedPageRenderer(OwnerContext, DisplayLists[pageNumber], threadCount, Pages[pageNumber].Bounds, this.ClipToPageBounds, this.ImageXRes, this.ImageYRes);
         }
 
         /// <summary>
@@ -1050,11 +1482,6 @@ namespace MuPDFCore
                 throw new ArgumentException("The PNG format only supports RGB or RGBA pixel data!", nameof(fileType));
             }
 
-            if (DisplayLists[pageNumber] == null)
-            {
-                DisplayLists[pageNumber] = new MuPDFDisplayList(this.OwnerContext, this.Pages[pageNumber], includeAnnotations);
-            }
-
             if (zoom < 0.000001 | zoom * region.Width <= 0.001 || zoom * region.Height <= 0.001)
             {
                 throw new ArgumentOutOfRangeException(nameof(zoom), zoom, "The zoom factor is too small!");
@@ -1072,7 +1499,24 @@ namespace MuPDFCore
 
             using (UTF8EncodedString encodedFileName = new UTF8EncodedString(fileName))
             {
-                result = (ExitCodes)NativeMethods.SaveImage(OwnerContext.NativeContext, DisplayLists[pageNumber].NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, encodedFileName.Address, (int)fileType, 90);
+                if (this.DirectRendering)
+                {
+                    result = (ExitCodes)NativeMethods.SavePageImage(OwnerContext.NativeContext, Pages[pageNumber].NativePage, includeAnnotations ? 1 : 0, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, encodedFileName.Address, (int)fileType, 90);
+                    this.ThrowIfInputFailed();
+                }
+                else
+                {
+                    MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+                    try
+                    {
+                        result = (ExitCodes)NativeMethods.SaveImage(OwnerContext.NativeContext, displayList.NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, encodedFileName.Address, (int)fileType, 90);
+                    }
+                    finally
+                    {
+                        displayList.Unpin();
+                    }
+                }
             }
 
             switch (result)
@@ -1109,11 +1553,6 @@ namespace MuPDFCore
                 throw new ArgumentOutOfRangeException(nameof(quality), quality, "The JPEG quality must range between 0 and 100 (inclusive)!");
             }
 
-            if (DisplayLists[pageNumber] == null)
-            {
-                DisplayLists[pageNumber] = new MuPDFDisplayList(this.OwnerContext, this.Pages[pageNumber], includeAnnotations);
-            }
-
             if (zoom < 0.000001 | zoom * region.Width <= 0.001 || zoom * region.Height <= 0.001)
             {
                 throw new ArgumentOutOfRangeException(nameof(zoom), zoom, "The zoom factor is too small!");
@@ -1131,7 +1570,24 @@ namespace MuPDFCore
 
             using (UTF8EncodedString encodedFileName = new UTF8EncodedString(fileName))
             {
-                result = (ExitCodes)NativeMethods.SaveImage(OwnerContext.NativeContext, DisplayLists[pageNumber].NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)PixelFormats.RGB, encodedFileName.Address, (int)RasterOutputFileTypes.JPEG, quality);
+                if (this.DirectRendering)
+                {
+                    result = (ExitCodes)NativeMethods.SavePageImage(OwnerContext.NativeContext, Pages[pageNumber].NativePage, includeAnnotations ? 1 : 0, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)PixelFormats.RGB, encodedFileName.Address, (int)RasterOutputFileTypes.JPEG, quality);
+                    this.ThrowIfInputFailed();
+                }
+                else
+                {
+                    MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+                    try
+                    {
+                        result = (ExitCodes)NativeMethods.SaveImage(OwnerContext.NativeContext, displayList.NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)PixelFormats.RGB, encodedFileName.Address, (int)RasterOutputFileTypes.JPEG, quality);
+                    }
+                    finally
+                    {
+                        displayList.Unpin();
+                    }
+                }
             }
 
             switch (result)
@@ -1163,27 +1619,375 @@ namespace MuPDFCore
                 throw new DocumentLockedException("A password is necessary to render the document!");
             }
 
-            Rectangle region = this.Pages[pageNumber].Bounds;
-            SaveImage(pageNumber, region, zoom, pixelFormat, fileName, fileType, includeAnnotations);
-        }
+            Rectangle region = this.Pages[pageNumber].Bounds;
+            SaveImage(pageNumber, region, zoom, pixelFormat, fileName, fileType, includeAnnotations);
+        }
+
+        /// <summary>
+        /// Save a page to an image file in JPEG format, with the specified quality.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page to render (starting at 0).</param>
+        /// <param name="zoom">The scale at which the page will be rendered. This will determine the size in pixel of the image.</param>
+        /// <param name="fileName">The path to the output file.</param>
+        /// <param name="quality">The quality of the JPEG output file (ranging from 0 to 100).</param>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the display list that is generated. Otherwise, only the page contents are included.</param>
+        public void SaveImageAsJPEG(int pageNumber, double zoom, string fileName, int quality, bool includeAnnotations = true)
+        {
+            if (this.EncryptionState == EncryptionState.Encrypted)
+            {
+                throw new DocumentLockedException("A password is necessary to render the document!");
+            }
+
+            Rectangle region = this.Pages[pageNumber].Bounds;
+            SaveImageAsJPEG(pageNumber, region, zoom, fileName, quality, includeAnnotations);
+        }
+
+        /// <summary>
+        /// Save (part of) a page to an image file in the specified format, rendering and encoding it <paramref name="bandHeight"/> rows at a time. Peak memory usage
+        /// is determined by the band height rather than by the size of the image, which makes it possible to save images that would not fit in memory as a single pixmap.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page to render (starting at 0).</param>
+        /// <param name="region">The region of the page to render in page units.</param>
+        /// <param name="zoom">The scale at which the page will be rendered. This will determine the size in pixel of the image.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <param name="fileName">The path to the output file.</param>
+        /// <param name="fileType">The output format of the file. <see cref="RasterOutputFileTypes.JPEG"/> is not supported.</param>
+        /// <param name="bandHeight">The height in pixels of each band.</param>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the display list that is generated. Otherwise, only the page contents are included.</param>
+        public void SaveImageBanded(int pageNumber, Rectangle region, double zoom, PixelFormats pixelFormat, string fileName, RasterOutputFileTypes fileType, int bandHeight, bool includeAnnotations = true)
+        {
+            if (this.EncryptionState == EncryptionState.Encrypted)
+            {
+                throw new DocumentLockedException("A password is necessary to render the document!");
+            }
+
+            if (fileType == RasterOutputFileTypes.JPEG)
+            {
+                throw new ArgumentException("The JPEG format does not support banded output!", nameof(fileType));
+            }
+
+            if (pixelFormat == PixelFormats.RGBA && fileType == RasterOutputFileTypes.PNM)
+            {
+                throw new ArgumentException("Cannot save an image with alpha channel in PNM format!", nameof(fileType));
+            }
+
+            if ((pixelFormat != PixelFormats.RGB && pixelFormat != PixelFormats.RGBA) && fileType == RasterOutputFileTypes.PNG)
+            {
+                throw new ArgumentException("The PNG format only supports RGB or RGBA pixel data!", nameof(fileType));
+            }
+
+            if (bandHeight <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(bandHeight), bandHeight, "The band height must be greater than 0!");
+            }
+
+            if (zoom < 0.000001 | zoom * region.Width <= 0.001 || zoom * region.Height <= 0.001)
+            {
+                throw new ArgumentOutOfRangeException(nameof(zoom), zoom, "The zoom factor is too small!");
+            }
+
+            if (this.ImageXRes != 72 || this.ImageYRes != 72)
+            {
+                zoom *= Math.Sqrt(this.ImageXRes * this.ImageYRes) / 72;
+                region = new Rectangle(region.X0 * 72 / this.ImageXRes, region.Y0 * 72 / this.ImageYRes, region.X1 * 72 / this.ImageXRes, region.Y1 * 72 / this.ImageYRes);
+            }
+
+            float fzoom = (float)zoom;
+
+            ExitCodes result;
+
+            using (UTF8EncodedString encodedFileName = new UTF8EncodedString(fileName))
+            {
+                if (this.DirectRendering)
+                {
+                    result = (ExitCodes)NativeMethods.SavePageImageBanded(OwnerContext.NativeContext, Pages[pageNumber].NativePage, includeAnnotations ? 1 : 0, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, encodedFileName.Address, (int)fileType, bandHeight);
+                    this.ThrowIfInputFailed();
+                }
+                else
+                {
+                    MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+                    try
+                    {
+                        result = (ExitCodes)NativeMethods.SaveImageBanded(OwnerContext.NativeContext, displayList.NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, encodedFileName.Address, (int)fileType, bandHeight);
+                    }
+                    finally
+                    {
+                        displayList.Unpin();
+                    }
+                }
+            }
+
+            switch (result)
+            {
+                case ExitCodes.EXIT_SUCCESS:
+                    break;
+                case ExitCodes.ERR_CANNOT_RENDER:
+                    throw new MuPDFException("Cannot render page", result);
+                case ExitCodes.ERR_CANNOT_CREATE_BUFFER:
+                    throw new MuPDFException("Cannot allocate the band buffer", result);
+                case ExitCodes.ERR_CANNOT_SAVE:
+                    throw new MuPDFException("Cannot save to the output file", result);
+                default:
+                    throw new MuPDFException("Unknown error", result);
+            }
+        }
+
+        /// <summary>
+        /// Save a page to an image file in the specified format, rendering and encoding it <paramref name="bandHeight"/> rows at a time. Peak memory usage
+        /// is determined by the band height rather than by the size of the image.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page to render (starting at 0).</param>
+        /// <param name="zoom">The scale at which the page will be rendered. This will determine the size in pixel of the image.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <param name="fileName">The path to the output file.</param>
+        /// <param name="fileType">The output format of the file. <see cref="RasterOutputFileTypes.JPEG"/> is not supported.</param>
+        /// <param name="bandHeight">The height in pixels of each band.</param>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the display list that is generated. Otherwise, only the page contents are included.</param>
+        public void SaveImageBanded(int pageNumber, double zoom, PixelFormats pixelFormat, string fileName, RasterOutputFileTypes fileType, int bandHeight, bool includeAnnotations = true)
+        {
+            if (this.EncryptionState == EncryptionState.Encrypted)
+            {
+                throw new DocumentLockedException("A password is necessary to render the document!");
+            }
+
+            Rectangle region = this.Pages[pageNumber].Bounds;
+            SaveImageBanded(pageNumber, region, zoom, pixelFormat, fileName, fileType, bandHeight, includeAnnotations);
+        }
+
+        /// <summary>
+        /// Save (part of) a page to an image file in the specified format, rendering bands of <paramref name="bandHeight"/> rows concurrently on the threads of a
+        /// <paramref name="workerPool"/>, while the calling thread encodes them in order. At most twice as many bands as there are workers in the pool are held in memory
+        /// at any time, thus peak memory usage is still determined by the band height rather than by the size of the image. The page is always rendered through its
+        /// display list, even if <see cref="DirectRendering"/> is enabled.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page to render (starting at 0).</param>
+        /// <param name="region">The region of the page to render in page units.</param>
+        /// <param name="zoom">The scale at which the page will be rendered. This will determine the size in pixel of the image.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <param name="fileName">The path to the output file.</param>
+        /// <param name="fileType">The output format of the file. <see cref="RasterOutputFileTypes.JPEG"/> is not supported.</param>
+        /// <param name="bandHeight">The height in pixels of each band.</param>
+        /// <param name="workerPool">The worker pool that renders the bands. This must have been created using the same context as this document.</param>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the display list that is generated. Otherwise, only the page contents are included.</param>
+        public void SaveImageBanded(int pageNumber, Rectangle region, double zoom, PixelFormats pixelFormat, string fileName, RasterOutputFileTypes fileType, int bandHeight, MuPDFRenderWorkerPool workerPool, bool includeAnnotations = true)
+        {
+            if (this.EncryptionState == EncryptionState.Encrypted)
+            {
+                throw new DocumentLockedException("A password is necessary to render the document!");
+            }
+
+            if (workerPool == null)
+            {
+                throw new ArgumentNullException(nameof(workerPool));
+            }
+
+            if (workerPool.Context.RootContext != OwnerContext.RootContext)
+            {
+                throw new ArgumentException("The worker pool must have been created using the same context as the document!", nameof(workerPool));
+            }
+
+            if (fileType == RasterOutputFileTypes.JPEG)
+            {
+                throw new ArgumentException("The JPEG format does not support banded output!", nameof(fileType));
+            }
+
+            if (pixelFormat == PixelFormats.RGBA && fileType == RasterOutputFileTypes.PNM)
+            {
+                throw new ArgumentException("Cannot save an image with alpha channel in PNM format!", nameof(fileType));
+            }
+
+            if ((pixelFormat != PixelFormats.RGB && pixelFormat != PixelFormats.RGBA) && fileType == RasterOutputFileTypes.PNG)
+            {
+                throw new ArgumentException("The PNG format only supports RGB or RGBA pixel data!", nameof(fileType));
+            }
+
+            if (bandHeight <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(bandHeight), bandHeight, "The band height must be greater than 0!");
+            }
+
+            if (zoom < 0.000001 | zoom * region.Width <= 0.001 || zoom * region.Height <= 0.001)
+            {
+                throw new ArgumentOutOfRangeException(nameof(zoom), zoom, "The zoom factor is too small!");
+            }
+
+            if (this.ImageXRes != 72 || this.ImageYRes != 72)
+            {
+                zoom *= Math.Sqrt(this.ImageXRes * this.ImageYRes) / 72;
+                region = new Rectangle(region.X0 * 72 / this.ImageXRes, region.Y0 * 72 / this.ImageYRes, region.X1 * 72 / this.ImageXRes, region.Y1 * 72 / this.ImageYRes);
+            }
+
+            float fzoom = (float)zoom;
+
+            MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+            IntPtr writer = IntPtr.Zero;
+
+            try
+            {
+                int width = 0;
+                int height = 0;
+
+                ExitCodes result;
+
+                using (UTF8EncodedString encodedFileName = new UTF8EncodedString(fileName))
+                {
+                    result = (ExitCodes)NativeMethods.CreateBandedImageWriter(OwnerContext.NativeContext, encodedFileName.Address, (int)fileType, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, ref writer, ref width, ref height);
+                }
+
+                switch (result)
+                {
+                    case ExitCodes.EXIT_SUCCESS:
+                        break;
+                    case ExitCodes.ERR_CANNOT_SAVE:
+                        throw new MuPDFException("Cannot open the output file", result);
+                    case ExitCodes.ERR_CANNOT_CREATE_WRITER:
+                        throw new MuPDFException("Cannot create the band writer", result);
+                    default:
+                        throw new MuPDFException("Unknown error", result);
+                }
+
+                int pixelSize = pixelFormat == PixelFormats.RGBA || pixelFormat == PixelFormats.BGRA ? 4 : 3;
+
+                RunBandedPipeline(displayList, region, fzoom, pixelFormat, writer, width * pixelSize, height, bandHeight, workerPool);
+
+                result = (ExitCodes)NativeMethods.CloseBandedImageWriter(OwnerContext.NativeContext, writer);
+
+                switch (result)
+                {
+                    case ExitCodes.EXIT_SUCCESS:
+                        break;
+                    case ExitCodes.ERR_CANNOT_SAVE:
+                        throw new MuPDFException("Cannot save to the output file", result);
+                    default:
+                        throw new MuPDFException("Unknown error", result);
+                }
+            }
+            finally
+            {
+                if (writer != IntPtr.Zero)
+                {
+                    NativeMethods.DisposeBandedImageWriter(OwnerContext.NativeContext, writer);
+                }
+
+                displayList.Unpin();
+            }
+        }
+
+        /// <summary>
+        /// Save a page to an image file in the specified format, rendering bands of <paramref name="bandHeight"/> rows concurrently on the threads of a
+        /// <paramref name="workerPool"/>, while the calling thread encodes them in order.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page to render (starting at 0).</param>
+        /// <param name="zoom">The scale at which the page will be rendered. This will determine the size in pixel of the image.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <param name="fileName">The path to the output file.</param>
+        /// <param name="fileType">The output format of the file. <see cref="RasterOutputFileTypes.JPEG"/> is not supported.</param>
+        /// <param name="bandHeight">The height in pixels of each band.</param>
+        /// <param name="workerPool">The worker pool that renders the bands. This must have been created using the same context as this document.</param>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the display list that is generated. Otherwise, only the page contents are included.</param>
+        public void SaveImageBanded(int pageNumber, double zoom, PixelFormats pixelFormat, string fileName, RasterOutputFileTypes fileType, int bandHeight, MuPDFRenderWorkerPool workerPool, bool includeAnnotations = true)
+        {
+            if (this.EncryptionState == EncryptionState.Encrypted)
+            {
+                throw new DocumentLockedException("A password is necessary to render the document!");
+            }
+
+            Rectangle region = this.Pages[pageNumber].Bounds;
+            SaveImageBanded(pageNumber, region, zoom, pixelFormat, fileName, fileType, bandHeight, workerPool, includeAnnotations);
+        }
+
+        /// <summary>
+        /// Render the bands of an image on the <paramref name="workerPool"/> and feed them to the <paramref name="writer"/> in order. Rendering runs ahead of encoding
+        /// by at most twice the number of workers; band buffers are recycled once they have been encoded.
+        /// </summary>
+        private void RunBandedPipeline(MuPDFDisplayList displayList, Rectangle region, float zoom, PixelFormats pixelFormat, IntPtr writer, int stride, int height, int bandHeight, MuPDFRenderWorkerPool workerPool)
+        {
+            int maxInFlight = 2 * workerPool.WorkerCount;
+            int bandCount = (height + bandHeight - 1) / bandHeight;
+            int bandSize = checked(stride * Math.Min(bandHeight, height));
+
+            Queue<(Task Task, IntPtr Buffer, int RowCount)> inFlight = new Queue<(Task, IntPtr, int)>();
+            Stack<IntPtr> freeBuffers = new Stack<IntPtr>();
+            List<IntPtr> allBuffers = new List<IntPtr>();
+
+            //Wait for the oldest band to be rendered, encode it, and make its buffer available for another band.
+            void writeNextBand()
+            {
+                (Task task, IntPtr buffer, int rowCount) = inFlight.Peek();
+
+                task.GetAwaiter().GetResult();
+                inFlight.Dequeue();
+
+                ExitCodes result = (ExitCodes)NativeMethods.WriteImageBand(OwnerContext.NativeContext, writer, rowCount, buffer);
+
+                if (result != ExitCodes.EXIT_SUCCESS)
+                {
+                    throw new MuPDFException("Cannot save to the output file", result);
+                }
+
+                freeBuffers.Push(buffer);
+            }
 
-        /// <summary>
-        /// Save a page to an image file in JPEG format, with the specified quality.
-        /// </summary>
-        /// <param name="pageNumber">The number of the page to render (starting at 0).</param>
-        /// <param name="zoom">The scale at which the page will be rendered. This will determine the size in pixel of the image.</param>
-        /// <param name="fileName">The path to the output file.</param>
-        /// <param name="quality">The quality of the JPEG output file (ranging from 0 to 100).</param>
-        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included in the display list that is generated. Otherwise, only the page contents are included.</param>
-        public void SaveImageAsJPEG(int pageNumber, double zoom, string fileName, int quality, bool includeAnnotations = true)
-        {
-            if (this.EncryptionState == EncryptionState.Encrypted)
+            try
             {
-                throw new DocumentLockedException("A password is necessary to render the document!");
+                for (int i = 0; i < bandCount; i++)
+                {
+                    if (inFlight.Count == maxInFlight)
+                    {
+                        writeNextBand();
+                    }
+
+                    IntPtr buffer;
+
+                    if (freeBuffers.Count > 0)
+                    {
+                        buffer = freeBuffers.Pop();
+                    }
+                    else
+                    {
+                        buffer = Marshal.AllocHGlobal(bandSize);
+                        allBuffers.Add(buffer);
+                    }
+
+                    int firstRow = i * bandHeight;
+                    int rowCount = Math.Min(bandHeight, height - firstRow);
+
+                    Task task = workerPool.Run(nativeContext =>
+                    {
+                        ExitCodes result = (ExitCodes)NativeMethods.RenderImageBand(nativeContext, displayList.NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, zoom, (int)pixelFormat, firstRow, rowCount, buffer, IntPtr.Zero);
+
+                        if (result != ExitCodes.EXIT_SUCCESS)
+                        {
+                            throw new MuPDFException("Cannot render page", result);
+                        }
+                    });
+
+                    inFlight.Enqueue((task, buffer, rowCount));
+                }
+
+                while (inFlight.Count > 0)
+                {
+                    writeNextBand();
+                }
             }
+            finally
+            {
+                //If something went wrong, the bands that are still being rendered must finish before their buffers can be freed.
+                foreach ((Task task, IntPtr _, int _) in inFlight)
+                {
+                    try
+                    {
+                        task.Wait();
+                    }
+                    catch { }
+                }
 
-            Rectangle region = this.Pages[pageNumber].Bounds;
-            SaveImageAsJPEG(pageNumber, region, zoom, fileName, quality, includeAnnotations);
+                for (int i = 0; i < allBuffers.Count; i++)
+                {
+                    Marshal.FreeHGlobal(allBuffers[i]);
+                }
+            }
         }
 
         /// <summary>
@@ -1218,11 +2022,6 @@ namespace MuPDFCore
                 throw new ArgumentException("The PNG format only supports RGB or RGBA pixel data!", nameof(fileType));
             }
 
-            if (DisplayLists[pageNumber] == null)
-            {
-                DisplayLists[pageNumber] = new MuPDFDisplayList(this.OwnerContext, this.Pages[pageNumber], includeAnnotations);
-            }
-
             if (zoom < 0.000001 | zoom * region.Width <= 0.001 || zoom * region.Height <= 0.001)
             {
                 throw new ArgumentOutOfRangeException(nameof(zoom), zoom, "The zoom factor is too small!");
@@ -1236,11 +2035,32 @@ namespace MuPDFCore
 
             float fzoom = (float)zoom;
 
-            IntPtr outputBuffer = IntPtr.Zero;
-            IntPtr outputData = IntPtr.Zero;
-            ulong outputDataLength = 0;
+            //The encoded image is passed to the stream in chunks while it is being written, rather than being accumulated in a native buffer first.
+            OutputStreamCallback output = new OutputStreamCallback(outputStream);
+
+            ExitCodes result;
+
+            if (this.DirectRendering)
+            {
+                result = (ExitCodes)NativeMethods.WritePageImageToStream(OwnerContext.NativeContext, Pages[pageNumber].NativePage, includeAnnotations ? 1 : 0, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, (int)fileType, 90, output.Callback);
+                this.ThrowIfInputFailed();
+            }
+            else
+            {
+                MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+                try
+                {
+                    result = (ExitCodes)NativeMethods.WriteImageToStream(OwnerContext.NativeContext, displayList.NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, (int)fileType, 90, output.Callback);
+                }
+                finally
+                {
+                    displayList.Unpin();
+                }
+            }
 
-            ExitCodes result = (ExitCodes)NativeMethods.WriteImage(OwnerContext.NativeContext, DisplayLists[pageNumber].NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)pixelFormat, (int)fileType, 90, ref outputBuffer, ref outputData, ref outputDataLength);
+            GC.KeepAlive(output);
+            output.ThrowIfFailed();
 
             switch (result)
             {
@@ -1250,22 +2070,11 @@ namespace MuPDFCore
                     throw new MuPDFException("Cannot render page", result);
                 case ExitCodes.ERR_CANNOT_CREATE_BUFFER:
                     throw new MuPDFException("Cannot create the output buffer", result);
+                case ExitCodes.ERR_CANNOT_SAVE:
+                    throw new MuPDFException("Cannot write the image", result);
                 default:
                     throw new MuPDFException("Unknown error", result);
             }
-
-            byte[] buffer = new byte[1024];
-
-            while (outputDataLength > 0)
-            {
-                int bytesToCopy = (int)Math.Min(buffer.Length, (long)outputDataLength);
-                Marshal.Copy(outputData, buffer, 0, bytesToCopy);
-                outputData = IntPtr.Add(outputData, bytesToCopy);
-                outputStream.Write(buffer, 0, bytesToCopy);
-                outputDataLength -= (ulong)bytesToCopy;
-            }
-
-            NativeMethods.DisposeBuffer(OwnerContext.NativeContext, outputBuffer);
         }
 
 
@@ -1290,11 +2099,6 @@ namespace MuPDFCore
                 throw new ArgumentOutOfRangeException(nameof(quality), quality, "The JPEG quality must range between 0 and 100 (inclusive)!");
             }
 
-            if (DisplayLists[pageNumber] == null)
-            {
-                DisplayLists[pageNumber] = new MuPDFDisplayList(this.OwnerContext, this.Pages[pageNumber], includeAnnotations);
-            }
-
             if (zoom < 0.000001 | zoom * region.Width <= 0.001 || zoom * region.Height <= 0.001)
             {
                 throw new ArgumentOutOfRangeException(nameof(zoom), zoom, "The zoom factor is too small!");
@@ -1308,11 +2112,32 @@ namespace MuPDFCore
 
             float fzoom = (float)zoom;
 
-            IntPtr outputBuffer = IntPtr.Zero;
-            IntPtr outputData = IntPtr.Zero;
-            ulong outputDataLength = 0;
+            //The encoded image is passed to the stream in chunks while it is being written, rather than being accumulated in a native buffer first.
+            OutputStreamCallback output = new OutputStreamCallback(outputStream);
+
+            ExitCodes result;
+
+            if (this.DirectRendering)
+            {
+                result = (ExitCodes)NativeMethods.WritePageImageToStream(OwnerContext.NativeContext, Pages[pageNumber].NativePage, includeAnnotations ? 1 : 0, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)PixelFormats.RGB, (int)RasterOutputFileTypes.JPEG, quality, output.Callback);
+                this.ThrowIfInputFailed();
+            }
+            else
+            {
+                MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+                try
+                {
+                    result = (ExitCodes)NativeMethods.WriteImageToStream(OwnerContext.NativeContext, displayList.NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)PixelFormats.RGB, (int)RasterOutputFileTypes.JPEG, quality, output.Callback);
+                }
+                finally
+                {
+                    displayList.Unpin();
+                }
+            }
 
-            ExitCodes result = (ExitCodes)NativeMethods.WriteImage(OwnerContext.NativeContext, DisplayLists[pageNumber].NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, fzoom, (int)PixelFormats.RGB, (int)RasterOutputFileTypes.JPEG, quality, ref outputBuffer, ref outputData, ref outputDataLength);
+            GC.KeepAlive(output);
+            output.ThrowIfFailed();
 
             switch (result)
             {
@@ -1322,22 +2147,11 @@ namespace MuPDFCore
                     throw new MuPDFException("Cannot render page", result);
                 case ExitCodes.ERR_CANNOT_CREATE_BUFFER:
                     throw new MuPDFException("Cannot create the output buffer", result);
+                case ExitCodes.ERR_CANNOT_SAVE:
+                    throw new MuPDFException("Cannot write the image", result);
                 default:
                     throw new MuPDFException("Unknown error", result);
             }
-
-            byte[] buffer = new byte[1024];
-
-            while (outputDataLength > 0)
-            {
-                int bytesToCopy = (int)Math.Min(buffer.Length, (long)outputDataLength);
-                Marshal.Copy(outputData, buffer, 0, bytesToCopy);
-                outputData = IntPtr.Add(outputData, bytesToCopy);
-                outputStream.Write(buffer, 0, bytesToCopy);
-                outputDataLength -= (ulong)bytesToCopy;
-            }
-
-            NativeMethods.DisposeBuffer(OwnerContext.NativeContext, outputBuffer);
         }
 
         /// <summary>
@@ -1393,12 +2207,16 @@ namespace MuPDFCore
                 throw new DocumentLockedException("A password is necessary to render the document!");
             }
 
-            if (DisplayLists[pageNumber] == null)
+            MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+            try
             {
-                DisplayLists[pageNumber] = new MuPDFDisplayList(this.OwnerContext, this.Pages[pageNumber], includeAnnotations);
+                return new MuPDFStructuredTextPage(this.OwnerContext, displayList, null, 1, new Rectangle(), flags);
+            }
+            finally
+            {
+                displayList.Unpin();
             }
-
-            return new MuPDFStructuredTextPage(this.OwnerContext, this.DisplayLists[pageNumber], null, 1, new Rectangle(), flags);
         }
 
         /// <summary>
@@ -1418,11 +2236,6 @@ namespace MuPDFCore
                 throw new DocumentLockedException("A password is necessary to render the document!");
             }
 
-            if (DisplayLists[pageNumber] == null)
-            {
-                DisplayLists[pageNumber] = new MuPDFDisplayList(this.OwnerContext, this.Pages[pageNumber], includeAnnotations);
-            }
-
             double zoom = 1;
             Rectangle region = this.Pages[pageNumber].Bounds;
 
@@ -1432,7 +2245,16 @@ namespace MuPDFCore
                 region = new Rectangle(region.X0 * 72 / this.ImageXRes, region.Y0 * 72 / this.ImageYRes, region.X1 * 72 / this.ImageXRes, region.Y1 * 72 / this.ImageYRes);
             }
 
-            return new MuPDFStructuredTextPage(this.OwnerContext, this.DisplayLists[pageNumber], ocrLanguage, zoom, region, flags, cancellationToken, progress);
+            MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+            try
+            {
+                return new MuPDFStructuredTextPage(this.OwnerContext, displayList, ocrLanguage, zoom, region, flags, cancellationToken, progress);
+            }
+            finally
+            {
+                displayList.Unpin();
+            }
         }
 
         /// <summary>
@@ -1452,11 +2274,6 @@ namespace MuPDFCore
                 throw new DocumentLockedException("A password is necessary to render the document!");
             }
 
-            if (DisplayLists[pageNumber] == null)
-            {
-                DisplayLists[pageNumber] = new MuPDFDisplayList(this.OwnerContext, this.Pages[pageNumber], includeAnnotations);
-            }
-
             double zoom = 1;
             Rectangle region = this.Pages[pageNumber].Bounds;
 
@@ -1466,7 +2283,16 @@ namespace MuPDFCore
                 region = new Rectangle(region.X0 * 72 / this.ImageXRes, region.Y0 * 72 / this.ImageYRes, region.X1 * 72 / this.ImageXRes, region.Y1 * 72 / this.ImageYRes);
             }
 
-            return await Task.Run(() => new MuPDFStructuredTextPage(this.OwnerContext, this.DisplayLists[pageNumber], ocrLanguage, zoom, region, flags, cancellationToken, progress));
+            MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+            try
+            {
+                return await Task.Run(() => new MuPDFStructuredTextPage(this.OwnerContext, displayList, ocrLanguage, zoom, region, flags, cancellationToken, progress));
+            }
+            finally
+            {
+                displayList.Unpin();
+            }
         }
 
         /// <summary>
@@ -1517,6 +2343,218 @@ namespace MuPDFCore
             return text.ToString();
         }
 
+        /// <summary>
+        /// Extracts the text from a page directly into a buffer of characters, without creating a <see cref="MuPDFStructuredTextPage"/>. The text is the same that the page contributes to <see cref="ExtractText(string, bool)"/>:
+        /// lines that are empty or only contain white space are skipped. The reading order is taken from the order the text is drawn in the source file, so may not be accurate.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page (starting at 0).</param>
+        /// <param name="destination">The buffer where the text is written. If this is too small, only the text that fits is written (without splitting surrogate pairs).
+        /// This can be empty, to determine the length of the text.</param>
+        /// <param name="separator">The character(s) used to separate the text lines obtained from the page. If this is <see langword="null" />, <see cref="Environment.NewLine"/> is used as a default separator.</param>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included. Otherwise, only the page contents are included.</param>
+        /// <returns>The length of the text of the page, in <see cref="char"/>s. If this is greater than the length of the <paramref name="destination"/>, the text has been truncated.</returns>
+        public int ExtractPageText(int pageNumber, Span<char> destination, string separator = null, bool includeAnnotations = true)
+        {
+            if (this.EncryptionState == EncryptionState.Encrypted)
+            {
+                throw new DocumentLockedException("A password is necessary to render the document!");
+            }
+
+            separator = separator ?? Environment.NewLine;
+
+            MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+            long length = 0;
+            ExitCodes result;
+
+            try
+            {
+                using (UTF8EncodedString encodedSeparator = new UTF8EncodedString(separator))
+                {
+                    unsafe
+                    {
+                        fixed (char* destinationPointer = destination)
+                        {
+                            result = (ExitCodes)NativeMethods.GetPageText(OwnerContext.NativeContext, displayList.NativeDisplayList, (int)StructuredTextFlags.None, encodedSeparator.Address, (int)TextEncodings.UTF16, (IntPtr)destinationPointer, destination.Length, ref length);
+                        }
+                    }
+                }
+            }
+            finally
+            {
+                displayList.Unpin();
+            }
+
+            switch (result)
+            {
+                case ExitCodes.EXIT_SUCCESS:
+                    break;
+                case ExitCodes.ERR_CANNOT_CREATE_PAGE:
+                    throw new MuPDFException("Cannot create page", result);
+                case ExitCodes.ERR_CANNOT_POPULATE_PAGE:
+                    throw new MuPDFException("Cannot populate page", result);
+                default:
+                    throw new MuPDFException("Unknown error", result);
+            }
+
+            return checked((int)length);
+        }
+
+        /// <summary>
+        /// Searches for the specified literal string in the text of a page, using MuPDF's native search. The structured text page is created and searched in native code, without creating a <see cref="MuPDFStructuredTextPage"/>.
+        /// The white space in the <paramref name="needle"/> matches any amount of white space in the text, and a single hit can span multiple lines.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page to search (starting at 0).</param>
+        /// <param name="needle">The string to search for.</param>
+        /// <param name="caseSensitive">If this is <see langword="false"/>, the search ignores the case of the characters.</param>
+        /// <param name="maxHits">The maximum number of hits to return, or 0 to return all of them.</param>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included. Otherwise, only the page contents are included.</param>
+        /// <returns>An array of <see cref="MuPDFTextSearchHit"/>s representing the occurrences of the <paramref name="needle"/> in the page, in reading order. The addresses of the hits refer to the
+        /// <see cref="MuPDFStructuredTextPage"/> returned by <see cref="GetStructuredTextPage(int, bool, StructuredTextFlags)"/> with <see cref="StructuredTextFlags.None"/>.</returns>
+        public MuPDFTextSearchHit[] SearchPage(int pageNumber, string needle, bool caseSensitive = false, int maxHits = 0, bool includeAnnotations = true)
+        {
+            if (needle == null)
+            {
+                throw new ArgumentNullException(nameof(needle));
+            }
+
+            if (maxHits < 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(maxHits), maxHits, "The maximum number of hits must be greater than or equal to 0!");
+            }
+
+            if (this.EncryptionState == EncryptionState.Encrypted)
+            {
+                throw new DocumentLockedException("A password is necessary to render the document!");
+            }
+
+            if (needle.Length == 0)
+            {
+                return new MuPDFTextSearchHit[0];
+            }
+
+            MuPDFDisplayList displayList = Cache.GetDisplayList(pageNumber, includeAnnotations);
+
+            IntPtr data = IntPtr.Zero;
+            int hitCount = 0;
+            int quadCount = 0;
+
+            ExitCodes result;
+
+            try
+            {
+                using (UTF8EncodedString encodedNeedle = new UTF8EncodedString(needle))
+                {
+                    result = (ExitCodes)NativeMethods.SearchDisplayListText(OwnerContext.NativeContext, displayList.NativeDisplayList, (int)StructuredTextFlags.None, encodedNeedle.Address, (int)(caseSensitive ? SearchOptions.CaseSensitive : SearchOptions.None), maxHits, ref data, ref hitCount, ref quadCount);
+                }
+            }
+            finally
+            {
+                displayList.Unpin();
+            }
+
+            MuPDFTextSearchHit.CheckResult(result);
+
+            return MuPDFTextSearchHit.ReadHits(OwnerContext, data, hitCount, quadCount, pageNumber);
+        }
+
+        /// <summary>
+        /// Searches for the specified literal string in the text of every page of the document, using MuPDF's native search (see <see cref="SearchPage(int, string, bool, int, bool)"/>).
+        /// </summary>
+        /// <param name="needle">The string to search for.</param>
+        /// <param name="caseSensitive">If this is <see langword="false"/>, the search ignores the case of the characters.</param>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included. Otherwise, only the page contents are included.</param>
+        /// <returns>A lazy collection of <see cref="MuPDFTextSearchHit"/>s representing the occurrences of the <paramref name="needle"/> in the document. Each page is only searched when the enumeration reaches it.</returns>
+        public IEnumerable<MuPDFTextSearchHit> Search(string needle, bool caseSensitive = false, bool includeAnnotations = true)
+        {
+            if (needle == null)
+            {
+                throw new ArgumentNullException(nameof(needle));
+            }
+
+            return SearchPages(needle, caseSensitive, includeAnnotations);
+        }
+
+        /// <summary>
+        /// Lazily search all the pages of the document.
+        /// </summary>
+        private IEnumerable<MuPDFTextSearchHit> SearchPages(string needle, bool caseSensitive, bool includeAnnotations)
+        {
+            for (int i = 0; i < this.Pages.Count; i++)
+            {
+                foreach (MuPDFTextSearchHit hit in SearchPage(i, needle, caseSensitive, 0, includeAnnotations))
+                {
+                    yield return hit;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Extracts all the text from the document and returns it as a <see cref="string"/>, processing multiple pages at the same time. The reading order is taken from the order the text is drawn in the source file, so may not be accurate.
+        /// Each worker thread uses its own cloned context and its own handle to the document (see <see cref="MuPDFBatchRenderer"/>); the text of each page is produced as UTF-8 by the native code, and the pages are reassembled in order.
+        /// The result is the same as <see cref="ExtractText(string, bool)"/>. If the document was not opened from a file or from memory, the pages are processed sequentially.
+        /// </summary>
+        /// <param name="workerCount">The number of threads to use. If this is 0, a number of threads equal to the number of processors in the computer is used.</param>
+        /// <param name="separator">The character(s) used to separate the text lines obtained from the document. If this is <see langword="null" />, <see cref="Environment.NewLine"/> is used as a default separator.</param>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included. Otherwise, only the page contents are included.</param>
+        /// <returns>A <see cref="string"/> containing all the text in the document.</returns>
+        public string ExtractText(int workerCount, string separator = null, bool includeAnnotations = true)
+        {
+            if (this.EncryptionState == EncryptionState.Encrypted)
+            {
+                throw new DocumentLockedException("A password is necessary to render the document!");
+            }
+
+            if (workerCount < 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(workerCount), workerCount, "The number of workers must be greater than or equal to 0!");
+            }
+
+            if ((this.SourceFileName == null && this.SourceDataAddress == IntPtr.Zero) || this.Pages.Count == 0)
+            {
+                return ExtractText(separator, includeAnnotations);
+            }
+
+            separator = separator ?? Environment.NewLine;
+
+            string[] pageTexts = new string[this.Pages.Count];
+
+            using (MuPDFBatchRenderer renderer = new MuPDFBatchRenderer(this, workerCount) { IncludeAnnotations = includeAnnotations })
+            {
+                foreach (MuPDFBatchTextResult result in renderer.ExtractText(0, this.Pages.Count, separator))
+                {
+                    if (!result.Succeeded)
+                    {
+                        ExceptionDispatchInfo.Capture(result.Error).Throw();
+                    }
+
+                    pageTexts[result.PageNumber] = result.Text;
+                }
+            }
+
+            var text = new StringBuilder();
+            bool started = false;
+
+            for (int i = 0; i < pageTexts.Length; i++)
+            {
+                if (pageTexts[i].Length > 0)
+                {
+                    if (started)
+                    {
+                        text.Append(separator);
+                    }
+                    else
+                    {
+                        started = true;
+                    }
+
+                    text.Append(pageTexts[i]);
+                }
+            }
+
+            return text.ToString();
+        }
+
         /// <summary>
         /// Extracts all the text from the document and returns it as a <see cref="string"/>, using optical character recognition (OCR) to determine what text is written on the image.
         /// </summary>
@@ -1663,6 +2701,7 @@ namespace MuPDFCore
                     passwordType = PasswordTypes.None;
                     return true;
                 case 2:
+                    this.UnlockPassword = password;
                     if (this.EncryptionState == EncryptionState.Encrypted)
                     {
                         this.EncryptionState = EncryptionState.Unlocked;
@@ -1670,6 +2709,7 @@ namespace MuPDFCore
                     passwordType = PasswordTypes.User;
                     return true;
                 case 4:
+                    this.UnlockPassword = password;
                     if (this.RestrictionState == RestrictionState.Restricted)
                     {
                         this.RestrictionState = RestrictionState.Unlocked;
@@ -1677,6 +2717,7 @@ namespace MuPDFCore
                     passwordType = PasswordTypes.Owner;
                     return true;
                 case 6:
+                    this.UnlockPassword = password;
                     pt = 0;
 
                     if (this.EncryptionState == EncryptionState.Encrypted)
@@ -1707,11 +2748,10 @@ namespace MuPDFCore
             {
                 if (disposing)
                 {
-                    Pages.Dispose();
-                    foreach (MuPDFDisplayList list in DisplayLists)
-                    {
-                        list?.Dispose();
-                    }
+                    //Stop the background layout before the document data is released.
+                    IncrementalLayout?.Dispose();
+                    pages?.Dispose();
+                    Cache.Release();
                     DataHandle?.Free();
                     DataHolder?.Dispose();
                 }
@@ -1733,6 +2773,11 @@ namespace MuPDFCore
                     NativeMethods.DisposeStream(OwnerContext.NativeContext, NativeStream);
                 }
 
+                if (NativeMapping != IntPtr.Zero)
+                {
+                    NativeMethods.DisposeMappedFile(NativeMapping);
+                }
+
                 disposedValue = true;
             }
         }
@@ -0,0 +1,482 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2020  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+using System;
+using System.Collections.Generic;
+
+namespace MuPDFCore
+{
+    /// <summary>
+    /// Types of objects that can be held by a <see cref="MuPDFDocumentCache"/>.
+    /// </summary>
+    public enum CachedObjectType
+    {
+        /// <summary>
+        /// A native page object, which is loaded again when needed.
+        /// </summary>
+        Page,
+
+        /// <summary>
+        /// A display list, which is used to render the page or extract its text.
+        /// </summary>
+        DisplayList
+    }
+
+    /// <summary>
+    /// EventArgs for the <see cref="MuPDFDocumentCache.ObjectEvicted"/> event.
+    /// </summary>
+    public class CacheEvictionEventArgs : EventArgs
+    {
+        /// <summary>
+        /// The type of object that has been evicted.
+        /// </summary>
+        public CachedObjectType ObjectType { get; }
+
+        /// <summary>
+        /// The number of the page (starting at 0) to which the evicted object belonged.
+        /// </summary>
+        public int PageNumber { get; }
+
+        /// <summary>
+        /// For display lists, whether the display list included annotations. This is always <see langword="false"/> for pages.
+        /// </summary>
+        public bool IncludeAnnotations { get; }
+
+        /// <summary>
+        /// The estimated size in bytes of the evicted object.
+        /// </summary>
+        public long Size { get; }
+
+        /// <summary>
+        /// Create a new <see cref="CacheEvictionEventArgs"/> instance.
+        /// </summary>
+        /// <param name="objectType">The type of object that has been evicted.</param>
+        /// <param name="pageNumber">The number of the page (starting at 0) to which the evicted object belonged.</param>
+        /// <param name="includeAnnotations">For display lists, whether the display list included annotations.</param>
+        /// <param name="size">The estimated size in bytes of the evicted object.</param>
+        public CacheEvictionEventArgs(CachedObjectType objectType, int pageNumber, bool includeAnnotations, long size)
+        {
+            this.ObjectType = objectType;
+            this.PageNumber = pageNumber;
+            this.IncludeAnnotations = includeAnnotations;
+            this.Size = size;
+        }
+    }
+
+    /// <summary>
+    /// A least-recently-used cache holding the native pages and display lists that have been loaded from a <see cref="MuPDFDocument"/>.
+    /// When the total estimated size of the cached objects exceeds <see cref="MaxSize"/>, the objects that have not been used for the longest time are freed.
+    /// Display lists that are being used (e.g., by a <see cref="MuPDFMultiThreadedPageRenderer"/>) are never evicted.
+    /// </summary>
+    public class MuPDFDocumentCache
+    {
+        /// <summary>
+        /// The estimated size in bytes of a native page object. The actual size of a page cannot be determined, thus this is only a rough estimate.
+        /// </summary>
+        internal const long PageSizeEstimate = 4096;
+
+        /// <summary>
+        /// An object held by the cache.
+        /// </summary>
+        private class CacheEntry
+        {
+            /// <summary>
+            /// The key identifying the object.
+            /// </summary>
+            public (CachedObjectType, int, bool) Key;
+
+            /// <summary>
+            /// The estimated size of the object in bytes.
+            /// </summary>
+            public long Size;
+
+            /// <summary>
+            /// The cached page, if this entry holds a page.
+            /// </summary>
+            public MuPDFPage Page;
+
+            /// <summary>
+            /// The cached display list, if this entry holds a display list.
+            /// </summary>
+            public MuPDFDisplayList DisplayList;
+
+            /// <summary>
+            /// Whether the object is currently in use and cannot be evicted.
+            /// </summary>
+            public bool IsPinned => this.DisplayList?.IsPinned == true;
+        }
+
+        /// <summary>
+        /// The document whose objects are cached.
+        /// </summary>
+        private readonly MuPDFDocument OwnerDocument;
+
+        /// <summary>
+        /// Used to synchronise access to the cache.
+        /// </summary>
+        private readonly object CacheLock = new object();
+
+        /// <summary>
+        /// The cached objects, from the most recently used to the least recently used.
+        /// </summary>
+        private readonly LinkedList<CacheEntry> Entries = new LinkedList<CacheEntry>();
+
+        /// <summary>
+        /// Used to look up cached objects.
+        /// </summary>
+        private readonly Dictionary<(CachedObjectType, int, bool), LinkedListNode<CacheEntry>> Index = new Dictionary<(CachedObjectType, int, bool), LinkedListNode<CacheEntry>>();
+
+        private long maxSize = long.MaxValue;
+
+        /// <summary>
+        /// The maximum total estimated size in bytes of the objects held by the cache. By default, this is <see cref="long.MaxValue"/> (i.e., objects are never evicted).
+        /// Setting this to a lower value immediately evicts the least recently used objects, until the cache fits within the new limit (or only objects that are in use are left).
+        /// </summary>
+        public long MaxSize
+        {
+            get
+            {
+                return maxSize;
+            }
+
+            set
+            {
+                if (value < 0)
+                {
+                    throw new ArgumentOutOfRangeException(nameof(value), value, "The maximum size of the cache must be greater than or equal to 0!");
+                }
+
+                List<CacheEntry> evicted;
+
+                lock (CacheLock)
+                {
+                    maxSize = value;
+                    evicted = Trim(null);
+                }
+
+                NotifyEvicted(evicted);
+            }
+        }
+
+        /// <summary>
+        /// The current total estimated size in bytes of the objects held by the cache.
+        /// </summary>
+        public long CurrentSize { get; private set; }
+
+        /// <summary>
+        /// The number of objects currently held by the cache.
+        /// </summary>
+        public int Count
+        {
+            get
+            {
+                lock (CacheLock)
+                {
+                    return Entries.Count;
+                }
+            }
+        }
+
+        /// <summary>
+        /// The number of times a display list has been found in the cache.
+        /// </summary>
+        public long Hits { get; private set; }
+
+        /// <summary>
+        /// The number of times a display list had to be created because it was not in the cache.
+        /// </summary>
+        public long Misses { get; private set; }
+
+        /// <summary>
+        /// The number of objects that have been evicted from the cache.
+        /// </summary>
+        public long Evictions { get; private set; }
+
+        /// <summary>
+        /// Invoked after an object has been evicted from the cache, either because the cache exceeded its <see cref="MaxSize"/> or because it was cleared.
+        /// </summary>
+        public event EventHandler<CacheEvictionEventArgs> ObjectEvicted;
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocumentCache"/> for the specified document.
+        /// </summary>
+        /// <param name="document">The document whose objects will be cached.</param>
+        internal MuPDFDocumentCache(MuPDFDocument document)
+        {
+            this.OwnerDocument = document;
+        }
+
+        /// <summary>
+        /// Reset the <see cref="Hits"/>, <see cref="Misses"/> and <see cref="Evictions"/> counters.
+        /// </summary>
+        public void ResetStatistics()
+        {
+            lock (CacheLock)
+            {
+                this.Hits = 0;
+                this.Misses = 0;
+                this.Evictions = 0;
+            }
+        }
+
+        /// <summary>
+        /// Evict all the objects held by the cache. Display lists that are currently in use are removed from the cache, but they are only freed after they are no longer needed.
+        /// </summary>
+        public void Clear()
+        {
+            NotifyEvicted(RemoveAll(null));
+        }
+
+        /// <summary>
+        /// Evict all the display lists held by the cache.
+        /// </summary>
+        internal void ClearDisplayLists()
+        {
+            NotifyEvicted(RemoveAll(CachedObjectType.DisplayList));
+        }
+
+        /// <summary>
+        /// Free all the display lists held by the cache, without invoking the <see cref="ObjectEvicted"/> event. Used when the document is disposed.
+        /// </summary>
+        internal void Release()
+        {
+            RemoveAll(null);
+        }
+
+        /// <summary>
+        /// Get the display list for the specified page, creating it if it is not in the cache. The display list is pinned, and it will not be evicted until <see cref="MuPDFDisplayList.Unpin"/> is called.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page (starting at 0).</param>
+        /// <param name="includeAnnotations">Whether the display list should include annotations.</param>
+        /// <returns>A pinned <see cref="MuPDFDisplayList"/>.</returns>
+        internal MuPDFDisplayList GetDisplayList(int pageNumber, bool includeAnnotations)
+        {
+            (CachedObjectType, int, bool) key = (CachedObjectType.DisplayList, pageNumber, includeAnnotations);
+
+            lock (CacheLock)
+            {
+                if (Index.TryGetValue(key, out LinkedListNode<CacheEntry> node))
+                {
+                    Entries.Remove(node);
+                    Entries.AddFirst(node);
+                    Hits++;
+                    node.Value.DisplayList.Pin();
+                    return node.Value.DisplayList;
+                }
+
+                Misses++;
+            }
+
+            MuPDFDisplayList list = new MuPDFDisplayList(OwnerDocument.OwnerContext, OwnerDocument.Pages[pageNumber], includeAnnotations);
+            list.Pin();
+
+            Add(new CacheEntry() { Key = key, Size = list.Size, DisplayList = list });
+
+            return list;
+        }
+
+        /// <summary>
+        /// Determine whether the display list for the specified page is in the cache.
+        /// </summary>
+        /// <param name="pageNumber">The number of the page (starting at 0).</param>
+        /// <param name="includeAnnotations">Whether the display list includes annotations.</param>
+        /// <returns><see langword="true"/> if the display list is in the cache, <see langword="false"/> otherwise.</returns>
+        internal bool ContainsDisplayList(int pageNumber, bool includeAnnotations)
+        {
+            lock (CacheLock)
+            {
+                return Index.ContainsKey((CachedObjectType.DisplayList, pageNumber, includeAnnotations));
+            }
+        }
+
+        /// <summary>
+        /// Add a page whose native object has just been loaded to the cache.
+        /// </summary>
+        /// <param name="page">The page to add.</param>
+        internal void AddPage(MuPDFPage page)
+        {
+            Add(new CacheEntry() { Key = (CachedObjectType.Page, page.PageNumber, false), Size = PageSizeEstimate, Page = page });
+        }
+
+        /// <summary>
+        /// Mark a page as the most recently used object.
+        /// </summary>
+        /// <param name="page">The page that is being used.</param>
+        internal void TouchPage(MuPDFPage page)
+        {
+            lock (CacheLock)
+            {
+                if (Index.TryGetValue((CachedObjectType.Page, page.PageNumber, false), out LinkedListNode<CacheEntry> node) && node.Value.Page == page && node != Entries.First)
+                {
+                    Entries.Remove(node);
+                    Entries.AddFirst(node);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Remove a page from the cache without evicting it. Used when the page is disposed.
+        /// </summary>
+        /// <param name="page">The page to remove.</param>
+        internal void RemovePage(MuPDFPage page)
+        {
+            lock (CacheLock)
+            {
+                if (Index.TryGetValue((CachedObjectType.Page, page.PageNumber, false), out LinkedListNode<CacheEntry> node) && node.Value.Page == page)
+                {
+                    Entries.Remove(node);
+                    Index.Remove(node.Value.Key);
+                    CurrentSize -= node.Value.Size;
+                }
+            }
+        }
+
+        /// <summary>
+        /// Add an object to the cache, evicting older objects if necessary.
+        /// </summary>
+        /// <param name="entry">The entry holding the object.</param>
+        private void Add(CacheEntry entry)
+        {
+            List<CacheEntry> evicted;
+
+            lock (CacheLock)
+            {
+                if (Index.TryGetValue(entry.Key, out LinkedListNode<CacheEntry> existing))
+                {
+                    Entries.Remove(existing);
+                    Index.Remove(existing.Value.Key);
+                    CurrentSize -= existing.Value.Size;
+
+                    if (existing.Value.Page == null || existing.Value.Page != entry.Page)
+                    {
+                        Evict(existing.Value);
+                    }
+                }
+
+                LinkedListNode<CacheEntry> node = Entries.AddFirst(entry);
+                Index.Add(entry.Key, node);
+                CurrentSize += entry.Size;
+
+                evicted = Trim(node);
+            }
+
+            NotifyEvicted(evicted);
+        }
+
+        /// <summary>
+        /// Evict the least recently used objects until the cache fits within <see cref="MaxSize"/>. Must be called while holding <see cref="CacheLock"/>.
+        /// </summary>
+        /// <param name="keep">An entry that must not be evicted, because it has just been added.</param>
+        /// <returns>The entries that have been evicted.</returns>
+        private List<CacheEntry> Trim(LinkedListNode<CacheEntry> keep)
+        {
+            List<CacheEntry> evicted = null;
+
+            LinkedListNode<CacheEntry> node = Entries.Last;
+
+            while (CurrentSize > maxSize && node != null)
+            {
+                LinkedListNode<CacheEntry> previous = node.Previous;
+
+                if (node != keep && !node.Value.IsPinned)
+                {
+                    Entries.Remove(node);
+                    Index.Remove(node.Value.Key);
+                    CurrentSize -= node.Value.Size;
+                    Evictions++;
+                    Evict(node.Value);
+
+                    if (evicted == null)
+                    {
+                        evicted = new List<CacheEntry>();
+                    }
+
+                    evicted.Add(node.Value);
+                }
+
+                node = previous;
+            }
+
+            return evicted;
+        }
+
+        /// <summary>
+        /// Remove all the objects of the specified type from the cache and evict them.
+        /// </summary>
+        /// <param name="type">The type of objects to remove, or <see langword="null"/> to remove all objects.</param>
+        /// <returns>The entries that have been evicted.</returns>
+        private List<CacheEntry> RemoveAll(CachedObjectType? type)
+        {
+            List<CacheEntry> evicted = new List<CacheEntry>();
+
+            lock (CacheLock)
+            {
+                LinkedListNode<CacheEntry> node = Entries.First;
+
+                while (node != null)
+                {
+                    LinkedListNode<CacheEntry> next = node.Next;
+
+                    if (type == null || node.Value.Key.Item1 == type)
+                    {
+                        Entries.Remove(node);
+                        Index.Remove(node.Value.Key);
+                        CurrentSize -= node.Value.Size;
+                        Evictions++;
+                        Evict(node.Value);
+                        evicted.Add(node.Value);
+                    }
+
+                    node = next;
+                }
+            }
+
+            return evicted;
+        }
+
+        /// <summary>
+        /// Free the native resources held by an entry that has been removed from the cache.
+        /// </summary>
+        /// <param name="entry">The entry to evict.</param>
+        private static void Evict(CacheEntry entry)
+        {
+            if (entry.DisplayList != null)
+            {
+                entry.DisplayList.Evict();
+            }
+            else
+            {
+                entry.Page.ReleaseNativePage();
+            }
+        }
+
+        /// <summary>
+        /// Invoke the <see cref="ObjectEvicted"/> event for each evicted entry.
+        /// </summary>
+        /// <param name="evicted">The entries that have been evicted.</param>
+        private void NotifyEvicted(List<CacheEntry> evicted)
+        {
+            if (evicted != null && ObjectEvicted != null)
+            {
+                foreach (CacheEntry entry in evicted)
+                {
+                    ObjectEvicted.Invoke(this, new CacheEvictionEventArgs(entry.Key.Item1, entry.Key.Item2, entry.Key.Item3, entry.Size));
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,122 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2024  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+using System;
+
+namespace MuPDFCore
+{
+    /// <summary>
+    /// Options determining how a <see cref="MuPDFDocument"/> is laid out and how its pages are counted when it is opened. These are mostly relevant for reflowable
+    /// document types (e.g., EPUB, HTML, FB2), where laying out the document and counting its pages requires the whole document to be processed; documents with a
+    /// fixed layout (e.g., PDF) ignore the layout.
+    /// </summary>
+    public class MuPDFDocumentOpenOptions
+    {
+        private float layoutWidth = 595;
+
+        /// <summary>
+        /// The page width (in points) used to lay out reflowable documents when they are opened. The default is 595 (the width of an A4 page). Must be &gt; 0.
+        /// </summary>
+        public float LayoutWidth
+        {
+            get => layoutWidth;
+
+            set
+            {
+                if (value <= 0)
+                {
+                    throw new ArgumentOutOfRangeException(nameof(value), value, "The page width must be greater than 0!");
+                }
+
+                layoutWidth = value;
+            }
+        }
+
+        private float layoutHeight = 842;
+
+        /// <summary>
+        /// The page height (in points) used to lay out reflowable documents when they are opened. The default is 842 (the height of an A4 page). If this is 0, the
+        /// document is laid out as a single page, as tall as necessary (like <see cref="MuPDFDocument.LayoutSinglePage(float, float)"/>). Must be &gt;= 0.
+        /// </summary>
+        public float LayoutHeight
+        {
+            get => layoutHeight;
+
+            set
+            {
+                if (value < 0)
+                {
+                    throw new ArgumentOutOfRangeException(nameof(value), value, "The page height must be greater than or equal to 0!");
+                }
+
+                layoutHeight = value;
+            }
+        }
+
+        /// <summary>
+        /// The default font size (in points) used to lay out reflowable documents when they are opened. The default is 11.
+        /// </summary>
+        public float LayoutEm { get; set; } = 11;
+
+        /// <summary>
+        /// If this is <see langword="true"/>, reflowable documents are not laid out when they are opened, and their pages are not counted. This is useful when
+        /// <see cref="MuPDFDocument.Layout(float, float, float)"/> or <see cref="MuPDFDocument.LayoutSinglePage(float, float)"/> is going to be called immediately
+        /// afterwards, because it avoids laying out the whole document twice. If <see cref="MuPDFDocument.Pages"/> is accessed before the layout is set, the document is laid out
+        /// at that point using <see cref="LayoutWidth"/>, <see cref="LayoutHeight"/> and <see cref="LayoutEm"/>.
+        /// </summary>
+        public bool DeferLayout { get; set; } = false;
+
+        /// <summary>
+        /// If this is <see langword="true"/>, the pages of the document are not counted when it is opened, but only the first time that <see cref="MuPDFDocument.Pages"/> is accessed.
+        /// </summary>
+        public bool LazyPageCount { get; set; } = false;
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocumentOpenOptions"/> with the default values (an A4 page layout, with the pages counted when the document is opened).
+        /// </summary>
+        public MuPDFDocumentOpenOptions() { }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFDocumentOpenOptions"/> with the specified initial layout.
+        /// </summary>
+        /// <param name="layoutWidth">The page width (in points) used to lay out reflowable documents when they are opened. Must be &gt; 0.</param>
+        /// <param name="layoutHeight">The page height (in points) used to lay out reflowable documents when they are opened. If this is 0, the document is laid out as a single page. Must be &gt;= 0.</param>
+        /// <param name="layoutEm">The default font size (in points) used to lay out reflowable documents when they are opened.</param>
+        public MuPDFDocumentOpenOptions(float layoutWidth, float layoutHeight, float layoutEm)
+        {
+            this.LayoutWidth = layoutWidth;
+            this.LayoutHeight = layoutHeight;
+            this.LayoutEm = layoutEm;
+        }
+
+        /// <summary>
+        /// Get the values to pass to the native functions that open documents.
+        /// </summary>
+        /// <param name="width">The page width for the initial layout, or -1 if the document should not be laid out.</param>
+        /// <param name="height">The page height for the initial layout.</param>
+        /// <param name="em">The default font size for the initial layout.</param>
+        /// <param name="countPages">1 if the pages should be counted when the document is opened, 0 otherwise.</param>
+        internal void GetNativeLayout(out float width, out float height, out float em, out int countPages)
+        {
+            width = this.DeferLayout ? -1 : this.LayoutWidth;
+            height = this.LayoutHeight;
+            em = this.LayoutEm;
+            countPages = this.DeferLayout || this.LazyPageCount ? 0 : 1;
+        }
+    }
+}
@@ -293,11 +293,12 @@ namespace MuPDFCore
                 }
             }
 
-            IntPtr outputBuffer = IntPtr.Zero;
-            IntPtr outputData = IntPtr.Zero;
-            ulong outputDataLength = 0;
+            OutputStreamCallback output = new OutputStreamCallback(outputStream);
 
-            ExitCodes result = (ExitCodes)NativeMethods.WriteRasterImage(OwnerContext.NativeContext, this.NativePointer, (int)fileType, 90, ref outputBuffer, ref outputData, ref outputDataLength, convertToRGB == true ? 1 : 0);
+            ExitCodes result = (ExitCodes)NativeMethods.WriteRasterImageToStream(OwnerContext.NativeContext, this.NativePointer, (int)fileType, 90, convertToRGB == true ? 1 : 0, output.Callback);
+
+            GC.KeepAlive(output);
+            output.ThrowIfFailed();
 
             switch (result)
             {
@@ -307,22 +308,11 @@ namespace MuPDFCore
                     throw new MuPDFException("Cannot render page", result);
                 case ExitCodes.ERR_CANNOT_CREATE_BUFFER:
                     throw new MuPDFException("Cannot create the output buffer", result);
+                case ExitCodes.ERR_CANNOT_SAVE:
+                    throw new MuPDFException("Cannot write the image", result);
                 default:
                     throw new MuPDFException("Unknown error", result);
             }
-
-            byte[] buffer = new byte[1024];
-
-            while (outputDataLength > 0)
-            {
-                int bytesToCopy = (int)Math.Min(buffer.Length, (long)outputDataLength);
-                Marshal.Copy(outputData, buffer, 0, bytesToCopy);
-                outputData = IntPtr.Add(outputData, bytesToCopy);
-                outputStream.Write(buffer, 0, bytesToCopy);
-                outputDataLength -= (ulong)bytesToCopy;
-            }
-
-            NativeMethods.DisposeBuffer(OwnerContext.NativeContext, outputBuffer);
         }
 
         /// <summary>
@@ -357,11 +347,12 @@ namespace MuPDFCore
                 }
             }
 
-            IntPtr outputBuffer = IntPtr.Zero;
-            IntPtr outputData = IntPtr.Zero;
-            ulong outputDataLength = 0;
+            OutputStreamCallback output = new OutputStreamCallback(outputStream);
 
-            ExitCodes result = (ExitCodes)NativeMethods.WriteRasterImage(OwnerContext.NativeContext, this.NativePointer, (int)RasterOutputFileTypes.JPEG, quality, ref outputBuffer, ref outputData, ref outputDataLength, convertToRGB == true ? 1 : 0);
+            ExitCodes result = (ExitCodes)NativeMethods.WriteRasterImageToStream(OwnerContext.NativeContext, this.NativePointer, (int)RasterOutputFileTypes.JPEG, quality, convertToRGB == true ? 1 : 0, output.Callback);
+
+            GC.KeepAlive(output);
+            output.ThrowIfFailed();
 
             switch (result)
             {
@@ -371,22 +362,11 @@ namespace MuPDFCore
                     throw new MuPDFException("Cannot render page", result);
                 case ExitCodes.ERR_CANNOT_CREATE_BUFFER:
                     throw new MuPDFException("Cannot create the output buffer", result);
+                case ExitCodes.ERR_CANNOT_SAVE:
+                    throw new MuPDFException("Cannot write the image", result);
                 default:
                     throw new MuPDFException("Unknown error", result);
             }
-
-            byte[] buffer = new byte[1024];
-
-            while (outputDataLength > 0)
-            {
-                int bytesToCopy = (int)Math.Min(buffer.Length, (long)outputDataLength);
-                Marshal.Copy(outputData, buffer, 0, bytesToCopy);
-                outputData = IntPtr.Add(outputData, bytesToCopy);
-                outputStream.Write(buffer, 0, bytesToCopy);
-                outputDataLength -= (ulong)bytesToCopy;
-            }
-
-            NativeMethods.DisposeBuffer(OwnerContext.NativeContext, outputBuffer);
         }
 
         /// <summary>
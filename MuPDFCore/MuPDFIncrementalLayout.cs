@@ -0,0 +1,309 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2024  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+using System;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace MuPDFCore
+{
+    /// <summary>
+    /// Describes the progress of a <see cref="MuPDFIncrementalLayout"/>.
+    /// </summary>
+    public class LayoutProgressInfo
+    {
+        /// <summary>
+        /// The number of chapters in the document.
+        /// </summary>
+        public int ChapterCount { get; }
+
+        /// <summary>
+        /// The number of chapters that have been laid out so far.
+        /// </summary>
+        public int LaidOutChapters { get; }
+
+        /// <summary>
+        /// The number of pages in the chapters that have been laid out so far.
+        /// </summary>
+        public int KnownPageCount { get; }
+
+        /// <summary>
+        /// A value between 0 and 1, indicating how much progress has been completed.
+        /// </summary>
+        public double Progress => ChapterCount > 0 ? (double)LaidOutChapters / ChapterCount : 1;
+
+        internal LayoutProgressInfo(int chapterCount, int laidOutChapters, int knownPageCount)
+        {
+            this.ChapterCount = chapterCount;
+            this.LaidOutChapters = laidOutChapters;
+            this.KnownPageCount = knownPageCount;
+        }
+    }
+
+    /// <summary>
+    /// Represents a layout of a reflowable document that is being computed incrementally, one chapter at a time (see <see cref="MuPDFDocument.LayoutIncrementally"/>).
+    /// While the layout is running, <see cref="MuPDFDocument.Pages"/> contains the pages of the chapters that have been laid out so far, and grows as more
+    /// chapters are laid out. Disposing this object cancels the layout, if it has not completed yet.
+    /// </summary>
+    public class MuPDFIncrementalLayout : IDisposable
+    {
+        /// <summary>
+        /// Used to stop the background layout when the caller's token is cancelled or this object is disposed.
+        /// </summary>
+        private readonly CancellationTokenSource CancellationSource;
+
+        /// <summary>
+        /// Completed with the total page count when all the chapters have been laid out.
+        /// </summary>
+        private readonly TaskCompletionSource<int> CompletionSource = new TaskCompletionSource<int>(TaskCreationOptions.RunContinuationsAsynchronously);
+
+        /// <summary>
+        /// The task that lays out the chapters in the background, or <see langword="null"/> if the layout was completed synchronously.
+        /// </summary>
+        private readonly Task BackgroundTask;
+
+        /// <summary>
+        /// The cloned context used by the background layout.
+        /// </summary>
+        private MuPDFContext BackgroundContext;
+
+        /// <summary>
+        /// The background layout's own handle to the document.
+        /// </summary>
+        private IntPtr BackgroundDocument;
+
+        /// <summary>
+        /// The native stream from which <see cref="BackgroundDocument"/> was opened (if any).
+        /// </summary>
+        private IntPtr BackgroundStream;
+
+        private int knownPageCount;
+        private int laidOutChapters;
+
+        /// <summary>
+        /// The number of chapters in the document.
+        /// </summary>
+        public int ChapterCount { get; }
+
+        /// <summary>
+        /// The number of chapters that have been laid out so far. Chapters are laid out in order, starting from the first one.
+        /// </summary>
+        public int LaidOutChapters => Volatile.Read(ref laidOutChapters);
+
+        /// <summary>
+        /// The number of pages in the chapters that have been laid out so far.
+        /// </summary>
+        public int KnownPageCount => Volatile.Read(ref knownPageCount);
+
+        /// <summary>
+        /// Whether all the chapters have been laid out.
+        /// </summary>
+        public bool IsCompleted => LaidOutChapters == ChapterCount;
+
+        /// <summary>
+        /// A <see cref="Task{TResult}"/> that completes with the total number of pages in the document when all the chapters have been laid out. If the layout is cancelled,
+        /// the task is cancelled, and <see cref="MuPDFDocument.Pages"/> only contains the pages of the chapters that had been laid out.
+        /// </summary>
+        public Task<int> Completion => CompletionSource.Task;
+
+        /// <summary>
+        /// Start laying out the chapters following the first one. If the <paramref name="document"/> can be reopened from its source (a file or memory), the chapters are laid out
+        /// on a background thread using a cloned context; otherwise, they are laid out synchronously.
+        /// </summary>
+        /// <param name="document">The document that is being laid out. Its layout must already have been set, and its first chapter must have been laid out.</param>
+        /// <param name="chapterCount">The number of chapters in the document.</param>
+        /// <param name="firstChapterPageCount">The number of pages in the first chapter.</param>
+        /// <param name="cancellationToken">A <see cref="CancellationToken"/> used to cancel the layout.</param>
+        /// <param name="progress">An <see cref="IProgress{T}"/> that is notified each time a chapter has been laid out.</param>
+        internal MuPDFIncrementalLayout(MuPDFDocument document, int chapterCount, int firstChapterPageCount, CancellationToken cancellationToken, IProgress<LayoutProgressInfo> progress)
+        {
+            this.ChapterCount = chapterCount;
+            this.knownPageCount = firstChapterPageCount;
+            this.laidOutChapters = Math.Min(1, chapterCount);
+            this.CancellationSource = CancellationTokenSource.CreateLinkedTokenSource(cancellationToken);
+
+            progress?.Report(new LayoutProgressInfo(this.ChapterCount, this.laidOutChapters, this.knownPageCount));
+
+            if (this.laidOutChapters == this.ChapterCount)
+            {
+                CompletionSource.SetResult(this.knownPageCount);
+                return;
+            }
+
+            if (document.SourceFileName == null && document.SourceDataAddress == IntPtr.Zero)
+            {
+                //The document cannot be opened again, and its handle cannot be used concurrently.
+                LayOutChapters(document.OwnerContext.NativeContext, document.NativeDocument, document, this.CancellationSource.Token, progress);
+                return;
+            }
+
+            IntPtr[] contexts = new IntPtr[1];
+            GCHandle contextsHandle = GCHandle.Alloc(contexts, GCHandleType.Pinned);
+
+            try
+            {
+                ExitCodes result = (ExitCodes)NativeMethods.CloneContext(document.OwnerContext.NativeContext, 1, contextsHandle.AddrOfPinnedObject());
+
+                switch (result)
+                {
+                    case ExitCodes.EXIT_SUCCESS:
+                        break;
+                    case ExitCodes.ERR_CANNOT_INIT_MUTEX:
+                        throw new MuPDFException("Cannot initalize mutex objects", result);
+                    case ExitCodes.ERR_CANNOT_CREATE_CONTEXT:
+                        throw new MuPDFException("Cannot create master context", result);
+                    case ExitCodes.ERR_CANNOT_CLONE_CONTEXT:
+                        throw new MuPDFException("Cannot create context clones", result);
+                    default:
+                        throw new MuPDFException("Unknown error", result);
+                }
+            }
+            finally
+            {
+                contextsHandle.Free();
+            }
+
+            this.BackgroundContext = new MuPDFContext(document.OwnerContext, contexts[0]);
+
+            try
+            {
+                document.OpenSourceDocument(this.BackgroundContext, ref this.BackgroundDocument, ref this.BackgroundStream);
+            }
+            catch
+            {
+                ReleaseBackgroundDocument();
+                throw;
+            }
+
+            CancellationToken token = this.CancellationSource.Token;
+
+            this.BackgroundTask = Task.Factory.StartNew(() =>
+            {
+                try
+                {
+                    LayOutChapters(this.BackgroundContext.NativeContext, this.BackgroundDocument, null, token, progress);
+                }
+                finally
+                {
+                    ReleaseBackgroundDocument();
+                }
+            }, CancellationToken.None, TaskCreationOptions.LongRunning, TaskScheduler.Default);
+        }
+
+        /// <summary>
+        /// Lay out the remaining chapters, one at a time, updating the page count after each chapter.
+        /// </summary>
+        /// <param name="nativeContext">The context that owns the <paramref name="nativeDocument"/>.</param>
+        /// <param name="nativeDocument">The document handle used to lay out the chapters, with the same layout as the document that is being laid out.</param>
+        /// <param name="inputDocument">The document that owns <paramref name="nativeDocument"/>, used to report errors reading its source stream, or <see langword="null"/> if the document was reopened from its source.</param>
+        /// <param name="cancellationToken">A <see cref="CancellationToken"/> used to cancel the layout.</param>
+        /// <param name="progress">An <see cref="IProgress{T}"/> that is notified each time a chapter has been laid out.</param>
+        private void LayOutChapters(IntPtr nativeContext, IntPtr nativeDocument, MuPDFDocument inputDocument, CancellationToken cancellationToken, IProgress<LayoutProgressInfo> progress)
+        {
+            try
+            {
+                for (int i = this.LaidOutChapters; i < this.ChapterCount; i++)
+                {
+                    if (cancellationToken.IsCancellationRequested)
+                    {
+                        CompletionSource.TrySetCanceled(cancellationToken);
+                        return;
+                    }
+
+                    ExitCodes result = (ExitCodes)NativeMethods.CountChapterPages(nativeContext, nativeDocument, i, out int chapterPageCount);
+
+                    if (result != ExitCodes.EXIT_SUCCESS)
+                    {
+                        inputDocument?.ThrowIfInputFailed();
+                        CompletionSource.TrySetException(new MuPDFException("Cannot count pages", result));
+                        return;
+                    }
+
+                    int pageCount = Interlocked.Add(ref this.knownPageCount, chapterPageCount);
+                    Volatile.Write(ref this.laidOutChapters, i + 1);
+
+                    progress?.Report(new LayoutProgressInfo(this.ChapterCount, i + 1, pageCount));
+                }
+
+                CompletionSource.TrySetResult(this.KnownPageCount);
+            }
+            catch (Exception ex)
+            {
+                CompletionSource.TrySetException(ex);
+            }
+        }
+
+        /// <summary>
+        /// Free the background layout's document handle and context.
+        /// </summary>
+        private void ReleaseBackgroundDocument()
+        {
+            if (this.BackgroundDocument != IntPtr.Zero)
+            {
+                NativeMethods.DisposeDocument(this.BackgroundContext.NativeContext, this.BackgroundDocument);
+                this.BackgroundDocument = IntPtr.Zero;
+            }
+
+            if (this.BackgroundStream != IntPtr.Zero)
+            {
+                NativeMethods.DisposeStream(this.BackgroundContext.NativeContext, this.BackgroundStream);
+                this.BackgroundStream = IntPtr.Zero;
+            }
+
+            if (this.BackgroundContext != null)
+            {
+                this.BackgroundContext.Dispose();
+                this.BackgroundContext = null;
+            }
+        }
+
+        private bool disposedValue;
+
+        ///<inheritdoc/>
+        protected virtual void Dispose(bool disposing)
+        {
+            if (!disposedValue)
+            {
+                disposedValue = true;
+
+                if (disposing)
+                {
+                    this.CancellationSource.Cancel();
+
+                    //Wait until the background layout stops, so that the document's data is not freed while it is still being read.
+                    try
+                    {
+                        this.BackgroundTask?.Wait();
+                    }
+                    catch (AggregateException) { }
+
+                    this.CancellationSource.Dispose();
+                    CompletionSource.TrySetCanceled();
+                }
+            }
+        }
+
+        ///<inheritdoc/>
+        public void Dispose()
+        {
+            Dispose(disposing: true);
+            GC.SuppressFinalize(this);
+        }
+    }
+}
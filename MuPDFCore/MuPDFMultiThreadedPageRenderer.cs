@@ -20,9 +20,158 @@ using System.Collections.Generic;
 using System.Linq;
 using System.Runtime.InteropServices;
 using System.Threading;
+using System.Threading.Tasks;
 
 namespace MuPDFCore
 {
+    /// <summary>
+    /// A set of tiles that are rendered by multiple <see cref="RenderingThread"/>s. Each thread pulls the next tile from a shared counter until all the tiles have been rendered, so that threads that finish early take over work from the others.
+    /// </summary>
+    internal class TileRenderJob
+    {
+        /// <summary>
+        /// The display list being rendered.
+        /// </summary>
+        public MuPDFDisplayList DisplayList;
+
+        /// <summary>
+        /// The scale at which the display list is rendered (already corrected for the image resolution).
+        /// </summary>
+        public float Zoom;
+
+        /// <summary>
+        /// The horizontal device coordinate (in pixels) of the top-left corner of the image.
+        /// </summary>
+        public int OriginX;
+
+        /// <summary>
+        /// The vertical device coordinate (in pixels) of the top-left corner of the image.
+        /// </summary>
+        public int OriginY;
+
+        /// <summary>
+        /// The size in pixels of the whole image.
+        /// </summary>
+        public RoundedSize TargetSize;
+
+        /// <summary>
+        /// The width and height in pixels of each tile (tiles on the right and bottom edges may be smaller).
+        /// </summary>
+        public int TileSize;
+
+        /// <summary>
+        /// The number of tile columns.
+        /// </summary>
+        public int Columns;
+
+        /// <summary>
+        /// The total number of tiles.
+        /// </summary>
+        public int TileCount;
+
+        /// <summary>
+        /// The address of the buffer where the whole image is written.
+        /// </summary>
+        public IntPtr Destination;
+
+        /// <summary>
+        /// The format of the pixel data.
+        /// </summary>
+        public PixelFormats PixelFormat;
+
+        /// <summary>
+        /// The bounds of the page being rendered.
+        /// </summary>
+        public Rectangle PageBounds;
+
+        /// <summary>
+        /// Whether the rendered image should be clipped to the bounds of the page.
+        /// </summary>
+        public bool ClipToPageBounds;
+
+        /// <summary>
+        /// Whether images with an alpha channel should be left with premultiplied colour values.
+        /// </summary>
+        public bool PremultipliedAlpha;
+
+        /// <summary>
+        /// Invoked (on the rendering thread) after each tile has been copied to the <see cref="Destination"/>.
+        /// </summary>
+        public Action<RoundedRectangle> TileRendered;
+
+        /// <summary>
+        /// The index of the next tile that should be rendered, minus one.
+        /// </summary>
+        private int NextTile = -1;
+
+        /// <summary>
+        /// The first exception that occurred while rendering, if any.
+        /// </summary>
+        public Exception Error;
+
+        /// <summary>
+        /// Render tiles until there are no more left, or the rendering is aborted.
+        /// </summary>
+        /// <param name="context">The rendering context.</param>
+        /// <param name="cookie">A pointer to the <see cref="Cookie"/> of the calling thread.</param>
+        public unsafe void Run(IntPtr context, IntPtr cookie)
+        {
+            int pixelSize = this.PixelFormat == PixelFormats.RGBA || this.PixelFormat == PixelFormats.BGRA ? 4 : 3;
+            int destinationStride = this.TargetSize.Width * pixelSize;
+
+            IntPtr tileBuffer = Marshal.AllocHGlobal(this.TileSize * this.TileSize * pixelSize);
+
+            try
+            {
+                int tile;
+
+                while ((tile = Interlocked.Increment(ref NextTile)) < this.TileCount && ((Cookie*)cookie)->abort == 0 && this.Error == null)
+                {
+                    int x0 = (tile % this.Columns) * this.TileSize;
+                    int y0 = (tile / this.Columns) * this.TileSize;
+                    int x1 = Math.Min(x0 + this.TileSize, this.TargetSize.Width);
+                    int y1 = Math.Min(y0 + this.TileSize, this.TargetSize.Height);
+
+                    RoundedSize tileSize = new RoundedSize(x1 - x0, y1 - y0);
+                    Rectangle region = new Rectangle((this.OriginX + x0) / (double)this.Zoom, (this.OriginY + y0) / (double)this.Zoom, (this.OriginX + x1) / (double)this.Zoom, (this.OriginY + y1) / (double)this.Zoom);
+
+                    RenderFlags flags = Utils.GetRenderFlags(region, this.DisplayList, context, this.PageBounds, this.ClipToPageBounds, this.PremultipliedAlpha);
+
+                    ExitCodes result = (ExitCodes)NativeMethods.RenderSubDisplayList(context, this.DisplayList.NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, this.Zoom, (int)this.PixelFormat, tileBuffer, (int)flags, this.PageBounds.X0, this.PageBounds.Y0, this.PageBounds.X1, this.PageBounds.Y1, cookie);
+
+                    switch (result)
+                    {
+                        case ExitCodes.EXIT_SUCCESS:
+                            break;
+                        case ExitCodes.ERR_CANNOT_RENDER:
+                            throw new MuPDFException("Cannot render page", result);
+                        default:
+                            throw new MuPDFException("Unknown error", result);
+                    }
+
+                    int tileStride = tileSize.Width * pixelSize;
+                    byte* source = (byte*)tileBuffer;
+                    byte* destination = (byte*)this.Destination + y0 * destinationStride + x0 * pixelSize;
+
+                    for (int y = 0; y < tileSize.Height; y++)
+                    {
+                        Buffer.MemoryCopy(source + y * tileStride, destination + y * destinationStride, tileStride, tileStride);
+                    }
+
+                    this.TileRendered?.Invoke(new RoundedRectangle(x0, y0, x1, y1));
+                }
+            }
+            catch (Exception ex)
+            {
+                Interlocked.CompareExchange(ref this.Error, ex, null);
+            }
+            finally
+            {
+                Marshal.FreeHGlobal(tileBuffer);
+            }
+        }
+    }
+
     /// <summary>
     /// A reusable thread to render part of an image.
     /// </summary>
@@ -41,6 +190,7 @@ namespace MuPDFCore
             public Rectangle PageBounds;
             public PixelFormats PixelFormat;
             public bool ClipToPageBounds;
+            public bool PremultipliedAlpha;
         }
 
         /// <summary>
@@ -78,12 +228,55 @@ namespace MuPDFCore
         /// </summary>
         private readonly IntPtr Cookie;
 
+        /// <summary>
+        /// The set of tiles that the thread should contribute to rendering, if any.
+        /// </summary>
+        private TileRenderJob CurrentTileJob;
+
+        /// <summary>
+        /// Completed when the current rendering operation finishes.
+        /// </summary>
+        private TaskCompletionSource<bool> Completion;
+
+        /// <summary>
+        /// The exception that occurred during the last rendering operation, if any.
+        /// </summary>
+        private Exception LastError;
+
         /// <summary>
         /// Performs the actual rendering.
         /// </summary>
         private void RenderAction()
         {
-            ExitCodes result = (ExitCodes)NativeMethods.RenderSubDisplayList(this.CurrentRenderData.Context, this.CurrentRenderData.DisplayList.NativeDisplayList, this.CurrentRenderData.Region.X0, this.CurrentRenderData.Region.Y0, this.CurrentRenderData.Region.X1, this.CurrentRenderData.Region.Y1, this.CurrentRenderData.Zoom, (int)this.CurrentRenderData.PixelFormat, this.CurrentRenderData.PixelStorage, Cookie);
+            if (this.CurrentTileJob != null)
+            {
+                TileRenderJob job = this.CurrentTileJob;
+                this.CurrentTileJob = null;
+                job.Run(this.CurrentRenderData.Context, Cookie);
+                return;
+            }
+
+            RenderRegion(this.CurrentRenderData.Context, this.CurrentRenderData.DisplayList, this.CurrentRenderData.Region, this.CurrentRenderData.Zoom, this.CurrentRenderData.PixelStorage, this.CurrentRenderData.PixelFormat, this.CurrentRenderData.PageBounds, this.CurrentRenderData.ClipToPageBounds, this.CurrentRenderData.PremultipliedAlpha, Cookie);
+        }
+
+        /// <summary>
+        /// Render a region of a display list to the specified destination, on the calling thread.
+        /// </summary>
+        /// <param name="context">The rendering context.</param>
+        /// <param name="displayList">The native display list that should be rendered.</param>
+        /// <param name="region">The region that should be rendered.</param>
+        /// <param name="zoom">The scale at which the region will be rendered. This will determine the size in pixel of the image.</param>
+        /// <param name="pixelStorage">The address of the buffer where the pixel data will be written. There must be enough space available to write the values for all the pixels, otherwise this will fail catastrophically!</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <param name="pageBounds">The bounds of the page being rendererd.</param>
+        /// <param name="clipToPageBounds">A boolean value indicating whether the rendered image should be clipped to the original page's bounds.</param>
+        /// <param name="premultipliedAlpha">A boolean value indicating whether images with an alpha channel should be left with premultiplied colour values.</param>
+        /// <param name="cookie">A pointer to a <see cref="MuPDFCore.Cookie"/> object that can be used to monitor the progress of the rendering or to abort it.</param>
+        internal static void RenderRegion(IntPtr context, MuPDFDisplayList displayList, Rectangle region, float zoom, IntPtr pixelStorage, PixelFormats pixelFormat, Rectangle pageBounds, bool clipToPageBounds, bool premultipliedAlpha, IntPtr cookie)
+        {
+            RenderFlags flags = Utils.GetRenderFlags(region, displayList, context, pageBounds, clipToPageBounds, premultipliedAlpha);
+
+            ExitCodes result = (ExitCodes)NativeMethods.RenderSubDisplayList(context, displayList.NativeDisplayList, region.X0, region.Y0, region.X1, region.Y1, zoom, (int)pixelFormat, pixelStorage, (int)flags, pageBounds.X0, pageBounds.Y0, pageBounds.X1, pageBounds.Y1, cookie);
 
             switch (result)
             {
@@ -94,19 +287,45 @@ namespace MuPDFCore
                 default:
                     throw new MuPDFException("Unknown error", result);
             }
+        }
 
-            RoundedRectangle roundedRegion = this.CurrentRenderData.Region.Round(this.CurrentRenderData.Zoom);
-            RoundedSize roundedSize = new RoundedSize(roundedRegion.Width, roundedRegion.Height);
-
-            if (this.CurrentRenderData.PixelFormat == PixelFormats.RGBA || this.CurrentRenderData.PixelFormat == PixelFormats.BGRA)
+        /// <summary>
+        /// Reset the fields of a <see cref="MuPDFCore.Cookie"/> before starting a new rendering operation.
+        /// </summary>
+        /// <param name="cookie">A pointer to the <see cref="MuPDFCore.Cookie"/>.</param>
+        internal static void ResetCookie(IntPtr cookie)
+        {
+            unsafe
             {
-                Utils.UnpremultiplyAlpha(this.CurrentRenderData.PixelStorage, roundedSize);
+                Cookie* cookiePtr = (Cookie*)cookie;
+
+                cookiePtr->abort = 0;
+                cookiePtr->errors = 0;
+                cookiePtr->incomplete = 0;
+                cookiePtr->progress = 0;
+                cookiePtr->progress_max = 0;
             }
+        }
 
-            if (this.CurrentRenderData.ClipToPageBounds && !this.CurrentRenderData.PageBounds.Contains(this.CurrentRenderData.DisplayList.Bounds.Intersect(this.CurrentRenderData.Region)))
+        /// <summary>
+        /// Get the progress of the rendering operation associated with a <see cref="MuPDFCore.Cookie"/>.
+        /// </summary>
+        /// <param name="cookie">A pointer to the <see cref="MuPDFCore.Cookie"/>.</param>
+        /// <returns>A <see cref="RenderProgress.ThreadRenderProgress"/> object containing the progress of the rendering operation.</returns>
+        internal static RenderProgress.ThreadRenderProgress GetCookieProgress(IntPtr cookie)
+        {
+            int progress;
+            ulong maxProgress;
+
+            unsafe
             {
-                Utils.ClipImage(this.CurrentRenderData.PixelStorage, roundedSize, this.CurrentRenderData.Region, this.CurrentRenderData.PageBounds, this.CurrentRenderData.PixelFormat);
+                Cookie* cookiePtr = (Cookie*)cookie;
+
+                progress = cookiePtr->progress;
+                maxProgress = cookiePtr->progress_max;
             }
+
+            return new RenderProgress.ThreadRenderProgress(progress, maxProgress);
         }
 
         /// <summary>
@@ -138,12 +357,34 @@ namespace MuPDFCore
                     {
                         SignalToThread.Reset();
 
+                        TaskCompletionSource<bool> completion;
+                        Exception error = null;
+
                         lock (RenderDataLock)
                         {
-                            this.RenderAction();
+                            completion = this.Completion;
+
+                            try
+                            {
+                                this.RenderAction();
+                            }
+                            catch (Exception ex)
+                            {
+                                error = ex;
+                            }
+
+                            this.LastError = error;
+                            SignalFromThread.Set();
                         }
 
-                        SignalFromThread.Set();
+                        if (error == null)
+                        {
+                            completion?.TrySetResult(true);
+                        }
+                        else
+                        {
+                            completion?.TrySetException(error);
+                        }
                     }
                     else
                     {
@@ -168,21 +409,17 @@ namespace MuPDFCore
         /// <param name="pixelFormat">The format of the pixel data.</param>
         /// <param name="pageBounds">The bounds of the page being rendererd.</param>
         /// <param name="clipToPageBounds">A boolean value indicating whether the rendered image should be clipped to the original page's bounds. This can be relevant if the page has been "cropped" by altering its mediabox, but otherwise leaving the contents untouched.</param>
-        public void Render(IntPtr context, MuPDFDisplayList displayList, Rectangle region, float zoom, IntPtr pixelStorage, PixelFormats pixelFormat, Rectangle pageBounds, bool clipToPageBounds)
+        /// <param name="premultipliedAlpha">A boolean value indicating whether images with an alpha channel should be left with premultiplied colour values.</param>
+        /// <returns>A <see cref="Task"/> that completes when the rendering operation finishes.</returns>
+        public Task Render(IntPtr context, MuPDFDisplayList displayList, Rectangle region, float zoom, IntPtr pixelStorage, PixelFormats pixelFormat, Rectangle pageBounds, bool clipToPageBounds, bool premultipliedAlpha)
         {
             lock (RenderDataLock)
             {
-                //Reset the cookie.
-                unsafe
-                {
-                    Cookie* cookie = (Cookie*)Cookie;
+                ResetCookie(Cookie);
 
-                    cookie->abort = 0;
-                    cookie->errors = 0;
-                    cookie->incomplete = 0;
-                    cookie->progress = 0;
-                    cookie->progress_max = 0;
-                }
+                SignalFromThread.Reset();
+                LastError = null;
+                Completion = new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously);
 
                 //Set up all the rendering data.
                 CurrentRenderData.Context = context;
@@ -193,7 +430,34 @@ namespace MuPDFCore
                 CurrentRenderData.PixelFormat = pixelFormat;
                 CurrentRenderData.PageBounds = pageBounds;
                 CurrentRenderData.ClipToPageBounds = clipToPageBounds;
+                CurrentRenderData.PremultipliedAlpha = premultipliedAlpha;
+                SignalToThread.Set();
+
+                return Completion.Task;
+            }
+        }
+
+        /// <summary>
+        /// Start rendering tiles from a shared <see cref="TileRenderJob"/>, until no tiles are left.
+        /// </summary>
+        /// <param name="context">The rendering context.</param>
+        /// <param name="job">The tiles to render.</param>
+        /// <returns>A <see cref="Task"/> that completes when the thread has finished rendering tiles.</returns>
+        public Task RenderTiles(IntPtr context, TileRenderJob job)
+        {
+            lock (RenderDataLock)
+            {
+                ResetCookie(Cookie);
+
+                SignalFromThread.Reset();
+                LastError = null;
+                Completion = new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously);
+
+                CurrentRenderData.Context = context;
+                CurrentTileJob = job;
                 SignalToThread.Set();
+
+                return Completion.Task;
             }
         }
 
@@ -207,6 +471,11 @@ namespace MuPDFCore
             if (result == 0)
             {
                 SignalFromThread.Reset();
+
+                if (this.LastError != null)
+                {
+                    throw this.LastError;
+                }
             }
         }
 
@@ -231,18 +500,7 @@ namespace MuPDFCore
         /// <returns>A <see cref="RenderProgress.ThreadRenderProgress"/> object containing the progress of the current rendering operation.</returns>
         public RenderProgress.ThreadRenderProgress GetProgress()
         {
-            int progress;
-            ulong maxProgress;
-
-            unsafe
-            {
-                Cookie* cookie = (Cookie*)Cookie;
-
-                progress = cookie->progress;
-                maxProgress = cookie->progress_max;
-            }
-
-            return new RenderProgress.ThreadRenderProgress(progress, maxProgress);
+            return GetCookieProgress(Cookie);
         }
 
         private bool disposedValue;
@@ -290,6 +548,21 @@ namespace MuPDFCore
         /// </summary>
         private readonly RenderingThread[] RenderingThreads;
 
+        /// <summary>
+        /// The shared pool that performs the rendering, if this renderer does not have its own <see cref="RenderingThreads"/>.
+        /// </summary>
+        private readonly MuPDFRenderWorkerPool WorkerPool;
+
+        /// <summary>
+        /// Pointers to the <see cref="Cookie"/> objects used to monitor or abort each part of the rendering, when the rendering is performed by the <see cref="WorkerPool"/>.
+        /// </summary>
+        private readonly IntPtr[] Cookies;
+
+        /// <summary>
+        /// A task that completes when the work submitted to the <see cref="WorkerPool"/> by the last rendering operation has finished.
+        /// </summary>
+        private Task PendingWork = Task.CompletedTask;
+
         /// <summary>
         /// The bounds of the page being rendered.
         /// </summary>
@@ -300,6 +573,11 @@ namespace MuPDFCore
         /// </summary>
         private readonly bool ClipToPageBounds;
 
+        /// <summary>
+        /// Whether rendered images with an alpha channel should be left with premultiplied colour values.
+        /// </summary>
+        private readonly bool PremultipliedAlpha;
+
         /// <summary>
         /// The number of threads that are used to render the image.
         /// </summary>
@@ -319,20 +597,25 @@ namespace MuPDFCore
         /// Create a new <see cref="MuPDFMultiThreadedPageRenderer"/> from a specified display list using the specified number of threads.
         /// </summary>
         /// <param name="context">The context that owns the document from which the display list was extracted.</param>
-        /// <param name="displayList">The display list to render.</param>
-        /// <param name="threadCount">The number of threads to use in the rendering. This must be factorisable using only powers of 2, 3, 5 or 7. Otherwise, the biggest number smaller than <paramref name="threadCount"/> that satisfies this condition is used.</param>
+        /// <param name="displayList">The display list to render. This must have been pinned, and it is unpinned when the renderer is disposed.</param>
+        /// <param name="threadCount">The number of threads to use in the rendering. This can be any number greater than 0.</param>
         /// <param name="pageBounds">The bounds of the page being rendererd.</param>
         /// <param name="clipToPageBounds">A boolean value indicating whether the rendered image should be clipped to the original page's bounds. This can be relevant if the page has been "cropped" by altering its mediabox, but otherwise leaving the contents untouched.</param>
         /// <param name="imageXRes">If the document is an image, the horizontal resolution of the image. Otherwise, 72.</param>
         /// <param name="imageYRes">If the document is an image, the vertical resolution of the image. Otherwise, 72.</param>
-        internal MuPDFMultiThreadedPageRenderer(MuPDFContext context, MuPDFDisplayList displayList, int threadCount, Rectangle pageBounds, bool clipToPageBounds, double imageXRes, double imageYRes)
+        /// <param name="premultipliedAlpha">A boolean value indicating whether rendered images with an alpha channel should be left with premultiplied colour values.</param>
+        internal MuPDFMultiThreadedPageRenderer(MuPDFContext context, MuPDFDisplayList displayList, int threadCount, Rectangle pageBounds, bool clipToPageBounds, double imageXRes, double imageYRes, bool premultipliedAlpha)
         {
-            threadCount = Utils.GetAcceptableNumber(threadCount);
+            if (threadCount <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(threadCount), threadCount, "The number of threads must be strictly higher than 0!");
+            }
 
             this.ThreadCount = threadCount;
             this.DisplayList = displayList;
             this.PageBounds = pageBounds;
             this.ClipToPageBounds = clipToPageBounds;
+            this.PremultipliedAlpha = premultipliedAlpha;
 
             this.ImageXRes = imageXRes;
             this.ImageYRes = imageYRes;
@@ -372,6 +655,108 @@ namespace MuPDFCore
             }
         }
 
+        /// <summary>
+        /// Create a new <see cref="MuPDFMultiThreadedPageRenderer"/> from a specified display list, which submits the rendering work to a shared <see cref="MuPDFRenderWorkerPool"/> instead of using its own threads.
+        /// </summary>
+        /// <param name="context">The context that owns the document from which the display list was extracted.</param>
+        /// <param name="displayList">The display list to render. This must have been pinned, and it is unpinned when the renderer is disposed.</param>
+        /// <param name="workerPool">The worker pool that performs the rendering. Images are split in a number of tiles equal to the number of workers in the pool.</param>
+        /// <param name="pageBounds">The bounds of the page being rendererd.</param>
+        /// <param name="clipToPageBounds">A boolean value indicating whether the rendered image should be clipped to the original page's bounds. This can be relevant if the page has been "cropped" by altering its mediabox, but otherwise leaving the contents untouched.</param>
+        /// <param name="imageXRes">If the document is an image, the horizontal resolution of the image. Otherwise, 72.</param>
+        /// <param name="imageYRes">If the document is an image, the vertical resolution of the image. Otherwise, 72.</param>
+        /// <param name="premultipliedAlpha">A boolean value indicating whether rendered images with an alpha channel should be left with premultiplied colour values.</param>
+        internal MuPDFMultiThreadedPageRenderer(MuPDFContext context, MuPDFDisplayList displayList, MuPDFRenderWorkerPool workerPool, Rectangle pageBounds, bool clipToPageBounds, double imageXRes, double imageYRes, bool premultipliedAlpha)
+        {
+            if (workerPool.Context.RootContext != context.RootContext)
+            {
+                throw new ArgumentException("The worker pool must have been created using the same context as the document!", nameof(workerPool));
+            }
+
+            this.ThreadCount = workerPool.WorkerCount;
+            this.DisplayList = displayList;
+            this.PageBounds = pageBounds;
+            this.ClipToPageBounds = clipToPageBounds;
+            this.PremultipliedAlpha = premultipliedAlpha;
+
+            this.ImageXRes = imageXRes;
+            this.ImageYRes = imageYRes;
+
+            this.WorkerPool = workerPool;
+            this.Cookies = new IntPtr[this.ThreadCount];
+
+            for (int i = 0; i < this.Cookies.Length; i++)
+            {
+                this.Cookies[i] = Marshal.AllocHGlobal(Marshal.SizeOf<Cookie>());
+                RenderingThread.ResetCookie(this.Cookies[i]);
+            }
+        }
+
+        /// <summary>
+        /// Start rendering a region of the display list, either on one of the <see cref="RenderingThreads"/> or on the <see cref="WorkerPool"/>.
+        /// </summary>
+        /// <param name="index">The index of the rendering thread (or cookie) to use.</param>
+        /// <param name="region">The region that should be rendered.</param>
+        /// <param name="zoom">The scale at which the region will be rendered.</param>
+        /// <param name="destination">The address of the buffer where the pixel data will be written.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <returns>A <see cref="Task"/> that completes when the region has been rendered.</returns>
+        private Task StartRegion(int index, Rectangle region, float zoom, IntPtr destination, PixelFormats pixelFormat)
+        {
+            if (this.WorkerPool == null)
+            {
+                return RenderingThreads[index].Render(Contexts[index].NativeContext, DisplayList, region, zoom, destination, pixelFormat, this.PageBounds, ClipToPageBounds, PremultipliedAlpha);
+            }
+            else
+            {
+                IntPtr cookie = this.Cookies[index];
+                RenderingThread.ResetCookie(cookie);
+                return this.WorkerPool.Run(nativeContext => RenderingThread.RenderRegion(nativeContext, DisplayList, region, zoom, destination, pixelFormat, this.PageBounds, ClipToPageBounds, PremultipliedAlpha, cookie));
+            }
+        }
+
+        /// <summary>
+        /// Start rendering tiles from a <see cref="TileRenderJob"/>, either on one of the <see cref="RenderingThreads"/> or on the <see cref="WorkerPool"/>.
+        /// </summary>
+        /// <param name="index">The index of the rendering thread (or cookie) to use.</param>
+        /// <param name="job">The tiles to render.</param>
+        /// <returns>A <see cref="Task"/> that completes when no tiles are left.</returns>
+        private Task StartTiles(int index, TileRenderJob job)
+        {
+            if (this.WorkerPool == null)
+            {
+                return RenderingThreads[index].RenderTiles(Contexts[index].NativeContext, job);
+            }
+            else
+            {
+                IntPtr cookie = this.Cookies[index];
+                RenderingThread.ResetCookie(cookie);
+                return this.WorkerPool.Run(nativeContext => job.Run(nativeContext, cookie));
+            }
+        }
+
+        /// <summary>
+        /// Wait until the rendering operations that have been started have finished.
+        /// </summary>
+        /// <param name="tasks">The tasks returned by <see cref="StartRegion"/> or <see cref="StartTiles"/>.</param>
+        private void WaitForRendering(Task[] tasks)
+        {
+            if (this.WorkerPool == null)
+            {
+                for (int i = 0; i < tasks.Length; i++)
+                {
+                    RenderingThreads[i].WaitForRendering();
+                }
+            }
+            else
+            {
+                for (int i = 0; i < tasks.Length; i++)
+                {
+                    tasks[i].GetAwaiter().GetResult();
+                }
+            }
+        }
+
         /// <summary>
         /// Render the specified region to an image of the specified size, split in a number of tiles equal to the number of threads used by this <see cref="MuPDFMultiThreadedPageRenderer"/>, without marshaling. This method will not return until all the rendering threads have finished.
         /// </summary>
@@ -382,7 +767,49 @@ namespace MuPDFCore
         /// <param name="pixelFormat">The format of the pixel data.</param>
         public void Render(RoundedSize targetSize, Rectangle region, IntPtr[] destinations, PixelFormats pixelFormat)
         {
-            if (destinations.Length != Contexts.Length)
+            Task[] tasks = StartRendering(targetSize, region, destinations, pixelFormat);
+
+            if (tasks != null)
+            {
+                WaitForRendering(tasks);
+            }
+        }
+
+        /// <summary>
+        /// Render the specified region to an image of the specified size, split in a number of tiles equal to the number of threads used by this <see cref="MuPDFMultiThreadedPageRenderer"/>, without marshaling.
+        /// This method returns as soon as the rendering has started; the returned <see cref="Task"/> completes when all the tiles have been rendered. Do not start another rendering operation with this renderer until then.
+        /// </summary>
+        /// <param name="targetSize">The total size of the image that should be rendered.</param>
+        /// <param name="region">The region in page units that should be rendered.</param>
+        /// <param name="destinations">An array containing the addresses of the buffers where the rendered tiles will be written. There must be enough space available in each buffer to write the values for all the pixels of the tile, otherwise this will fail catastrophically!
+        /// The buffers must remain valid until the returned <see cref="Task"/> has completed.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <returns>A <see cref="Task"/> that completes when all the tiles have been rendered.</returns>
+        public Task RenderAsync(RoundedSize targetSize, Rectangle region, IntPtr[] destinations, PixelFormats pixelFormat)
+        {
+            Task[] tasks = StartRendering(targetSize, region, destinations, pixelFormat);
+
+            if (tasks != null)
+            {
+                return Task.WhenAll(tasks);
+            }
+            else
+            {
+                return Task.CompletedTask;
+            }
+        }
+
+        /// <summary>
+        /// Start rendering the specified region to an image of the specified size, split in a number of tiles equal to the number of threads used by this <see cref="MuPDFMultiThreadedPageRenderer"/>.
+        /// </summary>
+        /// <param name="targetSize">The total size of the image that should be rendered.</param>
+        /// <param name="region">The region in page units that should be rendered.</param>
+        /// <param name="destinations">An array containing the addresses of the buffers where the rendered tiles will be written.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <returns>The tasks corresponding to each tile, or <see langword="null"/> if the tiles could not be sized correctly and nothing was rendered.</returns>
+        private Task[] StartRendering(RoundedSize targetSize, Rectangle region, IntPtr[] destinations, PixelFormats pixelFormat)
+        {
+            if (destinations.Length != this.ThreadCount)
             {
                 throw new ArgumentOutOfRangeException(nameof(destinations), destinations.Length, "The number of destinations must be equal to the number of rendering threads!");
             }
@@ -464,11 +891,13 @@ namespace MuPDFCore
                     if (countBlanks >= 100)
                     {
                         //It seems that we can't coerce the expected size and the actual size to be the same. Give up.
-                        return;
+                        return null;
                     }
                 }
             }
 
+            Task[] tasks = new Task[destinations.Length];
+
             //Start each rendering thread.
             for (int i = 0; i < destinations.Length; i++)
             {
@@ -480,13 +909,122 @@ namespace MuPDFCore
                     origin = new Rectangle(origin.X0 * 72 / this.ImageXRes, origin.Y0 * 72 / this.ImageYRes, origin.X1 * 72 / this.ImageXRes, origin.Y1 * 72 / this.ImageYRes);
                 }
 
-                RenderingThreads[i].Render(Contexts[i].NativeContext, DisplayList, origin, (float)dzoom, destinations[i], pixelFormat, this.PageBounds, ClipToPageBounds);
+                tasks[i] = StartRegion(i, origin, (float)dzoom, destinations[i], pixelFormat);
             }
 
-            //Wait until all the rendering threads have finished.
-            for (int i = 0; i < destinations.Length; i++)
+            if (this.WorkerPool != null)
+            {
+                this.PendingWork = Task.WhenAll(tasks);
+            }
+
+            return tasks;
+        }
+
+        /// <summary>
+        /// Render the specified region to an image of the specified size, without marshaling. The image is divided into square tiles, which are handed out dynamically to the rendering threads:
+        /// each thread picks up the next tile as soon as it has finished the previous one, so that a region that is expensive to render does not leave the other threads idle. This method will not return until all the tiles have been rendered.
+        /// </summary>
+        /// <param name="targetSize">The total size of the image that should be rendered.</param>
+        /// <param name="region">The region in page units that should be rendered.</param>
+        /// <param name="destination">The address of the buffer where the whole image will be written. There must be enough space available to write the values for all the pixels, otherwise this will fail catastrophically!</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <param name="tileSize">The width and height in pixels of each tile.</param>
+        /// <param name="tileRendered">An optional callback that is invoked after each tile has been written to the <paramref name="destination"/>, with the area of the image (in pixels) that is now complete.
+        /// This is invoked on the rendering threads, possibly concurrently.</param>
+        public void RenderTiled(RoundedSize targetSize, Rectangle region, IntPtr destination, PixelFormats pixelFormat, int tileSize = 256, Action<RoundedRectangle> tileRendered = null)
+        {
+            if (tileSize <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(tileSize), tileSize, "The tile size must be strictly positive!");
+            }
+
+            if (targetSize.Width <= 0 || targetSize.Height <= 0)
+            {
+                return;
+            }
+
+            float zoomX = targetSize.Width / region.Width;
+            float zoomY = targetSize.Height / region.Height;
+
+            double zoom = Math.Sqrt(zoomX * zoomY);
+
+            Rectangle origin = region;
+
+            if (this.ImageXRes != 72 || this.ImageYRes != 72)
+            {
+                zoom *= Math.Sqrt(this.ImageXRes * this.ImageYRes) / 72;
+                origin = new Rectangle(origin.X0 * 72 / this.ImageXRes, origin.Y0 * 72 / this.ImageYRes, origin.X1 * 72 / this.ImageXRes, origin.Y1 * 72 / this.ImageYRes);
+            }
+
+            RoundedRectangle roundedOrigin = origin.Round(zoom);
+
+            int columns = (targetSize.Width + tileSize - 1) / tileSize;
+            int rows = (targetSize.Height + tileSize - 1) / tileSize;
+
+            TileRenderJob job = new TileRenderJob()
+            {
+                DisplayList = this.DisplayList,
+                Zoom = (float)zoom,
+                OriginX = roundedOrigin.X0,
+                OriginY = roundedOrigin.Y0,
+                TargetSize = targetSize,
+                TileSize = tileSize,
+                Columns = columns,
+                TileCount = columns * rows,
+                Destination = destination,
+                PixelFormat = pixelFormat,
+                PageBounds = this.PageBounds,
+                ClipToPageBounds = this.ClipToPageBounds,
+                PremultipliedAlpha = this.PremultipliedAlpha,
+                TileRendered = tileRendered
+            };
+
+            //There is no point in starting more threads than there are tiles.
+            Task[] tasks = new Task[Math.Min(this.ThreadCount, job.TileCount)];
+
+            for (int i = 0; i < tasks.Length; i++)
+            {
+                tasks[i] = StartTiles(i, job);
+            }
+
+            if (this.WorkerPool != null)
             {
-                RenderingThreads[i].WaitForRendering();
+                this.PendingWork = Task.WhenAll(tasks);
+            }
+
+            WaitForRendering(tasks);
+
+            if (job.Error != null)
+            {
+                throw job.Error;
+            }
+        }
+
+        /// <summary>
+        /// Render the specified region to an image of the specified size, without marshaling. The image is divided into square tiles, which are handed out dynamically to the rendering threads. This method will not return until all the tiles have been rendered.
+        /// </summary>
+        /// <param name="targetSize">The total size of the image that should be rendered.</param>
+        /// <param name="region">The region in page units that should be rendered.</param>
+        /// <param name="disposable">An <see cref="IDisposable"/> that can be used to free the memory where the rendered image is stored. You should keep track of this and dispose it when you have finished working with the image.</param>
+        /// <param name="pixelFormat">The format of the pixel data.</param>
+        /// <param name="tileSize">The width and height in pixels of each tile.</param>
+        /// <param name="tileRendered">An optional callback that is invoked after each tile has been rendered, with the area of the image (in pixels) that is now complete.
+        /// This is invoked on the rendering threads, possibly concurrently.</param>
+        /// <returns>A <see cref="Span{T}"/> containing the rendered image.</returns>
+        public Span<byte> RenderTiled(RoundedSize targetSize, Rectangle region, out IDisposable disposable, PixelFormats pixelFormat, int tileSize = 256, Action<RoundedRectangle> tileRendered = null)
+        {
+            bool hasAlpha = pixelFormat == PixelFormats.RGBA || pixelFormat == PixelFormats.BGRA;
+
+            int allocSize = targetSize.Width * targetSize.Height * (hasAlpha ? 4 : 3);
+
+            IntPtr destination = Marshal.AllocHGlobal(allocSize);
+            disposable = new DisposableIntPtr(destination, allocSize);
+
+            this.RenderTiled(targetSize, region, destination, pixelFormat, tileSize, tileRendered);
+
+            unsafe
+            {
+                return new Span<byte>((void*)destination, allocSize);
             }
         }
 
@@ -542,9 +1080,23 @@ namespace MuPDFCore
         /// </summary>
         public void Abort()
         {
-            for (int i = 0; i < RenderingThreads.Length; i++)
+            if (this.WorkerPool == null)
+            {
+                for (int i = 0; i < RenderingThreads.Length; i++)
+                {
+                    RenderingThreads[i].AbortRendering();
+                }
+            }
+            else
             {
-                RenderingThreads[i].AbortRendering();
+                for (int i = 0; i < Cookies.Length; i++)
+                {
+                    unsafe
+                    {
+                        Cookie* cookie = (Cookie*)Cookies[i];
+                        cookie->abort = 1;
+                    }
+                }
             }
         }
 
@@ -554,7 +1106,14 @@ namespace MuPDFCore
         /// <returns>A <see cref="RenderProgress"/> object containing the rendering progress of all the threads.</returns>
         public RenderProgress GetProgress()
         {
-            return new RenderProgress((from el in RenderingThreads select el.GetProgress()).ToArray());
+            if (this.WorkerPool == null)
+            {
+                return new RenderProgress((from el in RenderingThreads select el.GetProgress()).ToArray());
+            }
+            else
+            {
+                return new RenderProgress((from el in Cookies select RenderingThread.GetCookieProgress(el)).ToArray());
+            }
         }
 
         private bool disposedValue;
@@ -584,6 +1143,25 @@ namespace MuPDFCore
                         }
                     }
                 }
+
+                if (Cookies != null)
+                {
+                    //The workers may still be using the cookies.
+                    try
+                    {
+                        PendingWork.Wait();
+                    }
+                    catch (AggregateException) { }
+
+                    for (int i = 0; i < Cookies.Length; i++)
+                    {
+                        Marshal.FreeHGlobal(Cookies[i]);
+                    }
+                }
+
+                //The display list can now be evicted from the document's cache.
+                DisplayList.Unpin();
+
                 disposedValue = true;
             }
         }
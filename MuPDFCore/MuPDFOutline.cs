@@ -53,6 +53,7 @@ namespace MuPDFCore
             }
             else
             {
+                document.ThrowIfInputFailed();
                 this.Items = new MuPDFOutlineItem[0];
             }
 
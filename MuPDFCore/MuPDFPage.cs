@@ -56,9 +56,29 @@ namespace MuPDFCore
         }
 
         /// <summary>
-        /// A pointer to the native page object.
+        /// A pointer to the native page object, or <see cref="IntPtr.Zero"/> if it has been evicted from the document's cache.
         /// </summary>
-        internal readonly IntPtr NativePage;
+        private IntPtr nativePage;
+
+        /// <summary>
+        /// A pointer to the native page object. If the native page has been evicted from the document's cache, it is loaded again.
+        /// </summary>
+        internal IntPtr NativePage
+        {
+            get
+            {
+                if (nativePage == IntPtr.Zero)
+                {
+                    LoadNativePage();
+                }
+                else
+                {
+                    OwnerDocument.Cache.TouchPage(this);
+                }
+
+                return nativePage;
+            }
+        }
 
         /// <summary>
         /// The context that owns the document from which this page was extracted.
@@ -97,7 +117,12 @@ namespace MuPDFCore
             float w = 0;
             float h = 0;
 
-            ExitCodes result = (ExitCodes)NativeMethods.LoadPage(context.NativeContext, document.NativeDocument, number, ref NativePage, ref x, ref y, ref w, ref h);
+            ExitCodes result = (ExitCodes)NativeMethods.LoadPage(context.NativeContext, document.NativeDocument, number, ref nativePage, ref x, ref y, ref w, ref h);
+
+            if (result != ExitCodes.EXIT_SUCCESS)
+            {
+                document.ThrowIfInputFailed();
+            }
 
             double sX = Math.Round(x * document.ImageXRes / 72.0 * 1000) / 1000;
             double sY = Math.Round(y * document.ImageYRes / 72.0 * 1000) / 1000;
@@ -118,6 +143,57 @@ namespace MuPDFCore
                 default:
                     throw new MuPDFException("Unknown error", result);
             }
+
+            document.Cache.AddPage(this);
+        }
+
+        /// <summary>
+        /// Load the native page object again, after it has been evicted from the document's cache.
+        /// </summary>
+        private void LoadNativePage()
+        {
+            if (disposedValue)
+            {
+                throw new ObjectDisposedException(nameof(MuPDFPage));
+            }
+
+            float x = 0;
+            float y = 0;
+            float w = 0;
+            float h = 0;
+
+            ExitCodes result = (ExitCodes)NativeMethods.LoadPage(OwnerContext.NativeContext, OwnerDocument.NativeDocument, PageNumber, ref nativePage, ref x, ref y, ref w, ref h);
+
+            if (result != ExitCodes.EXIT_SUCCESS)
+            {
+                OwnerDocument.ThrowIfInputFailed();
+            }
+
+            switch (result)
+            {
+                case ExitCodes.EXIT_SUCCESS:
+                    break;
+                case ExitCodes.ERR_CANNOT_LOAD_PAGE:
+                    throw new MuPDFException("Cannot load page", result);
+                case ExitCodes.ERR_CANNOT_COMPUTE_BOUNDS:
+                    throw new MuPDFException("Cannot compute bounds", result);
+                default:
+                    throw new MuPDFException("Unknown error", result);
+            }
+
+            OwnerDocument.Cache.AddPage(this);
+        }
+
+        /// <summary>
+        /// Free the native page object. This is called by the document's cache when the page is evicted; the page is loaded again the next time it is needed.
+        /// </summary>
+        internal void ReleaseNativePage()
+        {
+            if (nativePage != IntPtr.Zero)
+            {
+                NativeMethods.DisposePage(OwnerContext.NativeContext, nativePage);
+                nativePage = IntPtr.Zero;
+            }
         }
 
         /// <summary>
@@ -169,14 +245,19 @@ namespace MuPDFCore
             {
                 if (OwnerContext.disposedValue)
                 {
-                    throw new LifetimeManagementException<MuPDFPage, MuPDFContext>(this, OwnerContext, this.NativePage, OwnerContext.NativeContext);
+                    throw new LifetimeManagementException<MuPDFPage, MuPDFContext>(this, OwnerContext, this.nativePage, OwnerContext.NativeContext);
                 }
                 if (disposing)
                 {
-                    this.Links.Dispose();
+                    this.CachedLinks?.Dispose();
+                    OwnerDocument.Cache.RemovePage(this);
+                }
+
+                if (nativePage != IntPtr.Zero)
+                {
+                    NativeMethods.DisposePage(OwnerContext.NativeContext, nativePage);
                 }
 
-                NativeMethods.DisposePage(OwnerContext.NativeContext, NativePage);
                 disposedValue = true;
             }
         }
@@ -184,7 +265,7 @@ namespace MuPDFCore
         ///<inheritdoc/>
         ~MuPDFPage()
         {
-            if (NativePage != IntPtr.Zero)
+            if (nativePage != IntPtr.Zero)
             {
                 Dispose(disposing: false);
             }
@@ -206,7 +287,7 @@ namespace MuPDFCore
         /// <summary>
         /// The internal store of the pages.
         /// </summary>
-        private readonly MuPDFPage[] Pages;
+        private MuPDFPage[] Pages;
 
         /// <summary>
         /// The context that owns the document from which the pages were extracted.
@@ -264,6 +345,18 @@ namespace MuPDFCore
             OwnerDocument = document;
         }
 
+        /// <summary>
+        /// Extend the collection so that it contains the specified number of pages. This is used while the document is being laid out incrementally.
+        /// </summary>
+        /// <param name="length">The new number of pages in the document.</param>
+        internal void Extend(int length)
+        {
+            if (length > Pages.Length)
+            {
+                Array.Resize(ref Pages, length);
+            }
+        }
+
         ///<inheritdoc/>
         public IEnumerator<MuPDFPage> GetEnumerator()
         {
@@ -0,0 +1,212 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2020  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+using System;
+using System.Collections.Concurrent;
+using System.Runtime.InteropServices;
+using System.Threading;
+using System.Threading.Tasks;
+
+namespace MuPDFCore
+{
+    /// <summary>
+    /// A fixed set of rendering threads, each with its own cloned MuPDF context, that can be shared by any number of <see cref="MuPDFMultiThreadedPageRenderer"/>s.
+    /// Renderers created using a worker pool do not start any threads of their own, and the work they submit is queued and executed by the first available worker.
+    /// </summary>
+    public class MuPDFRenderWorkerPool : IDisposable
+    {
+        /// <summary>
+        /// A unit of work that has been submitted to the pool.
+        /// </summary>
+        private class WorkItem
+        {
+            /// <summary>
+            /// The work to perform. The parameter is the native context of the worker that executes the work.
+            /// </summary>
+            public Action<IntPtr> Work;
+
+            /// <summary>
+            /// The <see cref="TaskCompletionSource{TResult}"/> that is completed when the work has been performed.
+            /// </summary>
+            public TaskCompletionSource<bool> Completion;
+        }
+
+        /// <summary>
+        /// The context from which the contexts of the workers have been cloned.
+        /// </summary>
+        internal MuPDFContext Context { get; }
+
+        /// <summary>
+        /// The cloned contexts that are used by the <see cref="Workers"/>.
+        /// </summary>
+        private readonly MuPDFContext[] Contexts;
+
+        /// <summary>
+        /// The threads that perform the work.
+        /// </summary>
+        private readonly Thread[] Workers;
+
+        /// <summary>
+        /// The queue of work that has been submitted but not started yet.
+        /// </summary>
+        private readonly BlockingCollection<WorkItem> Queue;
+
+        /// <summary>
+        /// The number of threads (and contexts) in the pool.
+        /// </summary>
+        public int WorkerCount { get; }
+
+        /// <summary>
+        /// Create a new <see cref="MuPDFRenderWorkerPool"/>. The pool can be used to render documents that have been opened using the specified <paramref name="context"/>.
+        /// </summary>
+        /// <param name="context">The context whose documents will be rendered using this pool.</param>
+        /// <param name="workerCount">The number of rendering threads. If this is 0, a number of threads equal to the number of processors in the computer is used.</param>
+        public MuPDFRenderWorkerPool(MuPDFContext context, int workerCount = 0)
+        {
+            if (workerCount < 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(workerCount), workerCount, "The number of workers must be greater than or equal to 0!");
+            }
+
+            if (workerCount == 0)
+            {
+                workerCount = Environment.ProcessorCount;
+            }
+
+            this.Context = context;
+            this.WorkerCount = workerCount;
+
+            IntPtr[] contexts = new IntPtr[workerCount];
+            GCHandle contextsHandle = GCHandle.Alloc(contexts, GCHandleType.Pinned);
+
+            try
+            {
+                ExitCodes result = (ExitCodes)NativeMethods.CloneContext(context.NativeContext, workerCount, contextsHandle.AddrOfPinnedObject());
+
+                switch (result)
+                {
+                    case ExitCodes.EXIT_SUCCESS:
+                        break;
+                    case ExitCodes.ERR_CANNOT_INIT_MUTEX:
+                        throw new MuPDFException("Cannot initalize mutex objects", result);
+                    case ExitCodes.ERR_CANNOT_CREATE_CONTEXT:
+                        throw new MuPDFException("Cannot create master context", result);
+                    case ExitCodes.ERR_CANNOT_CLONE_CONTEXT:
+                        throw new MuPDFException("Cannot create context clones", result);
+                    default:
+                        throw new MuPDFException("Unknown error", result);
+                }
+            }
+            finally
+            {
+                contextsHandle.Free();
+            }
+
+            this.Queue = new BlockingCollection<WorkItem>();
+            this.Contexts = new MuPDFContext[workerCount];
+            this.Workers = new Thread[workerCount];
+
+            for (int i = 0; i < workerCount; i++)
+            {
+                this.Contexts[i] = new MuPDFContext(context, contexts[i]);
+
+                IntPtr nativeContext = contexts[i];
+
+                this.Workers[i] = new Thread(() => WorkerAction(nativeContext))
+                {
+                    IsBackground = true,
+                    Name = "MuPDF render worker " + i.ToString()
+                };
+
+                this.Workers[i].Start();
+            }
+        }
+
+        /// <summary>
+        /// The loop executed by each worker thread.
+        /// </summary>
+        /// <param name="nativeContext">The native context used by the worker.</param>
+        private void WorkerAction(IntPtr nativeContext)
+        {
+            foreach (WorkItem item in this.Queue.GetConsumingEnumerable())
+            {
+                try
+                {
+                    item.Work(nativeContext);
+                    item.Completion.SetResult(true);
+                }
+                catch (Exception ex)
+                {
+                    item.Completion.SetException(ex);
+                }
+            }
+        }
+
+        /// <summary>
+        /// Submit work to the pool.
+        /// </summary>
+        /// <param name="work">The work to perform. The parameter is the native context of the worker that executes the work.</param>
+        /// <returns>A <see cref="Task"/> that completes when the work has been performed.</returns>
+        internal Task Run(Action<IntPtr> work)
+        {
+            if (disposedValue)
+            {
+                throw new ObjectDisposedException(nameof(MuPDFRenderWorkerPool));
+            }
+
+            WorkItem item = new WorkItem() { Work = work, Completion = new TaskCompletionSource<bool>(TaskCreationOptions.RunContinuationsAsynchronously) };
+            this.Queue.Add(item);
+            return item.Completion.Task;
+        }
+
+        private bool disposedValue;
+
+        ///<inheritdoc/>
+        protected virtual void Dispose(bool disposing)
+        {
+            if (!disposedValue)
+            {
+                disposedValue = true;
+
+                if (disposing)
+                {
+                    //Let the workers finish the work that has already been submitted.
+                    this.Queue.CompleteAdding();
+
+                    for (int i = 0; i < this.Workers.Length; i++)
+                    {
+                        this.Workers[i].Join();
+                    }
+
+                    for (int i = 0; i < this.Contexts.Length; i++)
+                    {
+                        this.Contexts[i].Dispose();
+                    }
+
+                    this.Queue.Dispose();
+                }
+            }
+        }
+
+        ///<inheritdoc/>
+        public void Dispose()
+        {
+            Dispose(disposing: true);
+            GC.SuppressFinalize(this);
+        }
+    }
+}
@@ -0,0 +1,102 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2020  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+using System;
+using System.IO;
+using System.Runtime.ExceptionServices;
+using System.Runtime.InteropServices;
+
+namespace MuPDFCore
+{
+    /// <summary>
+    /// Forwards the data produced by a native writer (e.g. an image encoder) to a managed <see cref="System.IO.Stream"/> as it is written, so that the whole output never needs to be held in memory.
+    /// </summary>
+    internal class OutputStreamCallback
+    {
+        /// <summary>
+        /// The size of the buffer used to copy data from native memory to the stream.
+        /// </summary>
+        private const int BufferSize = 65536;
+
+        /// <summary>
+        /// The stream to which the data is written.
+        /// </summary>
+        private readonly Stream Stream;
+
+        /// <summary>
+        /// The buffer used to copy data from native memory to the stream.
+        /// </summary>
+        private readonly byte[] Buffer;
+
+        /// <summary>
+        /// The exception that was thrown while writing to the stream, if any.
+        /// </summary>
+        private ExceptionDispatchInfo Exception;
+
+        /// <summary>
+        /// The delegate that should be passed to the native method. The caller must make sure that this object stays alive until the native method returns.
+        /// </summary>
+        public NativeMethods.WriteCallback Callback { get; }
+
+        /// <summary>
+        /// Create a new <see cref="OutputStreamCallback"/> that writes data to the specified <paramref name="stream"/>.
+        /// </summary>
+        /// <param name="stream">The stream to which the data will be written.</param>
+        public OutputStreamCallback(Stream stream)
+        {
+            this.Stream = stream;
+            this.Buffer = new byte[BufferSize];
+            this.Callback = this.Write;
+        }
+
+        /// <summary>
+        /// Copy a chunk of native data to the stream. Exceptions cannot propagate through native code, thus they are stored and rethrown by <see cref="ThrowIfFailed"/>.
+        /// </summary>
+        /// <param name="data">A pointer to the data.</param>
+        /// <param name="length">The length in bytes of the data.</param>
+        /// <returns>0 if the data was written successfully, 1 otherwise.</returns>
+        private int Write(IntPtr data, ulong length)
+        {
+            try
+            {
+                while (length > 0)
+                {
+                    int bytesToCopy = (int)Math.Min((ulong)this.Buffer.Length, length);
+                    Marshal.Copy(data, this.Buffer, 0, bytesToCopy);
+                    data = IntPtr.Add(data, bytesToCopy);
+                    this.Stream.Write(this.Buffer, 0, bytesToCopy);
+                    length -= (ulong)bytesToCopy;
+                }
+
+                return 0;
+            }
+            catch (Exception ex)
+            {
+                this.Exception = ExceptionDispatchInfo.Capture(ex);
+                return 1;
+            }
+        }
+
+        /// <summary>
+        /// If writing to the stream failed, rethrow the exception that caused the failure.
+        /// </summary>
+        public void ThrowIfFailed()
+        {
+            this.Exception?.Throw();
+        }
+    }
+}
@@ -59,16 +59,21 @@ namespace MuPDFCore
         /// <summary>
         /// Split the size into the specified number of <see cref="Rectangle"/>s.
         /// </summary>
-        /// <param name="divisions">The number of rectangles in which the size should be split. This must be factorisable using only powers of 2, 3, 5 or 7. Otherwise, the biggest number smaller than <paramref name="divisions"/> that satisfies this condition is used.</param>
+        /// <param name="divisions">The number of rectangles in which the size should be split. This can be any number greater than 0; all the rectangles have the same area.</param>
         /// <returns>An array of <see cref="Rectangle"/>s that when positioned properly cover an area of the size of this object.</returns>
         public Rectangle[] Split(int divisions)
         {
-            divisions = Utils.GetAcceptableNumber(divisions);
+            if (divisions <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(divisions), divisions, "The number of divisions must be strictly higher than 0!");
+            }
 
             Rectangle[] tbr = new Rectangle[divisions];
 
             bool isVertical = this.Height > this.Width;
 
+            int factor = Utils.GetSmallestFactor(divisions);
+
             if (divisions == 1)
             {
                 tbr[0] = new Rectangle(0, 0, Width, Height);
@@ -86,86 +91,50 @@ namespace MuPDFCore
                     tbr[1] = new Rectangle(Width / 2, 0, Width, Height);
                 }
             }
-            else if (divisions == 3)
-            {
-                if (isVertical)
-                {
-                    tbr[0] = new Rectangle(0, 0, Width / 2, 2 * Height / 3);
-                    tbr[1] = new Rectangle(Width / 2, 0, Width, 2 * Height / 3);
-                    tbr[2] = new Rectangle(0, 2 * Height / 3, Width, Height);
-                }
-                else
-                {
-                    tbr[0] = new Rectangle(0, 0, 2 * Width / 3, Height / 2);
-                    tbr[1] = new Rectangle(0, Height / 2, 2 * Width / 3, Height);
-                    tbr[2] = new Rectangle(2 * Width / 3, 0, Width, Height);
-                }
-            }
-            else if (divisions == 5)
+            else if (factor == divisions)
             {
-                if (isVertical)
-                {
-                    tbr[0] = new Rectangle(0, 0, Width / 2, 2 * Height / 5);
-                    tbr[1] = new Rectangle(Width / 2, 0, Width, 2 * Height / 5);
-                    tbr[2] = new Rectangle(0, 2 * Height / 5, Width / 2, 4 * Height / 5);
-                    tbr[3] = new Rectangle(Width / 2, 2 * Height / 5, Width, 4 * Height / 5);
-                    tbr[4] = new Rectangle(0, 4 * Height / 5, Width, Height);
-                }
-                else
+                //Odd prime number: split the longer side into (divisions - 1) / 2 strips containing two rectangles each, plus a last strip containing a single rectangle.
+                //The length of each strip is proportional to the number of rectangles it contains, so that all the rectangles have the same area.
+                int pairs = (divisions - 1) / 2;
+
+                for (int i = 0; i < pairs; i++)
                 {
-                    tbr[0] = new Rectangle(0, 0, 2 * Width / 5, Height / 2);
-                    tbr[1] = new Rectangle(0, Height / 2, 2 * Width / 5, Height);
-                    tbr[2] = new Rectangle(2 * Width / 5, 0, 4 * Width / 5, Height / 2);
-                    tbr[3] = new Rectangle(2 * Width / 5, Height / 2, 4 * Width / 5, Height);
-                    tbr[4] = new Rectangle(4 * Width / 5, 0, Width, Height);
+                    if (isVertical)
+                    {
+                        tbr[2 * i] = new Rectangle(0, 2 * i * Height / divisions, Width / 2, 2 * (i + 1) * Height / divisions);
+                        tbr[2 * i + 1] = new Rectangle(Width / 2, 2 * i * Height / divisions, Width, 2 * (i + 1) * Height / divisions);
+                    }
+                    else
+                    {
+                        tbr[2 * i] = new Rectangle(2 * i * Width / divisions, 0, 2 * (i + 1) * Width / divisions, Height / 2);
+                        tbr[2 * i + 1] = new Rectangle(2 * i * Width / divisions, Height / 2, 2 * (i + 1) * Width / divisions, Height);
+                    }
                 }
-            }
-            else if (divisions == 7)
-            {
+
                 if (isVertical)
                 {
-                    tbr[0] = new Rectangle(0, 0, Width / 2, 2 * Height / 7);
-                    tbr[1] = new Rectangle(Width / 2, 0, Width, 2 * Height / 7);
-                    tbr[2] = new Rectangle(0, 2 * Height / 7, Width / 2, 4 * Height / 7);
-                    tbr[3] = new Rectangle(Width / 2, 2 * Height / 7, Width, 4 * Height / 7);
-                    tbr[4] = new Rectangle(0, 4 * Height / 7, Width / 2, 6 * Height / 7);
-                    tbr[5] = new Rectangle(Width / 2, 4 * Height / 7, Width, 6 * Height / 7);
-                    tbr[6] = new Rectangle(0, 6 * Height / 7, Width, Height);
+                    tbr[divisions - 1] = new Rectangle(0, 2 * pairs * Height / divisions, Width, Height);
                 }
                 else
                 {
-                    tbr[0] = new Rectangle(0, 0, 2 * Width / 7, Height / 2);
-                    tbr[1] = new Rectangle(0, Height / 2, 2 * Width / 7, Height);
-                    tbr[2] = new Rectangle(2 * Width / 7, 0, 4 * Width / 7, Height / 2);
-                    tbr[3] = new Rectangle(2 * Width / 7, Height / 2, 4 * Width / 7, Height);
-                    tbr[4] = new Rectangle(4 * Width / 7, 0, 6 * Width / 7, Height / 2);
-                    tbr[5] = new Rectangle(4 * Width / 7, Height / 2, 6 * Width / 7, Height);
-                    tbr[6] = new Rectangle(6 * Width / 7, 0, Width, Height);
+                    tbr[divisions - 1] = new Rectangle(2 * pairs * Width / divisions, 0, Width, Height);
                 }
             }
             else
             {
-                for (int divisorInd = 0; divisorInd < Utils.AcceptableDivisors.Length; divisorInd++)
-                {
-                    if (divisions % Utils.AcceptableDivisors[divisorInd] == 0)
-                    {
-                        Rectangle[] largerDivisions = this.Split(divisions / Utils.AcceptableDivisors[divisorInd]);
+                Rectangle[] largerDivisions = this.Split(divisions / factor);
 
-                        int pos = 0;
+                int pos = 0;
 
-                        for (int i = 0; i < largerDivisions.Length; i++)
-                        {
-                            Size s = new Size(largerDivisions[i].Width, largerDivisions[i].Height);
-                            Rectangle[] currDivision = s.Split(Utils.AcceptableDivisors[divisorInd]);
-
-                            for (int j = 0; j < currDivision.Length; j++)
-                            {
-                                tbr[pos] = new Rectangle(largerDivisions[i].X0 + currDivision[j].X0, largerDivisions[i].Y0 + currDivision[j].Y0, largerDivisions[i].X0 + currDivision[j].X1, largerDivisions[i].Y0 + currDivision[j].Y1);
-                                pos++;
-                            }
-                        }
+                for (int i = 0; i < largerDivisions.Length; i++)
+                {
+                    Size s = new Size(largerDivisions[i].Width, largerDivisions[i].Height);
+                    Rectangle[] currDivision = s.Split(factor);
 
-                        break;
+                    for (int j = 0; j < currDivision.Length; j++)
+                    {
+                        tbr[pos] = new Rectangle(largerDivisions[i].X0 + currDivision[j].X0, largerDivisions[i].Y0 + currDivision[j].Y0, largerDivisions[i].X0 + currDivision[j].X1, largerDivisions[i].Y0 + currDivision[j].Y1);
+                        pos++;
                     }
                 }
             }
@@ -204,16 +173,21 @@ namespace MuPDFCore
         /// <summary>
         /// Split the size into the specified number of <see cref="RoundedRectangle"/>s.
         /// </summary>
-        /// <param name="divisions">The number of rectangles in which the size should be split. This must be factorisable using only powers of 2, 3, 5 or 7. Otherwise, the biggest number smaller than <paramref name="divisions"/> that satisfies this condition is used.</param>
+        /// <param name="divisions">The number of rectangles in which the size should be split. This can be any number greater than 0; all the rectangles have the same area.</param>
         /// <returns>An array of <see cref="RoundedRectangle"/>s that when positioned properly cover an area of the size of this object.</returns>
         public RoundedRectangle[] Split(int divisions)
         {
-            divisions = Utils.GetAcceptableNumber(divisions);
+            if (divisions <= 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(divisions), divisions, "The number of divisions must be strictly higher than 0!");
+            }
 
             RoundedRectangle[] tbr = new RoundedRectangle[divisions];
 
             bool isVertical = this.Height > this.Width;
 
+            int factor = Utils.GetSmallestFactor(divisions);
+
             if (divisions == 1)
             {
                 tbr[0] = new RoundedRectangle(0, 0, Width, Height);
@@ -231,86 +205,50 @@ namespace MuPDFCore
                     tbr[1] = new RoundedRectangle(Width / 2, 0, Width, Height);
                 }
             }
-            else if (divisions == 3)
-            {
-                if (isVertical)
-                {
-                    tbr[0] = new RoundedRectangle(0, 0, Width / 2, 2 * Height / 3);
-                    tbr[1] = new RoundedRectangle(Width / 2, 0, Width, 2 * Height / 3);
-                    tbr[2] = new RoundedRectangle(0, 2 * Height / 3, Width, Height);
-                }
-                else
-                {
-                    tbr[0] = new RoundedRectangle(0, 0, 2 * Width / 3, Height / 2);
-                    tbr[1] = new RoundedRectangle(0, Height / 2, 2 * Width / 3, Height);
-                    tbr[2] = new RoundedRectangle(2 * Width / 3, 0, Width, Height);
-                }
-            }
-            else if (divisions == 5)
+            else if (factor == divisions)
             {
-                if (isVertical)
-                {
-                    tbr[0] = new RoundedRectangle(0, 0, Width / 2, 2 * Height / 5);
-                    tbr[1] = new RoundedRectangle(Width / 2, 0, Width, 2 * Height / 5);
-                    tbr[2] = new RoundedRectangle(0, 2 * Height / 5, Width / 2, 4 * Height / 5);
-                    tbr[3] = new RoundedRectangle(Width / 2, 2 * Height / 5, Width, 4 * Height / 5);
-                    tbr[4] = new RoundedRectangle(0, 4 * Height / 5, Width, Height);
-                }
-                else
+                //Odd prime number: split the longer side into (divisions - 1) / 2 strips containing two rectangles each, plus a last strip containing a single rectangle.
+                //The length of each strip is proportional to the number of rectangles it contains, so that all the rectangles have the same area.
+                int pairs = (divisions - 1) / 2;
+
+                for (int i = 0; i < pairs; i++)
                 {
-                    tbr[0] = new RoundedRectangle(0, 0, 2 * Width / 5, Height / 2);
-                    tbr[1] = new RoundedRectangle(0, Height / 2, 2 * Width / 5, Height);
-                    tbr[2] = new RoundedRectangle(2 * Width / 5, 0, 4 * Width / 5, Height / 2);
-                    tbr[3] = new RoundedRectangle(2 * Width / 5, Height / 2, 4 * Width / 5, Height);
-                    tbr[4] = new RoundedRectangle(4 * Width / 5, 0, Width, Height);
+                    if (isVertical)
+                    {
+                        tbr[2 * i] = new RoundedRectangle(0, 2 * i * Height / divisions, Width / 2, 2 * (i + 1) * Height / divisions);
+                        tbr[2 * i + 1] = new RoundedRectangle(Width / 2, 2 * i * Height / divisions, Width, 2 * (i + 1) * Height / divisions);
+                    }
+                    else
+                    {
+                        tbr[2 * i] = new RoundedRectangle(2 * i * Width / divisions, 0, 2 * (i + 1) * Width / divisions, Height / 2);
+                        tbr[2 * i + 1] = new RoundedRectangle(2 * i * Width / divisions, Height / 2, 2 * (i + 1) * Width / divisions, Height);
+                    }
                 }
-            }
-            else if (divisions == 7)
-            {
+
                 if (isVertical)
                 {
-                    tbr[0] = new RoundedRectangle(0, 0, Width / 2, 2 * Height / 7);
-                    tbr[1] = new RoundedRectangle(Width / 2, 0, Width, 2 * Height / 7);
-                    tbr[2] = new RoundedRectangle(0, 2 * Height / 7, Width / 2, 4 * Height / 7);
-                    tbr[3] = new RoundedRectangle(Width / 2, 2 * Height / 7, Width, 4 * Height / 7);
-                    tbr[4] = new RoundedRectangle(0, 4 * Height / 7, Width / 2, 6 * Height / 7);
-                    tbr[5] = new RoundedRectangle(Width / 2, 4 * Height / 7, Width, 6 * Height / 7);
-                    tbr[6] = new RoundedRectangle(0, 6 * Height / 7, Width, Height);
+                    tbr[divisions - 1] = new RoundedRectangle(0, 2 * pairs * Height / divisions, Width, Height);
                 }
                 else
                 {
-                    tbr[0] = new RoundedRectangle(0, 0, 2 * Width / 7, Height / 2);
-                    tbr[1] = new RoundedRectangle(0, Height / 2, 2 * Width / 7, Height);
-                    tbr[2] = new RoundedRectangle(2 * Width / 7, 0, 4 * Width / 7, Height / 2);
-                    tbr[3] = new RoundedRectangle(2 * Width / 7, Height / 2, 4 * Width / 7, Height);
-                    tbr[4] = new RoundedRectangle(4 * Width / 7, 0, 6 * Width / 7, Height / 2);
-                    tbr[5] = new RoundedRectangle(4 * Width / 7, Height / 2, 6 * Width / 7, Height);
-                    tbr[6] = new RoundedRectangle(6 * Width / 7, 0, Width, Height);
+                    tbr[divisions - 1] = new RoundedRectangle(2 * pairs * Width / divisions, 0, Width, Height);
                 }
             }
             else
             {
-                for (int divisorInd = 0; divisorInd < Utils.AcceptableDivisors.Length; divisorInd++)
-                {
-                    if (divisions % Utils.AcceptableDivisors[divisorInd] == 0)
-                    {
-                        RoundedRectangle[] largerDivisions = this.Split(divisions / Utils.AcceptableDivisors[divisorInd]);
+                RoundedRectangle[] largerDivisions = this.Split(divisions / factor);
 
-                        int pos = 0;
+                int pos = 0;
 
-                        for (int i = 0; i < largerDivisions.Length; i++)
-                        {
-                            RoundedSize s = new RoundedSize(largerDivisions[i].Width, largerDivisions[i].Height);
-                            RoundedRectangle[] currDivision = s.Split(Utils.AcceptableDivisors[divisorInd]);
-
-                            for (int j = 0; j < currDivision.Length; j++)
-                            {
-                                tbr[pos] = new RoundedRectangle(largerDivisions[i].X0 + currDivision[j].X0, largerDivisions[i].Y0 + currDivision[j].Y0, largerDivisions[i].X0 + currDivision[j].X1, largerDivisions[i].Y0 + currDivision[j].Y1);
-                                pos++;
-                            }
-                        }
+                for (int i = 0; i < largerDivisions.Length; i++)
+                {
+                    RoundedSize s = new RoundedSize(largerDivisions[i].Width, largerDivisions[i].Height);
+                    RoundedRectangle[] currDivision = s.Split(factor);
 
-                        break;
+                    for (int j = 0; j < currDivision.Length; j++)
+                    {
+                        tbr[pos] = new RoundedRectangle(largerDivisions[i].X0 + currDivision[j].X0, largerDivisions[i].Y0 + currDivision[j].Y0, largerDivisions[i].X0 + currDivision[j].X1, largerDivisions[i].Y0 + currDivision[j].Y1);
+                        pos++;
                     }
                 }
             }
@@ -417,7 +355,7 @@ namespace MuPDFCore
         /// <summary>
         /// Split the rectangle into the specified number of <see cref="Rectangle"/>s.
         /// </summary>
-        /// <param name="divisions">The number of rectangles in which the rectangle should be split. This must be factorisable using only powers of 2, 3, 5 or 7. Otherwise, the biggest number smaller than <paramref name="divisions"/> that satisfies this condition is used.</param>
+        /// <param name="divisions">The number of rectangles in which the rectangle should be split. This can be any number greater than 0; all the rectangles have the same area.</param>
         /// <returns>An array of <see cref="Rectangle"/>s that when positioned properly cover the same area as this object.</returns>
         public Rectangle[] Split(int divisions)
         {
@@ -541,7 +479,7 @@ namespace MuPDFCore
         /// <summary>
         /// Split the rectangle into the specified number of <see cref="RoundedRectangle"/>s.
         /// </summary>
-        /// <param name="divisions">The number of rectangles in which the rectangle should be split. This must be factorisable using only powers of 2, 3, 5 or 7. Otherwise, the biggest number smaller than <paramref name="divisions"/> that satisfies this condition is used.</param>
+        /// <param name="divisions">The number of rectangles in which the rectangle should be split. This can be any number greater than 0; all the rectangles have the same area.</param>
         /// <returns>An array of <see cref="RoundedRectangle"/>s that when positioned properly cover the same area as this object.</returns>
         public RoundedRectangle[] Split(int divisions)
         {
@@ -144,7 +144,7 @@ namespace MuPDFCore.StructuredText
                 case Types.Image:
                     return new MuPDFImageStructuredTextBlock(context, parentPage, bBox, imagePointer, a, b, c, d, e, f);
                 case Types.Text:
-                    return new MuPDFTextStructuredTextBlock(context, parentPage, bBox, blockPointer, lineCount);
+                    return new MuPDFTextStructuredTextBlock(parentPage, bBox, parentPage.PageData, parentPage.PageData.GetBlockIndex(blockPointer));
                 case Types.Vector:
                     return new MuPDFVectorStructuredTextBlock(parentPage, bBox, stroked != 0, argb);
                 case Types.Grid:
@@ -155,8 +155,14 @@ namespace MuPDFCore.StructuredText
         }
 
         private MuPDFContext OwnerContext { get; }
+        private MuPDFStructuredTextSpatialIndex spatialIndex;
         private IntPtr NativePointer { get; }
 
+        /// <summary>
+        /// The flat representation of the text in the page. This is only available while the page is being constructed.
+        /// </summary>
+        internal MuPDFStructuredTextPageData PageData { get; private set; }
+
         internal unsafe MuPDFStructuredTextPage(MuPDFContext context, MuPDFDisplayList list, TesseractLanguage ocrLanguage, double zoom, Rectangle pageBounds, StructuredTextFlags flags, CancellationToken cancellationToken = default, IProgress<OCRProgressInfo> progress = null)
         {
             if (ocrLanguage != null && RuntimeInformation.IsOSPlatform(OSPlatform.Windows) && RuntimeInformation.ProcessArchitecture == Architecture.X86 && (cancellationToken != default || progress != null))
@@ -227,9 +233,20 @@ namespace MuPDFCore.StructuredText
 
             StructuredTextBlocks = new MuPDFStructuredTextBlock[blockCount];
 
-            for (int i = 0; i < blockCount; i++)
+            //Lines and characters are read in bulk from a flat buffer, rather than one native call at a time.
+            this.PageData = new MuPDFStructuredTextPageData(context, nativeStructuredPage);
+
+            try
             {
-                this.StructuredTextBlocks[i] = MuPDFStructuredTextBlock.Create(context, blockPointers[i], this, null);
+                for (int i = 0; i < blockCount; i++)
+                {
+                    this.StructuredTextBlocks[i] = MuPDFStructuredTextBlock.Create(context, blockPointers[i], this, null);
+                }
+            }
+            finally
+            {
+                this.PageData.Dispose();
+                this.PageData = null;
             }
 
             this.OwnerContext = context;
@@ -244,103 +261,36 @@ namespace MuPDFCore.StructuredText
         /// <returns>The address of the character containing the specified <paramref name="point"/>, or <see langword="null"/> if no character contains the <paramref name="point"/>.</returns>
         public MuPDFStructuredTextAddress? GetHitAddress(PointF point, bool includeImages)
         {
-            for (int i = 0; i < this.Count; i++)
-            {
-                if (includeImages || this[i].Type == MuPDFStructuredTextBlock.Types.Text || this[i].Type == MuPDFStructuredTextBlock.Types.Structure)
-                {
-                    if (this[i].BoundingBox.Contains(point))
-                    {
-                        for (int j = 0; j < this[i].Count; j++)
-                        {
-                            if (this[i][j].BoundingBox.Contains(point))
-                            {
-                                for (int k = 0; k < this[i][j].Count; k++)
-                                {
-                                    if (this[i][j][k].BoundingQuad.Contains(point))
-                                    {
-                                        return new MuPDFStructuredTextAddress(i, j, k);
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-
-            return null;
+            return GetSpatialIndex().GetHitAddress(point, includeImages);
         }
 
         /// <summary>
-        /// Gets the address of the character that contains the specified <paramref name="point"/> in page units.
+        /// Gets the address of the character that contains the specified <paramref name="point"/> in page units or, if no character contains it, of the character
+        /// whose closest vertex is nearest to the <paramref name="point"/> among all the characters in the page. If more than one character is at the same distance,
+        /// the one that comes first in the page is returned.
         /// </summary>
         /// <param name="point">The point that must be closest to the character. This is expressed in page units (i.e. with a zoom factor of 1).</param>
         /// <param name="includeImages">If this is <see langword="true"/>, blocks containing images may be returned. Otherwise, only blocks containing text are considered.</param>
         /// <returns>The address of the character closest to the specified <paramref name="point"/> This is <see langword="null"/> only if the page contains no characters.</returns>
         public MuPDFStructuredTextAddress? GetClosestHitAddress(PointF point, bool includeImages)
         {
-            float minDistance = float.MaxValue;
-            MuPDFStructuredTextAddress? closestHit = null;
+            return GetSpatialIndex().GetClosestHitAddress(point, includeImages);
+        }
 
-            float minBlockDistance = float.MaxValue;
-            float minLineDistance = float.MaxValue;
+        /// <summary>
+        /// Gets the spatial index used for hit testing, creating it the first time it is needed.
+        /// </summary>
+        private MuPDFStructuredTextSpatialIndex GetSpatialIndex()
+        {
+            MuPDFStructuredTextSpatialIndex index = Volatile.Read(ref this.spatialIndex);
 
-            for (int i = 0; i < this.Count; i++)
+            if (index == null)
             {
-                if (includeImages || this[i].Type == MuPDFStructuredTextBlock.Types.Text || this[i].Type == MuPDFStructuredTextBlock.Types.Structure)
-                {
-                    float dx = Math.Max(0, Math.Max(this[i].BoundingBox.X0 - point.X, point.X - this[i].BoundingBox.X1));
-                    float dy = Math.Max(0, Math.Max(this[i].BoundingBox.Y0 - point.Y, point.Y - this[i].BoundingBox.Y1));
-                    float blockDist = dx * dx + dy * dy;
-
-                    if (this[i].BoundingBox.Contains(point) || blockDist < minBlockDistance)
-                    {
-                        if (blockDist < minBlockDistance)
-                        {
-                            minBlockDistance = blockDist;
-                            minLineDistance = float.MaxValue;
-                        }
-
-                        for (int j = 0; j < this[i].Count; j++)
-                        {
-                            dx = Math.Max(0, Math.Max(this[i][j].BoundingBox.X0 - point.X, point.X - this[i][j].BoundingBox.X1));
-                            dy = Math.Max(0, Math.Max(this[i][j].BoundingBox.Y0 - point.Y, point.Y - this[i][j].BoundingBox.Y1));
-                            float lineDist = dx * dx + dy * dy;
-
-                            if (this[i][j].BoundingBox.Contains(point) || lineDist < minLineDistance)
-                            {
-                                if (lineDist < minLineDistance)
-                                {
-                                    minLineDistance = lineDist;
-                                }
-
-                                for (int k = 0; k < this[i][j].Count; k++)
-                                {
-                                    if (this[i][j][k].BoundingQuad.Contains(point))
-                                    {
-                                        return new MuPDFStructuredTextAddress(i, j, k);
-                                    }
-                                    else
-                                    {
-                                        //The quads should be small enough that the error due to only checking vertices and not sides is negligible. Also, since the square root is monotonous, we can skip it.
-                                        float minDist = (point.X - this[i][j][k].BoundingQuad.UpperLeft.X) * (point.X - this[i][j][k].BoundingQuad.UpperLeft.X) + (point.Y - this[i][j][k].BoundingQuad.UpperLeft.Y) * (point.Y - this[i][j][k].BoundingQuad.UpperLeft.Y);
-                                        minDist = Math.Min(minDist, (point.X - this[i][j][k].BoundingQuad.UpperRight.X) * (point.X - this[i][j][k].BoundingQuad.UpperRight.X) + (point.Y - this[i][j][k].BoundingQuad.UpperRight.Y) * (point.Y - this[i][j][k].BoundingQuad.UpperRight.Y));
-                                        minDist = Math.Min(minDist, (point.X - this[i][j][k].BoundingQuad.LowerRight.X) * (point.X - this[i][j][k].BoundingQuad.LowerRight.X) + (point.Y - this[i][j][k].BoundingQuad.LowerRight.Y) * (point.Y - this[i][j][k].BoundingQuad.LowerRight.Y));
-                                        minDist = Math.Min(minDist, (point.X - this[i][j][k].BoundingQuad.LowerLeft.X) * (point.X - this[i][j][k].BoundingQuad.LowerLeft.X) + (point.Y - this[i][j][k].BoundingQuad.LowerLeft.Y) * (point.Y - this[i][j][k].BoundingQuad.LowerLeft.Y));
-
-                                        if (minDist < minDistance)
-                                        {
-                                            minDistance = minDist;
-                                            closestHit = new MuPDFStructuredTextAddress(i, j, k);
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+                index = new MuPDFStructuredTextSpatialIndex(this);
+                index = Interlocked.CompareExchange(ref this.spatialIndex, index, null) ?? index;
             }
 
-            return closestHit;
+            return index;
         }
 
         /// <summary>
@@ -613,6 +563,52 @@ namespace MuPDFCore.StructuredText
             }
         }
 
+        /// <summary>
+        /// Searches for the specified literal string in the text of the page, using MuPDF's native search. Unlike <see cref="Search(Regex)"/>, a single match can span multiple lines,
+        /// and the white space in the <paramref name="needle"/> matches any amount of white space in the text.
+        /// </summary>
+        /// <param name="needle">The string to search for.</param>
+        /// <param name="caseSensitive">If this is <see langword="false"/>, the search ignores the case of the characters.</param>
+        /// <param name="maxHits">The maximum number of hits to return, or 0 to return all of them.</param>
+        /// <returns>An array of <see cref="MuPDFTextSearchHit"/>s representing the occurrences of the <paramref name="needle"/> in the text, in reading order.</returns>
+        public MuPDFTextSearchHit[] Search(string needle, bool caseSensitive = false, int maxHits = 0)
+        {
+            if (needle == null)
+            {
+                throw new ArgumentNullException(nameof(needle));
+            }
+
+            if (maxHits < 0)
+            {
+                throw new ArgumentOutOfRangeException(nameof(maxHits), maxHits, "The maximum number of hits must be greater than or equal to 0!");
+            }
+
+            if (disposedValue)
+            {
+                throw new ObjectDisposedException(nameof(MuPDFStructuredTextPage));
+            }
+
+            if (needle.Length == 0)
+            {
+                return new MuPDFTextSearchHit[0];
+            }
+
+            IntPtr data = IntPtr.Zero;
+            int hitCount = 0;
+            int quadCount = 0;
+
+            ExitCodes result;
+
+            using (UTF8EncodedString encodedNeedle = new UTF8EncodedString(needle))
+            {
+                result = (ExitCodes)NativeMethods.SearchStructuredTextPage(OwnerContext.NativeContext, NativePointer, encodedNeedle.Address, (int)(caseSensitive ? SearchOptions.CaseSensitive : SearchOptions.None), maxHits, ref data, ref hitCount, ref quadCount);
+            }
+
+            MuPDFTextSearchHit.CheckResult(result);
+
+            return MuPDFTextSearchHit.ReadHits(OwnerContext, data, hitCount, quadCount, -1);
+        }
+
         /// <inheritdoc/>
         public IEnumerator<MuPDFStructuredTextBlock> GetEnumerator()
         {
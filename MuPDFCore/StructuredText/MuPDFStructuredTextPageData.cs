@@ -0,0 +1,310 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2024  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+using System;
+using System.Collections.Generic;
+using System.Runtime.InteropServices;
+
+namespace MuPDFCore.StructuredText
+{
+    /// <summary>
+    /// Header of the flat buffer produced by <see cref="NativeMethods.GetStructuredTextPageData"/>. This must match the <c>stext_page_data_header</c> struct in the native wrapper. Offsets are in bytes from the start of the buffer.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct StructuredTextPageDataHeader
+    {
+        /// <summary>
+        /// The version of the buffer layout that is understood by this code.
+        /// </summary>
+        public const int SupportedVersion = 1;
+
+        /// <summary>
+        /// The version of the buffer layout.
+        /// </summary>
+        public int Version;
+        /// <summary>
+        /// The number of text blocks.
+        /// </summary>
+        public int BlockCount;
+        /// <summary>
+        /// The total number of lines.
+        /// </summary>
+        public int LineCount;
+        /// <summary>
+        /// The total number of characters.
+        /// </summary>
+        public int CharCount;
+        /// <summary>
+        /// The number of distinct fonts in the font table.
+        /// </summary>
+        public int FontCount;
+        /// <summary>
+        /// Padding.
+        /// </summary>
+        public int Reserved;
+
+        /// <summary>
+        /// Offset of the native block pointers (<see cref="IntPtr"/>[<see cref="BlockCount"/>]).
+        /// </summary>
+        public long BlockPointers;
+        /// <summary>
+        /// Offset of the index of the first line of each block (<see cref="int"/>[<see cref="BlockCount"/>]).
+        /// </summary>
+        public long BlockFirstLines;
+        /// <summary>
+        /// Offset of the number of lines in each block (<see cref="int"/>[<see cref="BlockCount"/>]).
+        /// </summary>
+        public long BlockLineCounts;
+
+        /// <summary>
+        /// Offset of the writing mode of each line (<see cref="int"/>[<see cref="LineCount"/>]).
+        /// </summary>
+        public long LineWritingModes;
+        /// <summary>
+        /// Offset of the bounding box of each line (<see cref="float"/>[<see cref="LineCount"/> * 4]).
+        /// </summary>
+        public long LineBoundingBoxes;
+        /// <summary>
+        /// Offset of the baseline direction of each line (<see cref="float"/>[<see cref="LineCount"/> * 2]).
+        /// </summary>
+        public long LineDirections;
+        /// <summary>
+        /// Offset of the index of the first character of each line (<see cref="int"/>[<see cref="LineCount"/>]).
+        /// </summary>
+        public long LineFirstChars;
+        /// <summary>
+        /// Offset of the number of characters in each line (<see cref="int"/>[<see cref="LineCount"/>]).
+        /// </summary>
+        public long LineCharCounts;
+
+        /// <summary>
+        /// Offset of the code point of each character (<see cref="int"/>[<see cref="CharCount"/>]).
+        /// </summary>
+        public long CharCodePoints;
+        /// <summary>
+        /// Offset of the colour of each character (<see cref="uint"/>[<see cref="CharCount"/>]).
+        /// </summary>
+        public long CharColors;
+        /// <summary>
+        /// Offset of the bidi level of each character (<see cref="int"/>[<see cref="CharCount"/>]).
+        /// </summary>
+        public long CharBidis;
+        /// <summary>
+        /// Offset of the index in the font table of the font of each character (<see cref="int"/>[<see cref="CharCount"/>]).
+        /// </summary>
+        public long CharFonts;
+        /// <summary>
+        /// Offset of the size of each character (<see cref="float"/>[<see cref="CharCount"/>]).
+        /// </summary>
+        public long CharSizes;
+        /// <summary>
+        /// Offset of the origin of each character (<see cref="float"/>[<see cref="CharCount"/> * 2]).
+        /// </summary>
+        public long CharOrigins;
+        /// <summary>
+        /// Offset of the bounding quad of each character, as lower left, upper left, upper right, lower right (<see cref="float"/>[<see cref="CharCount"/> * 8]).
+        /// </summary>
+        public long CharQuads;
+
+        /// <summary>
+        /// Offset of the font table (<see cref="IntPtr"/>[<see cref="FontCount"/>]).
+        /// </summary>
+        public long FontPointers;
+    }
+
+    /// <summary>
+    /// A flat, struct-of-arrays representation of all the text blocks, lines and characters in a native structured text page. This is used to build the managed object graph without one native call per character.
+    /// </summary>
+    internal unsafe class MuPDFStructuredTextPageData : IDisposable
+    {
+        /// <summary>
+        /// The context that owns the buffer.
+        /// </summary>
+        private readonly MuPDFContext OwnerContext;
+
+        /// <summary>
+        /// The native buffer.
+        /// </summary>
+        private IntPtr Data;
+
+        /// <summary>
+        /// The header of the buffer.
+        /// </summary>
+        private readonly StructuredTextPageDataHeader Header;
+
+        /// <summary>
+        /// Maps the address of each native text block to its index in the buffer.
+        /// </summary>
+        private readonly Dictionary<IntPtr, int> BlockIndices;
+
+        /// <summary>
+        /// Serialise the specified native structured text page.
+        /// </summary>
+        /// <param name="context">The context that owns the structured text page.</param>
+        /// <param name="nativeStructuredPage">The native structured text page.</param>
+        public MuPDFStructuredTextPageData(MuPDFContext context, IntPtr nativeStructuredPage)
+        {
+            IntPtr data = IntPtr.Zero;
+            long length = 0;
+
+            ExitCodes result = (ExitCodes)NativeMethods.GetStructuredTextPageData(context.NativeContext, nativeStructuredPage, ref data, ref length);
+
+            switch (result)
+            {
+                case ExitCodes.EXIT_SUCCESS:
+                    break;
+                case ExitCodes.ERR_CANNOT_CREATE_BUFFER:
+                    throw new MuPDFException("Cannot create buffer", result);
+                default:
+                    throw new MuPDFException("Unknown error", result);
+            }
+
+            this.OwnerContext = context;
+            this.Data = data;
+            this.Header = *(StructuredTextPageDataHeader*)data;
+
+            if (this.Header.Version != StructuredTextPageDataHeader.SupportedVersion)
+            {
+                this.Dispose();
+                throw new MuPDFException("Unsupported structured text data version: " + this.Header.Version.ToString(), ExitCodes.UNKNOWN_ERROR);
+            }
+
+            this.BlockIndices = new Dictionary<IntPtr, int>(this.Header.BlockCount);
+
+            IntPtr* blockPointers = (IntPtr*)((byte*)data + this.Header.BlockPointers);
+
+            for (int i = 0; i < this.Header.BlockCount; i++)
+            {
+                this.BlockIndices[blockPointers[i]] = i;
+            }
+        }
+
+        /// <summary>
+        /// Gets the index in the buffer of the specified native text block.
+        /// </summary>
+        /// <param name="blockPointer">The native text block.</param>
+        /// <returns>The index of the block, or -1 if the block is not a text block of this page.</returns>
+        public int GetBlockIndex(IntPtr blockPointer)
+        {
+            if (this.BlockIndices.TryGetValue(blockPointer, out int index))
+            {
+                return index;
+            }
+            else
+            {
+                return -1;
+            }
+        }
+
+        /// <summary>
+        /// Create the lines contained in the specified text block.
+        /// </summary>
+        /// <param name="parentBlock">The managed block that will contain the lines.</param>
+        /// <param name="blockIndex">The index of the block in the buffer.</param>
+        /// <returns>The lines in the block.</returns>
+        public MuPDFStructuredTextLine[] CreateLines(MuPDFStructuredTextBlock parentBlock, int blockIndex)
+        {
+            byte* data = (byte*)this.Data;
+
+            int firstLine = ((int*)(data + this.Header.BlockFirstLines))[blockIndex];
+            int lineCount = ((int*)(data + this.Header.BlockLineCounts))[blockIndex];
+
+            int* wmodes = (int*)(data + this.Header.LineWritingModes);
+            float* bboxes = (float*)(data + this.Header.LineBoundingBoxes);
+            float* dirs = (float*)(data + this.Header.LineDirections);
+
+            MuPDFStructuredTextLine[] lines = new MuPDFStructuredTextLine[lineCount];
+
+            for (int i = 0; i < lineCount; i++)
+            {
+                int l = firstLine + i;
+
+                Rectangle bBox = new Rectangle(bboxes[l * 4], bboxes[l * 4 + 1], bboxes[l * 4 + 2], bboxes[l * 4 + 3]);
+                PointF direction = new PointF(dirs[l * 2], dirs[l * 2 + 1]);
+
+                lines[i] = new MuPDFStructuredTextLine(this, l, parentBlock, (MuPDFStructuredTextLine.WritingModes)wmodes[l], direction, bBox);
+            }
+
+            return lines;
+        }
+
+        /// <summary>
+        /// Create the characters contained in the specified line.
+        /// </summary>
+        /// <param name="parentLine">The managed line that will contain the characters.</param>
+        /// <param name="lineIndex">The index of the line in the buffer.</param>
+        /// <param name="text">When this method returns, this will contain the text of the line.</param>
+        /// <returns>The characters in the line.</returns>
+        public MuPDFStructuredTextCharacter[] CreateCharacters(MuPDFStructuredTextLine parentLine, int lineIndex, out string text)
+        {
+            byte* data = (byte*)this.Data;
+
+            int firstChar = ((int*)(data + this.Header.LineFirstChars))[lineIndex];
+            int charCount = ((int*)(data + this.Header.LineCharCounts))[lineIndex];
+
+            int* codePoints = (int*)(data + this.Header.CharCodePoints);
+            uint* colors = (uint*)(data + this.Header.CharColors);
+            int* bidis = (int*)(data + this.Header.CharBidis);
+            int* fonts = (int*)(data + this.Header.CharFonts);
+            float* sizes = (float*)(data + this.Header.CharSizes);
+            float* origins = (float*)(data + this.Header.CharOrigins);
+            float* quads = (float*)(data + this.Header.CharQuads);
+            IntPtr* fontPointers = (IntPtr*)(data + this.Header.FontPointers);
+
+            MuPDFStructuredTextCharacter[] characters = new MuPDFStructuredTextCharacter[charCount];
+            char[] textChars = new char[charCount * 2];
+            int textLength = 0;
+
+            for (int i = 0; i < charCount; i++)
+            {
+                int c = firstChar + i;
+                float* q = quads + c * 8;
+
+                Quad quad = new Quad(new PointF(q[0], q[1]), new PointF(q[2], q[3]), new PointF(q[4], q[5]), new PointF(q[6], q[7]));
+                PointF origin = new PointF(origins[c * 2], origins[c * 2 + 1]);
+
+                MuPDFFont muPDFFont = this.OwnerContext.Resolve(fontPointers[fonts[c]]);
+
+                characters[i] = new MuPDFStructuredTextCharacter(parentLine, codePoints[c], colors[c], origin, quad, sizes[c], bidis[c] % 2 == 0 ? MuPDFStructuredTextCharacter.TextDirection.LeftToRight : MuPDFStructuredTextCharacter.TextDirection.RightToLeft, muPDFFont);
+
+                string character = characters[i].Character;
+
+                for (int j = 0; j < character.Length; j++)
+                {
+                    textChars[textLength++] = character[j];
+                }
+            }
+
+            text = new string(textChars, 0, textLength);
+
+            return characters;
+        }
+
+        /// <summary>
+        /// Free the native buffer.
+        /// </summary>
+        public void Dispose()
+        {
+            if (this.Data != IntPtr.Zero)
+            {
+                NativeMethods.DisposeStructuredTextPageData(this.OwnerContext.NativeContext, this.Data);
+                this.Data = IntPtr.Zero;
+            }
+        }
+    }
+}
@@ -0,0 +1,331 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2024  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+using System;
+
+namespace MuPDFCore.StructuredText
+{
+    /// <summary>
+    /// A uniform grid over the characters of a <see cref="MuPDFStructuredTextPage"/>, used to speed up hit testing.
+    /// </summary>
+    internal class MuPDFStructuredTextSpatialIndex
+    {
+        /// <summary>
+        /// A character in the index. Characters are stored in address order.
+        /// </summary>
+        private struct Entry
+        {
+            public MuPDFStructuredTextAddress Address;
+            public Quad Quad;
+            public float X0;
+            public float Y0;
+            public float X1;
+            public float Y1;
+            public bool IsText;
+        }
+
+        private readonly MuPDFStructuredTextPage Page;
+        private readonly Entry[] Entries;
+
+        private readonly float OriginX;
+        private readonly float OriginY;
+        private readonly float CellWidth;
+        private readonly float CellHeight;
+        private readonly int Columns;
+        private readonly int Rows;
+
+        /// <summary>
+        /// The entries contained in cell <c>c</c> are <c>CellEntries[CellStarts[c]]</c> to <c>CellEntries[CellStarts[c + 1] - 1]</c>, in address order.
+        /// </summary>
+        private readonly int[] CellStarts;
+        private readonly int[] CellEntries;
+
+        public MuPDFStructuredTextSpatialIndex(MuPDFStructuredTextPage page)
+        {
+            this.Page = page;
+
+            int count = 0;
+
+            for (int i = 0; i < page.Count; i++)
+            {
+                for (int j = 0; j < page[i].Count; j++)
+                {
+                    count += page[i][j].Count;
+                }
+            }
+
+            this.Entries = new Entry[count];
+
+            float minX = float.MaxValue;
+            float minY = float.MaxValue;
+            float maxX = float.MinValue;
+            float maxY = float.MinValue;
+
+            int index = 0;
+
+            for (int i = 0; i < page.Count; i++)
+            {
+                bool isText = page[i].Type == MuPDFStructuredTextBlock.Types.Text || page[i].Type == MuPDFStructuredTextBlock.Types.Structure;
+
+                for (int j = 0; j < page[i].Count; j++)
+                {
+                    for (int k = 0; k < page[i][j].Count; k++)
+                    {
+                        Quad quad = page[i][j][k].BoundingQuad;
+
+                        Entry entry = new Entry()
+                        {
+                            Address = new MuPDFStructuredTextAddress(i, j, k),
+                            Quad = quad,
+                            X0 = Math.Min(Math.Min(quad.LowerLeft.X, quad.UpperLeft.X), Math.Min(quad.UpperRight.X, quad.LowerRight.X)),
+                            Y0 = Math.Min(Math.Min(quad.LowerLeft.Y, quad.UpperLeft.Y), Math.Min(quad.UpperRight.Y, quad.LowerRight.Y)),
+                            X1 = Math.Max(Math.Max(quad.LowerLeft.X, quad.UpperLeft.X), Math.Max(quad.UpperRight.X, quad.LowerRight.X)),
+                            Y1 = Math.Max(Math.Max(quad.LowerLeft.Y, quad.UpperLeft.Y), Math.Max(quad.UpperRight.Y, quad.LowerRight.Y)),
+                            IsText = isText
+                        };
+
+                        minX = Math.Min(minX, entry.X0);
+                        minY = Math.Min(minY, entry.Y0);
+                        maxX = Math.Max(maxX, entry.X1);
+                        maxY = Math.Max(maxY, entry.Y1);
+
+                        this.Entries[index] = entry;
+                        index++;
+                    }
+                }
+            }
+
+            if (count == 0)
+            {
+                minX = minY = maxX = maxY = 0;
+            }
+
+            //Roughly one character per cell.
+            int side = Math.Max(1, (int)Math.Ceiling(Math.Sqrt(count)));
+
+            this.Columns = side;
+            this.Rows = side;
+            this.OriginX = minX;
+            this.OriginY = minY;
+            this.CellWidth = Math.Max((maxX - minX) / side, 1e-3f);
+            this.CellHeight = Math.Max((maxY - minY) / side, 1e-3f);
+
+            this.CellStarts = new int[this.Columns * this.Rows + 1];
+
+            for (int i = 0; i < this.Entries.Length; i++)
+            {
+                GetCellRange(this.Entries[i], out int cx0, out int cy0, out int cx1, out int cy1);
+
+                for (int y = cy0; y <= cy1; y++)
+                {
+                    for (int x = cx0; x <= cx1; x++)
+                    {
+                        this.CellStarts[y * this.Columns + x + 1]++;
+                    }
+                }
+            }
+
+            for (int i = 1; i < this.CellStarts.Length; i++)
+            {
+                this.CellStarts[i] += this.CellStarts[i - 1];
+            }
+
+            this.CellEntries = new int[this.CellStarts[this.CellStarts.Length - 1]];
+            int[] cellFill = new int[this.Columns * this.Rows];
+
+            for (int i = 0; i < this.Entries.Length; i++)
+            {
+                GetCellRange(this.Entries[i], out int cx0, out int cy0, out int cx1, out int cy1);
+
+                for (int y = cy0; y <= cy1; y++)
+                {
+                    for (int x = cx0; x <= cx1; x++)
+                    {
+                        int cell = y * this.Columns + x;
+                        this.CellEntries[this.CellStarts[cell] + cellFill[cell]] = i;
+                        cellFill[cell]++;
+                    }
+                }
+            }
+        }
+
+        /// <summary>
+        /// Gets the address of the first character that contains the specified <paramref name="point"/>, within a line and a block that also contain it.
+        /// This returns the same result as a linear scan of the page.
+        /// </summary>
+        public MuPDFStructuredTextAddress? GetHitAddress(PointF point, bool includeImages)
+        {
+            if (this.Entries.Length == 0)
+            {
+                return null;
+            }
+
+            int cell = GetRow(point.Y) * this.Columns + GetColumn(point.X);
+
+            for (int i = this.CellStarts[cell]; i < this.CellStarts[cell + 1]; i++)
+            {
+                Entry entry = this.Entries[this.CellEntries[i]];
+
+                if ((includeImages || entry.IsText) && entry.Quad.Contains(point))
+                {
+                    MuPDFStructuredTextAddress address = entry.Address;
+
+                    if (Page[address.BlockIndex].BoundingBox.Contains(point) && Page[address.BlockIndex][address.LineIndex].BoundingBox.Contains(point))
+                    {
+                        return address;
+                    }
+                }
+            }
+
+            return null;
+        }
+
+        /// <summary>
+        /// Gets the address of the character that contains the specified <paramref name="point"/> or, if no character contains it, of the character with the
+        /// vertex closest to the <paramref name="point"/>. Ties are resolved in favour of the character that comes first.
+        /// </summary>
+        public MuPDFStructuredTextAddress? GetClosestHitAddress(PointF point, bool includeImages)
+        {
+            MuPDFStructuredTextAddress? hit = GetHitAddress(point, includeImages);
+
+            if (hit != null)
+            {
+                return hit;
+            }
+
+            int cx = GetColumn(point.X);
+            int cy = GetRow(point.Y);
+
+            float minDistance = float.MaxValue;
+            int closest = -1;
+
+            for (int r = 0; ; r++)
+            {
+                int x0 = Math.Max(0, cx - r);
+                int x1 = Math.Min(this.Columns - 1, cx + r);
+                int y0 = Math.Max(0, cy - r);
+                int y1 = Math.Min(this.Rows - 1, cy + r);
+
+                //Visit the cells on the border of the square of radius r.
+                for (int y = y0; y <= y1; y++)
+                {
+                    bool fullRow = y == cy - r || y == cy + r;
+
+                    for (int x = x0; x <= x1; x++)
+                    {
+                        if (fullRow || x == cx - r || x == cx + r)
+                        {
+                            int cell = y * this.Columns + x;
+
+                            for (int i = this.CellStarts[cell]; i < this.CellStarts[cell + 1]; i++)
+                            {
+                                int entryIndex = this.CellEntries[i];
+
+                                if (includeImages || this.Entries[entryIndex].IsText)
+                                {
+                                    float distance = GetVertexDistance(this.Entries[entryIndex].Quad, point);
+
+                                    if (distance < minDistance || (distance == minDistance && entryIndex < closest))
+                                    {
+                                        minDistance = distance;
+                                        closest = entryIndex;
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+
+                if (x0 == 0 && y0 == 0 && x1 == this.Columns - 1 && y1 == this.Rows - 1)
+                {
+                    break;
+                }
+
+                //Any character that has not been visited yet lies entirely outside the visited cells.
+                float bound = float.MaxValue;
+
+                if (x0 > 0)
+                {
+                    bound = Math.Min(bound, point.X - (this.OriginX + x0 * this.CellWidth));
+                }
+
+                if (x1 < this.Columns - 1)
+                {
+                    bound = Math.Min(bound, this.OriginX + (x1 + 1) * this.CellWidth - point.X);
+                }
+
+                if (y0 > 0)
+                {
+                    bound = Math.Min(bound, point.Y - (this.OriginY + y0 * this.CellHeight));
+                }
+
+                if (y1 < this.Rows - 1)
+                {
+                    bound = Math.Min(bound, this.OriginY + (y1 + 1) * this.CellHeight - point.Y);
+                }
+
+                bound = Math.Max(0, bound);
+
+                if (closest >= 0 && bound * bound > minDistance)
+                {
+                    break;
+                }
+            }
+
+            if (closest >= 0)
+            {
+                return this.Entries[closest].Address;
+            }
+            else
+            {
+                return null;
+            }
+        }
+
+        /// <summary>
+        /// Computes the squared distance between the <paramref name="point"/> and the closest vertex of the <paramref name="quad"/>. The quads should be small
+        /// enough that the error due to only checking vertices and not sides is negligible.
+        /// </summary>
+        private static float GetVertexDistance(Quad quad, PointF point)
+        {
+            float minDist = (point.X - quad.UpperLeft.X) * (point.X - quad.UpperLeft.X) + (point.Y - quad.UpperLeft.Y) * (point.Y - quad.UpperLeft.Y);
+            minDist = Math.Min(minDist, (point.X - quad.UpperRight.X) * (point.X - quad.UpperRight.X) + (point.Y - quad.UpperRight.Y) * (point.Y - quad.UpperRight.Y));
+            minDist = Math.Min(minDist, (point.X - quad.LowerRight.X) * (point.X - quad.LowerRight.X) + (point.Y - quad.LowerRight.Y) * (point.Y - quad.LowerRight.Y));
+            minDist = Math.Min(minDist, (point.X - quad.LowerLeft.X) * (point.X - quad.LowerLeft.X) + (point.Y - quad.LowerLeft.Y) * (point.Y - quad.LowerLeft.Y));
+            return minDist;
+        }
+
+        private int GetColumn(float x)
+        {
+            return Math.Max(0, Math.Min(this.Columns - 1, (int)Math.Floor((x - this.OriginX) / this.CellWidth)));
+        }
+
+        private int GetRow(float y)
+        {
+            return Math.Max(0, Math.Min(this.Rows - 1, (int)Math.Floor((y - this.OriginY) / this.CellHeight)));
+        }
+
+        private void GetCellRange(Entry entry, out int cx0, out int cy0, out int cx1, out int cy1)
+        {
+            cx0 = GetColumn(entry.X0);
+            cy0 = GetRow(entry.Y0);
+            cx1 = GetColumn(entry.X1);
+            cy1 = GetRow(entry.Y1);
+        }
+    }
+}
@@ -0,0 +1,1286 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2024  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Runtime.InteropServices;
+using System.Security.Cryptography;
+using System.Text;
+
+namespace MuPDFCore.StructuredText
+{
+    /// <summary>
+    /// A document that has been added to a <see cref="MuPDFTextIndex"/>.
+    /// </summary>
+    public class MuPDFTextIndexDocument
+    {
+        /// <summary>
+        /// The index of the document within the <see cref="MuPDFTextIndex"/>.
+        /// </summary>
+        public int Index { get; }
+
+        /// <summary>
+        /// The path of the file from which the document was indexed.
+        /// </summary>
+        public string FileName { get; }
+
+        /// <summary>
+        /// The SHA-256 hash of the contents of the file, as a lowercase hexadecimal string. Documents are identified by this hash when the index is updated.
+        /// </summary>
+        public string ContentHash { get; }
+
+        /// <summary>
+        /// The number of pages in the document. If the document was encrypted, this is the number of pages, but no text has been indexed.
+        /// </summary>
+        public int PageCount { get; }
+
+        internal MuPDFTextIndexDocument(int index, string fileName, string contentHash, int pageCount)
+        {
+            this.Index = index;
+            this.FileName = fileName;
+            this.ContentHash = contentHash;
+            this.PageCount = pageCount;
+        }
+    }
+
+    /// <summary>
+    /// An occurrence of a query in a <see cref="MuPDFTextIndex"/>.
+    /// </summary>
+    public class MuPDFTextIndexHit
+    {
+        /// <summary>
+        /// The document containing the hit.
+        /// </summary>
+        public MuPDFTextIndexDocument Document { get; }
+
+        /// <summary>
+        /// The number of the page containing the hit (starting at 0).
+        /// </summary>
+        public int PageNumber { get; }
+
+        /// <summary>
+        /// The characters of the hit, as addresses in the <see cref="MuPDFStructuredTextPage"/> that would be obtained for the same page using <see cref="StructuredTextFlags.None"/>.
+        /// </summary>
+        public MuPDFStructuredTextAddressSpan Span { get; }
+
+        internal MuPDFTextIndexHit(MuPDFTextIndexDocument document, int pageNumber, MuPDFStructuredTextAddressSpan span)
+        {
+            this.Document = document;
+            this.PageNumber = pageNumber;
+            this.Span = span;
+        }
+    }
+
+    /// <summary>
+    /// The header of an index file.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct TextIndexHeader
+    {
+        public int Magic;
+        public int Version;
+        public int DocumentCount;
+        public int TermCount;
+        public long DocumentsOffset;
+        public long TermsOffset;
+        public long PostingsOffset;
+        public long StringsOffset;
+        public long PostingCount;
+        public int Flags;
+        public int Reserved;
+    }
+
+    /// <summary>
+    /// A document entry in an index file.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal unsafe struct TextIndexDocumentEntry
+    {
+        public fixed byte Hash[32];
+        public int PageCount;
+        public int NameLength;
+        public long NameOffset;
+    }
+
+    /// <summary>
+    /// A term entry in an index file. Terms are sorted by their UTF-8 representation.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct TextIndexTermEntry
+    {
+        public long StringOffset;
+        public int StringLength;
+        public int PostingCount;
+        public long FirstPosting;
+    }
+
+    /// <summary>
+    /// An occurrence of a term in an index file. The postings for each term are sorted by document, page and position.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct TextIndexPosting
+    {
+        public int Document;
+        public int Page;
+        public int Position;
+        public int Block;
+        public int Line;
+        public int StartCharacter;
+        public int EndCharacter;
+
+        public static int Compare(TextIndexPosting a, TextIndexPosting b)
+        {
+            if (a.Document != b.Document)
+            {
+                return a.Document.CompareTo(b.Document);
+            }
+            else if (a.Page != b.Page)
+            {
+                return a.Page.CompareTo(b.Page);
+            }
+            else
+            {
+                return a.Position.CompareTo(b.Position);
+            }
+        }
+    }
+
+    /// <summary>
+    /// A positional inverted index of the text contained in a collection of documents, stored in a memory-mapped file. Queries are answered from the index
+    /// alone, without opening or parsing the indexed documents.
+    /// </summary>
+    /// <remarks>
+    /// The text of each page is obtained from a <see cref="MuPDFStructuredTextPage"/> and split into terms, i.e. runs of letters and digits within a line,
+    /// which are compared ignoring case. The index file is written in the byte order of the machine that created it.
+    /// </remarks>
+    public class MuPDFTextIndex : IDisposable
+    {
+        private const int IndexMagic = 0x4954504D;
+        private const int IndexVersion = 2;
+
+        /// <summary>
+        /// Set in <see cref="TextIndexHeader.Flags"/> if annotations were included when the documents were indexed.
+        /// </summary>
+        private const int IncludeAnnotationsFlag = 1;
+
+        /// <summary>
+        /// The number of postings that are collected in memory while creating an index before they are written to a temporary run file.
+        /// </summary>
+        private const int MaxBufferedPostings = 1 << 20;
+
+        private readonly MemoryMappedFile MappedFile;
+        private readonly MemoryMappedViewAccessor Accessor;
+        private readonly unsafe byte* Data;
+        private readonly long Length;
+        private readonly TextIndexHeader Header;
+        private bool PointerAcquired;
+
+        /// <summary>
+        /// The documents contained in the index.
+        /// </summary>
+        public IReadOnlyList<MuPDFTextIndexDocument> Documents { get; }
+
+        /// <summary>
+        /// The number of distinct terms in the index.
+        /// </summary>
+        public int TermCount => Header.TermCount;
+
+        /// <summary>
+        /// Whether annotations were included when the documents were indexed.
+        /// </summary>
+        public bool IncludeAnnotations => (Header.Flags & IncludeAnnotationsFlag) != 0;
+
+        /// <summary>
+        /// Opens an index file that has been created using <see cref="Create(MuPDFContext, string, IEnumerable{string}, bool)"/>.
+        /// </summary>
+        /// <param name="indexFile">The path to the index file.</param>
+        /// <exception cref="InvalidDataException">Thrown if the file is not a valid index file.</exception>
+        public unsafe MuPDFTextIndex(string indexFile)
+        {
+            this.Length = new FileInfo(indexFile).Length;
+
+            if (this.Length < sizeof(TextIndexHeader))
+            {
+                throw new InvalidDataException("The file is not a valid text index!");
+            }
+
+            this.MappedFile = MemoryMappedFile.CreateFromFile(indexFile, FileMode.Open, null, 0, MemoryMappedFileAccess.Read);
+
+            try
+            {
+                this.Accessor = this.MappedFile.CreateViewAccessor(0, 0, MemoryMappedFileAccess.Read);
+
+                byte* pointer = null;
+                this.Accessor.SafeMemoryMappedViewHandle.AcquirePointer(ref pointer);
+                this.PointerAcquired = true;
+                this.Data = pointer + this.Accessor.PointerOffset;
+
+                this.Header = *(TextIndexHeader*)this.Data;
+
+                if (Header.Magic != IndexMagic || Header.Version != IndexVersion ||
+                    !IsValidRange(Header.DocumentsOffset, Header.DocumentCount, sizeof(TextIndexDocumentEntry), sizeof(TextIndexHeader), this.Length) ||
+                    !IsValidRange(Header.TermsOffset, Header.TermCount, sizeof(TextIndexTermEntry), sizeof(TextIndexHeader), this.Length) ||
+                    !IsValidRange(Header.PostingsOffset, Header.PostingCount, sizeof(TextIndexPosting), sizeof(TextIndexHeader), this.Length) ||
+                    !IsValidRange(Header.StringsOffset, 0, 1, sizeof(TextIndexHeader), this.Length))
+                {
+                    throw new InvalidDataException("The file is not a valid text index!");
+                }
+
+                //All the offsets that are used later as pointers are checked here, so that a corrupt file cannot cause reads outside of the mapped view.
+                long stringsLength = this.Length - Header.StringsOffset;
+
+                MuPDFTextIndexDocument[] documents = new MuPDFTextIndexDocument[Header.DocumentCount];
+                TextIndexDocumentEntry* documentEntries = (TextIndexDocumentEntry*)(this.Data + Header.DocumentsOffset);
+
+                for (int i = 0; i < documents.Length; i++)
+                {
+                    TextIndexDocumentEntry* entry = documentEntries + i;
+
+                    if (entry->PageCount < 0 || !IsValidRange(entry->NameOffset, entry->NameLength, 1, 0, stringsLength))
+                    {
+                        throw new InvalidDataException("The file is not a valid text index!");
+                    }
+
+                    string name = Encoding.UTF8.GetString(this.Data + Header.StringsOffset + entry->NameOffset, entry->NameLength);
+
+                    byte[] hash = new byte[32];
+                    Marshal.Copy((IntPtr)entry->Hash, hash, 0, 32);
+
+                    documents[i] = new MuPDFTextIndexDocument(i, name, HashToString(hash), entry->PageCount);
+                }
+
+                this.Documents = documents;
+
+                TextIndexTermEntry* terms = (TextIndexTermEntry*)(this.Data + Header.TermsOffset);
+
+                for (int i = 0; i < Header.TermCount; i++)
+                {
+                    if (!IsValidRange(terms[i].StringOffset, terms[i].StringLength, 1, 0, stringsLength) || !IsValidRange(terms[i].FirstPosting, terms[i].PostingCount, 1, 0, Header.PostingCount))
+                    {
+                        throw new InvalidDataException("The file is not a valid text index!");
+                    }
+                }
+
+                TextIndexPosting* postings = (TextIndexPosting*)(this.Data + Header.PostingsOffset);
+
+                for (long i = 0; i < Header.PostingCount; i++)
+                {
+                    if (postings[i].Document < 0 || postings[i].Document >= Header.DocumentCount)
+                    {
+                        throw new InvalidDataException("The file is not a valid text index!");
+                    }
+                }
+            }
+            catch
+            {
+                ReleaseView();
+                throw;
+            }
+        }
+
+        /// <summary>
+        /// Searches the index for the specified <paramref name="query"/>. The query is split into terms in the same way as the text of the documents; if it
+        /// contains more than one term, only the places where the terms occur consecutively (i.e. as a phrase) are returned.
+        /// </summary>
+        /// <param name="query">The text to search for.</param>
+        /// <returns>An array containing the occurrences of the <paramref name="query"/>, sorted by document, page and position within the page.</returns>
+        public unsafe MuPDFTextIndexHit[] Search(string query)
+        {
+            if (query == null)
+            {
+                throw new ArgumentNullException(nameof(query));
+            }
+
+            if (disposedValue)
+            {
+                throw new ObjectDisposedException(nameof(MuPDFTextIndex));
+            }
+
+            List<string> terms = Tokenize(query);
+
+            if (terms.Count == 0)
+            {
+                return new MuPDFTextIndexHit[0];
+            }
+
+            TextIndexTermEntry*[] entries = new TextIndexTermEntry*[terms.Count];
+
+            for (int i = 0; i < terms.Count; i++)
+            {
+                entries[i] = FindTerm(Encoding.UTF8.GetBytes(terms[i]));
+
+                if (entries[i] == null)
+                {
+                    return new MuPDFTextIndexHit[0];
+                }
+            }
+
+            TextIndexPosting* postings = (TextIndexPosting*)(this.Data + Header.PostingsOffset);
+
+            List<MuPDFTextIndexHit> tbr = new List<MuPDFTextIndexHit>();
+
+            TextIndexPosting* firstPostings = postings + entries[0]->FirstPosting;
+
+            for (int i = 0; i < entries[0]->PostingCount; i++)
+            {
+                TextIndexPosting first = firstPostings[i];
+                TextIndexPosting last = first;
+                bool found = true;
+
+                for (int j = 1; j < entries.Length; j++)
+                {
+                    TextIndexPosting target = first;
+                    target.Position += j;
+
+                    TextIndexPosting* match = FindPosting(postings + entries[j]->FirstPosting, entries[j]->PostingCount, target);
+
+                    if (match == null)
+                    {
+                        found = false;
+                        break;
+                    }
+
+                    last = *match;
+                }
+
+                if (found)
+                {
+                    tbr.Add(new MuPDFTextIndexHit(Documents[first.Document], first.Page, new MuPDFStructuredTextAddressSpan(new MuPDFStructuredTextAddress(first.Block, first.Line, first.StartCharacter), new MuPDFStructuredTextAddress(last.Block, last.Line, last.EndCharacter))));
+                }
+            }
+
+            return tbr.ToArray();
+        }
+
+        /// <summary>
+        /// Creates or updates an index file containing the text of the specified documents. If the <paramref name="indexFile"/> already exists and is a valid index,
+        /// the documents whose content hash is already present in it are not opened again, and their entries are copied from the existing index.
+        /// The postings of new documents are written to temporary files next to <paramref name="indexFile"/> and merged with the existing index, so that the
+        /// memory used does not depend on the total size of the indexed documents.
+        /// </summary>
+        /// <param name="context">The context used to open the documents that need to be indexed.</param>
+        /// <param name="indexFile">The path to the index file. If the file already exists, it is replaced.</param>
+        /// <param name="documentFiles">The paths to the documents to index. Files with the same contents are only indexed once.</param>
+        /// <param name="includeAnnotations">If this is <see langword="true" />, annotations (e.g. signatures) are included. Otherwise, only the page contents are included.
+        /// Entries from an existing index are only reused if it was created with the same value.</param>
+        public static void Create(MuPDFContext context, string indexFile, IEnumerable<string> documentFiles, bool includeAnnotations = true)
+        {
+            CreateIndex(context, indexFile, documentFiles, includeAnnotations);
+        }
+
+        /// <summary>
+        /// Creates or updates an index file (see <see cref="Create(MuPDFContext, string, IEnumerable{string}, bool)"/>), writing the postings to a temporary
+        /// run file whenever at least <paramref name="maxBufferedPostings"/> postings have been collected in memory.
+        /// </summary>
+        /// <returns>The number of documents that had to be opened and indexed, i.e. that could not be copied from the existing index.</returns>
+        internal static int CreateIndex(MuPDFContext context, string indexFile, IEnumerable<string> documentFiles, bool includeAnnotations, int maxBufferedPostings = MaxBufferedPostings)
+        {
+            if (context == null)
+            {
+                throw new ArgumentNullException(nameof(context));
+            }
+
+            if (indexFile == null)
+            {
+                throw new ArgumentNullException(nameof(indexFile));
+            }
+
+            if (documentFiles == null)
+            {
+                throw new ArgumentNullException(nameof(documentFiles));
+            }
+
+            List<string> fileNames = new List<string>();
+            List<byte[]> hashes = new List<byte[]>();
+            Dictionary<string, int> hashIndices = new Dictionary<string, int>();
+
+            using (SHA256 sha = SHA256.Create())
+            {
+                foreach (string documentFile in documentFiles)
+                {
+                    byte[] hash;
+
+                    using (FileStream stream = File.OpenRead(documentFile))
+                    {
+                        hash = sha.ComputeHash(stream);
+                    }
+
+                    string hashString = HashToString(hash);
+
+                    if (!hashIndices.ContainsKey(hashString))
+                    {
+                        hashIndices[hashString] = fileNames.Count;
+                        fileNames.Add(documentFile);
+                        hashes.Add(hash);
+                    }
+                }
+            }
+
+            int[] pageCounts = new int[fileNames.Count];
+            bool[] indexed = new bool[fileNames.Count];
+
+            List<PostingSource> sources = new List<PostingSource>();
+            List<string> runFiles = new List<string>();
+            MuPDFTextIndex previousIndex = null;
+
+            string tempFile = indexFile + ".tmp";
+
+            try
+            {
+                if (File.Exists(indexFile))
+                {
+                    try
+                    {
+                        previousIndex = new MuPDFTextIndex(indexFile);
+                    }
+                    catch (InvalidDataException)
+                    {
+                        //The existing file is not a valid index: all the documents are indexed again.
+                    }
+
+                    //An index created with different settings contains different text, so it cannot be reused.
+                    if (previousIndex != null && previousIndex.IncludeAnnotations == includeAnnotations)
+                    {
+                        int[] documentMap = previousIndex.MapDocuments(hashIndices, pageCounts, indexed);
+                        sources.Add(new IndexPostingSource(previousIndex, documentMap));
+                    }
+                }
+
+                //The postings of the documents that need to be indexed are sorted and written to temporary files (runs) once enough of them have been
+                //collected, so that only the postings of the last few documents are held in memory.
+                Dictionary<string, List<TextIndexPosting>> termPostings = new Dictionary<string, List<TextIndexPosting>>();
+                long bufferedPostings = 0;
+                int indexedCount = 0;
+
+                for (int i = 0; i < fileNames.Count; i++)
+                {
+                    if (!indexed[i])
+                    {
+                        pageCounts[i] = IndexDocument(context, fileNames[i], i, includeAnnotations, termPostings, ref bufferedPostings);
+                        indexedCount++;
+
+                        if (bufferedPostings >= maxBufferedPostings)
+                        {
+                            FlushRun(indexFile, runFiles, termPostings);
+                            bufferedPostings = 0;
+                        }
+                    }
+                }
+
+                if (termPostings.Count > 0)
+                {
+                    FlushRun(indexFile, runFiles, termPostings);
+                }
+
+                foreach (string runFile in runFiles)
+                {
+                    sources.Add(new RunPostingSource(runFile));
+                }
+
+                WriteIndex(tempFile, fileNames, hashes, pageCounts, includeAnnotations, sources);
+
+                foreach (PostingSource source in sources)
+                {
+                    source.Dispose();
+                }
+
+                sources.Clear();
+
+                previousIndex?.Dispose();
+                previousIndex = null;
+
+                if (File.Exists(indexFile))
+                {
+                    File.Delete(indexFile);
+                }
+
+                File.Move(tempFile, indexFile);
+
+                return indexedCount;
+            }
+            finally
+            {
+                foreach (PostingSource source in sources)
+                {
+                    source.Dispose();
+                }
+
+                previousIndex?.Dispose();
+
+                foreach (string runFile in runFiles)
+                {
+                    DeleteTemporaryFile(runFile);
+                }
+
+                DeleteTemporaryFile(tempFile);
+            }
+        }
+
+        /// <summary>
+        /// Sorts the postings that have been collected and writes them to a new run file, then clears them.
+        /// </summary>
+        /// <param name="indexFile">The path to the index file that is being created. The run file is created next to it.</param>
+        /// <param name="runFiles">The run files that have been written so far. The new file is added to this list.</param>
+        /// <param name="termPostings">The postings that have been collected.</param>
+        private static void FlushRun(string indexFile, List<string> runFiles, Dictionary<string, List<TextIndexPosting>> termPostings)
+        {
+            List<KeyValuePair<byte[], List<TextIndexPosting>>> terms = new List<KeyValuePair<byte[], List<TextIndexPosting>>>(termPostings.Count);
+
+            foreach (KeyValuePair<string, List<TextIndexPosting>> kvp in termPostings)
+            {
+                kvp.Value.Sort(TextIndexPosting.Compare);
+                terms.Add(new KeyValuePair<byte[], List<TextIndexPosting>>(Encoding.UTF8.GetBytes(kvp.Key), kvp.Value));
+            }
+
+            terms.Sort((a, b) => CompareBytes(a.Key, a.Key.Length, b.Key));
+
+            string runFile = indexFile + "." + runFiles.Count.ToString(System.Globalization.CultureInfo.InvariantCulture) + ".run";
+            runFiles.Add(runFile);
+
+            using (FileStream stream = new FileStream(runFile, FileMode.Create, FileAccess.Write, FileShare.None, 65536))
+            using (BinaryWriter writer = new BinaryWriter(stream))
+            {
+                for (int i = 0; i < terms.Count; i++)
+                {
+                    writer.Write(terms[i].Key.Length);
+                    writer.Write(terms[i].Key);
+                    writer.Write(terms[i].Value.Count);
+
+                    foreach (TextIndexPosting posting in terms[i].Value)
+                    {
+                        WritePosting(writer, posting);
+                    }
+                }
+            }
+
+            termPostings.Clear();
+        }
+
+        /// <summary>
+        /// Determines which documents of this index are still present in a new index, and marks them as already indexed.
+        /// </summary>
+        /// <param name="hashIndices">The content hashes of the documents in the new index, and their new indices.</param>
+        /// <param name="pageCounts">The page counts of the documents in the new index.</param>
+        /// <param name="indexed">Whether each document in the new index has already been indexed.</param>
+        /// <returns>For each document in this index, its index in the new index, or -1 if it is not present in the new index.</returns>
+        private int[] MapDocuments(Dictionary<string, int> hashIndices, int[] pageCounts, bool[] indexed)
+        {
+            int[] documentMap = new int[Documents.Count];
+
+            for (int i = 0; i < Documents.Count; i++)
+            {
+                if (hashIndices.TryGetValue(Documents[i].ContentHash, out int newIndex) && !indexed[newIndex])
+                {
+                    documentMap[i] = newIndex;
+                    pageCounts[newIndex] = Documents[i].PageCount;
+                    indexed[newIndex] = true;
+                }
+                else
+                {
+                    documentMap[i] = -1;
+                }
+            }
+
+            return documentMap;
+        }
+
+        /// <summary>
+        /// Extracts the text from a document and adds its terms to the postings, incrementing <paramref name="postingCount"/> by the number of postings added.
+        /// </summary>
+        /// <returns>The number of pages in the document.</returns>
+        private static int IndexDocument(MuPDFContext context, string fileName, int documentIndex, bool includeAnnotations, Dictionary<string, List<TextIndexPosting>> termPostings, ref long postingCount)
+        {
+            using (MuPDFDocument document = new MuPDFDocument(context, fileName))
+            {
+                if (document.EncryptionState == EncryptionState.Encrypted)
+                {
+                    return document.Pages.Count;
+                }
+
+                StringBuilder term = new StringBuilder();
+
+                for (int pageNumber = 0; pageNumber < document.Pages.Count; pageNumber++)
+                {
+                    int position = 0;
+
+                    using (MuPDFStructuredTextPage page = document.GetStructuredTextPage(pageNumber, includeAnnotations))
+                    {
+                        for (int i = 0; i < page.Count; i++)
+                        {
+                            if (page[i].Type != MuPDFStructuredTextBlock.Types.Text && page[i].Type != MuPDFStructuredTextBlock.Types.Structure)
+                            {
+                                continue;
+                            }
+
+                            for (int j = 0; j < page[i].Count; j++)
+                            {
+                                MuPDFStructuredTextLine line = page[i][j];
+                                int start = -1;
+
+                                for (int k = 0; k <= line.Count; k++)
+                                {
+                                    string character = k < line.Count ? line[k].Character : null;
+
+                                    if (!string.IsNullOrEmpty(character) && char.IsLetterOrDigit(character, 0))
+                                    {
+                                        if (start < 0)
+                                        {
+                                            start = k;
+                                        }
+
+                                        term.Append(character.ToLowerInvariant());
+                                    }
+                                    else if (start >= 0)
+                                    {
+                                        string termString = term.ToString();
+
+                                        if (!termPostings.TryGetValue(termString, out List<TextIndexPosting> list))
+                                        {
+                                            list = new List<TextIndexPosting>();
+                                            termPostings[termString] = list;
+                                        }
+
+                                        list.Add(new TextIndexPosting() { Document = documentIndex, Page = pageNumber, Position = position, Block = i, Line = j, StartCharacter = start, EndCharacter = k - 1 });
+                                        postingCount++;
+
+                                        position++;
+                                        start = -1;
+                                        term.Clear();
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+
+                return document.Pages.Count;
+            }
+        }
+
+        /// <summary>
+        /// Writes the index file, merging the postings from all the sources.
+        /// </summary>
+        private static unsafe void WriteIndex(string fileName, List<string> fileNames, List<byte[]> hashes, int[] pageCounts, bool includeAnnotations, List<PostingSource> sources)
+        {
+            byte[][] encodedNames = new byte[fileNames.Count][];
+            long namesLength = 0;
+
+            for (int i = 0; i < fileNames.Count; i++)
+            {
+                encodedNames[i] = Encoding.UTF8.GetBytes(fileNames[i]);
+                namesLength += encodedNames[i].Length;
+            }
+
+            TextIndexHeader header = new TextIndexHeader
+            {
+                Magic = IndexMagic,
+                Version = IndexVersion,
+                DocumentCount = fileNames.Count,
+                Flags = includeAnnotations ? IncludeAnnotationsFlag : 0
+            };
+
+            //The number of terms and postings is only known after the sources have been merged, so the postings are written before the terms, and
+            //the term entries and the term strings are collected in temporary files.
+            header.DocumentsOffset = sizeof(TextIndexHeader);
+            header.PostingsOffset = header.DocumentsOffset + (long)header.DocumentCount * sizeof(TextIndexDocumentEntry);
+
+            string termsFile = fileName + ".terms";
+            string stringsFile = fileName + ".strings";
+
+            try
+            {
+                using (FileStream stream = new FileStream(fileName, FileMode.Create, FileAccess.Write, FileShare.None, 65536))
+                using (BinaryWriter writer = new BinaryWriter(stream))
+                {
+                    WriteHeader(writer, header);
+
+                    long stringOffset = 0;
+
+                    for (int i = 0; i < fileNames.Count; i++)
+                    {
+                        writer.Write(hashes[i]);
+                        writer.Write(pageCounts[i]);
+                        writer.Write(encodedNames[i].Length);
+                        writer.Write(stringOffset);
+                        stringOffset += encodedNames[i].Length;
+                    }
+
+                    using (FileStream termsStream = new FileStream(termsFile, FileMode.Create, FileAccess.ReadWrite, FileShare.None, 65536))
+                    using (FileStream stringsStream = new FileStream(stringsFile, FileMode.Create, FileAccess.ReadWrite, FileShare.None, 65536))
+                    {
+                        using (BinaryWriter termsWriter = new BinaryWriter(termsStream, Encoding.UTF8, true))
+                        using (BinaryWriter stringsWriter = new BinaryWriter(stringsStream, Encoding.UTF8, true))
+                        {
+                            int termCount = 0;
+                            long postingCount = 0;
+
+                            List<PostingSource> termSources = new List<PostingSource>(sources.Count);
+                            TextIndexPosting[] heads = new TextIndexPosting[sources.Count];
+
+                            for (int i = 0; i < sources.Count; i++)
+                            {
+                                sources[i].NextTerm();
+                            }
+
+                            while (true)
+                            {
+                                //Find the smallest term among the sources, and the sources that contain it.
+                                byte[] term = null;
+                                termSources.Clear();
+
+                                for (int i = 0; i < sources.Count; i++)
+                                {
+                                    if (sources[i].Term != null)
+                                    {
+                                        int comparison = term == null ? -1 : CompareBytes(sources[i].Term, sources[i].Term.Length, term);
+
+                                        if (comparison < 0)
+                                        {
+                                            term = sources[i].Term;
+                                            termSources.Clear();
+                                        }
+
+                                        if (comparison <= 0)
+                                        {
+                                            termSources.Add(sources[i]);
+                                        }
+                                    }
+                                }
+
+                                if (term == null)
+                                {
+                                    break;
+                                }
+
+                                //Merge the postings for this term, which are sorted within each source.
+                                int activeCount = 0;
+
+                                for (int i = 0; i < termSources.Count; i++)
+                                {
+                                    if (termSources[i].ReadPosting(out heads[activeCount]))
+                                    {
+                                        termSources[activeCount] = termSources[i];
+                                        activeCount++;
+                                    }
+                                }
+
+                                long firstPosting = postingCount;
+
+                                while (activeCount > 0)
+                                {
+                                    int min = 0;
+
+                                    for (int i = 1; i < activeCount; i++)
+                                    {
+                                        if (TextIndexPosting.Compare(heads[i], heads[min]) < 0)
+                                        {
+                                            min = i;
+                                        }
+                                    }
+
+                                    WritePosting(writer, heads[min]);
+                                    postingCount++;
+
+                                    if (!termSources[min].ReadPosting(out heads[min]))
+                                    {
+                                        activeCount--;
+                                        termSources[min] = termSources[activeCount];
+                                        heads[min] = heads[activeCount];
+                                    }
+                                }
+
+                                termsWriter.Write(namesLength + stringsStream.Position);
+                                termsWriter.Write(term.Length);
+                                termsWriter.Write(checked((int)(postingCount - firstPosting)));
+                                termsWriter.Write(firstPosting);
+                                stringsWriter.Write(term);
+                                termCount++;
+
+                                for (int i = 0; i < sources.Count; i++)
+                                {
+                                    if (sources[i].Term != null && CompareBytes(sources[i].Term, sources[i].Term.Length, term) == 0)
+                                    {
+                                        sources[i].NextTerm();
+                                    }
+                                }
+                            }
+
+                            header.TermCount = termCount;
+                            header.PostingCount = postingCount;
+                        }
+
+                        writer.Flush();
+
+                        //Keep the term entries aligned, as the postings are 28 bytes long.
+                        while (stream.Position % 8 != 0)
+                        {
+                            stream.WriteByte(0);
+                        }
+
+                        header.TermsOffset = stream.Position;
+                        termsStream.Seek(0, SeekOrigin.Begin);
+                        termsStream.CopyTo(stream);
+
+                        header.StringsOffset = stream.Position;
+
+                        for (int i = 0; i < encodedNames.Length; i++)
+                        {
+                            writer.Write(encodedNames[i]);
+                        }
+
+                        writer.Flush();
+
+                        stringsStream.Seek(0, SeekOrigin.Begin);
+                        stringsStream.CopyTo(stream);
+                    }
+
+                    stream.Seek(0, SeekOrigin.Begin);
+                    WriteHeader(writer, header);
+                }
+            }
+            finally
+            {
+                DeleteTemporaryFile(termsFile);
+                DeleteTemporaryFile(stringsFile);
+            }
+        }
+
+        /// <summary>
+        /// Writes the header of the index file.
+        /// </summary>
+        private static void WriteHeader(BinaryWriter writer, TextIndexHeader header)
+        {
+            writer.Write(header.Magic);
+            writer.Write(header.Version);
+            writer.Write(header.DocumentCount);
+            writer.Write(header.TermCount);
+            writer.Write(header.DocumentsOffset);
+            writer.Write(header.TermsOffset);
+            writer.Write(header.PostingsOffset);
+            writer.Write(header.StringsOffset);
+            writer.Write(header.PostingCount);
+            writer.Write(header.Flags);
+            writer.Write(header.Reserved);
+        }
+
+        /// <summary>
+        /// Writes a posting to an index or run file.
+        /// </summary>
+        private static void WritePosting(BinaryWriter writer, TextIndexPosting posting)
+        {
+            writer.Write(posting.Document);
+            writer.Write(posting.Page);
+            writer.Write(posting.Position);
+            writer.Write(posting.Block);
+            writer.Write(posting.Line);
+            writer.Write(posting.StartCharacter);
+            writer.Write(posting.EndCharacter);
+        }
+
+        /// <summary>
+        /// Deletes a temporary file, if it exists.
+        /// </summary>
+        private static void DeleteTemporaryFile(string fileName)
+        {
+            try
+            {
+                if (File.Exists(fileName))
+                {
+                    File.Delete(fileName);
+                }
+            }
+            catch (IOException)
+            {
+                //The file is left behind, and will be overwritten the next time the index is created.
+            }
+            catch (UnauthorizedAccessException)
+            {
+                //As above.
+            }
+        }
+
+        /// <summary>
+        /// A sequence of terms, sorted by their UTF-8 bytes, each with a sequence of sorted postings.
+        /// </summary>
+        private abstract class PostingSource : IDisposable
+        {
+            /// <summary>
+            /// The UTF-8 bytes of the current term, or <see langword="null"/> if all the terms have been read.
+            /// </summary>
+            public byte[] Term { get; protected set; }
+
+            /// <summary>
+            /// Moves to the next term, skipping any postings of the current term that have not been read.
+            /// </summary>
+            public abstract void NextTerm();
+
+            /// <summary>
+            /// Reads the next posting of the current term.
+            /// </summary>
+            /// <returns><see langword="true"/> if a posting was read, <see langword="false"/> if all the postings of the current term have been read.</returns>
+            public abstract bool ReadPosting(out TextIndexPosting posting);
+
+            /// <inheritdoc/>
+            public virtual void Dispose() { }
+        }
+
+        /// <summary>
+        /// Reads the postings of the documents that are still present directly from an existing index, renumbering the documents.
+        /// </summary>
+        private sealed class IndexPostingSource : PostingSource
+        {
+            private readonly MuPDFTextIndex Index;
+            private readonly int[] DocumentMap;
+            private readonly List<(int Document, long Start, long Count)> Segments = new List<(int Document, long Start, long Count)>();
+
+            private int TermIndex = -1;
+            private int SegmentIndex;
+            private long PostingIndex;
+
+            public IndexPostingSource(MuPDFTextIndex index, int[] documentMap)
+            {
+                this.Index = index;
+                this.DocumentMap = documentMap;
+            }
+
+            public override unsafe void NextTerm()
+            {
+                TextIndexTermEntry* terms = (TextIndexTermEntry*)(Index.Data + Index.Header.TermsOffset);
+                TextIndexPosting* postings = (TextIndexPosting*)(Index.Data + Index.Header.PostingsOffset);
+
+                this.Term = null;
+
+                while (this.Term == null && ++TermIndex < Index.Header.TermCount)
+                {
+                    //The postings of each term are sorted by document, so the postings of each document form a contiguous range. The documents
+                    //may be renumbered in a different order, so the ranges are sorted by the new document index.
+                    Segments.Clear();
+
+                    long first = terms[TermIndex].FirstPosting;
+                    long end = first + terms[TermIndex].PostingCount;
+
+                    for (long start = first; start < end;)
+                    {
+                        int document = postings[start].Document;
+                        long next = start + 1;
+
+                        while (next < end && postings[next].Document == document)
+                        {
+                            next++;
+                        }
+
+                        if (DocumentMap[document] >= 0)
+                        {
+                            Segments.Add((DocumentMap[document], start, next - start));
+                        }
+
+                        start = next;
+                    }
+
+                    if (Segments.Count > 0)
+                    {
+                        Segments.Sort((a, b) => a.Document.CompareTo(b.Document));
+                        SegmentIndex = 0;
+                        PostingIndex = 0;
+
+                        this.Term = new byte[terms[TermIndex].StringLength];
+                        Marshal.Copy((IntPtr)(Index.Data + Index.Header.StringsOffset + terms[TermIndex].StringOffset), this.Term, 0, this.Term.Length);
+                    }
+                }
+            }
+
+            public override unsafe bool ReadPosting(out TextIndexPosting posting)
+            {
+                while (SegmentIndex < Segments.Count && PostingIndex >= Segments[SegmentIndex].Count)
+                {
+                    SegmentIndex++;
+                    PostingIndex = 0;
+                }
+
+                if (SegmentIndex >= Segments.Count)
+                {
+                    posting = default;
+                    return false;
+                }
+
+                TextIndexPosting* postings = (TextIndexPosting*)(Index.Data + Index.Header.PostingsOffset);
+
+                posting = postings[Segments[SegmentIndex].Start + PostingIndex];
+                posting.Document = Segments[SegmentIndex].Document;
+                PostingIndex++;
+
+                return true;
+            }
+        }
+
+        /// <summary>
+        /// Reads the postings from a run file created by <see cref="FlushRun"/>.
+        /// </summary>
+        private sealed class RunPostingSource : PostingSource
+        {
+            private readonly BinaryReader Reader;
+            private int RemainingPostings;
+
+            public RunPostingSource(string fileName)
+            {
+                this.Reader = new BinaryReader(new FileStream(fileName, FileMode.Open, FileAccess.Read, FileShare.Read, 65536));
+            }
+
+            public override void NextTerm()
+            {
+                while (RemainingPostings > 0)
+                {
+                    ReadPosting(out _);
+                }
+
+                if (Reader.BaseStream.Position < Reader.BaseStream.Length)
+                {
+                    int length = Reader.ReadInt32();
+                    this.Term = Reader.ReadBytes(length);
+                    RemainingPostings = Reader.ReadInt32();
+                }
+                else
+                {
+                    this.Term = null;
+                }
+            }
+
+            public override bool ReadPosting(out TextIndexPosting posting)
+            {
+                if (RemainingPostings == 0)
+                {
+                    posting = default;
+                    return false;
+                }
+
+                posting = new TextIndexPosting()
+                {
+                    Document = Reader.ReadInt32(),
+                    Page = Reader.ReadInt32(),
+                    Position = Reader.ReadInt32(),
+                    Block = Reader.ReadInt32(),
+                    Line = Reader.ReadInt32(),
+                    StartCharacter = Reader.ReadInt32(),
+                    EndCharacter = Reader.ReadInt32()
+                };
+
+                RemainingPostings--;
+                return true;
+            }
+
+            public override void Dispose()
+            {
+                Reader.Dispose();
+            }
+        }
+
+        /// <summary>
+        /// Splits a string into terms, in the same way as the text of the documents.
+        /// </summary>
+        internal static List<string> Tokenize(string text)
+        {
+            List<string> tbr = new List<string>();
+            StringBuilder term = new StringBuilder();
+
+            for (int i = 0; i < text.Length; i += char.IsSurrogatePair(text, i) ? 2 : 1)
+            {
+                if (char.IsLetterOrDigit(text, i))
+                {
+                    term.Append(text.Substring(i, char.IsSurrogatePair(text, i) ? 2 : 1).ToLowerInvariant());
+                }
+                else if (term.Length > 0)
+                {
+                    tbr.Add(term.ToString());
+                    term.Clear();
+                }
+            }
+
+            if (term.Length > 0)
+            {
+                tbr.Add(term.ToString());
+            }
+
+            return tbr;
+        }
+
+        /// <summary>
+        /// Finds the entry for a term using a binary search.
+        /// </summary>
+        /// <returns>A pointer to the term entry, or <see langword="null"/> if the term is not in the index.</returns>
+        private unsafe TextIndexTermEntry* FindTerm(byte[] term)
+        {
+            TextIndexTermEntry* terms = (TextIndexTermEntry*)(this.Data + Header.TermsOffset);
+            byte* strings = this.Data + Header.StringsOffset;
+
+            int min = 0;
+            int max = Header.TermCount - 1;
+
+            fixed (byte* termPointer = term)
+            {
+                while (min <= max)
+                {
+                    int mid = min + (max - min) / 2;
+
+                    int comparison = CompareBytes(strings + terms[mid].StringOffset, terms[mid].StringLength, termPointer, term.Length);
+
+                    if (comparison == 0)
+                    {
+                        return terms + mid;
+                    }
+                    else if (comparison < 0)
+                    {
+                        min = mid + 1;
+                    }
+                    else
+                    {
+                        max = mid - 1;
+                    }
+                }
+            }
+
+            return null;
+        }
+
+        /// <summary>
+        /// Finds a posting with the same document, page and position as the <paramref name="target"/> using a binary search.
+        /// </summary>
+        /// <returns>A pointer to the posting, or <see langword="null"/> if the posting is not present.</returns>
+        private static unsafe TextIndexPosting* FindPosting(TextIndexPosting* postings, int count, TextIndexPosting target)
+        {
+            int min = 0;
+            int max = count - 1;
+
+            while (min <= max)
+            {
+                int mid = min + (max - min) / 2;
+
+                int comparison = TextIndexPosting.Compare(postings[mid], target);
+
+                if (comparison == 0)
+                {
+                    return postings + mid;
+                }
+                else if (comparison < 0)
+                {
+                    min = mid + 1;
+                }
+                else
+                {
+                    max = mid - 1;
+                }
+            }
+
+            return null;
+        }
+
+        /// <summary>
+        /// Checks that a range of <paramref name="count"/> elements of <paramref name="elementSize"/> bytes starting at <paramref name="offset"/> lies
+        /// between <paramref name="minimum"/> and <paramref name="limit"/>, without overflowing.
+        /// </summary>
+        private static bool IsValidRange(long offset, long count, long elementSize, long minimum, long limit)
+        {
+            return offset >= minimum && count >= 0 && offset <= limit && count <= (limit - offset) / elementSize;
+        }
+
+        /// <summary>
+        /// Compares two byte sequences lexicographically.
+        /// </summary>
+        private static unsafe int CompareBytes(byte[] a, int aLength, byte[] b)
+        {
+            fixed (byte* aPointer = a)
+            fixed (byte* bPointer = b)
+            {
+                return CompareBytes(aPointer, aLength, bPointer, b.Length);
+            }
+        }
+
+        /// <summary>
+        /// Compares two byte sequences lexicographically.
+        /// </summary>
+        private static unsafe int CompareBytes(byte* a, int aLength, byte* b, int bLength)
+        {
+            int length = Math.Min(aLength, bLength);
+
+            for (int i = 0; i < length; i++)
+            {
+                if (a[i] != b[i])
+                {
+                    return a[i].CompareTo(b[i]);
+                }
+            }
+
+            return aLength.CompareTo(bLength);
+        }
+
+        /// <summary>
+        /// Converts a hash to a lowercase hexadecimal string.
+        /// </summary>
+        private static string HashToString(byte[] hash)
+        {
+            StringBuilder builder = new StringBuilder(hash.Length * 2);
+
+            for (int i = 0; i < hash.Length; i++)
+            {
+                builder.Append(hash[i].ToString("x2"));
+            }
+
+            return builder.ToString();
+        }
+
+        /// <summary>
+        /// Releases the view of the memory-mapped file.
+        /// </summary>
+        private void ReleaseView()
+        {
+            if (this.PointerAcquired)
+            {
+                this.Accessor.SafeMemoryMappedViewHandle.ReleasePointer();
+                this.PointerAcquired = false;
+            }
+
+            this.Accessor?.Dispose();
+
+            this.MappedFile?.Dispose();
+        }
+
+        private bool disposedValue;
+
+        ///<inheritdoc/>
+        protected virtual void Dispose(bool disposing)
+        {
+            if (!disposedValue)
+            {
+                disposedValue = true;
+
+                if (disposing)
+                {
+                    ReleaseView();
+                }
+            }
+        }
+
+        ///<inheritdoc/>
+        public void Dispose()
+        {
+            Dispose(disposing: true);
+            GC.SuppressFinalize(this);
+        }
+    }
+}
@@ -0,0 +1,190 @@
+﻿/*
+    MuPDFCore - A set of multiplatform .NET Core bindings for MuPDF.
+    Copyright (C) 2024  Giorgio Bianchini
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU Affero General Public License as
+    published by the Free Software Foundation, version 3.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Affero General Public License for more details.
+
+    You should have received a copy of the GNU Affero General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>
+*/
+
+
+using System;
+using System.Runtime.InteropServices;
+
+namespace MuPDFCore.StructuredText
+{
+    /// <summary>
+    /// Options for the native text search.
+    /// </summary>
+    [Flags]
+    internal enum SearchOptions
+    {
+        /// <summary>
+        /// Case-insensitive search (the default behaviour of MuPDF).
+        /// </summary>
+        None = 0,
+
+        /// <summary>
+        /// Only keep the hits whose characters match the needle exactly.
+        /// </summary>
+        CaseSensitive = 1
+    }
+
+    /// <summary>
+    /// A search hit, as stored in the buffer produced by <see cref="NativeMethods.SearchStructuredTextPage"/>. This must match the <c>stext_search_hit</c> struct in the native wrapper.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential)]
+    internal struct StructuredTextSearchHit
+    {
+        /// <summary>
+        /// The index of the first quad of the hit.
+        /// </summary>
+        public int FirstQuad;
+
+        /// <summary>
+        /// The number of quads of the hit.
+        /// </summary>
+        public int QuadCount;
+
+        /// <summary>
+        /// The block index of the first character of the hit (or -1).
+        /// </summary>
+        public int StartBlock;
+
+        /// <summary>
+        /// The line index of the first character of the hit (or -1).
+        /// </summary>
+        public int StartLine;
+
+        /// <summary>
+        /// The character index of the first character of the hit (or -1).
+        /// </summary>
+        public int StartCharacter;
+
+        /// <summary>
+        /// The block index of the last character of the hit (or -1).
+        /// </summary>
+        public int EndBlock;
+
+        /// <summary>
+        /// The line index of the last character of the hit (or -1).
+        /// </summary>
+        public int EndLine;
+
+        /// <summary>
+        /// The character index of the last character of the hit (or -1).
+        /// </summary>
+        public int EndCharacter;
+    }
+
+    /// <summary>
+    /// An occurrence of a string found by the native text search.
+    /// </summary>
+    public class MuPDFTextSearchHit
+    {
+        /// <summary>
+        /// The number of the page containing the hit (starting at 0), or -1 if the search was performed on a <see cref="MuPDFStructuredTextPage"/>.
+        /// </summary>
+        public int PageNumber { get; }
+
+        /// <summary>
+        /// The characters of the hit, as addresses in the <see cref="MuPDFStructuredTextPage"/> that would be obtained for the same page using <see cref="StructuredTextFlags.None"/>
+        /// (or in the page that was searched). This is <see langword="null"/> if the hit could not be mapped to the characters of the page.
+        /// </summary>
+        public MuPDFStructuredTextAddressSpan Span { get; }
+
+        /// <summary>
+        /// The quads (in page units) covering the hit. There is usually one quad for each line that the hit spans.
+        /// </summary>
+        public Quad[] Quads { get; }
+
+        private MuPDFTextSearchHit(int pageNumber, MuPDFStructuredTextAddressSpan span, Quad[] quads)
+        {
+            this.PageNumber = pageNumber;
+            this.Span = span;
+            this.Quads = quads;
+        }
+
+        /// <summary>
+        /// Read the hits from a buffer produced by the native search, and free the buffer.
+        /// </summary>
+        /// <param name="context">The context that was used to perform the search.</param>
+        /// <param name="data">The buffer produced by the native search.</param>
+        /// <param name="hitCount">The number of hits in the buffer.</param>
+        /// <param name="quadCount">The number of quads in the buffer.</param>
+        /// <param name="pageNumber">The number of the page that was searched, or -1.</param>
+        /// <returns>The hits contained in the buffer.</returns>
+        internal static unsafe MuPDFTextSearchHit[] ReadHits(MuPDFContext context, IntPtr data, int hitCount, int quadCount, int pageNumber)
+        {
+            if (data == IntPtr.Zero)
+            {
+                return new MuPDFTextSearchHit[0];
+            }
+
+            try
+            {
+                StructuredTextSearchHit* hits = (StructuredTextSearchHit*)data;
+                float* quads = (float*)(hits + hitCount);
+
+                MuPDFTextSearchHit[] tbr = new MuPDFTextSearchHit[hitCount];
+
+                for (int i = 0; i < hitCount; i++)
+                {
+                    StructuredTextSearchHit hit = hits[i];
+
+                    Quad[] hitQuads = new Quad[hit.QuadCount];
+
+                    for (int j = 0; j < hit.QuadCount; j++)
+                    {
+                        float* q = quads + (hit.FirstQuad + j) * 8;
+                        hitQuads[j] = new Quad(new PointF(q[0], q[1]), new PointF(q[2], q[3]), new PointF(q[4], q[5]), new PointF(q[6], q[7]));
+                    }
+
+                    MuPDFStructuredTextAddressSpan span = null;
+
+                    if (hit.StartBlock >= 0 && hit.EndBlock >= 0)
+                    {
+                        span = new MuPDFStructuredTextAddressSpan(new MuPDFStructuredTextAddress(hit.StartBlock, hit.StartLine, hit.StartCharacter), new MuPDFStructuredTextAddress(hit.EndBlock, hit.EndLine, hit.EndCharacter));
+                    }
+
+                    tbr[i] = new MuPDFTextSearchHit(pageNumber, span, hitQuads);
+                }
+
+                return tbr;
+            }
+            finally
+            {
+                NativeMethods.DisposeSearchHits(context.NativeContext, data);
+            }
+        }
+
+        /// <summary>
+        /// Check the exit code returned by the native search.
+        /// </summary>
+        /// <param name="result">The exit code returned by the native search.</param>
+        internal static void CheckResult(ExitCodes result)
+        {
+            switch (result)
+            {
+                case ExitCodes.EXIT_SUCCESS:
+                    break;
+                case ExitCodes.ERR_CANNOT_CREATE_PAGE:
+                    throw new MuPDFException("Cannot create page", result);
+                case ExitCodes.ERR_CANNOT_POPULATE_PAGE:
+                    throw new MuPDFException("Cannot populate page", result);
+                case ExitCodes.ERR_CANNOT_CREATE_BUFFER:
+                    throw new MuPDFException("Cannot create the output buffer", result);
+                default:
+                    throw new MuPDFException("Unknown error", result);
+            }
+        }
+    }
+}
@@ -18,7 +18,6 @@
 using System;
 using System.Collections;
 using System.Collections.Generic;
-using System.Runtime.InteropServices;
 using System.Text;
 
 namespace MuPDFCore.StructuredText
@@ -44,58 +43,9 @@ namespace MuPDFCore.StructuredText
         /// <inheritdoc/>
         public override MuPDFStructuredTextLine this[int index] => ((IReadOnlyList<MuPDFStructuredTextLine>)Lines)[index];
 
-        internal MuPDFTextStructuredTextBlock(MuPDFContext context, MuPDFStructuredTextPage parentPage, Rectangle boundingBox, IntPtr blockPointer, int lineCount) : base(boundingBox, parentPage)
+        internal MuPDFTextStructuredTextBlock(MuPDFStructuredTextPage parentPage, Rectangle boundingBox, MuPDFStructuredTextPageData pageData, int blockIndex) : base(boundingBox, parentPage)
         {
-            IntPtr[] linePointers = new IntPtr[lineCount];
-            GCHandle linesHandle = GCHandle.Alloc(linePointers, GCHandleType.Pinned);
-
-            try
-            {
-                ExitCodes result = (ExitCodes)NativeMethods.GetStructuredTextLines(blockPointer, linesHandle.AddrOfPinnedObject());
-
-                switch (result)
-                {
-                    case ExitCodes.EXIT_SUCCESS:
-                        break;
-                    default:
-                        throw new MuPDFException("Unknown error", result);
-                }
-
-                Lines = new MuPDFStructuredTextLine[lineCount];
-
-                for (int i = 0; i < lineCount; i++)
-                {
-                    int wmode = -1;
-                    float x0 = -1;
-                    float y0 = -1;
-                    float x1 = -1;
-                    float y1 = -1;
-
-                    float x = -1;
-                    float y = -1;
-
-                    int charCount = -1;
-
-                    result = (ExitCodes)NativeMethods.GetStructuredTextLine(linePointers[i], ref wmode, ref x0, ref y0, ref x1, ref y1, ref x, ref y, ref charCount);
-
-                    switch (result)
-                    {
-                        case ExitCodes.EXIT_SUCCESS:
-                            break;
-                        default:
-                            throw new MuPDFException("Unknown error", result);
-                    }
-
-                    Rectangle bBox = new Rectangle(x0, y0, x1, y1);
-                    PointF direction = new PointF(x, y);
-
-                    Lines[i] = new MuPDFStructuredTextLine(context, this, linePointers[i], (MuPDFStructuredTextLine.WritingModes)wmode, direction, bBox, charCount);
-                }
-            }
-            finally
-            {
-                linesHandle.Free();
-            }
+            Lines = pageData.CreateLines(this, blockIndex);
         }
 
         /// <inheritdoc/>
@@ -223,75 +173,15 @@ namespace MuPDFCore.StructuredText
             };
         }
 
-        internal MuPDFStructuredTextLine(MuPDFContext context, MuPDFStructuredTextBlock parentBlock, IntPtr linePointer, WritingModes writingMode, PointF direction, Rectangle boundingBox, int charCount)
+        internal MuPDFStructuredTextLine(MuPDFStructuredTextPageData pageData, int lineIndex, MuPDFStructuredTextBlock parentBlock, WritingModes writingMode, PointF direction, Rectangle boundingBox)
         {
             this.WritingMode = writingMode;
             this.Direction = direction;
             this.BoundingBox = boundingBox;
             this.ParentBlock = parentBlock;
 
-            IntPtr[] charPointers = new IntPtr[charCount];
-            GCHandle charsHandle = GCHandle.Alloc(charPointers, GCHandleType.Pinned);
-
-            try
-            {
-                ExitCodes result = (ExitCodes)NativeMethods.GetStructuredTextChars(linePointer, charsHandle.AddrOfPinnedObject());
-
-                switch (result)
-                {
-                    case ExitCodes.EXIT_SUCCESS:
-                        break;
-                    default:
-                        throw new MuPDFException("Unknown error", result);
-                }
-
-                Characters = new MuPDFStructuredTextCharacter[charCount];
-
-                StringBuilder textBuilder = new StringBuilder(charCount);
-
-                for (int i = 0; i < charCount; i++)
-                {
-                    int c = -1;
-                    uint color = 0;
-                    float originX = -1;
-                    float originY = -1;
-                    float size = -1;
-                    float llX = -1;
-                    float llY = -1;
-                    float ulX = -1;
-                    float ulY = -1;
-                    float urX = -1;
-                    float urY = -1;
-                    float lrX = -1;
-                    float lrY = -1;
-                    int bidi = -1;
-                    IntPtr font = IntPtr.Zero;
-
-                    result = (ExitCodes)NativeMethods.GetStructuredTextChar(context.NativeContext, charPointers[i], ref c, ref color, ref originX, ref originY, ref size, ref llX, ref llY, ref ulX, ref ulY, ref urX, ref urY, ref lrX, ref lrY, ref bidi, ref font);
-
-                    switch (result)
-                    {
-                        case ExitCodes.EXIT_SUCCESS:
-                            break;
-                        default:
-                            throw new MuPDFException("Unknown error", result);
-                    }
-
-                    Quad quad = new Quad(new PointF(llX, llY), new PointF(ulX, ulY), new PointF(urX, urY), new PointF(lrX, lrY));
-                    PointF origin = new PointF(originX, originY);
-
-                    MuPDFFont muPDFFont = context.Resolve(font);
-
-                    Characters[i] = new MuPDFStructuredTextCharacter(this, c, color, origin, quad, size, bidi % 2 == 0 ? MuPDFStructuredTextCharacter.TextDirection.LeftToRight : MuPDFStructuredTextCharacter.TextDirection.RightToLeft, muPDFFont);
-                    textBuilder.Append(Characters[i].Character);
-                }
-
-                this.Text = textBuilder.ToString();
-            }
-            finally
-            {
-                charsHandle.Free();
-            }
+            this.Characters = pageData.CreateCharacters(this, lineIndex, out string text);
+            this.Text = text;
         }
 
         /// <summary>
@@ -25,167 +25,84 @@ namespace MuPDFCore
     internal static class Utils
     {
         /// <summary>
-        /// The factors by which we can divide a rectangle/size.
+        /// Computes the smallest factor of a number that is greater than 1.
         /// </summary>
-        public static readonly int[] AcceptableDivisors = new[] { 2, 3, 5, 7 };
-
-        /// <summary>
-        /// Computes the biggest number smaller than or equal to the specified value that is factorisable using only the <see cref="AcceptableDivisors"/>.
-        /// </summary>
-        /// <param name="n">The maximum number.</param>
-        /// <returns>A number that is &lt;= <paramref name="n"/> and is factorisable using only the <see cref="AcceptableDivisors"/>.</returns>
-        public static int GetAcceptableNumber(int n)
+        /// <param name="n">The number to analyse. This must be strictly higher than 0.</param>
+        /// <returns>The smallest factor of <paramref name="n"/> that is greater than 1, or <paramref name="n"/> itself if it is prime (or 1).</returns>
+        public static int GetSmallestFactor(int n)
         {
-            for (int i = n; i >= 1; i--)
+            if (n <= 0)
             {
-                if (IsAcceptableNumber(i))
-                {
-                    return i;
-                }
+                throw new ArgumentOutOfRangeException(nameof(n), n, "The number must be strictly higher than 0!");
             }
 
-            throw new ArgumentOutOfRangeException(nameof(n), n, "The number must be strictly higher than 0!");
-        }
-
-        /// <summary>
-        /// Determine whether a number is factorisable using only the <see cref="AcceptableDivisors"/>.
-        /// </summary>
-        /// <param name="n">The number to analyse.</param>
-        /// <returns>A boolean value indicating whether the number is factorisable using only the <see cref="AcceptableDivisors"/>.</returns>
-        public static bool IsAcceptableNumber(int n)
-        {
-            if (n == 0)
+            if (n % 2 == 0)
             {
-                return false;
+                return 2;
             }
-            else if (n == 1)
-            {
-                return true;
-            }
-            else
+
+            for (int i = 3; i <= n / i; i += 2)
             {
-                for (int i = 0; i < AcceptableDivisors.Length; i++)
+                if (n % i == 0)
                 {
-                    bool divided = false;
-
-                    while (n % AcceptableDivisors[i] == 0)
-                    {
-                        n /= AcceptableDivisors[i];
-                        divided = true;
-                    }
-
-                    if (divided)
-                    {
-                        return IsAcceptableNumber(n);
-                    }
+                    return i;
                 }
-
-                return false;
             }
+
+            return n;
         }
 
         /// <summary>
-        /// Clear all pixels outside of a specified region.
+        /// Determine the post-processing steps that the native rendering code should perform after rendering a region of a display list.
         /// </summary>
-        /// <param name="image">A pointer to the address where the pixel data is stored.</param>
-        /// <param name="imageSize">The size in pixels of the image.</param>
-        /// <param name="imageArea">The area represented by the image.</param>
-        /// <param name="clipArea">The region outside which all pixels will be cleared, in image units.</param>
-        /// <param name="pixelFormat">The format of the pixel data.</param>
-        public static void ClipImage(IntPtr image, RoundedSize imageSize, Rectangle imageArea, Rectangle clipArea, PixelFormats pixelFormat)
+        /// <param name="region">The region being rendered.</param>
+        /// <param name="displayList">The display list being rendered. Its bounds are only computed if they are needed.</param>
+        /// <param name="nativeContext">The native context that should be used to compute the bounds of the display list, if necessary.</param>
+        /// <param name="pageBounds">The bounds of the page being rendered.</param>
+        /// <param name="clipToPageBounds">Whether the rendered image should be clipped to the bounds of the page.</param>
+        /// <param name="premultipliedAlpha">Whether images with an alpha channel should be left with premultiplied colour values.</param>
+        /// <returns>The <see cref="RenderFlags"/> that should be passed to the native rendering code.</returns>
+        public static RenderFlags GetRenderFlags(Rectangle region, MuPDFDisplayList displayList, IntPtr nativeContext, Rectangle pageBounds, bool clipToPageBounds, bool premultipliedAlpha)
         {
-            int clipLeft = Math.Max(0, (int)Math.Ceiling((clipArea.X0 - imageArea.X0) / imageArea.Width * imageSize.Width - 0.001));
-            int clipRight = Math.Max(0, (int)Math.Floor(imageSize.Width - (imageArea.X1 - clipArea.X1) / imageArea.Width * imageSize.Width + 0.001));
-
-            int clipTop = Math.Max(0, (int)Math.Ceiling((clipArea.Y0 - imageArea.Y0) / imageArea.Height * imageSize.Height - 0.001));
-            int clipBottom = Math.Max(0, (int)Math.Floor(imageSize.Height - (imageArea.Y1 - clipArea.Y1) / imageArea.Height * imageSize.Height + 0.001));
+            RenderFlags flags = RenderFlags.None;
 
-            int pixelSize = -1;
-            byte clearValue = 0;
-
-            switch (pixelFormat)
+            if (!premultipliedAlpha)
             {
-                case PixelFormats.RGB:
-                case PixelFormats.BGR:
-                    pixelSize = 3;
-                    clearValue = 255;
-                    break;
-                case PixelFormats.RGBA:
-                case PixelFormats.BGRA:
-                    pixelSize = 4;
-                    clearValue = 0;
-                    break;
+                flags |= RenderFlags.Unpremultiply;
             }
 
-            int stride = imageSize.Width * pixelSize;
-
-            if (clipLeft > 0 || clipRight < imageSize.Width || clipTop > 0 || clipBottom < imageSize.Height)
+            if (clipToPageBounds && !pageBounds.Contains(displayList.GetBounds(nativeContext).Intersect(region)))
             {
-                unsafe
-                {
-                    byte* imageData = (byte*)image;
-
-                    for (int y = 0; y < imageSize.Height; y++)
-                    {
-                        if (y < clipTop || y >= clipBottom)
-                        {
-                            for (int x = 0; x < imageSize.Width; x++)
-                            {
-                                for (int i = 0; i < pixelSize; i++)
-                                {
-                                    imageData[y * stride + x * pixelSize + i] = clearValue;
-                                }
-                            }
-                        }
-                        else
-                        {
-                            for (int x = 0; x < Math.Min(clipLeft, imageSize.Width); x++)
-                            {
-                                for (int i = 0; i < pixelSize; i++)
-                                {
-                                    imageData[y * stride + x * pixelSize + i] = clearValue;
-                                }
-                            }
-
-                            for (int x = Math.Max(0, clipRight); x < imageSize.Width; x++)
-                            {
-                                for (int i = 0; i < pixelSize; i++)
-                                {
-                                    imageData[y * stride + x * pixelSize + i] = clearValue;
-                                }
-                            }
-                        }
-                    }
-                }
+                flags |= RenderFlags.Clip;
             }
+
+            return flags;
         }
 
         /// <summary>
-        /// Converts an image with premultiplied alpha values into an image with unpremultiplied alpha values.
+        /// Determine the post-processing steps that the native rendering code should perform after rendering a region of a page directly, without a display list.
+        /// Since the bounds of the page contents are not known, the image is clipped whenever the region extends beyond the page bounds.
         /// </summary>
-        /// <param name="image">A pointer to the address where the pixel data is stored.</param>
-        /// <param name="imageSize">The size in pixels of the image.</param>
-        public static void UnpremultiplyAlpha(IntPtr image, RoundedSize imageSize)
+        /// <param name="region">The region being rendered.</param>
+        /// <param name="pageBounds">The bounds of the page being rendered.</param>
+        /// <param name="clipToPageBounds">Whether the rendered image should be clipped to the bounds of the page.</param>
+        /// <param name="premultipliedAlpha">Whether images with an alpha channel should be left with premultiplied colour values.</param>
+        /// <returns>The <see cref="RenderFlags"/> that should be passed to the native rendering code.</returns>
+        public static RenderFlags GetRenderFlags(Rectangle region, Rectangle pageBounds, bool clipToPageBounds, bool premultipliedAlpha)
         {
-            int stride = imageSize.Width * 4;
+            RenderFlags flags = RenderFlags.None;
 
-            unsafe
+            if (!premultipliedAlpha)
             {
-                byte* imageData = (byte*)image;
+                flags |= RenderFlags.Unpremultiply;
+            }
 
-                for (int y = 0; y < imageSize.Height; y++)
-                {
-                    for (int x = 0; x < imageSize.Width; x++)
-                    {
-                        if (imageData[y * stride + x * 4 + 3] > 0)
-                        {
-                            imageData[y * stride + x * 4] = (byte)(imageData[y * stride + x * 4] * 255 / imageData[y * stride + x * 4 + 3]);
-                            imageData[y * stride + x * 4 + 1] = (byte)(imageData[y * stride + x * 4 + 1] * 255 / imageData[y * stride + x * 4 + 3]);
-                            imageData[y * stride + x * 4 + 2] = (byte)(imageData[y * stride + x * 4 + 2] * 255 / imageData[y * stride + x * 4 + 3]);
-                        }
-                    }
-                }
+            if (clipToPageBounds && !pageBounds.Contains(region))
+            {
+                flags |= RenderFlags.Clip;
             }
+
+            return flags;
         }
     }
 }
@@ -0,0 +1,84 @@
+﻿using MuPDFCore;
+using System;
+using System.IO;
+
+namespace MuPDFCoreBenchmarks
+{
+    /// <summary>
+    /// Compares the time needed to open each document in the test corpus normally and using an accelerator file created by a previous open.
+    /// </summary>
+    static class AcceleratorBenchmark
+    {
+        /// <summary>
+        /// Arguments: none
+        /// </summary>
+        public static void Run(string[] args)
+        {
+            string cacheDirectory = Path.Combine(Path.GetTempPath(), "MuPDFCoreBenchmarks-" + Guid.NewGuid().ToString("N"));
+
+            Console.WriteLine("{0,-30} {1,6} {2,12} {3,16} {4,10}", "File", "Pages", "Normal (ms)", "Accelerated (ms)", "Speedup");
+
+            try
+            {
+                foreach (string fileName in Program.GetDataFiles())
+                {
+                    int pageCount;
+                    AcceleratorState state;
+
+                    try
+                    {
+                        using MuPDFContext context = new MuPDFContext();
+                        using MuPDFDocument document = new MuPDFDocument(context, fileName, cacheDirectory);
+
+                        pageCount = document.Pages.Count;
+                        state = document.AcceleratorState;
+                    }
+                    catch (MuPDFException)
+                    {
+                        //The file cannot be opened.
+                        continue;
+                    }
+
+                    string name = Path.GetFileName(fileName);
+
+                    if (name.Length > 30)
+                    {
+                        name = name.Substring(0, 27) + "...";
+                    }
+
+                    if (state == AcceleratorState.NotUsed)
+                    {
+                        Console.WriteLine("{0,-30} {1,6} {2,12} {3,16} {4,10}", name, pageCount, "-", "-", "unsupported");
+                        continue;
+                    }
+
+                    double normalTime = Program.Time(() => Open(fileName, null));
+                    double acceleratedTime = Program.Time(() => Open(fileName, cacheDirectory));
+
+                    Console.WriteLine("{0,-30} {1,6} {2,12:0.0} {3,16:0.0} {4,10:0.00}", name, pageCount, normalTime, acceleratedTime, normalTime / acceleratedTime);
+                }
+            }
+            finally
+            {
+                try
+                {
+                    Directory.Delete(cacheDirectory, true);
+                }
+                catch { }
+            }
+
+            Console.WriteLine();
+        }
+
+        /// <summary>
+        /// Opens the document with a new context (so that no resources are cached) and loads the last page.
+        /// </summary>
+        private static void Open(string fileName, string cacheDirectory)
+        {
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = cacheDirectory == null ? new MuPDFDocument(context, fileName) : new MuPDFDocument(context, fileName, cacheDirectory);
+
+            _ = document.Pages[document.Pages.Count - 1].Bounds;
+        }
+    }
+}
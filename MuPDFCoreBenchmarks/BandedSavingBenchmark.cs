@@ -0,0 +1,67 @@
+﻿using MuPDFCore;
+using System;
+using System.Collections.Generic;
+using System.IO;
+
+namespace MuPDFCoreBenchmarks
+{
+    /// <summary>
+    /// Compares saving a large image in a single pass (<see cref="MuPDFDocument.SaveImage(int, double, PixelFormats, string, RasterOutputFileTypes, bool)"/>),
+    /// band by band on a single thread, and band by band with the bands rendered in parallel by a <see cref="MuPDFRenderWorkerPool"/> while they are being encoded.
+    /// </summary>
+    static class BandedSavingBenchmark
+    {
+        /// <summary>
+        /// Arguments: [zoom, in percent] [band height, in pixels] [maximum thread count]
+        /// </summary>
+        public static void Run(string[] args)
+        {
+            double zoom = Program.GetIntArgument(args, 0, 800) / 100.0;
+            int bandHeight = Program.GetIntArgument(args, 1, 256);
+            int maxThreads = Program.GetIntArgument(args, 2, Environment.ProcessorCount);
+
+            string fileName = Program.GetDataFile("mupdf_explored.pdf");
+            string outputFile = Path.GetTempFileName();
+
+            Console.WriteLine("File: {0}", fileName);
+            Console.WriteLine("Zoom: {0:0%}", zoom);
+            Console.WriteLine("Band height: {0}", bandHeight);
+            Console.WriteLine();
+            Console.WriteLine("{0,-24} {1,12} {2,10}", "Method", "Time (ms)", "Speedup");
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, fileName);
+
+            double singlePassTime = Program.Time(() => document.SaveImage(0, zoom, PixelFormats.RGB, outputFile, RasterOutputFileTypes.PNG), 3);
+            Console.WriteLine("{0,-24} {1,12:0.0} {2,10:0.00}", "Single pass", singlePassTime, 1.0);
+
+            double bandedTime = Program.Time(() => document.SaveImageBanded(0, zoom, PixelFormats.RGB, outputFile, RasterOutputFileTypes.PNG, bandHeight), 3);
+            Console.WriteLine("{0,-24} {1,12:0.0} {2,10:0.00}", "Banded", bandedTime, singlePassTime / bandedTime);
+
+            List<int> threadCounts = new List<int>();
+
+            for (int i = 1; i < maxThreads; i *= 2)
+            {
+                threadCounts.Add(i);
+            }
+
+            threadCounts.Add(maxThreads);
+
+            foreach (int threadCount in threadCounts)
+            {
+                using MuPDFRenderWorkerPool workerPool = new MuPDFRenderWorkerPool(context, threadCount);
+
+                double parallelTime = Program.Time(() => document.SaveImageBanded(0, zoom, PixelFormats.RGB, outputFile, RasterOutputFileTypes.PNG, bandHeight, workerPool), 3);
+                Console.WriteLine("{0,-24} {1,12:0.0} {2,10:0.00}", "Banded, " + threadCount.ToString() + " workers", parallelTime, singlePassTime / parallelTime);
+            }
+
+            try
+            {
+                File.Delete(outputFile);
+            }
+            catch { }
+
+            Console.WriteLine();
+        }
+    }
+}
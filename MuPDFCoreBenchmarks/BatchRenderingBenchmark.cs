@@ -0,0 +1,73 @@
+﻿using MuPDFCore;
+using System;
+using System.Collections.Generic;
+
+namespace MuPDFCoreBenchmarks
+{
+    /// <summary>
+    /// Compares rendering every page of a document sequentially with rendering them using a <see cref="MuPDFBatchRenderer"/> with 1 to N workers.
+    /// </summary>
+    static class BatchRenderingBenchmark
+    {
+        /// <summary>
+        /// Arguments: [zoom, in percent] [maximum thread count]
+        /// </summary>
+        public static void Run(string[] args)
+        {
+            double zoom = Program.GetIntArgument(args, 0, 100) / 100.0;
+            int maxThreads = Program.GetIntArgument(args, 1, Environment.ProcessorCount);
+
+            string fileName = Program.GetDataFile("mupdf_explored.pdf");
+
+            Console.WriteLine("File: {0}", fileName);
+            Console.WriteLine("Zoom: {0:0%}", zoom);
+            Console.WriteLine();
+            Console.WriteLine("{0,-24} {1,12} {2,10}", "Method", "Time (ms)", "Speedup");
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, fileName);
+
+            int pageCount = document.Pages.Count;
+
+            double sequentialTime = Program.Time(() =>
+            {
+                for (int i = 0; i < pageCount; i++)
+                {
+                    document.ClearCache();
+                    _ = document.Render(i, zoom, PixelFormats.RGB);
+                }
+            }, 3);
+
+            Console.WriteLine("{0,-24} {1,12:0.0} {2,10:0.00}", "Sequential", sequentialTime, 1.0);
+
+            List<int> threadCounts = new List<int>();
+
+            for (int i = 1; i < maxThreads; i *= 2)
+            {
+                threadCounts.Add(i);
+            }
+
+            threadCounts.Add(maxThreads);
+
+            foreach (int threadCount in threadCounts)
+            {
+                using MuPDFBatchRenderer renderer = new MuPDFBatchRenderer(document, threadCount);
+
+                double batchTime = Program.Time(() =>
+                {
+                    foreach (MuPDFBatchRenderResult result in renderer.Render(0, pageCount, zoom, PixelFormats.RGB))
+                    {
+                        if (!result.Succeeded)
+                        {
+                            throw result.Error;
+                        }
+                    }
+                }, 3);
+
+                Console.WriteLine("{0,-24} {1,12:0.0} {2,10:0.00}", "Batch, " + threadCount.ToString() + " workers", batchTime, sequentialTime / batchTime);
+            }
+
+            Console.WriteLine();
+        }
+    }
+}
@@ -0,0 +1,99 @@
+﻿using MuPDFCore;
+using System;
+using System.Collections.Generic;
+using System.Threading;
+
+namespace MuPDFCoreBenchmarks
+{
+    /// <summary>
+    /// Measures how rendering throughput scales when multiple threads each use their own, independent, <see cref="MuPDFContext"/>.
+    /// Since every context has its own lock table, the threads should not contend with each other.
+    /// </summary>
+    static class ContextScalingBenchmark
+    {
+        /// <summary>
+        /// Arguments: [maximum thread count] [renders per thread]
+        /// </summary>
+        public static void Run(string[] args)
+        {
+            int maxThreads = Program.GetIntArgument(args, 0, Environment.ProcessorCount);
+            int rendersPerThread = Program.GetIntArgument(args, 1, 20);
+
+            string fileName = Program.GetDataFile("mupdf_explored.pdf");
+
+            List<int> threadCounts = new List<int>();
+
+            for (int i = 1; i < maxThreads; i *= 2)
+            {
+                threadCounts.Add(i);
+            }
+
+            threadCounts.Add(maxThreads);
+
+            Console.WriteLine("File: {0}", fileName);
+            Console.WriteLine("Renders per thread: {0}", rendersPerThread);
+            Console.WriteLine();
+            Console.WriteLine("{0,8} {1,12} {2,14} {3,10} {4,11}", "Threads", "Time (ms)", "Renders/s", "Speedup", "Efficiency");
+
+            double baseThroughput = 0;
+
+            foreach (int threadCount in threadCounts)
+            {
+                double time = Program.Time(() => RenderOnIndependentContexts(fileName, threadCount, rendersPerThread), 3);
+                double throughput = threadCount * rendersPerThread / time * 1000;
+
+                if (baseThroughput == 0)
+                {
+                    baseThroughput = throughput;
+                }
+
+                double speedup = throughput / baseThroughput;
+
+                Console.WriteLine("{0,8} {1,12:0.0} {2,14:0.0} {3,10:0.00} {4,10:0%}", threadCount, time, throughput, speedup, speedup / threadCount);
+            }
+
+            Console.WriteLine();
+        }
+
+        /// <summary>
+        /// Creates <paramref name="threadCount"/> threads, each of which opens the document with its own context and renders pages from it.
+        /// </summary>
+        private static void RenderOnIndependentContexts(string fileName, int threadCount, int rendersPerThread)
+        {
+            Thread[] threads = new Thread[threadCount];
+            Barrier barrier = new Barrier(threadCount);
+
+            for (int i = 0; i < threadCount; i++)
+            {
+                threads[i] = new Thread(() =>
+                {
+                    using MuPDFContext context = new MuPDFContext();
+                    using MuPDFDocument document = new MuPDFDocument(context, fileName);
+
+                    barrier.SignalAndWait();
+
+                    for (int j = 0; j < rendersPerThread; j++)
+                    {
+                        int pageNumber = j % document.Pages.Count;
+
+                        _ = document.Render(pageNumber, 1, PixelFormats.RGBA);
+
+                        //Drop the cached display lists and resources, so that every render goes through the store and the glyph cache again.
+                        if (pageNumber == document.Pages.Count - 1)
+                        {
+                            document.ClearCache();
+                            context.ClearStore();
+                        }
+                    }
+                });
+
+                threads[i].Start();
+            }
+
+            for (int i = 0; i < threadCount; i++)
+            {
+                threads[i].Join();
+            }
+        }
+    }
+}
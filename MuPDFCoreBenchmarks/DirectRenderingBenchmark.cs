@@ -0,0 +1,82 @@
+﻿using MuPDFCore;
+using System;
+using System.IO;
+
+namespace MuPDFCoreBenchmarks
+{
+    /// <summary>
+    /// Compares rendering each page once through a display list (the default) with running the page directly into the draw device (<see cref="MuPDFDocument.DirectRendering"/>),
+    /// which is the typical workload when creating thumbnails.
+    /// </summary>
+    static class DirectRenderingBenchmark
+    {
+        /// <summary>
+        /// Arguments: [zoom, in percent] [band height, in pixels]
+        /// </summary>
+        public static void Run(string[] args)
+        {
+            double zoom = Program.GetIntArgument(args, 0, 100) / 100.0;
+            int bandHeight = Program.GetIntArgument(args, 1, 256);
+
+            Console.WriteLine("Zoom: {0:0%}", zoom);
+            Console.WriteLine("Band height: {0}", bandHeight);
+            Console.WriteLine();
+            Console.WriteLine("{0,-30} {1,6} {2,16} {3,12} {4,14} {5,10}", "File", "Pages", "Display list (ms)", "Direct (ms)", "Banded (ms)", "Speedup");
+
+            foreach (string fileName in Program.GetDataFiles())
+            {
+                int pageCount;
+
+                try
+                {
+                    using MuPDFContext context = new MuPDFContext();
+                    using MuPDFDocument document = new MuPDFDocument(context, fileName);
+
+                    if (document.EncryptionState == EncryptionState.Encrypted)
+                    {
+                        continue;
+                    }
+
+                    pageCount = document.Pages.Count;
+                }
+                catch (MuPDFException)
+                {
+                    //The file cannot be opened.
+                    continue;
+                }
+
+                double displayListTime = Program.Time(() => RenderAllPages(fileName, zoom, false, 0), 3);
+                double directTime = Program.Time(() => RenderAllPages(fileName, zoom, true, 0), 3);
+                double bandedTime = Program.Time(() => RenderAllPages(fileName, zoom, true, bandHeight), 3);
+
+                string name = Path.GetFileName(fileName);
+
+                if (name.Length > 30)
+                {
+                    name = name.Substring(0, 27) + "...";
+                }
+
+                Console.WriteLine("{0,-30} {1,6} {2,16:0.0} {3,12:0.0} {4,14:0.0} {5,10:0.00}", name, pageCount, displayListTime, directTime, bandedTime, displayListTime / directTime);
+            }
+
+            Console.WriteLine();
+        }
+
+        /// <summary>
+        /// Opens the document with a new context (so that no resources are cached) and renders every page once.
+        /// </summary>
+        private static void RenderAllPages(string fileName, double zoom, bool direct, int bandHeight)
+        {
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, fileName);
+
+            document.DirectRendering = direct;
+            document.DirectRenderingBandHeight = bandHeight;
+
+            for (int i = 0; i < document.Pages.Count; i++)
+            {
+                _ = document.Render(i, zoom, PixelFormats.RGB);
+            }
+        }
+    }
+}
@@ -0,0 +1,225 @@
+﻿using MuPDFCore;
+using System;
+using System.Collections.Generic;
+using System.IO;
+
+namespace MuPDFCoreBenchmarks
+{
+    /// <summary>
+    /// Measures the time needed to open image documents (which includes reading the image resolution) from a file and from memory, compared with the time needed
+    /// to decode the first page. Opening an image should only parse its header, thus it should be much faster than decoding it.
+    /// </summary>
+    static class ImageOpeningBenchmark
+    {
+        /// <summary>
+        /// Arguments: [zoom, in percent] [number of TIFF pages] [additional image files...]
+        /// </summary>
+        public static void Run(string[] args)
+        {
+            double zoom = Program.GetIntArgument(args, 0, 400) / 100.0;
+            int tiffPages = Program.GetIntArgument(args, 1, 8);
+
+            string tempDirectory = Path.Combine(Path.GetTempPath(), "MuPDFCoreBenchmarks-" + Guid.NewGuid().ToString("N"));
+            Directory.CreateDirectory(tempDirectory);
+
+            try
+            {
+                List<(string, InputFileTypes)> files = CreateImages(tempDirectory, zoom, tiffPages);
+
+                for (int i = 2; i < args.Length; i++)
+                {
+                    string extension = Path.GetExtension(args[i]).ToLowerInvariant();
+
+                    if (extension == ".tif" || extension == ".tiff")
+                    {
+                        files.Add((args[i], InputFileTypes.TIFF));
+                    }
+                    else if (extension == ".jpg" || extension == ".jpeg")
+                    {
+                        files.Add((args[i], InputFileTypes.JPEG));
+                    }
+                }
+
+                Console.WriteLine("{0,-30} {1,6} {2,10} {3,10} {4,14} {5,16}", "File", "Pages", "Size (MB)", "File (ms)", "Memory (ms)", "First page (ms)");
+
+                foreach ((string fileName, InputFileTypes fileType) in files)
+                {
+                    int pageCount;
+
+                    using (MuPDFContext context = new MuPDFContext())
+                    using (MuPDFDocument document = new MuPDFDocument(context, fileName))
+                    {
+                        pageCount = document.Pages.Count;
+                    }
+
+                    byte[] data = File.ReadAllBytes(fileName);
+
+                    double fileTime = Program.Time(() => OpenFromFile(fileName));
+                    double memoryTime = Program.Time(() => OpenFromMemory(data, fileType));
+                    double decodeTime = Program.Time(() => DecodeFirstPage(fileName), 3);
+
+                    string name = Path.GetFileName(fileName);
+
+                    if (name.Length > 30)
+                    {
+                        name = name.Substring(0, 27) + "...";
+                    }
+
+                    Console.WriteLine("{0,-30} {1,6} {2,10:0.0} {3,10:0.00} {4,14:0.00} {5,16:0.0}", name, pageCount, data.Length / 1048576.0, fileTime, memoryTime, decodeTime);
+                }
+            }
+            finally
+            {
+                try
+                {
+                    Directory.Delete(tempDirectory, true);
+                }
+                catch { }
+            }
+
+            Console.WriteLine();
+        }
+
+        /// <summary>
+        /// Opens the image file with a new context (so that no resources are cached) and counts the pages.
+        /// </summary>
+        private static void OpenFromFile(string fileName)
+        {
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, fileName);
+
+            _ = document.Pages.Count;
+        }
+
+        /// <summary>
+        /// Opens the image from memory with a new context (so that no resources are cached) and counts the pages.
+        /// </summary>
+        private static void OpenFromMemory(byte[] data, InputFileTypes fileType)
+        {
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, data, fileType);
+
+            _ = document.Pages.Count;
+        }
+
+        /// <summary>
+        /// Opens the image file and renders the first page at its native resolution, which requires the image to be decoded.
+        /// </summary>
+        private static void DecodeFirstPage(string fileName)
+        {
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, fileName);
+
+            _ = document.Render(0, 1, PixelFormats.RGB);
+        }
+
+        /// <summary>
+        /// Renders the pages of the benchmark PDF document and uses them to create a JPEG image and a multi-page TIFF image.
+        /// </summary>
+        private static List<(string, InputFileTypes)> CreateImages(string directory, double zoom, int tiffPages)
+        {
+            string jpegFile = Path.Combine(directory, "Rendered.jpg");
+            string tiffFile = Path.Combine(directory, "Rendered.tif");
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, Program.GetDataFile("mupdf_explored.pdf"));
+
+            document.SaveImageAsJPEG(0, zoom, jpegFile, 90);
+
+            List<(int width, int height, byte[] pixels)> pages = new List<(int, int, byte[])>();
+
+            for (int i = 0; i < Math.Min(tiffPages, document.Pages.Count); i++)
+            {
+                RoundedRectangle bounds = document.Pages[i].Bounds.Round(zoom);
+                byte[] pixels = document.Render(i, zoom, PixelFormats.RGB);
+
+                pages.Add((bounds.Width, pixels.Length / (bounds.Width * 3), pixels));
+            }
+
+            WriteTIFF(tiffFile, pages, (int)Math.Round(72 * zoom));
+
+            return new List<(string, InputFileTypes)>() { (jpegFile, InputFileTypes.JPEG), (tiffFile, InputFileTypes.TIFF) };
+        }
+
+        /// <summary>
+        /// Writes an uncompressed RGB TIFF file with one image for each page.
+        /// </summary>
+        private static void WriteTIFF(string fileName, List<(int width, int height, byte[] pixels)> pages, int resolution)
+        {
+            using FileStream stream = File.Create(fileName);
+            using BinaryWriter writer = new BinaryWriter(stream);
+
+            //Little-endian header; the offset of the first IFD is written later.
+            writer.Write((byte)'I');
+            writer.Write((byte)'I');
+            writer.Write((ushort)42);
+
+            long previousIFDPointer = stream.Position;
+            writer.Write(0U);
+
+            foreach ((int width, int height, byte[] pixels) in pages)
+            {
+                uint pixelOffset = (uint)stream.Position;
+                writer.Write(pixels);
+
+                if (stream.Position % 2 != 0)
+                {
+                    writer.Write((byte)0);
+                }
+
+                uint bitsPerSampleOffset = (uint)stream.Position;
+                writer.Write((ushort)8);
+                writer.Write((ushort)8);
+                writer.Write((ushort)8);
+                writer.Write((ushort)0);
+
+                uint resolutionOffset = (uint)stream.Position;
+                writer.Write((uint)resolution);
+                writer.Write(1U);
+
+                uint ifdOffset = (uint)stream.Position;
+
+                stream.Seek(previousIFDPointer, SeekOrigin.Begin);
+                writer.Write(ifdOffset);
+                stream.Seek(ifdOffset, SeekOrigin.Begin);
+
+                writer.Write((ushort)12);
+                WriteIFDEntry(writer, 256, 4, 1, (uint)width);
+                WriteIFDEntry(writer, 257, 4, 1, (uint)height);
+                WriteIFDEntry(writer, 258, 3, 3, bitsPerSampleOffset);
+                WriteIFDEntry(writer, 259, 3, 1, 1);
+                WriteIFDEntry(writer, 262, 3, 1, 2);
+                WriteIFDEntry(writer, 273, 4, 1, pixelOffset);
+                WriteIFDEntry(writer, 277, 3, 1, 3);
+                WriteIFDEntry(writer, 278, 4, 1, (uint)height);
+                WriteIFDEntry(writer, 279, 4, 1, (uint)pixels.Length);
+                WriteIFDEntry(writer, 282, 5, 1, resolutionOffset);
+                WriteIFDEntry(writer, 283, 5, 1, resolutionOffset);
+                WriteIFDEntry(writer, 296, 3, 1, 2);
+
+                previousIFDPointer = stream.Position;
+                writer.Write(0U);
+            }
+        }
+
+        /// <summary>
+        /// Writes a TIFF IFD entry whose value (or offset) fits in 4 bytes.
+        /// </summary>
+        private static void WriteIFDEntry(BinaryWriter writer, ushort tag, ushort type, uint count, uint value)
+        {
+            writer.Write(tag);
+            writer.Write(type);
+            writer.Write(count);
+
+            if (type == 3 && count == 1)
+            {
+                writer.Write((ushort)value);
+                writer.Write((ushort)0);
+            }
+            else
+            {
+                writer.Write(value);
+            }
+        }
+    }
+}
@@ -0,0 +1,118 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Linq;
+
+namespace MuPDFCoreBenchmarks
+{
+    class Program
+    {
+        /// <summary>
+        /// The available benchmarks. Each benchmark receives the command-line arguments following its name.
+        /// </summary>
+        static readonly Dictionary<string, (string description, Action<string[]> run)> Benchmarks = new Dictionary<string, (string, Action<string[]>)>()
+        {
+            { "contexts", ("Rendering throughput with 1 to N independent contexts, each used by its own thread.", ContextScalingBenchmark.Run) },
+            { "direct", ("One-shot rendering of every page in the test corpus, with and without display lists.", DirectRenderingBenchmark.Run) },
+            { "banded", ("Saving a large image in a single pass, in bands, and in bands rendered in parallel.", BandedSavingBenchmark.Run) },
+            { "batch", ("Rendering every page of a document sequentially and with a batch renderer using 1 to N workers.", BatchRenderingBenchmark.Run) },
+            { "accelerator", ("Opening every document in the test corpus with and without an accelerator file.", AcceleratorBenchmark.Run) },
+            { "images", ("Opening multi-page TIFF and JPEG images from a file and from memory, compared with decoding their first page.", ImageOpeningBenchmark.Run) },
+        };
+
+        static int Main(string[] args)
+        {
+            Console.WriteLine();
+            Console.WriteLine("MuPDFCore benchmarks");
+            Console.WriteLine();
+
+            if (args.Length == 0 || !Benchmarks.ContainsKey(args[0]))
+            {
+                Console.WriteLine("Usage: MuPDFCoreBenchmarks <benchmark> [arguments]");
+                Console.WriteLine();
+                Console.WriteLine("Available benchmarks:");
+
+                int longestName = Benchmarks.Keys.Max(x => x.Length);
+
+                foreach (KeyValuePair<string, (string description, Action<string[]> run)> benchmark in Benchmarks)
+                {
+                    Console.WriteLine("    {0}{1}", benchmark.Key.PadRight(longestName + 4), benchmark.Value.description);
+                }
+
+                Console.WriteLine();
+
+                return args.Length == 0 ? 0 : 1;
+            }
+
+            Benchmarks[args[0]].run(args.Skip(1).ToArray());
+
+            return 0;
+        }
+
+        /// <summary>
+        /// Gets the full path of a file in the benchmark data folder.
+        /// </summary>
+        /// <param name="fileName">The name of the file.</param>
+        /// <returns>The full path of the file.</returns>
+        internal static string GetDataFile(string fileName)
+        {
+            return Path.Combine(AppContext.BaseDirectory, "Data", fileName);
+        }
+
+        /// <summary>
+        /// Gets the full paths of all the files in the benchmark data folder.
+        /// </summary>
+        /// <returns>The full paths of the files, sorted by name.</returns>
+        internal static string[] GetDataFiles()
+        {
+            string[] files = Directory.GetFiles(Path.Combine(AppContext.BaseDirectory, "Data"));
+            Array.Sort(files, StringComparer.Ordinal);
+            return files;
+        }
+
+        /// <summary>
+        /// Runs the specified action <paramref name="repeats"/> times (after a warm-up run) and returns the median time in milliseconds.
+        /// </summary>
+        /// <param name="action">The action to time.</param>
+        /// <param name="repeats">The number of timed runs.</param>
+        /// <returns>The median time in milliseconds.</returns>
+        internal static double Time(Action action, int repeats = 5)
+        {
+            action();
+
+            double[] times = new double[repeats];
+
+            for (int i = 0; i < repeats; i++)
+            {
+                Stopwatch sw = Stopwatch.StartNew();
+                action();
+                sw.Stop();
+                times[i] = sw.Elapsed.TotalMilliseconds;
+            }
+
+            Array.Sort(times);
+
+            return times[repeats / 2];
+        }
+
+        /// <summary>
+        /// Parses an optional integer argument.
+        /// </summary>
+        /// <param name="args">The arguments.</param>
+        /// <param name="index">The index of the argument.</param>
+        /// <param name="defaultValue">The value to return if the argument is missing.</param>
+        /// <returns>The parsed argument, or <paramref name="defaultValue"/>.</returns>
+        internal static int GetIntArgument(string[] args, int index, int defaultValue)
+        {
+            if (args.Length > index && int.TryParse(args[index], out int value))
+            {
+                return value;
+            }
+            else
+            {
+                return defaultValue;
+            }
+        }
+    }
+}
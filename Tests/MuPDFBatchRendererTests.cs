@@ -0,0 +1,134 @@
+﻿using Microsoft.VisualStudio.TestTools.UnitTesting;
+using MuPDFCore;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Threading;
+
+#pragma warning disable IDE0090 // Use 'new(...)'
+
+namespace Tests
+{
+    [TestClass]
+    public class MuPDFBatchRendererTests
+    {
+        [TestMethod]
+        public void BatchRendererRendering()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.mupdf_explored.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+            using MuPDFBatchRenderer renderer = new MuPDFBatchRenderer(document, 3, 2);
+
+            Assert.AreEqual(3, renderer.WorkerCount, "The worker count for the renderer is wrong.");
+            Assert.AreEqual(2, renderer.MaxPendingResults, "The maximum number of pending results is wrong.");
+
+            int pageCount = Math.Min(document.Pages.Count, 10);
+
+            List<MuPDFBatchRenderResult> results = renderer.Render(0, pageCount, 0.5, PixelFormats.RGBA).ToList();
+
+            CollectionAssert.AreEquivalent(Enumerable.Range(0, pageCount).ToArray(), results.Select(x => x.PageNumber).ToArray(), "The rendered pages are wrong.");
+
+            foreach (MuPDFBatchRenderResult result in results)
+            {
+                Assert.IsTrue(result.Succeeded, "Page " + result.PageNumber.ToString() + " was not rendered: " + result.Error?.Message);
+
+                byte[] expected = document.Render(result.PageNumber, 0.5, PixelFormats.RGBA);
+                RoundedRectangle expectedSize = document.Pages[result.PageNumber].Bounds.Round(0.5);
+
+                Assert.AreEqual(expectedSize.Width, result.Size.Width, "The width of page " + result.PageNumber.ToString() + " is wrong.");
+                Assert.AreEqual(expectedSize.Height, result.Size.Height, "The height of page " + result.PageNumber.ToString() + " is wrong.");
+                CollectionAssert.AreEqual(expected, result.Data, "The image of page " + result.PageNumber.ToString() + " is different from the image rendered by the document.");
+            }
+        }
+
+        [TestMethod]
+        public void BatchRendererWritingImages()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+            using MuPDFBatchRenderer renderer = new MuPDFBatchRenderer(document, 2);
+
+            MemoryStream[] outputs = new MemoryStream[document.Pages.Count];
+
+            foreach (MuPDFBatchRenderResult result in renderer.WriteImages(0, document.Pages.Count, 1, PixelFormats.RGB, RasterOutputFileTypes.PNG, i => outputs[i] = new MemoryStream()))
+            {
+                Assert.IsTrue(result.Succeeded, "Page " + result.PageNumber.ToString() + " was not written: " + result.Error?.Message);
+            }
+
+            for (int i = 0; i < outputs.Length; i++)
+            {
+                using MemoryStream expected = new MemoryStream();
+                document.WriteImage(i, 1, PixelFormats.RGB, expected, RasterOutputFileTypes.PNG);
+
+                CollectionAssert.AreEqual(expected.ToArray(), outputs[i].ToArray(), "The image written for page " + i.ToString() + " is wrong.");
+                outputs[i].Dispose();
+            }
+        }
+
+        [TestMethod]
+        public void BatchRendererErrorsAndCancellation()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+            using MuPDFBatchRenderer renderer = new MuPDFBatchRenderer(document, 2);
+
+            Assert.ThrowsException<ArgumentOutOfRangeException>(() => renderer.Render(0, document.Pages.Count + 1, 1, PixelFormats.RGB), "A page range extending beyond the end of the document should not be allowed.");
+
+            //The zoom is valid, but too small for the size of the pages: each page should report an error, without stopping the others.
+            List<MuPDFBatchRenderResult> results = renderer.Render(0, document.Pages.Count, 0.0000011, PixelFormats.RGB).ToList();
+
+            Assert.AreEqual(document.Pages.Count, results.Count, "The number of results is wrong.");
+
+            foreach (MuPDFBatchRenderResult result in results)
+            {
+                Assert.IsFalse(result.Succeeded, "Page " + result.PageNumber.ToString() + " should have failed.");
+                Assert.IsInstanceOfType(result.Error, typeof(ArgumentOutOfRangeException), "The error reported for page " + result.PageNumber.ToString() + " is wrong.");
+            }
+
+            using CancellationTokenSource cancellationTokenSource = new CancellationTokenSource();
+            cancellationTokenSource.Cancel();
+
+            Assert.ThrowsException<OperationCanceledException>(() => renderer.Render(0, document.Pages.Count, 1, PixelFormats.RGB, cancellationTokenSource.Token).ToList(), "Rendering should have been cancelled.");
+
+            //The renderer can be used again after a cancelled run.
+            Assert.IsTrue(renderer.Render(0, 1, 1, PixelFormats.RGB).Single().Succeeded, "The renderer could not be reused after cancellation.");
+        }
+
+        [TestMethod]
+        public void BatchRendererDisposeWhileRunning()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+            MuPDFBatchRenderer renderer = new MuPDFBatchRenderer(document, 2, 1);
+
+            using (IEnumerator<MuPDFBatchRenderResult> enumerator = renderer.Render(0, document.Pages.Count, 1, PixelFormats.RGB).GetEnumerator())
+            {
+                Assert.IsTrue(enumerator.MoveNext(), "The first page was not rendered.");
+
+                //The workers are still rendering the other pages.
+                Assert.ThrowsException<InvalidOperationException>(() => renderer.Dispose(), "Disposing the renderer while it is running should throw an exception.");
+            }
+
+            renderer.Dispose();
+
+            Assert.ThrowsException<ObjectDisposedException>(() => renderer.Render(0, 1, 1, PixelFormats.RGB).ToList(), "Rendering with a disposed renderer should throw an exception.");
+        }
+    }
+}
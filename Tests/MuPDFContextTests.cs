@@ -1,6 +1,8 @@
 ﻿using Microsoft.VisualStudio.TestTools.UnitTesting;
 using MuPDFCore;
 using System;
+using System.IO;
+using System.Threading.Tasks;
 
 #pragma warning disable IDE0090 // Use 'new(...)'
 
@@ -23,6 +25,68 @@ namespace Tests
             Assert.AreNotEqual(IntPtr.Zero, context.NativeContext, "The native context pointer is null.");
         }
 
+        [TestMethod]
+        [DeploymentItem("Data/Sample.pdf")]
+        public void MuPDFContextCreationWithPoolAllocator()
+        {
+            byte[] expected;
+
+            using (MuPDFContext context = new MuPDFContext())
+            {
+                using MuPDFDocument document = new MuPDFDocument(context, "Sample.pdf");
+                expected = document.Render(0, 1, PixelFormats.RGBA);
+            }
+
+            using (MuPDFContext context = new MuPDFContext(256 << 20, NativeAllocators.Pool))
+            {
+                Assert.AreEqual(NativeAllocators.Pool, context.Allocator, "The context is using the wrong allocator.");
+
+                using MuPDFDocument document = new MuPDFDocument(context, "Sample.pdf");
+
+                for (int i = 0; i < 3; i++)
+                {
+                    byte[] actual = document.Render(0, 1, PixelFormats.RGBA);
+                    CollectionAssert.AreEqual(expected, actual, "The page rendered using the pooled allocator is different.");
+                    document.ClearCache();
+                }
+            }
+
+            MuPDFContext.ReleasePooledMemory();
+        }
+
+        [TestMethod]
+        public void MuPDFContextConcurrentLayoutInSeparateContexts()
+        {
+            using Stream epubDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.basic-v3plus2.epub");
+            MemoryStream epubStream = new MemoryStream();
+            epubDataStream.CopyTo(epubStream);
+            byte[] epubData = epubStream.ToArray();
+
+            int expectedPageCount;
+            byte[] expected;
+
+            using (MuPDFContext context = new MuPDFContext())
+            using (MuPDFDocument document = new MuPDFDocument(context, epubData, InputFileTypes.EPUB))
+            {
+                document.Layout(420, 595, 10);
+                expectedPageCount = document.Pages.Count;
+                expected = document.Render(0, 1, PixelFormats.RGBA);
+            }
+
+            //Independent contexts have separate lock tables, but text shaping uses global state that must still be protected by a process-wide lock.
+            Parallel.For(0, 8, new ParallelOptions() { MaxDegreeOfParallelism = 4 }, i =>
+            {
+                using MuPDFContext context = new MuPDFContext();
+                using MuPDFDocument document = new MuPDFDocument(context, epubData, InputFileTypes.EPUB);
+
+                document.Layout(420, 595, 10);
+                Assert.AreEqual(expectedPageCount, document.Pages.Count, "The page count is wrong.");
+
+                byte[] actual = document.Render(0, 1, PixelFormats.RGBA);
+                CollectionAssert.AreEqual(expected, actual, "The page rendered concurrently is different.");
+            });
+        }
+
         [TestMethod]
         public void MuPDFContextCurrentStoreSizeGetter()
         {
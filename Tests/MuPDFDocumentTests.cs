@@ -1,6 +1,7 @@
 ﻿using Microsoft.VisualStudio.TestTools.UnitTesting;
 using MuPDFCore;
 using System;
+using System.Collections.Generic;
 using System.IO;
 using System.Runtime.InteropServices;
 using System.Threading;
@@ -29,6 +30,97 @@ namespace Tests
             Assert.AreEqual(72, document.ImageYRes, "The image x resolution is wrong.");
         }
 
+        [TestMethod]
+        [DeploymentItem("Data/Sample.pdf")]
+        public void MuPDFDocumentCreationFromEPUBFileWithAccelerator()
+        {
+            string cacheDirectory = Path.Combine(Path.GetTempPath(), Guid.NewGuid().ToString("N"));
+            string tempEpub = Path.Combine(Path.GetTempPath(), Guid.NewGuid().ToString("N") + ".epub");
+
+            using (Stream epubDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.basic-v3plus2.epub"))
+            using (FileStream fs = File.Create(tempEpub))
+            {
+                epubDataStream.CopyTo(fs);
+            }
+
+            try
+            {
+                using MuPDFContext context = new MuPDFContext();
+
+                int pageCount;
+
+                using (MuPDFDocument document = new MuPDFDocument(context, tempEpub, cacheDirectory))
+                {
+                    Assert.AreEqual(AcceleratorState.Created, document.AcceleratorState, "The accelerator has not been created.");
+                    Assert.AreEqual(1, Directory.GetFiles(cacheDirectory).Length, "The accelerator file has not been saved.");
+                    pageCount = document.Pages.Count;
+                }
+
+                using (MuPDFDocument document = new MuPDFDocument(context, tempEpub, cacheDirectory))
+                {
+                    Assert.AreEqual(AcceleratorState.Loaded, document.AcceleratorState, "The accelerator has not been used.");
+                    Assert.AreEqual(pageCount, document.Pages.Count, "The page count of the accelerated document is wrong.");
+                    Assert.IsTrue(document.Render(0, 1, PixelFormats.RGB).Length > 0, "The accelerated document could not be rendered.");
+                }
+
+                //A file that has been modified (even if its length and its first and last bytes are unchanged) does not reuse the old accelerator.
+                File.SetLastWriteTimeUtc(tempEpub, File.GetLastWriteTimeUtc(tempEpub).AddHours(1));
+
+                using (MuPDFDocument document = new MuPDFDocument(context, tempEpub, cacheDirectory))
+                {
+                    Assert.AreEqual(AcceleratorState.Created, document.AcceleratorState, "The accelerator of a modified file has been reused.");
+                    Assert.AreEqual(pageCount, document.Pages.Count, "The page count of the modified document is wrong.");
+                }
+
+                using (MuPDFDocument document = new MuPDFDocument(context, tempEpub))
+                {
+                    Assert.AreEqual(AcceleratorState.NotUsed, document.AcceleratorState, "The accelerator state is wrong.");
+                }
+
+                //PDF documents do not support accelerators.
+                using (MuPDFDocument document = new MuPDFDocument(context, "Sample.pdf", cacheDirectory))
+                {
+                    Assert.AreEqual(AcceleratorState.NotUsed, document.AcceleratorState, "The accelerator state of a PDF document is wrong.");
+                    Assert.AreEqual(2, document.Pages.Count, "The page count of the PDF document is wrong.");
+                }
+            }
+            finally
+            {
+                try
+                {
+                    File.Delete(tempEpub);
+                    Directory.Delete(cacheDirectory, true);
+                }
+                catch { }
+            }
+        }
+
+        [TestMethod]
+        [DeploymentItem("Data/Sample.pdf")]
+        public void MuPDFDocumentCreationFromMemoryMappedPDFFile()
+        {
+            using MuPDFContext context = new MuPDFContext();
+
+            byte[] expected;
+
+            using (MuPDFDocument document = new MuPDFDocument(context, "Sample.pdf"))
+            {
+                expected = document.Render(0, 1, PixelFormats.RGB);
+            }
+
+            using (MuPDFDocument document = new MuPDFDocument(context, "Sample.pdf", true))
+            {
+                Assert.IsNotNull(document, "The created document is null.");
+                Assert.AreNotEqual(IntPtr.Zero, document.NativeDocument, "The native document pointer is null.");
+                Assert.AreEqual(72, document.ImageXRes, "The image x resolution is wrong.");
+                Assert.AreEqual(72, document.ImageYRes, "The image x resolution is wrong.");
+
+                CollectionAssert.AreEqual(expected, document.Render(0, 1, PixelFormats.RGB), "The memory-mapped document was rendered differently.");
+            }
+
+            Assert.ThrowsException<MuPDFException>(() => new MuPDFDocument(context, "ThisFileDoesNotExist.pdf", true), "Opening a missing file should throw an exception.");
+        }
+
         [TestMethod]
         [DeploymentItem("Data/Sample.png")]
         public void MuPDFDocumentCreationFromPNGFile()
@@ -71,6 +163,197 @@ namespace Tests
             Assert.AreEqual(72, document.ImageYRes, "The image x resolution is wrong.");
         }
 
+        [TestMethod]
+        public void MuPDFDocumentCreationFromSeekableStream()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.mupdf_explored.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            string tempFile = Path.GetTempFileName();
+            File.WriteAllBytes(tempFile, pdfStream.ToArray());
+
+            try
+            {
+                using MuPDFContext context = new MuPDFContext();
+
+                byte[] expected;
+                int pageCount;
+
+                using (MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF))
+                {
+                    expected = document.Render(0, 1, PixelFormats.RGB);
+                    pageCount = document.Pages.Count;
+                }
+
+                //Use small blocks and a small cache, so that blocks need to be evicted and read again.
+                using (MuPDFDocument document = new MuPDFDocument(context, File.OpenRead(tempFile), InputFileTypes.PDF, false, 4096, 4))
+                {
+                    Assert.IsNotNull(document, "The created document is null.");
+                    Assert.AreNotEqual(IntPtr.Zero, document.NativeDocument, "The native document pointer is null.");
+                    Assert.AreEqual(pageCount, document.Pages.Count, "The page count is wrong.");
+
+                    CollectionAssert.AreEqual(expected, document.Render(0, 1, PixelFormats.RGB), "The document opened from the stream was rendered differently.");
+                }
+
+                //Use small blocks and a cache that can hold the whole file, so that each block is read at most once: only the blocks that are needed to open the document and render the first page should be read.
+                CountingStream countingStream = new CountingStream(File.OpenRead(tempFile));
+
+                using (MuPDFDocument document = new MuPDFDocument(context, countingStream, InputFileTypes.PDF, false, 1024, 4096))
+                {
+                    CollectionAssert.AreEqual(expected, document.Render(0, 1, PixelFormats.RGB), "The document opened from the stream was rendered differently.");
+
+                    Assert.IsTrue(countingStream.BytesRead > 0, "No data has been read from the stream.");
+                    Assert.IsTrue(countingStream.BytesRead < countingStream.Length, "The whole stream has been read, instead of only the blocks that were needed.");
+                }
+
+                using (FileStream stream = File.OpenRead(tempFile))
+                {
+                    using (MuPDFDocument document = new MuPDFDocument(context, stream, InputFileTypes.PDF, true))
+                    {
+                        CollectionAssert.AreEqual(expected, document.Render(0, 1, PixelFormats.RGB), "The document opened from the stream was rendered differently.");
+                    }
+
+                    Assert.IsTrue(stream.CanRead, "The stream has been disposed even though leaveOpen was true.");
+                }
+            }
+            finally
+            {
+                try
+                {
+                    File.Delete(tempFile);
+                }
+                catch { }
+            }
+        }
+
+        [TestMethod]
+        public void MuPDFDocumentCreationFromFailingStream()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+
+            CountingStream failingStream = new CountingStream(new MemoryStream(pdfStream.ToArray())) { FailReads = true };
+
+            //The exception thrown by the stream should be reported, rather than a generic error.
+            Assert.ThrowsException<IOException>(() => new MuPDFDocument(context, failingStream, InputFileTypes.PDF), "The exception thrown while reading from the stream has not been rethrown.");
+
+            CountingStream stream = new CountingStream(new MemoryStream(pdfStream.ToArray()));
+
+            using MuPDFDocument document = new MuPDFDocument(context, stream, InputFileTypes.PDF, false, 1024, 4096, new MuPDFDocumentOpenOptions() { LazyPageCount = true });
+
+            document.DirectRendering = true;
+            stream.FailReads = true;
+
+            Assert.ThrowsException<IOException>(() => document.Render(0, 1, PixelFormats.RGB), "The exception thrown while reading from the stream has not been rethrown.");
+        }
+
+        [TestMethod]
+        public void MuPDFDocumentCreationWithOpenOptions()
+        {
+            using Stream epubDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.basic-v3plus2.epub");
+            MemoryStream epubStream = new MemoryStream();
+            epubDataStream.CopyTo(epubStream);
+            byte[] epubData = epubStream.ToArray();
+
+            using MuPDFContext context = new MuPDFContext();
+
+            int expectedPageCount;
+            Rectangle expectedBounds;
+
+            using (MuPDFDocument document = new MuPDFDocument(context, epubData, InputFileTypes.EPUB))
+            {
+                document.Layout(420, 595, 10);
+                expectedPageCount = document.Pages.Count;
+                expectedBounds = document.Pages[0].Bounds;
+            }
+
+            using (MuPDFDocument document = new MuPDFDocument(context, epubData, InputFileTypes.EPUB, new MuPDFDocumentOpenOptions() { DeferLayout = true }))
+            {
+                document.Layout(420, 595, 10);
+
+                Assert.AreEqual(expectedPageCount, document.Pages.Count, "The page count after a deferred layout is wrong.");
+                Assert.AreEqual(expectedBounds, document.Pages[0].Bounds, "The page bounds after a deferred layout are wrong.");
+            }
+
+            using (MuPDFDocument document = new MuPDFDocument(context, epubData, InputFileTypes.EPUB, new MuPDFDocumentOpenOptions(420, 595, 10)))
+            {
+                Assert.AreEqual(expectedPageCount, document.Pages.Count, "The page count with an initial layout is wrong.");
+                Assert.AreEqual(expectedBounds, document.Pages[0].Bounds, "The page bounds with an initial layout are wrong.");
+            }
+
+            using (MuPDFDocument document = new MuPDFDocument(context, epubData, InputFileTypes.EPUB, new MuPDFDocumentOpenOptions(420, 595, 10) { DeferLayout = true }))
+            {
+                //The pages are accessed without setting the layout, so the layout from the options is applied at this point.
+                Assert.AreEqual(expectedPageCount, document.Pages.Count, "The page count with a deferred initial layout is wrong.");
+                Assert.AreEqual(expectedBounds, document.Pages[0].Bounds, "The page bounds with a deferred initial layout are wrong.");
+            }
+
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using (MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF, new MuPDFDocumentOpenOptions() { LazyPageCount = true }))
+            {
+                Assert.AreEqual(2, document.Pages.Count, "The lazily counted page count is wrong.");
+            }
+        }
+
+        [TestMethod]
+        public void MuPDFDocumentIncrementalLayout()
+        {
+            using Stream epubDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.basic-v3plus2.epub");
+            MemoryStream epubStream = new MemoryStream();
+            epubDataStream.CopyTo(epubStream);
+            byte[] epubData = epubStream.ToArray();
+
+            using MuPDFContext context = new MuPDFContext();
+
+            int expectedPageCount;
+            Rectangle expectedBounds;
+
+            using (MuPDFDocument document = new MuPDFDocument(context, epubData, InputFileTypes.EPUB))
+            {
+                document.Layout(420, 595, 10);
+                expectedPageCount = document.Pages.Count;
+                expectedBounds = document.Pages[0].Bounds;
+            }
+
+            using (MuPDFDocument document = new MuPDFDocument(context, epubData, InputFileTypes.EPUB))
+            {
+                MuPDFIncrementalLayout layout = document.LayoutIncrementally(420, 595, 10);
+
+                Assert.IsTrue(document.Pages.Count >= 1, "The pages of the first chapter are not available.");
+                Assert.AreEqual(expectedBounds, document.Pages[0].Bounds, "The page bounds with an incremental layout are wrong.");
+
+                layout.Completion.Wait();
+
+                Assert.AreEqual(expectedPageCount, layout.Completion.Result, "The page count reported by the incremental layout is wrong.");
+                Assert.AreEqual(expectedPageCount, document.Pages.Count, "The page count after the incremental layout is wrong.");
+                Assert.AreEqual(layout.ChapterCount, layout.LaidOutChapters, "Not all the chapters have been laid out.");
+            }
+
+            using (MuPDFDocument document = new MuPDFDocument(context, epubData, InputFileTypes.EPUB))
+            {
+                using CancellationTokenSource cancellationTokenSource = new CancellationTokenSource();
+                cancellationTokenSource.Cancel();
+
+                MuPDFIncrementalLayout layout = document.LayoutIncrementally(420, 595, 10, cancellationTokenSource.Token);
+
+                try
+                {
+                    layout.Completion.Wait();
+                }
+                catch (AggregateException) { }
+
+                Assert.IsTrue(layout.IsCompleted || layout.Completion.IsCanceled, "The incremental layout was not cancelled.");
+                Assert.AreEqual(layout.KnownPageCount, document.Pages.Count, "The page count after cancelling the incremental layout is wrong.");
+            }
+        }
+
         [TestMethod]
         public void MuPDFDocumentCreationFromPNGStream()
         {
@@ -87,6 +370,36 @@ namespace Tests
             Assert.AreEqual(96, document.ImageYRes, "The image x resolution is wrong.");
         }
 
+        [TestMethod]
+        public void MuPDFDocumentCreationFromPNGCallbackStream()
+        {
+            using Stream pngDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.png");
+            MemoryStream pngStream = new MemoryStream();
+            pngDataStream.CopyTo(pngStream);
+
+            using MuPDFContext context = new MuPDFContext();
+
+            byte[] expected;
+
+            using (MuPDFDocument document = new MuPDFDocument(context, pngStream.ToArray(), InputFileTypes.PNG))
+            {
+                expected = document.Render(0, 1, PixelFormats.RGB);
+            }
+
+            pngStream.Seek(0, SeekOrigin.Begin);
+
+            //Use blocks that are smaller than the image, so that the image is read from more than one block.
+            using (MuPDFDocument document = new MuPDFDocument(context, pngStream, InputFileTypes.PNG, false, 4096, 4))
+            {
+                Assert.IsNotNull(document, "The created document is null.");
+                Assert.AreNotEqual(IntPtr.Zero, document.NativeDocument, "The native document pointer is null.");
+                Assert.AreEqual(96, document.ImageXRes, "The image x resolution is wrong.");
+                Assert.AreEqual(96, document.ImageYRes, "The image x resolution is wrong.");
+
+                CollectionAssert.AreEqual(expected, document.Render(0, 1, PixelFormats.RGB), "The image opened from the stream was rendered differently.");
+            }
+        }
+
         [TestMethod]
         public void MuPDFDocumentCreationFromPDFBytes()
         {
@@ -238,8 +551,7 @@ namespace Tests
             using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
 
             byte[] rendered = document.Render(0, 1, PixelFormats.RGB);
-            MuPDFDisplayList[] displayLists = (MuPDFDisplayList[])typeof(MuPDFDocument).GetField("DisplayLists", System.Reflection.BindingFlags.NonPublic | System.Reflection.BindingFlags.Instance).GetValue(document);
-            Assert.IsNotNull(displayLists[0], "The display list has not been generated.");
+            Assert.IsTrue(document.Cache.ContainsDisplayList(0, true), "The display list has not been generated.");
 
             Assert.AreEqual(4000 * 2600 * 3, rendered.Length, "The size of the rendered image is wrong.");
             CollectionAssert.AreEqual(new byte[] { 0xF5, 0xF9, 0xFF }, rendered[0..3], "The start of the rendered image appears to be wrong.");
@@ -257,8 +569,7 @@ namespace Tests
             using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
 
             byte[] rendered = document.Render(0, 1, PixelFormats.BGRA);
-            MuPDFDisplayList[] displayLists = (MuPDFDisplayList[])typeof(MuPDFDocument).GetField("DisplayLists", System.Reflection.BindingFlags.NonPublic | System.Reflection.BindingFlags.Instance).GetValue(document);
-            Assert.IsNotNull(displayLists[0], "The display list has not been generated.");
+            Assert.IsTrue(document.Cache.ContainsDisplayList(0, true), "The display list has not been generated.");
 
             Assert.AreEqual(4000 * 2600 * 4, rendered.Length, "The size of the rendered image is wrong.");
             CollectionAssert.AreEqual(new byte[] { 0xFF, 0x73, 0x17, 0x0B, }, rendered[0..4], "The start of the rendered image appears to be wrong.");
@@ -277,8 +588,7 @@ namespace Tests
             using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
 
             byte[] rendered = document.Render(0, new Rectangle(100, 100, 500, 500), Math.Sqrt(2), PixelFormats.RGBA);
-            MuPDFDisplayList[] displayLists = (MuPDFDisplayList[])typeof(MuPDFDocument).GetField("DisplayLists", System.Reflection.BindingFlags.NonPublic | System.Reflection.BindingFlags.Instance).GetValue(document);
-            Assert.IsNotNull(displayLists[0], "The display list has not been generated.");
+            Assert.IsTrue(document.Cache.ContainsDisplayList(0, true), "The display list has not been generated.");
 
             Assert.AreEqual(567 * 567 * 4, rendered.Length, "The size of the rendered image is wrong.");
             CollectionAssert.AreEqual(new byte[] { 0x17, 0x73, 0xFF, 0x0B }, rendered[0..4], "The start of the rendered image appears to be wrong.");
@@ -302,8 +612,7 @@ namespace Tests
             byte[] rendered = new byte[bufferSize];
             Marshal.Copy(destination, rendered, 0, bufferSize);
 
-            MuPDFDisplayList[] displayLists = (MuPDFDisplayList[])typeof(MuPDFDocument).GetField("DisplayLists", System.Reflection.BindingFlags.NonPublic | System.Reflection.BindingFlags.Instance).GetValue(document);
-            Assert.IsNotNull(displayLists[0], "The display list has not been generated.");
+            Assert.IsTrue(document.Cache.ContainsDisplayList(0, true), "The display list has not been generated.");
 
             Assert.AreEqual(4000 * 2600 * 3, rendered.Length, "The size of the rendered image is wrong.");
             CollectionAssert.AreEqual(new byte[] { 0xF5, 0xF9, 0xFF }, rendered[0..3], "The start of the rendered image appears to be wrong.");
@@ -330,8 +639,7 @@ namespace Tests
             byte[] rendered = new byte[bufferSize];
             Marshal.Copy(destination, rendered, 0, bufferSize);
 
-            MuPDFDisplayList[] displayLists = (MuPDFDisplayList[])typeof(MuPDFDocument).GetField("DisplayLists", System.Reflection.BindingFlags.NonPublic | System.Reflection.BindingFlags.Instance).GetValue(document);
-            Assert.IsNotNull(displayLists[0], "The display list has not been generated.");
+            Assert.IsTrue(document.Cache.ContainsDisplayList(0, true), "The display list has not been generated.");
 
             Assert.AreEqual(567 * 567 * 4, rendered.Length, "The size of the rendered image is wrong.");
             CollectionAssert.AreEqual(new byte[] { 0x17, 0x73, 0xFF, 0x0B }, rendered[0..4], "The start of the rendered image appears to be wrong.");
@@ -352,8 +660,7 @@ namespace Tests
 
             Span<byte> rendered = document.Render(0, 1, PixelFormats.RGB, out IDisposable disposable);
 
-            MuPDFDisplayList[] displayLists = (MuPDFDisplayList[])typeof(MuPDFDocument).GetField("DisplayLists", System.Reflection.BindingFlags.NonPublic | System.Reflection.BindingFlags.Instance).GetValue(document);
-            Assert.IsNotNull(displayLists[0], "The display list has not been generated.");
+            Assert.IsTrue(document.Cache.ContainsDisplayList(0, true), "The display list has not been generated.");
 
             Assert.AreEqual(4000 * 2600 * 3, rendered.Length, "The size of the rendered image is wrong.");
             CollectionAssert.AreEqual(new byte[] { 0xF5, 0xF9, 0xFF }, new byte[] { rendered[0], rendered[1], rendered[2] }, "The start of the rendered image appears to be wrong.");
@@ -374,8 +681,7 @@ namespace Tests
 
             Span<byte> rendered = document.Render(0, new Rectangle(100, 100, 500, 500), Math.Sqrt(2), PixelFormats.RGBA, out IDisposable disposable);
 
-            MuPDFDisplayList[] displayLists = (MuPDFDisplayList[])typeof(MuPDFDocument).GetField("DisplayLists", System.Reflection.BindingFlags.NonPublic | System.Reflection.BindingFlags.Instance).GetValue(document);
-            Assert.IsNotNull(displayLists[0], "The display list has not been generated.");
+            Assert.IsTrue(document.Cache.ContainsDisplayList(0, true), "The display list has not been generated.");
 
             Assert.AreEqual(567 * 567 * 4, rendered.Length, "The size of the rendered image is wrong.");
             CollectionAssert.AreEqual(new byte[] { 0x17, 0x73, 0xFF, 0x0B }, new byte[] { rendered[0], rendered[1], rendered[2], rendered[3] }, "The start of the rendered image appears to be wrong.");
@@ -384,6 +690,42 @@ namespace Tests
             disposable.Dispose();
         }
 
+        [TestMethod]
+        public void MuPDFDocumentDirectRendering()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            byte[] expectedFullPage = document.Render(0, 1, PixelFormats.RGB);
+            byte[] expectedRegion = document.Render(0, new Rectangle(100, 100, 500, 500), Math.Sqrt(2), PixelFormats.RGBA);
+
+            document.ClearCache();
+            document.DirectRendering = true;
+
+            byte[] renderedFullPage = document.Render(0, 1, PixelFormats.RGB);
+            byte[] renderedRegion = document.Render(0, new Rectangle(100, 100, 500, 500), Math.Sqrt(2), PixelFormats.RGBA);
+
+            Assert.IsFalse(document.Cache.ContainsDisplayList(0, true), "A display list has been created.");
+            CollectionAssert.AreEqual(expectedFullPage, renderedFullPage, "The directly rendered page is different from the page rendered using a display list.");
+            CollectionAssert.AreEqual(expectedRegion, renderedRegion, "The directly rendered region is different from the region rendered using a display list.");
+
+            document.DirectRenderingBandHeight = 100;
+
+            renderedFullPage = document.Render(0, 1, PixelFormats.RGB);
+            renderedRegion = document.Render(0, new Rectangle(100, 100, 500, 500), Math.Sqrt(2), PixelFormats.RGBA);
+
+            Assert.AreEqual(4000 * 2600 * 3, renderedFullPage.Length, "The size of the page rendered in bands is wrong.");
+            CollectionAssert.AreEqual(new byte[] { 0xF5, 0xF9, 0xFF }, renderedFullPage[0..3], "The start of the page rendered in bands appears to be wrong.");
+            CollectionAssert.AreEqual(new byte[] { 0xF5, 0xF9, 0xFF }, renderedFullPage[^3..^0], "The end of the page rendered in bands appears to be wrong.");
+            Assert.AreEqual(567 * 567 * 4, renderedRegion.Length, "The size of the region rendered in bands is wrong.");
+            CollectionAssert.AreEqual(new byte[] { 0x17, 0x73, 0xFF, 0x0B }, renderedRegion[0..4], "The start of the region rendered in bands appears to be wrong.");
+            CollectionAssert.AreEqual(new byte[] { 0x17, 0x73, 0xFF, 0x0B }, renderedRegion[^4..^0], "The end of the region rendered in bands appears to be wrong.");
+        }
+
         [TestMethod]
         public void MuPDFDocumentCacheClearing()
         {
@@ -397,14 +739,48 @@ namespace Tests
             _ = document.Render(0, 1, PixelFormats.RGB);
             _ = document.Render(1, 1, PixelFormats.RGB);
 
-            MuPDFDisplayList[] displayLists = (MuPDFDisplayList[])typeof(MuPDFDocument).GetField("DisplayLists", System.Reflection.BindingFlags.NonPublic | System.Reflection.BindingFlags.Instance).GetValue(document);
-
             document.ClearCache();
 
-            for (int i = 0; i < displayLists.Length; i++)
+            Assert.IsFalse(document.Cache.ContainsDisplayList(0, true), "Not all display lists have been freed.");
+            Assert.IsFalse(document.Cache.ContainsDisplayList(1, true), "Not all display lists have been freed.");
+        }
+
+        [TestMethod]
+        public void MuPDFDocumentCacheEviction()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            int evictedDisplayLists = 0;
+            document.Cache.ObjectEvicted += (s, e) => { if (e.ObjectType == CachedObjectType.DisplayList) { evictedDisplayLists++; } };
+
+            _ = document.Render(0, 1, PixelFormats.RGB);
+            _ = document.Render(0, 1, PixelFormats.RGB);
+
+            Assert.AreEqual(1, document.Cache.Misses, "The number of cache misses is wrong.");
+            Assert.AreEqual(1, document.Cache.Hits, "The number of cache hits is wrong.");
+            Assert.IsTrue(document.Cache.CurrentSize > 0, "The size of the cache is wrong.");
+
+            using (MuPDFMultiThreadedPageRenderer renderer = document.GetMultiThreadedRenderer(0, 2))
             {
-                Assert.IsNull(displayLists[i], "Not all display lists have been freed.");
+                document.Cache.MaxSize = 0;
+                Assert.IsTrue(document.Cache.ContainsDisplayList(0, true), "A display list that is in use has been evicted.");
+                Assert.AreEqual(0, evictedDisplayLists, "A display list that is in use has been evicted.");
             }
+
+            _ = document.Render(1, 1, PixelFormats.RGB);
+
+            Assert.IsFalse(document.Cache.ContainsDisplayList(0, true), "The least recently used display list has not been evicted.");
+            Assert.IsTrue(document.Cache.ContainsDisplayList(1, true), "The most recently used display list has been evicted.");
+            Assert.AreEqual(1, evictedDisplayLists, "The eviction callback has not been invoked.");
+            Assert.AreEqual(1, document.Cache.Count, "The cache contains the wrong number of objects.");
+
+            Rectangle mediaBox = document.Pages[0].GetBoundingBox(BoxType.MediaBox);
+            Assert.IsTrue(mediaBox.Width > 0, "A page could not be loaded again after being evicted.");
         }
 
         [TestMethod]
@@ -736,6 +1112,119 @@ namespace Tests
             CollectionAssert.AreEqual(new byte[] { 0xFF, 0xFF, 0xFF, 0xFF }, savedBytes[^4..^0], "The end of the saved image appears to be wrong.");
         }
 
+        [TestMethod]
+        public void MuPDFDocumentImageSavingBandedPAM()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            string tempFile = Path.GetTempFileName();
+            string bandedTempFile = Path.GetTempFileName();
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            document.SaveImage(0, new Rectangle(100, 100, 500, 500), Math.Sqrt(2), PixelFormats.RGBA, tempFile, RasterOutputFileTypes.PAM);
+            document.SaveImageBanded(0, new Rectangle(100, 100, 500, 500), Math.Sqrt(2), PixelFormats.RGBA, bandedTempFile, RasterOutputFileTypes.PAM, 37);
+
+            Assert.IsTrue(File.Exists(bandedTempFile), "The output file has not been created.");
+
+            byte[] savedBytes = File.ReadAllBytes(tempFile);
+            byte[] bandedBytes = File.ReadAllBytes(bandedTempFile);
+
+            try
+            {
+                File.Delete(tempFile);
+                File.Delete(bandedTempFile);
+            }
+            catch { }
+
+            CollectionAssert.AreEqual(new byte[] { 0x50, 0x37, 0x0A, 0x57 }, bandedBytes[0..4], "The start of the saved image appears to be wrong.");
+            CollectionAssert.AreEqual(savedBytes, bandedBytes, "The image saved in bands is different from the image saved in a single pass.");
+        }
+
+        [TestMethod]
+        public void MuPDFDocumentImageSavingBandedPNG()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            string tempFile = Path.GetTempFileName();
+            string bandedTempFile = Path.GetTempFileName();
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            Assert.ThrowsException<ArgumentException>(() => document.SaveImageBanded(0, 1, PixelFormats.RGB, bandedTempFile, RasterOutputFileTypes.JPEG, 64), "Banded JPEG output should not be allowed.");
+            Assert.ThrowsException<ArgumentOutOfRangeException>(() => document.SaveImageBanded(0, 1, PixelFormats.RGB, bandedTempFile, RasterOutputFileTypes.PNG, 0), "A band height of 0 should not be allowed.");
+
+            document.SaveImage(0, 1, PixelFormats.RGBA, tempFile, RasterOutputFileTypes.PNG);
+            document.SaveImageBanded(0, 1, PixelFormats.RGBA, bandedTempFile, RasterOutputFileTypes.PNG, 64);
+
+            Assert.IsTrue(File.Exists(bandedTempFile), "The output file has not been created.");
+
+            byte[] savedBytes = File.ReadAllBytes(tempFile);
+            byte[] bandedBytes = File.ReadAllBytes(bandedTempFile);
+
+            try
+            {
+                File.Delete(tempFile);
+                File.Delete(bandedTempFile);
+            }
+            catch { }
+
+            CollectionAssert.AreEqual(new byte[] { 0x89, 0x50, 0x4E, 0x47 }, bandedBytes[0..4], "The start of the saved image appears to be wrong.");
+            CollectionAssert.AreEqual(new byte[] { 0xAE, 0x42, 0x60, 0x82 }, bandedBytes[^4..^0], "The end of the saved image appears to be wrong.");
+
+            //The PNG writer emits an IDAT chunk for each band, so the files differ in how the compressed data is split into chunks: compare the decoded pixels instead.
+            using MuPDFDocument savedImage = new MuPDFDocument(context, savedBytes, InputFileTypes.PNG);
+            using MuPDFDocument bandedImage = new MuPDFDocument(context, bandedBytes, InputFileTypes.PNG);
+
+            Assert.AreEqual(savedImage.Pages[0].Bounds.Width, bandedImage.Pages[0].Bounds.Width, "The image saved in bands has the wrong width.");
+            Assert.AreEqual(savedImage.Pages[0].Bounds.Height, bandedImage.Pages[0].Bounds.Height, "The image saved in bands has the wrong height.");
+
+            CollectionAssert.AreEqual(savedImage.Render(0, 1, PixelFormats.RGBA), bandedImage.Render(0, 1, PixelFormats.RGBA), "The image saved in bands is different from the image saved in a single pass.");
+        }
+
+        [TestMethod]
+        public void MuPDFDocumentImageSavingBandedParallel()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            string tempFile = Path.GetTempFileName();
+            string parallelTempFile = Path.GetTempFileName();
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+            using MuPDFRenderWorkerPool workerPool = new MuPDFRenderWorkerPool(context, 3);
+
+            document.SaveImageBanded(0, 2, PixelFormats.RGBA, tempFile, RasterOutputFileTypes.PAM, 50);
+            document.SaveImageBanded(0, 2, PixelFormats.RGBA, parallelTempFile, RasterOutputFileTypes.PAM, 50, workerPool);
+
+            Assert.IsTrue(File.Exists(parallelTempFile), "The output file has not been created.");
+
+            byte[] savedBytes = File.ReadAllBytes(tempFile);
+            byte[] parallelBytes = File.ReadAllBytes(parallelTempFile);
+
+            try
+            {
+                File.Delete(tempFile);
+                File.Delete(parallelTempFile);
+            }
+            catch { }
+
+            CollectionAssert.AreEqual(savedBytes, parallelBytes, "The image rendered in parallel is different from the image rendered sequentially.");
+
+            using MuPDFContext otherContext = new MuPDFContext();
+            using MuPDFRenderWorkerPool otherWorkerPool = new MuPDFRenderWorkerPool(otherContext, 1);
+
+            Assert.ThrowsException<ArgumentException>(() => document.SaveImageBanded(0, 1, PixelFormats.RGB, tempFile, RasterOutputFileTypes.PNG, 50, otherWorkerPool), "A worker pool from a different context should not be allowed.");
+        }
+
         [TestMethod]
         public void MuPDFDocumentImageWritingFullPagePNG()
         {
@@ -756,6 +1245,21 @@ namespace Tests
             CollectionAssert.AreEqual(new byte[] { 0xAE, 0x42, 0x60, 0x82 }, writtenBytes[^4..^0], "The end of the saved image appears to be wrong.");
         }
 
+        [TestMethod]
+        public void MuPDFDocumentImageWritingToReadOnlyStream()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            using MemoryStream renderStream = new MemoryStream(new byte[16], false);
+
+            Assert.ThrowsException<NotSupportedException>(() => document.WriteImage(0, 1, PixelFormats.RGBA, renderStream, RasterOutputFileTypes.PNG), "The exception thrown by the output stream was not propagated.");
+        }
+
         [TestMethod]
         public void MuPDFDocumentImageWritingFullPageJPEGWithQuality()
         {
@@ -1291,6 +1795,58 @@ namespace Tests
             Assert.IsTrue(extractedText.Length > 10, "The extracted text is too short.");
         }
 
+        [TestMethod]
+        public void MuPDFDocumentPageTextExtractionToSpan()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.mupdf_explored.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            List<string> pageTexts = new List<string>();
+
+            for (int i = 0; i < Math.Min(document.Pages.Count, 5); i++)
+            {
+                int length = document.ExtractPageText(i, Span<char>.Empty, "\n");
+
+                char[] buffer = new char[length];
+                Assert.AreEqual(length, document.ExtractPageText(i, buffer, "\n"), "The length of the text of page " + i.ToString() + " is inconsistent.");
+
+                if (length > 0)
+                {
+                    pageTexts.Add(new string(buffer));
+
+                    char[] shortBuffer = new char[length / 2];
+                    Assert.AreEqual(length, document.ExtractPageText(i, shortBuffer, "\n"), "The length of the truncated text of page " + i.ToString() + " is wrong.");
+                    Assert.IsTrue(buffer.AsSpan().StartsWith(shortBuffer.AsSpan().TrimEnd('\0')), "The truncated text of page " + i.ToString() + " is wrong.");
+                }
+            }
+
+            string extractedText = document.ExtractText("\n");
+
+            Assert.IsTrue(pageTexts.Count > 0, "No text was extracted.");
+            Assert.IsTrue(extractedText.StartsWith(string.Join("\n", pageTexts)), "The text extracted from the pages is different from the text extracted from the document.");
+        }
+
+        [TestMethod]
+        public void MuPDFDocumentTextExtractionParallel()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.mupdf_explored.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            string extractedText = document.ExtractText("\n", false);
+            string parallelText = document.ExtractText(4, "\n", false);
+
+            Assert.IsTrue(extractedText.Length > 10, "The extracted text is too short.");
+            Assert.AreEqual(extractedText, parallelText, "The text extracted in parallel is different from the text extracted sequentially.");
+        }
+
         [TestMethod]
         [DeploymentItem("Data/eng.traineddata")]
         public void MuPDFDocumentTextExtractionWithOCR()
@@ -1531,5 +2087,56 @@ namespace Tests
             Assert.IsFalse(((MuPDFOptionalContentGroupRadioButton)document.OptionalContentGroupData.DefaultConfiguration.UI[0].Children[0].Children[0]).IsEnabled, "After toggling, the first OCG UI radio button element has the wrong state.");
             Assert.IsTrue(((MuPDFOptionalContentGroupRadioButton)document.OptionalContentGroupData.DefaultConfiguration.UI[0].Children[0].Children[1]).IsEnabled, "After toggling, the second OCG UI radio button element has the wrong state.");
         }
+
+        /// <summary>
+        /// A read-only stream that counts the bytes that are read from an underlying stream, and can be made to fail.
+        /// </summary>
+        private class CountingStream : Stream
+        {
+            private readonly Stream BaseStream;
+
+            public long BytesRead { get; private set; }
+
+            public bool FailReads { get; set; }
+
+            public CountingStream(Stream baseStream)
+            {
+                this.BaseStream = baseStream;
+            }
+
+            public override bool CanRead => BaseStream.CanRead;
+            public override bool CanSeek => BaseStream.CanSeek;
+            public override bool CanWrite => false;
+            public override long Length => BaseStream.Length;
+            public override long Position { get => BaseStream.Position; set => BaseStream.Position = value; }
+
+            public override void Flush() { }
+
+            public override int Read(byte[] buffer, int offset, int count)
+            {
+                if (FailReads)
+                {
+                    throw new IOException("The stream is not available.");
+                }
+
+                int read = BaseStream.Read(buffer, offset, count);
+                BytesRead += read;
+                return read;
+            }
+
+            public override long Seek(long offset, SeekOrigin origin) => BaseStream.Seek(offset, origin);
+            public override void SetLength(long value) => throw new NotSupportedException();
+            public override void Write(byte[] buffer, int offset, int count) => throw new NotSupportedException();
+
+            protected override void Dispose(bool disposing)
+            {
+                if (disposing)
+                {
+                    BaseStream.Dispose();
+                }
+
+                base.Dispose(disposing);
+            }
+        }
     }
 }
@@ -27,7 +27,7 @@ namespace Tests
             using MuPDFMultiThreadedPageRenderer renderer = document.GetMultiThreadedRenderer(0, 11);
 
             Assert.IsNotNull(renderer, "The multi-threaded page renderer is null.");
-            Assert.AreEqual(10, renderer.ThreadCount, "The thread count for the renderer is wrong.");
+            Assert.AreEqual(11, renderer.ThreadCount, "The thread count for the renderer is wrong.");
         }
 
         [TestMethod]
@@ -143,6 +143,99 @@ namespace Tests
 
         }
 
+        [TestMethod]
+        public void MultiThreadedPageRendererRenderingTiled()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            RoundedSize targetSize = new RoundedSize(4000, 2600);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            using MuPDFMultiThreadedPageRenderer renderer = document.GetMultiThreadedRenderer(0, 4);
+
+            int tileCount = 0;
+            long renderedPixels = 0;
+
+            Span<byte> rendered = renderer.RenderTiled(targetSize, new Rectangle(0, 0, 4000, 2600), out IDisposable disposable, PixelFormats.RGBA, 256, tile =>
+            {
+                Interlocked.Increment(ref tileCount);
+                Interlocked.Add(ref renderedPixels, (long)tile.Width * tile.Height);
+            });
+
+            Assert.AreEqual(16 * 11, tileCount, "The number of rendered tiles is wrong.");
+            Assert.AreEqual(4000L * 2600, renderedPixels, "The rendered tiles do not cover the whole image.");
+            Assert.AreEqual(41600000, rendered.Length, "The size of the rendered image appears to be wrong.");
+            CollectionAssert.AreEqual(new byte[] { 0x17, 0x73, 0xFF, 0x0B }, new byte[] { rendered[0], rendered[1], rendered[2], rendered[3] }, "The start of the rendered image appears to be wrong.");
+            CollectionAssert.AreEqual(new byte[] { 0x17, 0x73, 0xFF, 0x0B }, new byte[] { rendered[rendered.Length - 4], rendered[rendered.Length - 3], rendered[rendered.Length - 2], rendered[rendered.Length - 1] }, "The end of the rendered image appears to be wrong.");
+
+            disposable.Dispose();
+        }
+
+
+        [TestMethod]
+        public async Task MultiThreadedPageRendererRenderingWithWorkerPool()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            using MuPDFRenderWorkerPool workerPool = new MuPDFRenderWorkerPool(context, 3);
+
+            using MuPDFMultiThreadedPageRenderer renderer1 = document.GetMultiThreadedRenderer(0, workerPool);
+            using MuPDFMultiThreadedPageRenderer renderer2 = document.GetMultiThreadedRenderer(0, workerPool);
+
+            Assert.AreEqual(3, renderer1.ThreadCount, "The thread count for the renderer is wrong.");
+
+            RoundedSize targetSize = new RoundedSize(4000, 2600);
+            RoundedRectangle[] splitSize = targetSize.Split(renderer1.ThreadCount);
+
+            IntPtr[] destinations1 = new IntPtr[splitSize.Length];
+            IntPtr[] destinations2 = new IntPtr[splitSize.Length];
+
+            for (int i = 0; i < splitSize.Length; i++)
+            {
+                destinations1[i] = Marshal.AllocHGlobal(splitSize[i].Width * splitSize[i].Height * 4);
+                destinations2[i] = Marshal.AllocHGlobal(splitSize[i].Width * splitSize[i].Height * 4);
+            }
+
+            try
+            {
+                await Task.WhenAll(renderer1.RenderAsync(targetSize, new Rectangle(0, 0, 4000, 2600), destinations1, PixelFormats.RGBA), renderer2.RenderAsync(targetSize, new Rectangle(0, 0, 4000, 2600), destinations2, PixelFormats.RGBA));
+
+                for (int i = 0; i < splitSize.Length; i++)
+                {
+                    byte[] rendered1 = new byte[splitSize[i].Width * splitSize[i].Height * 4];
+                    byte[] rendered2 = new byte[splitSize[i].Width * splitSize[i].Height * 4];
+
+                    Marshal.Copy(destinations1[i], rendered1, 0, rendered1.Length);
+                    Marshal.Copy(destinations2[i], rendered2, 0, rendered2.Length);
+
+                    CollectionAssert.AreEqual(new byte[] { 0x17, 0x73, 0xFF, 0x0B }, rendered1[0..4], "The start of tile " + i.ToString() + " appears to be wrong.");
+                    CollectionAssert.AreEqual(new byte[] { 0x17, 0x73, 0xFF, 0x0B }, rendered1[^4..^0], "The end of tile " + i.ToString() + " appears to be wrong.");
+                    CollectionAssert.AreEqual(rendered1, rendered2, "The two renderers produced different images for tile " + i.ToString() + ".");
+                }
+            }
+            finally
+            {
+                for (int i = 0; i < splitSize.Length; i++)
+                {
+                    Marshal.FreeHGlobal(destinations1[i]);
+                    Marshal.FreeHGlobal(destinations2[i]);
+                }
+            }
+
+            using MuPDFContext otherContext = new MuPDFContext();
+            using MuPDFRenderWorkerPool otherPool = new MuPDFRenderWorkerPool(otherContext, 1);
+
+            Assert.ThrowsException<ArgumentException>(() => document.GetMultiThreadedRenderer(0, otherPool), "Creating a renderer with a worker pool from a different context should fail.");
+        }
 
         [TestMethod]
         public async Task MultiThreadedPageRendererProgressGetter()
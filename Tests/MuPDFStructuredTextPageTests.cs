@@ -341,6 +341,123 @@ namespace Tests
             Assert.IsTrue(chr.Character == "v" || chr.Character == "l", "The hit test matched the wrong character.");
         }
 
+        [TestMethod]
+        public void MuPDFStructuredTextHitAddressMatchesLinearScan()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            using MuPDFStructuredTextPage sTextPage = document.GetStructuredTextPage(0);
+
+            Rectangle bounds = document.Pages[0].Bounds;
+
+            for (float y = bounds.Y0; y <= bounds.Y1; y += 7)
+            {
+                for (float x = bounds.X0; x <= bounds.X1; x += 5)
+                {
+                    PointF point = new PointF(x, y);
+
+                    MuPDFStructuredTextAddress? expected = null;
+
+                    for (int i = 0; i < sTextPage.Count && expected == null; i++)
+                    {
+                        if (sTextPage[i].BoundingBox.Contains(point))
+                        {
+                            for (int j = 0; j < sTextPage[i].Count && expected == null; j++)
+                            {
+                                if (sTextPage[i][j].BoundingBox.Contains(point))
+                                {
+                                    for (int k = 0; k < sTextPage[i][j].Count && expected == null; k++)
+                                    {
+                                        if (sTextPage[i][j][k].BoundingQuad.Contains(point))
+                                        {
+                                            expected = new MuPDFStructuredTextAddress(i, j, k);
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+
+                    Assert.AreEqual(expected, sTextPage.GetHitAddress(point, true), "The hit test returned the wrong character.");
+
+                    MuPDFStructuredTextAddress? closest = sTextPage.GetClosestHitAddress(point, true);
+
+                    Assert.IsNotNull(closest, "The closest hit test did not return a point.");
+
+                    if (expected != null)
+                    {
+                        Assert.AreEqual(expected, closest, "The closest hit test did not return the character containing the point.");
+                    }
+                }
+            }
+        }
+
+        [TestMethod]
+        public void MuPDFStructuredTextClosestHitAddressMatchesBruteForce()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            using MuPDFStructuredTextPage sTextPage = document.GetStructuredTextPage(0);
+
+            Rectangle bounds = document.Pages[0].Bounds;
+            Random random = new Random(42);
+
+            static float GetVertexDistance(Quad quad, PointF point)
+            {
+                float minDist = (point.X - quad.UpperLeft.X) * (point.X - quad.UpperLeft.X) + (point.Y - quad.UpperLeft.Y) * (point.Y - quad.UpperLeft.Y);
+                minDist = Math.Min(minDist, (point.X - quad.UpperRight.X) * (point.X - quad.UpperRight.X) + (point.Y - quad.UpperRight.Y) * (point.Y - quad.UpperRight.Y));
+                minDist = Math.Min(minDist, (point.X - quad.LowerRight.X) * (point.X - quad.LowerRight.X) + (point.Y - quad.LowerRight.Y) * (point.Y - quad.LowerRight.Y));
+                minDist = Math.Min(minDist, (point.X - quad.LowerLeft.X) * (point.X - quad.LowerLeft.X) + (point.Y - quad.LowerLeft.Y) * (point.Y - quad.LowerLeft.Y));
+                return minDist;
+            }
+
+            for (int n = 0; n < 2000; n++)
+            {
+                //Also include points outside of the page.
+                PointF point = new PointF((float)(bounds.X0 - 100 + random.NextDouble() * (bounds.Width + 200)), (float)(bounds.Y0 - 100 + random.NextDouble() * (bounds.Height + 200)));
+                bool includeImages = n % 2 == 0;
+
+                MuPDFStructuredTextAddress? expected = sTextPage.GetHitAddress(point, includeImages);
+
+                if (expected == null)
+                {
+                    float minDistance = float.MaxValue;
+
+                    for (int i = 0; i < sTextPage.Count; i++)
+                    {
+                        if (includeImages || sTextPage[i].Type == MuPDFStructuredTextBlock.Types.Text || sTextPage[i].Type == MuPDFStructuredTextBlock.Types.Structure)
+                        {
+                            for (int j = 0; j < sTextPage[i].Count; j++)
+                            {
+                                for (int k = 0; k < sTextPage[i][j].Count; k++)
+                                {
+                                    float distance = GetVertexDistance(sTextPage[i][j][k].BoundingQuad, point);
+
+                                    if (distance < minDistance)
+                                    {
+                                        minDistance = distance;
+                                        expected = new MuPDFStructuredTextAddress(i, j, k);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+
+                Assert.AreEqual(expected, sTextPage.GetClosestHitAddress(point, includeImages), "The closest hit test returned the wrong character.");
+            }
+        }
+
         [TestMethod]
         public void MuPDFStructuredTextHighlightQuadsGetter()
         {
@@ -404,6 +521,87 @@ namespace Tests
             Assert.AreEqual(8, result.Count(), "The search results are wrong.");
         }
 
+        [TestMethod]
+        public void MuPDFStructuredTextNativeSearching()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            using MuPDFStructuredTextPage sTextPage = document.GetStructuredTextPage(0);
+
+            MuPDFStructuredTextAddressSpan[] expected = sTextPage.Search(new System.Text.RegularExpressions.Regex("Helvetica")).ToArray();
+            MuPDFTextSearchHit[] hits = sTextPage.Search("Helvetica", true);
+
+            Assert.AreEqual(expected.Length, hits.Length, "The search results are wrong.");
+
+            for (int i = 0; i < hits.Length; i++)
+            {
+                Assert.AreEqual(-1, hits[i].PageNumber, "The page number is wrong.");
+                Assert.IsNotNull(hits[i].Span, "The hit address has not been mapped.");
+                Assert.AreEqual(expected[i].Start, hits[i].Span.Start, "The hit start address is wrong.");
+                Assert.AreEqual(expected[i].End, hits[i].Span.End, "The hit end address is wrong.");
+                Assert.IsTrue(hits[i].Quads.Length > 0, "The hit quads are missing.");
+            }
+
+            int caseInsensitive = sTextPage.Search(new System.Text.RegularExpressions.Regex("(?i)helvetica")).Count();
+            Assert.AreEqual(caseInsensitive, sTextPage.Search("helvetica").Length, "The case-insensitive search results are wrong.");
+            Assert.AreEqual(sTextPage.Search(new System.Text.RegularExpressions.Regex("helvetica")).Count(), sTextPage.Search("helvetica", true).Length, "The case-sensitive search results are wrong.");
+
+            Assert.AreEqual(1, sTextPage.Search("Helvetica", true, 1).Length, "The maximum number of hits was not respected.");
+            Assert.AreEqual(0, sTextPage.Search("").Length, "Searching for an empty string should not return any hits.");
+
+            MuPDFTextSearchHit[] pageHits = document.SearchPage(0, "Helvetica", true);
+            Assert.AreEqual(hits.Length, pageHits.Length, "The page search results are wrong.");
+
+            for (int i = 0; i < pageHits.Length; i++)
+            {
+                Assert.AreEqual(0, pageHits[i].PageNumber, "The page number is wrong.");
+                Assert.AreEqual(hits[i].Span.Start, pageHits[i].Span.Start, "The hit start address is wrong.");
+                Assert.AreEqual(hits[i].Span.End, pageHits[i].Span.End, "The hit end address is wrong.");
+            }
+
+            Assert.AreEqual(hits.Length, document.Search("Helvetica", true).Count(hit => hit.PageNumber == 0), "The document search results are wrong.");
+            Assert.ThrowsException<ArgumentNullException>(() => document.SearchPage(0, null), "Searching for a null string should throw an exception.");
+        }
+
+        [TestMethod]
+        public void MuPDFStructuredTextNativeCaseSensitiveSearchingWithMaxHits()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+            MemoryStream pdfStream = new MemoryStream();
+            pdfDataStream.CopyTo(pdfStream);
+
+            using MuPDFContext context = new MuPDFContext();
+            using MuPDFDocument document = new MuPDFDocument(context, ref pdfStream, InputFileTypes.PDF);
+
+            using MuPDFStructuredTextPage sTextPage = document.GetStructuredTextPage(0);
+
+            //The page contains both "R" (e.g., "Times-Roman") and "r" (e.g., "Courier"), and the first occurrence is upper-case.
+            MuPDFStructuredTextAddressSpan[] expected = sTextPage.Search(new System.Text.RegularExpressions.Regex("r")).ToArray();
+            int caseInsensitive = sTextPage.Search(new System.Text.RegularExpressions.Regex("(?i)r")).Count();
+
+            Assert.IsTrue(expected.Length > 1 && caseInsensitive > expected.Length, "The page does not contain both upper- and lower-case occurrences.");
+
+            for (int maxHits = 1; maxHits <= expected.Length + 1; maxHits++)
+            {
+                MuPDFTextSearchHit[] hits = sTextPage.Search("r", true, maxHits);
+
+                Assert.AreEqual(Math.Min(maxHits, expected.Length), hits.Length, "The maximum number of case-sensitive hits was not respected.");
+
+                for (int i = 0; i < hits.Length; i++)
+                {
+                    Assert.AreEqual(expected[i].Start, hits[i].Span.Start, "The hit start address is wrong.");
+                    Assert.AreEqual(expected[i].End, hits[i].Span.End, "The hit end address is wrong.");
+                }
+            }
+
+            Assert.AreEqual(Math.Min(3, expected.Length), document.SearchPage(0, "r", true, 3).Length, "The maximum number of case-sensitive page hits was not respected.");
+        }
+
         [TestMethod]
         public void MuPDFStructuredTextBlockMembers()
         {
@@ -0,0 +1,371 @@
+﻿using Microsoft.VisualStudio.TestTools.UnitTesting;
+using MuPDFCore;
+using MuPDFCore.StructuredText;
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text.RegularExpressions;
+
+#pragma warning disable IDE0090 // Use 'new(...)'
+
+namespace Tests
+{
+    [TestClass]
+    public class MuPDFTextIndexTests
+    {
+        [TestMethod]
+        public void MuPDFTextIndexCreationAndSearch()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+
+            string tempPdf = Path.GetTempFileName();
+            string tempIndex = Path.GetTempFileName();
+
+            using (FileStream fs = File.Create(tempPdf))
+            {
+                pdfDataStream.CopyTo(fs);
+            }
+
+            try
+            {
+                using MuPDFContext context = new MuPDFContext();
+
+                List<(int, MuPDFStructuredTextAddressSpan)> expected = new List<(int, MuPDFStructuredTextAddressSpan)>();
+
+                using (MuPDFDocument document = new MuPDFDocument(context, tempPdf))
+                {
+                    for (int i = 0; i < document.Pages.Count; i++)
+                    {
+                        using MuPDFStructuredTextPage sTextPage = document.GetStructuredTextPage(i);
+
+                        foreach (MuPDFStructuredTextAddressSpan span in sTextPage.Search(new Regex(@"(?i)(?<![\p{L}\p{N}])helvetica(?![\p{L}\p{N}])")))
+                        {
+                            expected.Add((i, span));
+                        }
+                    }
+                }
+
+                Assert.ThrowsException<InvalidDataException>(() => new MuPDFTextIndex(tempIndex), "Opening an invalid index should throw an exception.");
+
+                for (int repeat = 0; repeat < 2; repeat++)
+                {
+                    //The second time, the document is copied from the existing index.
+                    MuPDFTextIndex.Create(context, tempIndex, new string[] { tempPdf, tempPdf });
+
+                    using MuPDFTextIndex index = new MuPDFTextIndex(tempIndex);
+
+                    Assert.AreEqual(1, index.Documents.Count, "The number of indexed documents is wrong.");
+                    Assert.AreEqual(tempPdf, index.Documents[0].FileName, "The indexed file name is wrong.");
+                    Assert.AreEqual(64, index.Documents[0].ContentHash.Length, "The content hash is wrong.");
+                    Assert.IsTrue(index.TermCount > 0, "The index does not contain any terms.");
+
+                    MuPDFTextIndexHit[] hits = index.Search("HELVETICA");
+
+                    Assert.AreEqual(expected.Count, hits.Length, "The search results are wrong.");
+
+                    for (int i = 0; i < hits.Length; i++)
+                    {
+                        Assert.AreEqual(expected[i].Item1, hits[i].PageNumber, "The page number of the hit is wrong.");
+                        Assert.AreEqual(expected[i].Item2.Start, hits[i].Span.Start, "The hit start address is wrong.");
+                        Assert.AreEqual(expected[i].Item2.End, hits[i].Span.End, "The hit end address is wrong.");
+                    }
+
+                    Assert.AreEqual(0, index.Search("helveticahelvetica").Length, "A term that is not in the index has been found.");
+                    Assert.AreEqual(0, index.Search(" - ").Length, "A query without terms should not return any hits.");
+                }
+            }
+            finally
+            {
+                try
+                {
+                    File.Delete(tempPdf);
+                    File.Delete(tempIndex);
+                }
+                catch { }
+            }
+        }
+
+        [TestMethod]
+        public void MuPDFTextIndexPhraseSearch()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+
+            string tempPdf = Path.GetTempFileName();
+            string tempIndex = Path.GetTempFileName();
+
+            using (FileStream fs = File.Create(tempPdf))
+            {
+                pdfDataStream.CopyTo(fs);
+            }
+
+            try
+            {
+                using MuPDFContext context = new MuPDFContext();
+
+                List<(int, MuPDFStructuredTextAddressSpan)> expected = new List<(int, MuPDFStructuredTextAddressSpan)>();
+
+                using (MuPDFDocument document = new MuPDFDocument(context, tempPdf))
+                {
+                    for (int i = 0; i < document.Pages.Count; i++)
+                    {
+                        using MuPDFStructuredTextPage sTextPage = document.GetStructuredTextPage(i);
+
+                        foreach (MuPDFStructuredTextAddressSpan span in sTextPage.Search(new Regex(@"(?i)(?<![\p{L}\p{N}])side[^\p{L}\p{N}]+bearing(?![\p{L}\p{N}])")))
+                        {
+                            expected.Add((i, span));
+                        }
+                    }
+                }
+
+                Assert.IsTrue(expected.Count > 0, "The document does not contain the phrase.");
+
+                MuPDFTextIndex.Create(context, tempIndex, new string[] { tempPdf });
+
+                using MuPDFTextIndex index = new MuPDFTextIndex(tempIndex);
+
+                MuPDFTextIndexHit[] hits = index.Search("Side - Bearing");
+
+                Assert.AreEqual(expected.Count, hits.Length, "The phrase search results are wrong.");
+
+                for (int i = 0; i < hits.Length; i++)
+                {
+                    Assert.AreEqual(expected[i].Item1, hits[i].PageNumber, "The page number of the hit is wrong.");
+                    Assert.AreEqual(expected[i].Item2.Start, hits[i].Span.Start, "The hit start address is wrong.");
+                    Assert.AreEqual(expected[i].Item2.End, hits[i].Span.End, "The hit end address is wrong.");
+                }
+
+                Assert.IsTrue(index.Search("side").Length >= hits.Length && index.Search("bearing").Length >= hits.Length, "The terms of the phrase have not been found.");
+                Assert.AreEqual(0, index.Search("bearing side").Length, "A phrase whose terms are in the wrong order has been found.");
+            }
+            finally
+            {
+                try
+                {
+                    File.Delete(tempPdf);
+                    File.Delete(tempIndex);
+                }
+                catch { }
+            }
+        }
+
+        [TestMethod]
+        public void MuPDFTextIndexReuse()
+        {
+            string tempPdf = Path.GetTempFileName();
+            string tempPdf2 = Path.GetTempFileName();
+            string tempIndex = Path.GetTempFileName();
+
+            using (Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf"))
+            using (FileStream fs = File.Create(tempPdf))
+            {
+                pdfDataStream.CopyTo(fs);
+            }
+
+            using (Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Annotation.pdf"))
+            using (FileStream fs = File.Create(tempPdf2))
+            {
+                pdfDataStream.CopyTo(fs);
+            }
+
+            try
+            {
+                using MuPDFContext context = new MuPDFContext();
+
+                Assert.AreEqual(1, MuPDFTextIndex.CreateIndex(context, tempIndex, new string[] { tempPdf }, true), "The document was not indexed.");
+
+                MuPDFTextIndexHit[] expected;
+
+                using (MuPDFTextIndex index = new MuPDFTextIndex(tempIndex))
+                {
+                    Assert.IsTrue(index.IncludeAnnotations, "The annotation setting was not stored.");
+                    expected = index.Search("helvetica");
+                }
+
+                Assert.AreEqual(0, MuPDFTextIndex.CreateIndex(context, tempIndex, new string[] { tempPdf }, true), "The document was indexed again, instead of being copied from the existing index.");
+                Assert.AreEqual(1, MuPDFTextIndex.CreateIndex(context, tempIndex, new string[] { tempPdf, tempPdf2 }, true), "Only the new document should have been indexed.");
+
+                using (MuPDFTextIndex index = new MuPDFTextIndex(tempIndex))
+                {
+                    Assert.AreEqual(2, index.Documents.Count, "The number of indexed documents is wrong.");
+
+                    MuPDFTextIndexHit[] hits = index.Search("helvetica").Where(x => x.Document.Index == 0).ToArray();
+
+                    Assert.AreEqual(expected.Length, hits.Length, "The search results for the copied document are wrong.");
+
+                    for (int i = 0; i < hits.Length; i++)
+                    {
+                        Assert.AreEqual(expected[i].PageNumber, hits[i].PageNumber, "The page number of the hit is wrong.");
+                        Assert.AreEqual(expected[i].Span.Start, hits[i].Span.Start, "The hit start address is wrong.");
+                        Assert.AreEqual(expected[i].Span.End, hits[i].Span.End, "The hit end address is wrong.");
+                    }
+                }
+
+                //An index created with a different setting for the annotations cannot be reused.
+                Assert.AreEqual(2, MuPDFTextIndex.CreateIndex(context, tempIndex, new string[] { tempPdf, tempPdf2 }, false), "The documents should have been indexed again.");
+
+                using (MuPDFTextIndex index = new MuPDFTextIndex(tempIndex))
+                {
+                    Assert.IsFalse(index.IncludeAnnotations, "The annotation setting was not stored.");
+                }
+
+                Assert.AreEqual(0, MuPDFTextIndex.CreateIndex(context, tempIndex, new string[] { tempPdf, tempPdf2 }, false), "The documents were indexed again, instead of being copied from the existing index.");
+            }
+            finally
+            {
+                try
+                {
+                    File.Delete(tempPdf);
+                    File.Delete(tempPdf2);
+                    File.Delete(tempIndex);
+                }
+                catch { }
+            }
+        }
+
+        [TestMethod]
+        public void MuPDFTextIndexMergedRuns()
+        {
+            string tempPdf = Path.GetTempFileName();
+            string tempPdf2 = Path.GetTempFileName();
+            string tempIndex = Path.GetTempFileName();
+            string tempIndex2 = Path.GetTempFileName();
+
+            using (Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf"))
+            using (FileStream fs = File.Create(tempPdf))
+            {
+                pdfDataStream.CopyTo(fs);
+            }
+
+            using (Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Annotation.pdf"))
+            using (FileStream fs = File.Create(tempPdf2))
+            {
+                pdfDataStream.CopyTo(fs);
+            }
+
+            string[] queries = new string[] { "the", "helvetica", "a", "and", "annotation" };
+
+            static string GetKey(MuPDFTextIndexHit hit)
+            {
+                return hit.Document.FileName + "|" + hit.PageNumber.ToString() + "|" + hit.Span.Start.BlockIndex.ToString() + "," + hit.Span.Start.LineIndex.ToString() + "," + hit.Span.Start.CharacterIndex.ToString() + "|" + hit.Span.End.Value.BlockIndex.ToString() + "," + hit.Span.End.Value.LineIndex.ToString() + "," + hit.Span.End.Value.CharacterIndex.ToString();
+            }
+
+            try
+            {
+                using MuPDFContext context = new MuPDFContext();
+
+                Assert.AreEqual(2, MuPDFTextIndex.CreateIndex(context, tempIndex, new string[] { tempPdf, tempPdf2 }, true), "The documents were not indexed.");
+
+                //Each document is written to a separate run, and the runs are merged.
+                Assert.AreEqual(2, MuPDFTextIndex.CreateIndex(context, tempIndex2, new string[] { tempPdf, tempPdf2 }, true, 1), "The documents were not indexed.");
+
+                using (MuPDFTextIndex index = new MuPDFTextIndex(tempIndex))
+                using (MuPDFTextIndex index2 = new MuPDFTextIndex(tempIndex2))
+                {
+                    Assert.AreEqual(index.TermCount, index2.TermCount, "The number of terms in the merged index is wrong.");
+
+                    int totalHits = 0;
+
+                    foreach (string query in queries)
+                    {
+                        string[] hits = index.Search(query).Select(GetKey).ToArray();
+                        CollectionAssert.AreEqual(hits, index2.Search(query).Select(GetKey).ToArray(), "The search results of the merged index are wrong.");
+                        totalHits += hits.Length;
+                    }
+
+                    Assert.IsTrue(totalHits > 0, "The queries did not return any hits.");
+                }
+
+                //The documents are renumbered while their postings are copied from the existing index.
+                Assert.AreEqual(0, MuPDFTextIndex.CreateIndex(context, tempIndex2, new string[] { tempPdf2, tempPdf }, true, 1), "The documents were indexed again, instead of being copied from the existing index.");
+
+                using (MuPDFTextIndex index = new MuPDFTextIndex(tempIndex))
+                using (MuPDFTextIndex index2 = new MuPDFTextIndex(tempIndex2))
+                {
+                    Assert.AreEqual(tempPdf2, index2.Documents[0].FileName, "The documents were not renumbered.");
+                    Assert.AreEqual(index.TermCount, index2.TermCount, "The number of terms in the copied index is wrong.");
+
+                    foreach (string query in queries)
+                    {
+                        MuPDFTextIndexHit[] hits2 = index2.Search(query);
+
+                        CollectionAssert.AreEquivalent(index.Search(query).Select(GetKey).ToArray(), hits2.Select(GetKey).ToArray(), "The search results of the copied index are wrong.");
+                        CollectionAssert.AreEqual(hits2.Select(x => x.Document.Index).OrderBy(x => x).ToArray(), hits2.Select(x => x.Document.Index).ToArray(), "The search results are not sorted by document.");
+                    }
+                }
+
+                Assert.IsFalse(Directory.GetFiles(Path.GetDirectoryName(tempIndex2)).Any(x => x.StartsWith(tempIndex2 + ".")), "Temporary files were left behind.");
+            }
+            finally
+            {
+                try
+                {
+                    File.Delete(tempPdf);
+                    File.Delete(tempPdf2);
+                    File.Delete(tempIndex);
+                    File.Delete(tempIndex2);
+                }
+                catch { }
+            }
+        }
+
+        [TestMethod]
+        public void MuPDFTextIndexCorruptFile()
+        {
+            using Stream pdfDataStream = System.Reflection.Assembly.GetExecutingAssembly().GetManifestResourceStream("Tests.Data.Sample.pdf");
+
+            string tempPdf = Path.GetTempFileName();
+            string tempIndex = Path.GetTempFileName();
+            string corruptIndex = Path.GetTempFileName();
+
+            using (FileStream fs = File.Create(tempPdf))
+            {
+                pdfDataStream.CopyTo(fs);
+            }
+
+            try
+            {
+                using MuPDFContext context = new MuPDFContext();
+
+                MuPDFTextIndex.Create(context, tempIndex, new string[] { tempPdf });
+
+                byte[] data = File.ReadAllBytes(tempIndex);
+
+                //Truncated file: the strings are outside of the file.
+                File.WriteAllBytes(corruptIndex, data.Take(data.Length - 1).ToArray());
+                Assert.ThrowsException<InvalidDataException>(() => new MuPDFTextIndex(corruptIndex), "Opening a truncated index should throw an exception.");
+
+                long termsOffset = BitConverter.ToInt64(data, 24);
+                long postingsOffset = BitConverter.ToInt64(data, 32);
+
+                //The postings of the first term are outside of the postings section.
+                byte[] corrupt = (byte[])data.Clone();
+                BitConverter.GetBytes(long.MaxValue / 2).CopyTo(corrupt, termsOffset + 16);
+                File.WriteAllBytes(corruptIndex, corrupt);
+                Assert.ThrowsException<InvalidDataException>(() => new MuPDFTextIndex(corruptIndex), "Opening an index with an invalid posting offset should throw an exception.");
+
+                //The name of the first document is outside of the strings section.
+                corrupt = (byte[])data.Clone();
+                BitConverter.GetBytes(int.MaxValue).CopyTo(corrupt, 64 + 36);
+                File.WriteAllBytes(corruptIndex, corrupt);
+                Assert.ThrowsException<InvalidDataException>(() => new MuPDFTextIndex(corruptIndex), "Opening an index with an invalid document name should throw an exception.");
+
+                //The first posting refers to a document that does not exist.
+                corrupt = (byte[])data.Clone();
+                BitConverter.GetBytes(7).CopyTo(corrupt, postingsOffset);
+                File.WriteAllBytes(corruptIndex, corrupt);
+                Assert.ThrowsException<InvalidDataException>(() => new MuPDFTextIndex(corruptIndex), "Opening an index with an invalid posting should throw an exception.");
+            }
+            finally
+            {
+                try
+                {
+                    File.Delete(tempPdf);
+                    File.Delete(tempIndex);
+                    File.Delete(corruptIndex);
+                }
+                catch { }
+            }
+        }
+    }
+}
@@ -62,6 +62,24 @@ namespace Tests
             Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "DisposeContext returned the wrong exit code.");
         }
 
+        [TestMethod]
+        public void ContextCreationWithPoolAllocator()
+        {
+            IntPtr nativeContext = IntPtr.Zero;
+
+            int result = NativeMethods.CreateContextWithAllocator(256 << 20, (int)NativeAllocators.Pool, ref nativeContext);
+
+            Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "CreateContextWithAllocator returned the wrong exit code.");
+            Assert.AreNotEqual(IntPtr.Zero, nativeContext, "The native context pointer is null.");
+
+            try
+            {
+                _ = NativeMethods.DisposeContext(nativeContext);
+                NativeMethods.ReleasePooledMemory();
+            }
+            catch { }
+        }
+
         [TestMethod]
         public void ContextCloning()
         {
@@ -85,6 +103,31 @@ namespace Tests
             _ = NativeMethods.DisposeContext(nativeContext);
         }
 
+        [TestMethod]
+        public void ContextDisposalBeforeClones()
+        {
+            IntPtr nativeContext = IntPtr.Zero;
+            _ = NativeMethods.CreateContext(256 << 20, ref nativeContext);
+
+            IntPtr[] contexts = new IntPtr[2];
+            GCHandle contextsHandle = GCHandle.Alloc(contexts, GCHandleType.Pinned);
+
+            _ = NativeMethods.CloneContext(nativeContext, 2, contextsHandle.AddrOfPinnedObject());
+
+            //The lock table is shared between the original context and its clones, so it must outlive the original context.
+            int result = NativeMethods.DisposeContext(nativeContext);
+            Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "DisposeContext returned the wrong exit code.");
+
+            for (int i = 0; i < contexts.Length; i++)
+            {
+                NativeMethods.EmptyStore(contexts[i]);
+                result = NativeMethods.DisposeContext(contexts[i]);
+                Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "DisposeContext returned the wrong exit code.");
+            }
+
+            contextsHandle.Free();
+        }
+
         [TestMethod]
         public void CurrentStoreSizeGetter()
         {
@@ -212,7 +255,7 @@ namespace Tests
 
             _ = NativeMethods.CreateContext(256 << 20, ref nativeContext);
 
-            int result = NativeMethods.CreateDocumentFromStream(nativeContext, dataAddress, dataLength, ".pdf", 0, ref nativeDocument, ref nativeStream, ref pageCount, ref xRes, ref yRes);
+            int result = NativeMethods.CreateDocumentFromStream(nativeContext, dataAddress, dataLength, ".pdf", 0, 595, 842, 11, 1, ref nativeDocument, ref nativeStream, ref pageCount, ref xRes, ref yRes);
 
             Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "CreateDocumentFromStream returned the wrong exit code.");
             Assert.AreNotEqual(IntPtr.Zero, nativeDocument, "The native document pointer is null.");
@@ -289,7 +332,7 @@ namespace Tests
 
             _ = NativeMethods.CreateContext(256 << 20, ref nativeContext);
 
-            int result = NativeMethods.CreateDocumentFromStream(nativeContext, dataAddress, dataLength, ".png", 1, ref nativeDocument, ref nativeStream, ref pageCount, ref xRes, ref yRes);
+            int result = NativeMethods.CreateDocumentFromStream(nativeContext, dataAddress, dataLength, ".png", 1, 595, 842, 11, 1, ref nativeDocument, ref nativeStream, ref pageCount, ref xRes, ref yRes);
 
             Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "CreateDocumentFromStream returned the wrong exit code.");
             Assert.AreNotEqual(IntPtr.Zero, nativeDocument, "The native document pointer is null.");
@@ -331,7 +374,7 @@ namespace Tests
 
             _ = NativeMethods.CreateContext(256 << 20, ref nativeContext);
 
-            _ = NativeMethods.CreateDocumentFromStream(nativeContext, dataAddress, dataLength, ".pdf", 0, ref nativeDocument, ref nativeStream, ref pageCount, ref xRes, ref yRes);
+            _ = NativeMethods.CreateDocumentFromStream(nativeContext, dataAddress, dataLength, ".pdf", 0, 595, 842, 11, 1, ref nativeDocument, ref nativeStream, ref pageCount, ref xRes, ref yRes);
 
             return (dataHandle, ms, nativeContext, nativeDocument, nativeStream);
         }
@@ -358,7 +401,7 @@ namespace Tests
 
             _ = NativeMethods.CreateContext(256 << 20, ref nativeContext);
 
-            _ = NativeMethods.CreateDocumentFromStream(nativeContext, dataAddress, dataLength, ".png", 0, ref nativeDocument, ref nativeStream, ref pageCount, ref xRes, ref yRes);
+            _ = NativeMethods.CreateDocumentFromStream(nativeContext, dataAddress, dataLength, ".png", 0, 595, 842, 11, 1, ref nativeDocument, ref nativeStream, ref pageCount, ref xRes, ref yRes);
 
             return (dataHandle, ms, nativeContext, nativeDocument, nativeStream);
         }
@@ -525,6 +568,45 @@ namespace Tests
             catch { }
         }
 
+        [TestMethod]
+        public void DisplayListCreationWithoutBounds()
+        {
+            IntPtr nativeDisplayList = IntPtr.Zero;
+
+            float x0 = -1;
+            float y0 = -1;
+            float x1 = -1;
+            float y1 = -1;
+
+            (GCHandle dataHandle, MemoryStream ms, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext, float _, float _, float _, float _) = CreateSamplePage();
+
+            int result = NativeMethods.CreateDisplayList(nativeContext, nativePage, 1, ref nativeDisplayList);
+
+            Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "CreateDisplayList returned the wrong exit code.");
+            Assert.AreNotEqual(IntPtr.Zero, nativeDisplayList, "The native display list pointer is null.");
+
+            result = NativeMethods.GetDisplayListBounds(nativeContext, nativeDisplayList, ref x0, ref y0, ref x1, ref y1);
+
+            Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "GetDisplayListBounds returned the wrong exit code.");
+            Assert.AreEqual(0, x0, "The display list left coordinate is wrong.");
+            Assert.AreEqual(0, y0, "The display list top coordinate is wrong.");
+            Assert.AreEqual(4000, x1, "The display list right is wrong.");
+            Assert.AreEqual(2600, y1, "The display list bottom is wrong.");
+
+            try
+            {
+                dataHandle.Free();
+                ms.Dispose();
+
+                _ = NativeMethods.DisposeDisplayList(nativeContext, nativeDisplayList);
+                _ = NativeMethods.DisposePage(nativeContext, nativePage);
+                _ = NativeMethods.DisposeDocument(nativeContext, nativeDocument);
+                _ = NativeMethods.DisposeStream(nativeContext, nativeStream);
+                _ = NativeMethods.DisposeContext(nativeContext);
+            }
+            catch { }
+        }
+
         private static (GCHandle dataHandle, MemoryStream ms, IntPtr nativeDisplayList, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext, float x0, float y0, float x1, float y1) CreateSampleDisplayList(string resource = "Tests.Data.Sample.pdf")
         {
             IntPtr nativeDisplayList = IntPtr.Zero;
@@ -589,7 +671,7 @@ namespace Tests
 
             (GCHandle dataHandle, MemoryStream ms, IntPtr nativeDisplayList, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext, float x0, float y0, float x1, float y1) = CreateSampleDisplayList();
 
-            int result = NativeMethods.RenderSubDisplayList(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 0, bufferPointer, IntPtr.Zero);
+            int result = NativeMethods.RenderSubDisplayList(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 0, bufferPointer, 0, 0, 0, 0, 0, IntPtr.Zero);
 
             Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "RenderSubDisplayList returned the wrong exit code.");
 
@@ -622,7 +704,7 @@ namespace Tests
 
             (GCHandle dataHandle, MemoryStream ms, IntPtr nativeDisplayList, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext, float x0, float y0, float x1, float y1) = CreateSampleDisplayList();
 
-            int result = NativeMethods.RenderSubDisplayList(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 3, bufferPointer, IntPtr.Zero);
+            int result = NativeMethods.RenderSubDisplayList(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 3, bufferPointer, 0, 0, 0, 0, 0, IntPtr.Zero);
 
             Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "RenderSubDisplayList returned the wrong exit code.");
 
@@ -644,6 +726,60 @@ namespace Tests
             catch { }
         }
 
+        [TestMethod]
+        public void SubDisplayListRenderingBGRAUnpremultiplied()
+        {
+            int bufferSize = 4000 * 2600 * 4;
+            byte[] premultiplied = new byte[bufferSize];
+            byte[] buffer = new byte[bufferSize];
+
+            GCHandle premultipliedHandle = GCHandle.Alloc(premultiplied, GCHandleType.Pinned);
+            GCHandle bufferHandle = GCHandle.Alloc(buffer, GCHandleType.Pinned);
+
+            (GCHandle dataHandle, MemoryStream ms, IntPtr nativeDisplayList, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext, float x0, float y0, float x1, float y1) = CreateSampleDisplayList();
+
+            int result = NativeMethods.RenderSubDisplayList(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 3, premultipliedHandle.AddrOfPinnedObject(), 0, 0, 0, 0, 0, IntPtr.Zero);
+            Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "RenderSubDisplayList returned the wrong exit code.");
+
+            result = NativeMethods.RenderSubDisplayList(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 3, bufferHandle.AddrOfPinnedObject(), (int)RenderFlags.Unpremultiply, 0, 0, 0, 0, IntPtr.Zero);
+            Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "RenderSubDisplayList returned the wrong exit code.");
+
+            CollectionAssert.AreEqual(new byte[] { 0xFF, 0x73, 0x17, 0x0B }, buffer[0..4], "The start of the rendered image appears to be wrong.");
+            CollectionAssert.AreEqual(new byte[] { 0xFF, 0x73, 0x17, 0x0B }, buffer[^4..^0], "The end of the rendered image appears to be wrong.");
+
+            for (int i = 0; i < bufferSize; i += 4)
+            {
+                byte alpha = premultiplied[i + 3];
+
+                for (int j = 0; j < 3; j++)
+                {
+                    byte expected = alpha > 0 ? (byte)(premultiplied[i + j] * 255 / alpha) : premultiplied[i + j];
+
+                    if (buffer[i + j] != expected)
+                    {
+                        Assert.Fail("The un-premultiplied value of pixel " + (i / 4).ToString() + " is wrong.");
+                    }
+                }
+
+                Assert.AreEqual(alpha, buffer[i + 3], "The alpha value of pixel " + (i / 4).ToString() + " is wrong.");
+            }
+
+            try
+            {
+                premultipliedHandle.Free();
+                bufferHandle.Free();
+                dataHandle.Free();
+                ms.Dispose();
+
+                _ = NativeMethods.DisposeDisplayList(nativeContext, nativeDisplayList);
+                _ = NativeMethods.DisposePage(nativeContext, nativePage);
+                _ = NativeMethods.DisposeDocument(nativeContext, nativeDocument);
+                _ = NativeMethods.DisposeStream(nativeContext, nativeStream);
+                _ = NativeMethods.DisposeContext(nativeContext);
+            }
+            catch { }
+        }
+
         private static (GCHandle bufferHandle, GCHandle dataHandle, MemoryStream ms, IntPtr nativeDisplayList, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext) RenderSampleDisplayList()
         {
             int bufferSize = 4000 * 2600 * 3;
@@ -654,7 +790,7 @@ namespace Tests
 
             (GCHandle dataHandle, MemoryStream ms, IntPtr nativeDisplayList, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext, float x0, float y0, float x1, float y1) = CreateSampleDisplayList();
 
-            _ = NativeMethods.RenderSubDisplayList(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 0, bufferPointer, IntPtr.Zero);
+            _ = NativeMethods.RenderSubDisplayList(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 0, bufferPointer, 0, 0, 0, 0, 0, IntPtr.Zero);
 
 
             return (bufferHandle, dataHandle, ms, nativeDisplayList, nativePage, nativeDocument, nativeStream, nativeContext);
@@ -1105,6 +1241,57 @@ namespace Tests
             catch { }
         }
 
+        [TestMethod]
+        public void ImageWritingToStream()
+        {
+            IntPtr outputBuffer = IntPtr.Zero;
+            IntPtr outputData = IntPtr.Zero;
+            ulong outputDataLength = 0;
+
+            (GCHandle dataHandle, MemoryStream ms, IntPtr nativeDisplayList, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext, float x0, float y0, float x1, float y1) = CreateSampleDisplayList();
+
+            _ = NativeMethods.WriteImage(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 0, 2, 90, ref outputBuffer, ref outputData, ref outputDataLength);
+
+            byte[] expectedBytes = new byte[(int)outputDataLength];
+            Marshal.Copy(outputData, expectedBytes, 0, expectedBytes.Length);
+
+            using MemoryStream outputStream = new MemoryStream();
+            int chunkCount = 0;
+
+            NativeMethods.WriteCallback callback = (data, length) =>
+            {
+                byte[] chunk = new byte[(int)length];
+                Marshal.Copy(data, chunk, 0, chunk.Length);
+                outputStream.Write(chunk, 0, chunk.Length);
+                chunkCount++;
+                return 0;
+            };
+
+            int result = NativeMethods.WriteImageToStream(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 0, 2, 90, callback);
+
+            Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "WriteImageToStream returned the wrong exit code.");
+            Assert.IsTrue(chunkCount > 0, "The callback was not invoked.");
+            CollectionAssert.AreEqual(expectedBytes, outputStream.ToArray(), "The data written to the stream is different from the data written to the buffer.");
+
+            result = NativeMethods.WriteImageToStream(nativeContext, nativeDisplayList, x0, y0, x1, y1, 1, 0, 2, 90, (data, length) => 1);
+
+            Assert.AreEqual((int)ExitCodes.ERR_CANNOT_SAVE, result, "WriteImageToStream returned the wrong exit code when the callback failed.");
+
+            try
+            {
+                dataHandle.Free();
+                ms.Dispose();
+
+                _ = NativeMethods.DisposeBuffer(nativeContext, outputBuffer);
+                _ = NativeMethods.DisposeDisplayList(nativeContext, nativeDisplayList);
+                _ = NativeMethods.DisposePage(nativeContext, nativePage);
+                _ = NativeMethods.DisposeDocument(nativeContext, nativeDocument);
+                _ = NativeMethods.DisposeStream(nativeContext, nativeStream);
+                _ = NativeMethods.DisposeContext(nativeContext);
+            }
+            catch { }
+        }
+
         [TestMethod]
         public void BufferDisposal()
         {
@@ -1666,6 +1853,43 @@ namespace Tests
             catch { }
         }
 
+        [TestMethod]
+        public void StructuredTextPageDataGetter()
+        {
+            (GCHandle dataHandle, MemoryStream ms, IntPtr nativeSTextPage, int _, IntPtr nativeDisplayList, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext) = CreateSampleStructuredTextPage();
+
+            IntPtr data = IntPtr.Zero;
+            long length = 0;
+
+            int result = NativeMethods.GetStructuredTextPageData(nativeContext, nativeSTextPage, ref data, ref length);
+
+            Assert.AreEqual((int)ExitCodes.EXIT_SUCCESS, result, "GetStructuredTextPageData returned the wrong exit code.");
+            Assert.AreNotEqual(IntPtr.Zero, data, "The structured text data pointer is zero!");
+
+            StructuredTextPageDataHeader header = Marshal.PtrToStructure<StructuredTextPageDataHeader>(data);
+
+            Assert.AreEqual(StructuredTextPageDataHeader.SupportedVersion, header.Version, "The structured text data has the wrong version.");
+            Assert.IsTrue(header.BlockCount > 0, "The structured text data does not contain any text blocks.");
+            Assert.IsTrue(header.LineCount >= header.BlockCount, "The structured text data contains too few lines.");
+            Assert.IsTrue(header.CharCount >= header.LineCount, "The structured text data contains too few characters.");
+            Assert.IsTrue(header.FontCount > 0 && header.FontCount <= header.CharCount, "The structured text data contains the wrong number of fonts.");
+            Assert.IsTrue(header.CharQuads + header.CharCount * 8 * sizeof(float) <= length, "The structured text data arrays exceed the buffer length.");
+
+            try
+            {
+                NativeMethods.DisposeStructuredTextPageData(nativeContext, data);
+                dataHandle.Free();
+                ms.Dispose();
+                _ = NativeMethods.DisposeStructuredTextPage(nativeContext, nativeSTextPage);
+                _ = NativeMethods.DisposeDisplayList(nativeContext, nativeDisplayList);
+                _ = NativeMethods.DisposePage(nativeContext, nativePage);
+                _ = NativeMethods.DisposeDocument(nativeContext, nativeDocument);
+                _ = NativeMethods.DisposeStream(nativeContext, nativeStream);
+                _ = NativeMethods.DisposeContext(nativeContext);
+            }
+            catch { }
+        }
+
         private static (GCHandle blocksHandle, GCHandle dataHandle, MemoryStream ms, IntPtr[] blockPointers, IntPtr nativeSTextPage, IntPtr nativeDisplayList, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext) CreateSampleStructuredTextBlocks()
         {
             (GCHandle dataHandle, MemoryStream ms, IntPtr nativeSTextPage, int sTextBlockCount, IntPtr nativeDisplayList, IntPtr nativePage, IntPtr nativeDocument, IntPtr nativeStream, IntPtr nativeContext) = CreateSampleStructuredTextPage();
@@ -136,6 +136,71 @@ namespace Tests
             Assert.AreEqual(100, splitSize[6].Y1, "The split coordinate 6.Y1 is wrong.");
         }
 
+        [TestMethod]
+        public void SizeSplittingIn11Horiz()
+        {
+            Size size = new Size(220, 100);
+
+            Rectangle[] splitSize = size.Split(11);
+
+            Assert.AreEqual(11, splitSize.Length, "The number of split rectangles is wrong.");
+
+            Assert.AreEqual(0, splitSize[0].X0, "The split coordinate 0.X0 is wrong.");
+            Assert.AreEqual(0, splitSize[0].Y0, "The split coordinate 0.Y0 is wrong.");
+            Assert.AreEqual(40, splitSize[0].X1, "The split coordinate 0.X1 is wrong.");
+            Assert.AreEqual(50, splitSize[0].Y1, "The split coordinate 0.Y1 is wrong.");
+
+            Assert.AreEqual(0, splitSize[1].X0, "The split coordinate 1.X0 is wrong.");
+            Assert.AreEqual(50, splitSize[1].Y0, "The split coordinate 1.Y0 is wrong.");
+            Assert.AreEqual(40, splitSize[1].X1, "The split coordinate 1.X1 is wrong.");
+            Assert.AreEqual(100, splitSize[1].Y1, "The split coordinate 1.Y1 is wrong.");
+
+            Assert.AreEqual(40, splitSize[2].X0, "The split coordinate 2.X0 is wrong.");
+            Assert.AreEqual(0, splitSize[2].Y0, "The split coordinate 2.Y0 is wrong.");
+            Assert.AreEqual(80, splitSize[2].X1, "The split coordinate 2.X1 is wrong.");
+            Assert.AreEqual(50, splitSize[2].Y1, "The split coordinate 2.Y1 is wrong.");
+
+            Assert.AreEqual(40, splitSize[3].X0, "The split coordinate 3.X0 is wrong.");
+            Assert.AreEqual(50, splitSize[3].Y0, "The split coordinate 3.Y0 is wrong.");
+            Assert.AreEqual(80, splitSize[3].X1, "The split coordinate 3.X1 is wrong.");
+            Assert.AreEqual(100, splitSize[3].Y1, "The split coordinate 3.Y1 is wrong.");
+
+            Assert.AreEqual(80, splitSize[4].X0, "The split coordinate 4.X0 is wrong.");
+            Assert.AreEqual(0, splitSize[4].Y0, "The split coordinate 4.Y0 is wrong.");
+            Assert.AreEqual(120, splitSize[4].X1, "The split coordinate 4.X1 is wrong.");
+            Assert.AreEqual(50, splitSize[4].Y1, "The split coordinate 4.Y1 is wrong.");
+
+            Assert.AreEqual(80, splitSize[5].X0, "The split coordinate 5.X0 is wrong.");
+            Assert.AreEqual(50, splitSize[5].Y0, "The split coordinate 5.Y0 is wrong.");
+            Assert.AreEqual(120, splitSize[5].X1, "The split coordinate 5.X1 is wrong.");
+            Assert.AreEqual(100, splitSize[5].Y1, "The split coordinate 5.Y1 is wrong.");
+
+            Assert.AreEqual(120, splitSize[6].X0, "The split coordinate 6.X0 is wrong.");
+            Assert.AreEqual(0, splitSize[6].Y0, "The split coordinate 6.Y0 is wrong.");
+            Assert.AreEqual(160, splitSize[6].X1, "The split coordinate 6.X1 is wrong.");
+            Assert.AreEqual(50, splitSize[6].Y1, "The split coordinate 6.Y1 is wrong.");
+
+            Assert.AreEqual(120, splitSize[7].X0, "The split coordinate 7.X0 is wrong.");
+            Assert.AreEqual(50, splitSize[7].Y0, "The split coordinate 7.Y0 is wrong.");
+            Assert.AreEqual(160, splitSize[7].X1, "The split coordinate 7.X1 is wrong.");
+            Assert.AreEqual(100, splitSize[7].Y1, "The split coordinate 7.Y1 is wrong.");
+
+            Assert.AreEqual(160, splitSize[8].X0, "The split coordinate 8.X0 is wrong.");
+            Assert.AreEqual(0, splitSize[8].Y0, "The split coordinate 8.Y0 is wrong.");
+            Assert.AreEqual(200, splitSize[8].X1, "The split coordinate 8.X1 is wrong.");
+            Assert.AreEqual(50, splitSize[8].Y1, "The split coordinate 8.Y1 is wrong.");
+
+            Assert.AreEqual(160, splitSize[9].X0, "The split coordinate 9.X0 is wrong.");
+            Assert.AreEqual(50, splitSize[9].Y0, "The split coordinate 9.Y0 is wrong.");
+            Assert.AreEqual(200, splitSize[9].X1, "The split coordinate 9.X1 is wrong.");
+            Assert.AreEqual(100, splitSize[9].Y1, "The split coordinate 9.Y1 is wrong.");
+
+            Assert.AreEqual(200, splitSize[10].X0, "The split coordinate 10.X0 is wrong.");
+            Assert.AreEqual(0, splitSize[10].Y0, "The split coordinate 10.Y0 is wrong.");
+            Assert.AreEqual(220, splitSize[10].X1, "The split coordinate 10.X1 is wrong.");
+            Assert.AreEqual(100, splitSize[10].Y1, "The split coordinate 10.Y1 is wrong.");
+        }
+
         [TestMethod]
         public void SizeSplittingIn3Vert()
         {
@@ -517,6 +582,29 @@ namespace Tests
             Assert.AreEqual(100, splitSize[6].X1, "The split coordinate 6.X1 is wrong.");
         }
 
+        [TestMethod]
+        public void RoundedSizeSplittingInAnyNumber()
+        {
+            RoundedSize size = new RoundedSize(4000, 2600);
+
+            for (int divisions = 1; divisions <= 64; divisions++)
+            {
+                RoundedRectangle[] splitSize = size.Split(divisions);
+
+                Assert.AreEqual(divisions, splitSize.Length, "The number of split rectangles is wrong for " + divisions.ToString() + " divisions.");
+
+                long area = 0;
+
+                for (int i = 0; i < splitSize.Length; i++)
+                {
+                    Assert.IsTrue(splitSize[i].X0 >= 0 && splitSize[i].Y0 >= 0 && splitSize[i].X1 <= size.Width && splitSize[i].Y1 <= size.Height, "Split rectangle " + i.ToString() + " is out of bounds for " + divisions.ToString() + " divisions.");
+                    area += (long)splitSize[i].Width * splitSize[i].Height;
+                }
+
+                Assert.AreEqual((long)size.Width * size.Height, area, "The split rectangles do not cover the whole area for " + divisions.ToString() + " divisions.");
+            }
+        }
+
         [TestMethod]
         public void RectangleWidthHeight()
         {
@@ -11,6 +11,9 @@ extern "C"
 #include <stdio.h>
 #include <stdlib.h>
 #include <mutex>
+#include <atomic>
+#include <math.h>
+#include <string.h>
 
 #include "MuPDFWrapper.h"
 #include <iostream>
@@ -23,6 +26,8 @@ extern "C"
 	#include <unistd.h>
 	#include <sys/socket.h>
 	#include <sys/un.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
 #endif
 
 
@@ -120,6 +125,65 @@ new_pixmap_from_display_list_with_separations_bbox(fz_context* ctx, fz_display_l
 	return pix;
 }
 
+//Run a page through a device, including or excluding annotations and widgets.
+void run_page_with_annotations(fz_context* ctx, fz_page* page, int annotations, fz_device* dev, fz_matrix ctm, fz_cookie* cookie)
+{
+	if (annotations == 1)
+	{
+		fz_run_page(ctx, page, dev, ctm, cookie);
+	}
+	else
+	{
+		fz_run_page_contents(ctx, page, dev, ctm, cookie);
+	}
+}
+
+//Render a page straight into a draw device, without recording a display list. If pixel_storage is NULL, the pixmap allocates its own samples.
+fz_pixmap*
+new_pixmap_from_page_with_bbox_and_data(fz_context* ctx, fz_page* page, int annotations, fz_irect bbox, fz_matrix ctm, fz_colorspace* cs, int alpha, unsigned char* pixel_storage, fz_cookie* cookie)
+{
+	fz_pixmap* pix;
+	fz_device* dev = NULL;
+
+	fz_var(dev);
+
+	if (pixel_storage != NULL)
+	{
+		pix = new_pixmap_with_bbox_and_data(ctx, cs, bbox, NULL, alpha, pixel_storage);
+	}
+	else
+	{
+		pix = fz_new_pixmap_with_bbox(ctx, cs, bbox, NULL, alpha);
+	}
+
+	if (alpha)
+		fz_clear_pixmap(ctx, pix);
+	else
+		fz_clear_pixmap_with_value(ctx, pix, 0xFF);
+
+	fz_try(ctx)
+	{
+		dev = fz_new_draw_device(ctx, fz_identity, pix);
+		run_page_with_annotations(ctx, page, annotations, dev, ctm, cookie);
+		fz_close_device(ctx, dev);
+	}
+	fz_always(ctx)
+	{
+		fz_drop_device(ctx, dev);
+	}
+	fz_catch(ctx)
+	{
+		fz_drop_pixmap(ctx, pix);
+		fz_rethrow(ctx);
+	}
+
+	return pix;
+}
+
+//Mutex used for FZ_LOCK_FREETYPE by all contexts. MuPDF uses this lock to protect the global HarfBuzz allocator state, which is shared by every context
+//in the process, so it cannot be part of the per-context lock table.
+static std::mutex freetype_mutex;
+
 void lock_mutex(void* user, int lock)
 {
 	mutex_holder* mutex = (mutex_holder*)user;
@@ -130,7 +194,7 @@ void lock_mutex(void* user, int lock)
 		mutex->mutex0.lock();
 		break;
 	case 1:
-		mutex->mutex1.lock();
+		freetype_mutex.lock();
 		break;
 	case 2:
 		mutex->mutex2.lock();
@@ -151,7 +215,7 @@ void unlock_mutex(void* user, int lock)
 		mutex->mutex0.unlock();
 		break;
 	case 1:
-		mutex->mutex1.unlock();
+		freetype_mutex.unlock();
 		break;
 	case 2:
 		mutex->mutex2.unlock();
@@ -162,605 +226,2659 @@ void unlock_mutex(void* user, int lock)
 	}
 }
 
-extern "C"
-{
-	DLL_PUBLIC void GetLocationFromUri(fz_context* ctx, fz_document* doc, const char* uri, int* out_chapter, int* out_page, float* out_x, float* out_y)
-	{
-		fz_location loc;
-
-		loc = fz_resolve_link(ctx, doc, uri, out_x, out_y);
+//Size classes used by the pooled allocator. Requests larger than the largest class bypass the pool.
+static const size_t pool_size_classes[] = { 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192, 12288, 16384, 24576, 32768 };
+#define POOL_CLASS_COUNT ((int)(sizeof(pool_size_classes) / sizeof(pool_size_classes[0])))
+#define POOL_LARGE_BLOCK POOL_CLASS_COUNT
 
-		*out_chapter = loc.chapter;
-		*out_page = loc.page;
-	}
+//Maximum number of bytes of free blocks that each thread keeps in each size class.
+#define POOL_MAX_CACHED_BYTES (256 << 10)
 
-	DLL_PUBLIC int GetPageNumber(fz_context *ctx, fz_document *doc, int chapter, int page)
-	{
-		return fz_page_number_from_location(ctx, doc, fz_make_location(chapter, page));
-	}
+//Header stored in front of every block allocated by the pool. It is as large as the strictest alignment, so that the payload is suitably aligned.
+union pool_block_header
+{
+	//The size class of a block in use.
+	int size_class;
 
-	DLL_PUBLIC void ActivateLinkSetOCGState(fz_context *ctx, pdf_document *doc, fz_link *link)
-	{
-		pdf_activate_link_set_ocg_state(ctx, doc, link);
-	}
+	//The next free block, for blocks in a free list.
+	pool_block_header* next;
 
-	DLL_PUBLIC int IsLinkHidden(fz_context *ctx, const char *usage, fz_link* link)
-	{
-		return pdf_is_link_hidden(ctx, usage, link);
-	}
+	max_align_t align;
+};
 
-	DLL_PUBLIC void LoadLink(fz_context* ctx, fz_document* doc, fz_link* link, int uri_length, int isPDF, float* out_x0, float* out_y0, float* out_x1, float* out_y1, char* out_uri, int* out_is_external, int* out_is_setocgstate, int* out_dest_type, float* out_dest_x, float* out_dest_y,float* out_dest_w, float* out_dest_h, float* out_dest_zoom, int* out_dest_chapter, int* out_dest_page)
-	{
-		*out_x0 = link->rect.x0;
-		*out_y0 = link->rect.y0;
-		*out_x1 = link->rect.x1;
-		*out_y1 = link->rect.y1;
-		strncpy(out_uri, link->uri, uri_length);
+//Free blocks cached by a thread. This is deliberately trivially destructible, so that it can still be accessed during thread shutdown.
+struct pool_thread_cache
+{
+	pool_block_header* free_lists[POOL_CLASS_COUNT];
+	size_t cached_bytes[POOL_CLASS_COUNT];
+	bool released;
+};
 
-		int isExternal = fz_is_external_link(ctx, link->uri);
-		*out_is_external = isExternal;
+static thread_local pool_thread_cache pool_cache;
 
-		int isSetOCGState = 0;
+//Return the cached blocks of the calling thread to the system.
+static void pool_release_cache()
+{
+	for (int i = 0; i < POOL_CLASS_COUNT; i++)
+	{
+		pool_block_header* block = pool_cache.free_lists[i];
 
-		if (isPDF)
+		while (block != nullptr)
 		{
-			isSetOCGState = pdf_is_link_set_ocg_state(link);
+			pool_block_header* next = block->next;
+			free(block);
+			block = next;
 		}
 
-		*out_is_setocgstate = isSetOCGState;
-
-		if (!isExternal && !isSetOCGState)
-		{
-			fz_link_dest destination = fz_resolve_link_dest(ctx, doc, link->uri);
-
-			*out_dest_type = destination.type;
-			*out_dest_x = destination.x;
-			*out_dest_y = destination.y;
-			*out_dest_w = destination.w;
-			*out_dest_h = destination.h;
-			*out_dest_zoom = destination.zoom;
-
-			*out_dest_chapter = destination.loc.chapter;
-			*out_dest_page = destination.loc.page;
-		}
+		pool_cache.free_lists[i] = nullptr;
+		pool_cache.cached_bytes[i] = 0;
 	}
+}
 
-	DLL_PUBLIC void DisposeLinks(fz_context* ctx, fz_link* firstLink)
+//Releases the cache when the thread exits; blocks freed afterwards on the same thread go straight to the system.
+struct pool_thread_cache_guard
+{
+	~pool_thread_cache_guard()
 	{
-		fz_drop_link(ctx, firstLink);
+		pool_release_cache();
+		pool_cache.released = true;
 	}
+};
 
-	DLL_PUBLIC void LoadLinks(fz_link* firstLink, fz_link** out_links, int* out_uri_lengths)
+static thread_local pool_thread_cache_guard pool_cache_guard;
+
+static int pool_get_size_class(size_t size)
+{
+	for (int i = 0; i < POOL_CLASS_COUNT; i++)
 	{
-		fz_link* currLink = firstLink;
-		int count = 0;
-		while (currLink != nullptr)
+		if (size <= pool_size_classes[i])
 		{
-			out_links[count] = currLink;
-			out_uri_lengths[count] = (int)strlen(currLink->uri);
-			count++;
-			currLink = currLink->next;
+			return i;
 		}
 	}
 
-	DLL_PUBLIC int CountLinks(fz_context* ctx, fz_page *page, fz_link** out_firstLink)
-	{
-		fz_link* firstLink = fz_load_links(ctx, page);
-
-		*out_firstLink = firstLink;
+	return POOL_LARGE_BLOCK;
+}
 
-		fz_link* currLink = firstLink;
-		int count = 0;
-		while (currLink != nullptr)
-		{
-			count++;
-			currLink = currLink->next;
-		}
+//fz_alloc_context callbacks for the pooled allocator. Each thread keeps its own free lists, so no locking is required.
+static void* pool_malloc(void* user, size_t size)
+{
+	int size_class = pool_get_size_class(size);
+	pool_block_header* block;
 
-		return count;
+	if (size_class == POOL_LARGE_BLOCK)
+	{
+		block = (pool_block_header*)malloc(sizeof(pool_block_header) + size);
 	}
-
-	DLL_PUBLIC void SetOptionalContentGroupUIState(fz_context* ctx, pdf_document *doc, int ui_index, int state)
+	else if (pool_cache.free_lists[size_class] != nullptr)
 	{
-		if (state == 0)
-		{
-			pdf_deselect_layer_config_ui(ctx, doc, ui_index);
-		}
-		else if (state == 1)
-		{
-			pdf_select_layer_config_ui(ctx, doc, ui_index);
-		}
-		else if (state == 2)
-		{
-			pdf_toggle_layer_config_ui(ctx, doc, ui_index);
-		}
+		block = pool_cache.free_lists[size_class];
+		pool_cache.free_lists[size_class] = block->next;
+		pool_cache.cached_bytes[size_class] -= pool_size_classes[size_class];
 	}
-
-	DLL_PUBLIC int ReadOptionalContentGroupUIState(fz_context* ctx, pdf_document *doc, int ui_index)
+	else
 	{
-		pdf_layer_config_ui ui;
-		pdf_layer_config_ui_info(ctx, doc, ui_index, &ui);
-		return ui.selected;
+		//Make sure that the guard is constructed, so that the cache is released when the thread exits.
+		(void)&pool_cache_guard;
+		block = (pool_block_header*)malloc(sizeof(pool_block_header) + pool_size_classes[size_class]);
 	}
 
-	DLL_PUBLIC void ReadOptionalContentGroupUIs(fz_context* ctx, pdf_document *doc, int count, char** out_labels, int* out_depths, int* out_types, int* out_locked)
+	if (block == nullptr)
 	{
-		pdf_layer_config_ui ui;
-
-		for (int i = 0; i < count; i++)
-		{
-			pdf_layer_config_ui_info(ctx, doc, i, &ui);
+		return nullptr;
+	}
 
-			strncpy(out_labels[i], ui.text, strlen(ui.text));
+	block->size_class = size_class;
+	return block + 1;
+}
 
-			out_depths[i] = ui.depth;
-			out_types[i] = ui.type;
-			out_locked[i] = ui.locked;
-		}
+static void pool_free(void* user, void* ptr)
+{
+	if (ptr == nullptr)
+	{
+		return;
 	}
 
-	DLL_PUBLIC void ReadOptionalContentGroupUILabelLengths(fz_context* ctx, pdf_document *doc, int count, int* out_lengths)
-	{
-		pdf_layer_config_ui ui;
+	pool_block_header* block = (pool_block_header*)ptr - 1;
+	int size_class = block->size_class;
 
-		for (int i = 0; i < count; i++)
-		{
-			pdf_layer_config_ui_info(ctx, doc, i, &ui);
-			out_lengths[i] = (int)strlen(ui.text);
-		}
+	if (size_class == POOL_LARGE_BLOCK || pool_cache.released || pool_cache.cached_bytes[size_class] + pool_size_classes[size_class] > POOL_MAX_CACHED_BYTES)
+	{
+		free(block);
 	}
-
-	DLL_PUBLIC int CountOptionalContentGroupConfigUI(fz_context *ctx, pdf_document *doc)
+	else
 	{
-		return pdf_count_layer_config_ui(ctx, doc);
+		//The block may have been allocated on another thread, so this may be the first time that this thread uses the cache.
+		(void)&pool_cache_guard;
+		block->next = pool_cache.free_lists[size_class];
+		pool_cache.free_lists[size_class] = block;
+		pool_cache.cached_bytes[size_class] += pool_size_classes[size_class];
 	}
+}
 
-	DLL_PUBLIC void SetOptionalContentGroupState(fz_context* ctx, pdf_document *doc, int index, int state)
+static void* pool_realloc(void* user, void* ptr, size_t size)
+{
+	if (ptr == nullptr)
 	{
-		pdf_enable_layer(ctx, doc, index, state);
+		return pool_malloc(user, size);
 	}
 
-	DLL_PUBLIC int GetOptionalContentGroupState(fz_context* ctx, pdf_document *doc, int index)
+	if (size == 0)
 	{
-		return pdf_layer_is_enabled(ctx, doc, index);
+		pool_free(user, ptr);
+		return nullptr;
 	}
 
-	DLL_PUBLIC void GetOptionalContentGroups(fz_context* ctx, pdf_document *doc, int count, char** out_names)
+	pool_block_header* block = (pool_block_header*)ptr - 1;
+	int size_class = block->size_class;
+
+	if (size_class == POOL_LARGE_BLOCK)
 	{
-		for (int i = 0; i < count; i++)
+		if (pool_get_size_class(size) == POOL_LARGE_BLOCK)
 		{
-			const char* name = pdf_layer_name(ctx, doc, i);
+			pool_block_header* new_block = (pool_block_header*)realloc(block, sizeof(pool_block_header) + size);
 
-			strncpy(out_names[i], name, strlen(name));
+			if (new_block == nullptr)
+			{
+				return nullptr;
+			}
+
+			return new_block + 1;
 		}
 	}
-
-	DLL_PUBLIC void GetOptionalContentGroupNameLengths(fz_context* ctx, pdf_document *doc, int count, int* out_lengths)
+	else if (size <= pool_size_classes[size_class])
 	{
-		for (int i = 0; i < count; i++)
-		{
-			const char* name = pdf_layer_name(ctx, doc, i);
-			out_lengths[i] = (int)strlen(name);
-		}
+		//The block is already large enough.
+		return ptr;
 	}
 
-	DLL_PUBLIC int CountOptionalContentGroups(fz_context* ctx, pdf_document *doc)
+	void* new_ptr = pool_malloc(user, size);
+
+	if (new_ptr == nullptr)
 	{
-		return pdf_count_layers(ctx, doc);
+		return nullptr;
 	}
 
-	DLL_PUBLIC void EnableOCGConfig(fz_context* ctx, pdf_document *doc, int configuration_index)
+	//If the old block was large, the new size must be smaller than the old one.
+	size_t old_size = size_class == POOL_LARGE_BLOCK ? size : pool_size_classes[size_class];
+	memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+
+	pool_free(user, ptr);
+
+	return new_ptr;
+}
+
+//Post-processing kernels for rendered pixmaps. The SSE2 (x64) and NEON (arm64) kernels are always available, while the AVX2 kernel is selected at runtime.
+#if defined(__x86_64__) || defined(_M_X64)
+	#define PIXEL_KERNELS_X64
+	#include <immintrin.h>
+	#if defined(_MSC_VER)
+		#include <intrin.h>
+		#define TARGET_AVX2
+	#else
+		#define TARGET_AVX2 __attribute__((target("avx2")))
+	#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+	#define PIXEL_KERNELS_NEON
+	#include <arm_neon.h>
+#endif
+
+//Lookup tables used to un-premultiply the colour components of a pixel without divisions.
+struct unpremultiply_table
+{
+	//For each alpha value, r such that (c * r) >> 16 == c * 255 / alpha for every byte value c. This is exact for all c and alpha.
+	//Alpha values of 0 and 255 map to 65536, which leaves the colour unchanged.
+	uint32_t recip[256];
+
+	//The same values, split into (r >> 16) and (r & 0xFFFF) and replicated in the first three 16-bit lanes. The fourth lane leaves the alpha unchanged.
+	uint64_t hi[256];
+	uint64_t lo[256];
+
+	unpremultiply_table()
 	{
-		pdf_select_layer_config(ctx, doc, configuration_index);
+		for (uint32_t a = 0; a < 256; a++)
+		{
+			uint32_t r = (a == 0 || a == 255) ? 65536 : (255 * 65536 + a - 1) / a;
+
+			uint64_t h = r >> 16;
+			uint64_t l = r & 0xFFFF;
+
+			recip[a] = r;
+			hi[a] = h | (h << 16) | (h << 32) | ((uint64_t)1 << 48);
+			lo[a] = l | (l << 16) | (l << 32);
+		}
 	}
+};
 
-	DLL_PUBLIC void EnableDefaultOCGConfig(fz_context* ctx, pdf_document *doc)
+static const unpremultiply_table unpremultiply_lut;
+
+static void unpremultiply_scalar(unsigned char* data, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
 	{
-		pdf_select_default_layer_config(ctx, doc);
+		unsigned char* p = data + i * 4;
+		uint32_t r = unpremultiply_lut.recip[p[3]];
+
+		p[0] = (unsigned char)((p[0] * r) >> 16);
+		p[1] = (unsigned char)((p[1] * r) >> 16);
+		p[2] = (unsigned char)((p[2] * r) >> 16);
 	}
+}
 
-	DLL_PUBLIC void ReadOCGConfig(fz_context* ctx, pdf_document *doc, int configuration_index, int name_length, int creator_length, char* out_name, char* out_creator)
+#if defined(PIXEL_KERNELS_X64)
+
+//(c * r) >> 16 for 16-bit lanes, computed as c * (r >> 16) + ((c * (r & 0xFFFF)) >> 16).
+#define UNPREMULTIPLY_LANES_SSE2(c, rh, rl) _mm_and_si128(_mm_add_epi16(_mm_mullo_epi16(c, rh), _mm_mulhi_epu16(c, rl)), _mm_set1_epi16(0xFF))
+#define UNPREMULTIPLY_LANES_AVX2(c, rh, rl) _mm256_and_si256(_mm256_add_epi16(_mm256_mullo_epi16(c, rh), _mm256_mulhi_epu16(c, rl)), _mm256_set1_epi16(0xFF))
+
+static void unpremultiply_sse2(unsigned char* data, size_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+
+	size_t i = 0;
+
+	for (; i + 4 <= count; i += 4)
 	{
-		pdf_layer_config info;
-		pdf_layer_config_info(ctx, doc, configuration_index, &info);
+		unsigned char* p = data + i * 4;
+		__m128i px = _mm_loadu_si128((const __m128i*)p);
 
-		if (name_length > 0)
+		//Pixels that are fully opaque or fully transparent are left unchanged; skip blocks that only contain these.
+		__m128i alpha = _mm_and_si128(px, alpha_mask);
+		if (_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi32(alpha, alpha_mask), _mm_cmpeq_epi32(alpha, zero))) == 0xFFFF)
 		{
-			strncpy(out_name, info.name, name_length);
+			continue;
 		}
 
-		if (creator_length > 0)
-		{
-			strncpy(out_creator, info.creator, creator_length);
-		}
-	}
+		__m128i px01 = _mm_unpacklo_epi8(px, zero);
+		__m128i px23 = _mm_unpackhi_epi8(px, zero);
 
-	DLL_PUBLIC void ReadOCGConfigNameLength(fz_context* ctx, pdf_document *doc, int configuration_index, int* out_name_length, int* out_creator_length)
-	{
-		pdf_layer_config info;
-		pdf_layer_config_info(ctx, doc, configuration_index, &info);
+		__m128i rh01 = _mm_set_epi64x((long long)unpremultiply_lut.hi[p[7]], (long long)unpremultiply_lut.hi[p[3]]);
+		__m128i rl01 = _mm_set_epi64x((long long)unpremultiply_lut.lo[p[7]], (long long)unpremultiply_lut.lo[p[3]]);
+		__m128i rh23 = _mm_set_epi64x((long long)unpremultiply_lut.hi[p[15]], (long long)unpremultiply_lut.hi[p[11]]);
+		__m128i rl23 = _mm_set_epi64x((long long)unpremultiply_lut.lo[p[15]], (long long)unpremultiply_lut.lo[p[11]]);
 
-		*out_name_length = (int)strlen(info.name);
-		*out_creator_length = (int)strlen(info.creator);
-	}
+		px01 = UNPREMULTIPLY_LANES_SSE2(px01, rh01, rl01);
+		px23 = UNPREMULTIPLY_LANES_SSE2(px23, rh23, rl23);
 
-	DLL_PUBLIC int CountAlternativeOCGConfigs(fz_context* ctx, pdf_document* doc)
-	{
-		return pdf_count_layer_configs(ctx, doc);
+		_mm_storeu_si128((__m128i*)p, _mm_packus_epi16(px01, px23));
 	}
 
-	DLL_PUBLIC void ReadDefaultOCGConfig(fz_context* ctx, pdf_document *doc, int name_length, int creator_length, char* out_name, char* out_creator)
+	unpremultiply_scalar(data + i * 4, count - i);
+}
+
+TARGET_AVX2 static void unpremultiply_avx2(unsigned char* data, size_t count)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
+
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
 	{
-		pdf_layer_config info;
-		pdf_default_layer_config_info(ctx, doc, &info);
+		unsigned char* p = data + i * 4;
+		__m256i px = _mm256_loadu_si256((const __m256i*)p);
 
-		if (name_length > 0)
+		__m256i alpha = _mm256_and_si256(px, alpha_mask);
+		if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi32(alpha, alpha_mask), _mm256_cmpeq_epi32(alpha, zero))) == -1)
 		{
-			strncpy(out_name, info.name, name_length);
+			continue;
+		}
+
+		//Unpacking works within each 128-bit lane: the low half holds pixels 0, 1, 4, 5 and the high half holds pixels 2, 3, 6, 7.
+		__m256i px_lo = _mm256_unpacklo_epi8(px, zero);
+		__m256i px_hi = _mm256_unpackhi_epi8(px, zero);
+
+		__m256i rh_lo = _mm256_set_epi64x((long long)unpremultiply_lut.hi[p[23]], (long long)unpremultiply_lut.hi[p[19]], (long long)unpremultiply_lut.hi[p[7]], (long long)unpremultiply_lut.hi[p[3]]);
+		__m256i rl_lo = _mm256_set_epi64x((long long)unpremultiply_lut.lo[p[23]], (long long)unpremultiply_lut.lo[p[19]], (long long)unpremultiply_lut.lo[p[7]], (long long)unpremultiply_lut.lo[p[3]]);
+		__m256i rh_hi = _mm256_set_epi64x((long long)unpremultiply_lut.hi[p[31]], (long long)unpremultiply_lut.hi[p[27]], (long long)unpremultiply_lut.hi[p[15]], (long long)unpremultiply_lut.hi[p[11]]);
+		__m256i rl_hi = _mm256_set_epi64x((long long)unpremultiply_lut.lo[p[31]], (long long)unpremultiply_lut.lo[p[27]], (long long)unpremultiply_lut.lo[p[15]], (long long)unpremultiply_lut.lo[p[11]]);
+
+		px_lo = UNPREMULTIPLY_LANES_AVX2(px_lo, rh_lo, rl_lo);
+		px_hi = UNPREMULTIPLY_LANES_AVX2(px_hi, rh_hi, rl_hi);
+
+		_mm256_storeu_si256((__m256i*)p, _mm256_packus_epi16(px_lo, px_hi));
+	}
+
+	unpremultiply_sse2(data + i * 4, count - i);
+}
+
+static bool cpu_supports_avx2()
+{
+#if defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7)
+	{
+		return false;
+	}
+
+	//The OS must support AVX (OSXSAVE and AVX bits, and the YMM state enabled in XCR0).
+	__cpuid(info, 1);
+	if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+	{
+		return false;
+	}
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+static const bool use_avx2 = cpu_supports_avx2();
+
+#elif defined(PIXEL_KERNELS_NEON)
+
+static void unpremultiply_neon(unsigned char* data, size_t count)
+{
+	size_t i = 0;
+
+	for (; i + 8 <= count; i += 8)
+	{
+		unsigned char* p = data + i * 4;
+		uint8x8x4_t px = vld4_u8(p);
+
+		//Pixels that are fully opaque or fully transparent are left unchanged; skip blocks that only contain these.
+		if (vminv_u8(vorr_u8(vceq_u8(px.val[3], vdup_n_u8(0)), vceq_u8(px.val[3], vdup_n_u8(0xFF)))) == 0xFF)
+		{
+			continue;
+		}
+
+		uint32_t r[8];
+		for (int j = 0; j < 8; j++)
+		{
+			r[j] = unpremultiply_lut.recip[p[j * 4 + 3]];
+		}
+
+		uint32x4_t r_lo = vld1q_u32(r);
+		uint32x4_t r_hi = vld1q_u32(r + 4);
+
+		for (int c = 0; c < 3; c++)
+		{
+			uint16x8_t c16 = vmovl_u8(px.val[c]);
+			uint32x4_t c_lo = vshrq_n_u32(vmulq_u32(vmovl_u16(vget_low_u16(c16)), r_lo), 16);
+			uint32x4_t c_hi = vshrq_n_u32(vmulq_u32(vmovl_u16(vget_high_u16(c16)), r_hi), 16);
+			px.val[c] = vmovn_u16(vcombine_u16(vmovn_u32(c_lo), vmovn_u32(c_hi)));
+		}
+
+		vst4_u8(p, px);
+	}
+
+	unpremultiply_scalar(data + i * 4, count - i);
+}
+
+#endif
+
+//Convert count RGBA/BGRA pixels with premultiplied alpha to straight alpha, in place.
+static void unpremultiply_pixels(unsigned char* data, size_t count)
+{
+#if defined(PIXEL_KERNELS_X64)
+	if (use_avx2)
+	{
+		unpremultiply_avx2(data, count);
+	}
+	else
+	{
+		unpremultiply_sse2(data, count);
+	}
+#elif defined(PIXEL_KERNELS_NEON)
+	unpremultiply_neon(data, count);
+#else
+	unpremultiply_scalar(data, count);
+#endif
+}
+
+//Clear all the pixels of a pixmap that fall outside of the clip rectangle (in the same units as the region represented by the pixmap).
+static void clip_pixmap(fz_pixmap* pix, fz_rect region, fz_rect clip)
+{
+	int w = pix->w;
+	int h = pix->h;
+	int n = pix->n;
+
+	float width = region.x1 - region.x0;
+	float height = region.y1 - region.y0;
+
+	int clip_left = fz_maxi(0, (int)ceil((clip.x0 - region.x0) / width * w - 0.001));
+	int clip_right = fz_maxi(0, (int)floor(w - (region.x1 - clip.x1) / width * w + 0.001));
+	int clip_top = fz_maxi(0, (int)ceil((clip.y0 - region.y0) / height * h - 0.001));
+	int clip_bottom = fz_maxi(0, (int)floor(h - (region.y1 - clip.y1) / height * h + 0.001));
+
+	if (clip_left <= 0 && clip_right >= w && clip_top <= 0 && clip_bottom >= h)
+	{
+		return;
+	}
+
+	clip_left = fz_mini(clip_left, w);
+	clip_right = fz_mini(clip_right, w);
+
+	//Transparent for images with an alpha channel, white otherwise.
+	int clear_value = pix->alpha ? 0 : 0xFF;
+
+	for (int y = 0; y < h; y++)
+	{
+		unsigned char* row = pix->samples + (size_t)y * pix->stride;
+
+		if (y < clip_top || y >= clip_bottom)
+		{
+			memset(row, clear_value, (size_t)w * n);
+		}
+		else
+		{
+			memset(row, clear_value, (size_t)clip_left * n);
+			memset(row + (size_t)clip_right * n, clear_value, (size_t)(w - clip_right) * n);
+		}
+	}
+}
+//Render the part of a display list that falls within bbox (in device space). Only the objects that intersect the bbox are drawn.
+//If pixel_storage is NULL, the pixmap allocates its own samples.
+fz_pixmap*
+new_pixmap_from_display_list_with_bbox_and_data(fz_context* ctx, fz_display_list* list, fz_irect bbox, fz_matrix ctm, fz_colorspace* cs, int alpha, unsigned char* pixel_storage, fz_cookie* cookie)
+{
+	fz_pixmap* pix;
+	fz_device* dev = NULL;
+
+	fz_var(dev);
+
+	if (pixel_storage != NULL)
+	{
+		pix = new_pixmap_with_bbox_and_data(ctx, cs, bbox, NULL, alpha, pixel_storage);
+	}
+	else
+	{
+		pix = fz_new_pixmap_with_bbox(ctx, cs, bbox, NULL, alpha);
+	}
+
+	if (alpha)
+		fz_clear_pixmap(ctx, pix);
+	else
+		fz_clear_pixmap_with_value(ctx, pix, 0xFF);
+
+	fz_try(ctx)
+	{
+		dev = fz_new_draw_device(ctx, fz_identity, pix);
+		fz_run_display_list(ctx, list, dev, ctm, fz_rect_from_irect(bbox), cookie);
+		fz_close_device(ctx, dev);
+	}
+	fz_always(ctx)
+	{
+		fz_drop_device(ctx, dev);
+	}
+	fz_catch(ctx)
+	{
+		fz_drop_pixmap(ctx, pix);
+		fz_rethrow(ctx);
+	}
+
+	return pix;
+}
+
+//State of an image that is being encoded one band at a time.
+struct banded_image_writer
+{
+	fz_output* out;
+	int owns_output;
+	fz_band_writer* band_writer;
+	fz_irect bbox;
+	fz_colorspace* cs;
+	int alpha;
+	//The first row of the next band that will be written.
+	int next_row;
+};
+
+struct callback_output_state
+{
+	writeCallback callback;
+};
+
+static void callback_output_write(fz_context* ctx, void* opaque, const void* data, size_t n)
+{
+	callback_output_state* state = (callback_output_state*)opaque;
+
+	if (state->callback((const unsigned char*)data, (uint64_t)n) != 0)
+	{
+		fz_throw(ctx, FZ_ERROR_GENERIC, "Cannot write to the output stream");
+	}
+}
+
+//Size of the buffer used by outputs that forward the data to a callback: the callback is invoked once every time this fills up.
+#define CALLBACK_OUTPUT_BUFFER_SIZE 65536
+
+//Create an output that forwards the data written to it to a callback. The state must remain valid until the output has been dropped.
+static fz_output* new_callback_output(fz_context* ctx, callback_output_state* state)
+{
+	return fz_new_output(ctx, CALLBACK_OUTPUT_BUFFER_SIZE, state, callback_output_write, NULL, NULL);
+}
+
+//Estimate the size of the encoded image, so that the buffer does not have to grow while it is being written. Uncompressed formats
+//take about as many bytes as the samples (plus a header); for compressed formats the size cannot be known in advance, so a small
+//buffer is allocated and left to grow.
+static size_t estimate_encoded_size(fz_pixmap* pix, int output_format)
+{
+	switch (output_format)
+	{
+	case OUT_PNM:
+	case OUT_PAM:
+	case OUT_PSD:
+		return (size_t)pix->w * pix->h * pix->n + 4096;
+	default:
+		return 1024;
+	}
+}
+
+//Encode a pixmap in the specified format.
+static void write_pixmap(fz_context* ctx, fz_output* out, fz_pixmap* pix, int output_format, int quality)
+{
+	switch (output_format)
+	{
+	case OUT_PNM:
+		fz_write_pixmap_as_pnm(ctx, out, pix);
+		break;
+	case OUT_PAM:
+		fz_write_pixmap_as_pam(ctx, out, pix);
+		break;
+	case OUT_PNG:
+		fz_write_pixmap_as_png(ctx, out, pix);
+		break;
+	case OUT_PSD:
+		fz_write_pixmap_as_psd(ctx, out, pix);
+		break;
+	case OUT_JPEG:
+		fz_write_pixmap_as_jpeg(ctx, out, pix, quality, 1);
+		break;
+	}
+}
+
+//Encode a pixmap either to a callback (if callback is not NULL) or to a new memory buffer, which is returned in out_buffer. The pixmap is not dropped.
+static int encode_pixmap(fz_context* ctx, fz_pixmap* pix, int output_format, int quality, writeCallback callback, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length)
+{
+	fz_output* out = NULL;
+	fz_buffer* buf = NULL;
+	callback_output_state state;
+
+	state.callback = callback;
+
+	fz_var(out);
+	fz_var(buf);
+
+	fz_try(ctx)
+	{
+		if (callback != NULL)
+		{
+			out = new_callback_output(ctx, &state);
+		}
+		else
+		{
+			buf = fz_new_buffer(ctx, estimate_encoded_size(pix, output_format));
+			out = fz_new_output_with_buffer(ctx, buf);
+		}
+	}
+	fz_catch(ctx)
+	{
+		fz_drop_buffer(ctx, buf);
+		return ERR_CANNOT_CREATE_BUFFER;
+	}
+
+	//Closing the output flushes the data that is still buffered, which may invoke the callback and fail.
+	fz_try(ctx)
+	{
+		write_pixmap(ctx, out, pix, output_format, quality);
+		fz_close_output(ctx, out);
+	}
+	fz_always(ctx)
+	{
+		fz_drop_output(ctx, out);
+	}
+	fz_catch(ctx)
+	{
+		fz_drop_buffer(ctx, buf);
+		return ERR_CANNOT_SAVE;
+	}
+
+	if (callback == NULL)
+	{
+		*out_buffer = buf;
+		*out_data = buf->data;
+		*out_length = buf->len;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+extern "C"
+{
+	DLL_PUBLIC void GetLocationFromUri(fz_context* ctx, fz_document* doc, const char* uri, int* out_chapter, int* out_page, float* out_x, float* out_y)
+	{
+		fz_location loc;
+
+		loc = fz_resolve_link(ctx, doc, uri, out_x, out_y);
+
+		*out_chapter = loc.chapter;
+		*out_page = loc.page;
+	}
+
+	DLL_PUBLIC int GetPageNumber(fz_context *ctx, fz_document *doc, int chapter, int page)
+	{
+		return fz_page_number_from_location(ctx, doc, fz_make_location(chapter, page));
+	}
+
+	DLL_PUBLIC void ActivateLinkSetOCGState(fz_context *ctx, pdf_document *doc, fz_link *link)
+	{
+		pdf_activate_link_set_ocg_state(ctx, doc, link);
+	}
+
+	DLL_PUBLIC int IsLinkHidden(fz_context *ctx, const char *usage, fz_link* link)
+	{
+		return pdf_is_link_hidden(ctx, usage, link);
+	}
+
+	DLL_PUBLIC void LoadLink(fz_context* ctx, fz_document* doc, fz_link* link, int uri_length, int isPDF, float* out_x0, float* out_y0, float* out_x1, float* out_y1, char* out_uri, int* out_is_external, int* out_is_setocgstate, int* out_dest_type, float* out_dest_x, float* out_dest_y,float* out_dest_w, float* out_dest_h, float* out_dest_zoom, int* out_dest_chapter, int* out_dest_page)
+	{
+		*out_x0 = link->rect.x0;
+		*out_y0 = link->rect.y0;
+		*out_x1 = link->rect.x1;
+		*out_y1 = link->rect.y1;
+		strncpy(out_uri, link->uri, uri_length);
+
+		int isExternal = fz_is_external_link(ctx, link->uri);
+		*out_is_external = isExternal;
+
+		int isSetOCGState = 0;
+
+		if (isPDF)
+		{
+			isSetOCGState = pdf_is_link_set_ocg_state(link);
+		}
+
+		*out_is_setocgstate = isSetOCGState;
+
+		if (!isExternal && !isSetOCGState)
+		{
+			fz_link_dest destination = fz_resolve_link_dest(ctx, doc, link->uri);
+
+			*out_dest_type = destination.type;
+			*out_dest_x = destination.x;
+			*out_dest_y = destination.y;
+			*out_dest_w = destination.w;
+			*out_dest_h = destination.h;
+			*out_dest_zoom = destination.zoom;
+
+			*out_dest_chapter = destination.loc.chapter;
+			*out_dest_page = destination.loc.page;
+		}
+	}
+
+	DLL_PUBLIC void DisposeLinks(fz_context* ctx, fz_link* firstLink)
+	{
+		fz_drop_link(ctx, firstLink);
+	}
+
+	DLL_PUBLIC void LoadLinks(fz_link* firstLink, fz_link** out_links, int* out_uri_lengths)
+	{
+		fz_link* currLink = firstLink;
+		int count = 0;
+		while (currLink != nullptr)
+		{
+			out_links[count] = currLink;
+			out_uri_lengths[count] = (int)strlen(currLink->uri);
+			count++;
+			currLink = currLink->next;
+		}
+	}
+
+	DLL_PUBLIC int CountLinks(fz_context* ctx, fz_page *page, fz_link** out_firstLink)
+	{
+		fz_link* firstLink = fz_load_links(ctx, page);
+
+		*out_firstLink = firstLink;
+
+		fz_link* currLink = firstLink;
+		int count = 0;
+		while (currLink != nullptr)
+		{
+			count++;
+			currLink = currLink->next;
+		}
+
+		return count;
+	}
+
+	DLL_PUBLIC void SetOptionalContentGroupUIState(fz_context* ctx, pdf_document *doc, int ui_index, int state)
+	{
+		if (state == 0)
+		{
+			pdf_deselect_layer_config_ui(ctx, doc, ui_index);
+		}
+		else if (state == 1)
+		{
+			pdf_select_layer_config_ui(ctx, doc, ui_index);
+		}
+		else if (state == 2)
+		{
+			pdf_toggle_layer_config_ui(ctx, doc, ui_index);
+		}
+	}
+
+	DLL_PUBLIC int ReadOptionalContentGroupUIState(fz_context* ctx, pdf_document *doc, int ui_index)
+	{
+		pdf_layer_config_ui ui;
+		pdf_layer_config_ui_info(ctx, doc, ui_index, &ui);
+		return ui.selected;
+	}
+
+	DLL_PUBLIC void ReadOptionalContentGroupUIs(fz_context* ctx, pdf_document *doc, int count, char** out_labels, int* out_depths, int* out_types, int* out_locked)
+	{
+		pdf_layer_config_ui ui;
+
+		for (int i = 0; i < count; i++)
+		{
+			pdf_layer_config_ui_info(ctx, doc, i, &ui);
+
+			strncpy(out_labels[i], ui.text, strlen(ui.text));
+
+			out_depths[i] = ui.depth;
+			out_types[i] = ui.type;
+			out_locked[i] = ui.locked;
+		}
+	}
+
+	DLL_PUBLIC void ReadOptionalContentGroupUILabelLengths(fz_context* ctx, pdf_document *doc, int count, int* out_lengths)
+	{
+		pdf_layer_config_ui ui;
+
+		for (int i = 0; i < count; i++)
+		{
+			pdf_layer_config_ui_info(ctx, doc, i, &ui);
+			out_lengths[i] = (int)strlen(ui.text);
+		}
+	}
+
+	DLL_PUBLIC int CountOptionalContentGroupConfigUI(fz_context *ctx, pdf_document *doc)
+	{
+		return pdf_count_layer_config_ui(ctx, doc);
+	}
+
+	DLL_PUBLIC void SetOptionalContentGroupState(fz_context* ctx, pdf_document *doc, int index, int state)
+	{
+		pdf_enable_layer(ctx, doc, index, state);
+	}
+
+	DLL_PUBLIC int GetOptionalContentGroupState(fz_context* ctx, pdf_document *doc, int index)
+	{
+		return pdf_layer_is_enabled(ctx, doc, index);
+	}
+
+	DLL_PUBLIC void GetOptionalContentGroups(fz_context* ctx, pdf_document *doc, int count, char** out_names)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const char* name = pdf_layer_name(ctx, doc, i);
+
+			strncpy(out_names[i], name, strlen(name));
+		}
+	}
+
+	DLL_PUBLIC void GetOptionalContentGroupNameLengths(fz_context* ctx, pdf_document *doc, int count, int* out_lengths)
+	{
+		for (int i = 0; i < count; i++)
+		{
+			const char* name = pdf_layer_name(ctx, doc, i);
+			out_lengths[i] = (int)strlen(name);
+		}
+	}
+
+	DLL_PUBLIC int CountOptionalContentGroups(fz_context* ctx, pdf_document *doc)
+	{
+		return pdf_count_layers(ctx, doc);
+	}
+
+	DLL_PUBLIC void EnableOCGConfig(fz_context* ctx, pdf_document *doc, int configuration_index)
+	{
+		pdf_select_layer_config(ctx, doc, configuration_index);
+	}
+
+	DLL_PUBLIC void EnableDefaultOCGConfig(fz_context* ctx, pdf_document *doc)
+	{
+		pdf_select_default_layer_config(ctx, doc);
+	}
+
+	DLL_PUBLIC void ReadOCGConfig(fz_context* ctx, pdf_document *doc, int configuration_index, int name_length, int creator_length, char* out_name, char* out_creator)
+	{
+		pdf_layer_config info;
+		pdf_layer_config_info(ctx, doc, configuration_index, &info);
+
+		if (name_length > 0)
+		{
+			strncpy(out_name, info.name, name_length);
 		}
 
 		if (creator_length > 0)
 		{
-			strncpy(out_creator, info.creator, creator_length);
+			strncpy(out_creator, info.creator, creator_length);
+		}
+	}
+
+	DLL_PUBLIC void ReadOCGConfigNameLength(fz_context* ctx, pdf_document *doc, int configuration_index, int* out_name_length, int* out_creator_length)
+	{
+		pdf_layer_config info;
+		pdf_layer_config_info(ctx, doc, configuration_index, &info);
+
+		*out_name_length = (int)strlen(info.name);
+		*out_creator_length = (int)strlen(info.creator);
+	}
+
+	DLL_PUBLIC int CountAlternativeOCGConfigs(fz_context* ctx, pdf_document* doc)
+	{
+		return pdf_count_layer_configs(ctx, doc);
+	}
+
+	DLL_PUBLIC void ReadDefaultOCGConfig(fz_context* ctx, pdf_document *doc, int name_length, int creator_length, char* out_name, char* out_creator)
+	{
+		pdf_layer_config info;
+		pdf_default_layer_config_info(ctx, doc, &info);
+
+		if (name_length > 0)
+		{
+			strncpy(out_name, info.name, name_length);
+		}
+
+		if (creator_length > 0)
+		{
+			strncpy(out_creator, info.creator, creator_length);
+		}
+	}
+
+	DLL_PUBLIC void ReadDefaultOCGConfigNameLength(fz_context* ctx, pdf_document *doc, int* out_name_length, int* out_creator_length)
+	{
+		pdf_layer_config info;
+		pdf_default_layer_config_info(ctx, doc, &info);
+
+		if (info.name != nullptr)
+		{
+			*out_name_length = (int)strlen(info.name);
+		}
+		else
+		{
+			*out_name_length = 0;
+		}
+
+		if (info.creator != nullptr)
+		{
+			*out_creator_length = (int)strlen(info.creator);
+		}
+		else
+		{
+			*out_creator_length = 0;
+		}
+	}
+
+	DLL_PUBLIC int GetPDFDocument(fz_context* ctx, fz_document* doc, const pdf_document** out_pdf_doc)
+	{
+		pdf_document* pdfDoc = fz_new_pdf_document_from_fz_document(ctx, doc);
+
+		if (pdfDoc == nullptr)
+		{
+			return ERR_CANNOT_CONVERT_TO_PDF;
+		}
+		else
+		{
+			*out_pdf_doc = pdfDoc;
+			return EXIT_SUCCESS;
+		}
+	}
+
+	DLL_PUBLIC void DisposeFont(fz_context* ctx, fz_font* font)
+	{
+		fz_drop_font(ctx, font);
+	}
+
+	DLL_PUBLIC void DisposeImage(fz_context* ctx, fz_image* image)
+	{
+		fz_drop_image(ctx, image);
+	}
+
+	DLL_PUBLIC void DisposeColorSpace(fz_context* ctx, fz_colorspace* cs)
+	{
+		fz_drop_colorspace(ctx, cs);
+	}
+
+	DLL_PUBLIC int GetT3Procs(fz_context* ctx, fz_font* font, fz_buffer*** out_t3_procs)
+	{
+		fz_try(ctx)
+		{
+			*out_t3_procs = fz_font_t3_procs(ctx, font);
+		}
+		fz_catch(ctx)
+		{			
+			return ERR_FONT_METADATA;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetFTHandle(fz_context* ctx, fz_font* font, void** out_handle)
+	{
+		fz_try(ctx)
+		{
+			*out_handle = fz_font_ft_face(ctx, font);
+		}
+		fz_catch(ctx)
+		{			
+			return ERR_FONT_METADATA;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetFontName(fz_context* ctx, fz_font* font, int length, char* out_name)
+	{
+		fz_try(ctx)
+		{
+			const char* name = fz_font_name(ctx, font);
+			strncpy(out_name, name, length);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_FONT_METADATA;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetFontMetadata(fz_context* ctx, fz_font* font, int* out_font_name_length, int* out_bold, int* out_italic, int* out_serif, int* out_monospaced)
+	{
+		fz_try(ctx)
+		{
+			*out_font_name_length = (int)strlen(fz_font_name(ctx, font));
+			*out_bold = fz_font_is_bold(ctx, font);
+			*out_italic = fz_font_is_italic(ctx, font);
+			*out_serif = fz_font_is_serif(ctx, font);
+			*out_monospaced = fz_font_is_monospaced(ctx, font);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_FONT_METADATA;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetColorantName(fz_context* ctx, fz_colorspace* cs, int n, int length, char* out_name)
+	{
+		fz_try(ctx)
+		{
+			const char* name = fz_colorspace_colorant(ctx, cs, n);
+			strncpy(out_name, name, length);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_COLORSPACE_METADATA;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetColorantNameLength(fz_context* ctx, fz_colorspace* cs, int n, int* out_name_length)
+	{
+		fz_try(ctx)
+		{
+			*out_name_length = (int)strlen(fz_colorspace_colorant(ctx, cs, n));
+		}
+		fz_catch(ctx)
+		{
+			return ERR_COLORSPACE_METADATA;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetColorSpaceName(fz_context* ctx, fz_colorspace* cs, int length, char* out_name)
+	{
+		fz_try(ctx)
+		{
+			const char* name = fz_colorspace_name(ctx, cs);
+			strncpy(out_name, name, length);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_COLORSPACE_METADATA;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetColorSpaceData(fz_context* ctx, fz_colorspace* cs, int* out_cs_type, int* out_name_len, fz_colorspace** out_base_cs, int* out_lookup_size, unsigned char** out_lookup_table)
+	{
+		fz_try(ctx)
+		{
+			*out_cs_type = fz_colorspace_type(ctx, cs);
+			*out_name_len = (int)strlen(fz_colorspace_name(ctx, cs));
+
+			if (*out_cs_type == FZ_COLORSPACE_INDEXED)
+			{
+				*out_base_cs = fz_base_colorspace(ctx, cs);
+				*out_lookup_size = cs->u.indexed.high;
+				*out_lookup_table = cs ->u.indexed.lookup;
+			}
+			else if (*out_cs_type == FZ_COLORSPACE_SEPARATION)
+			{
+				*out_base_cs = cs->u.separation.base;
+				*out_lookup_size = fz_colorspace_n(ctx, cs);
+			}
+		}
+		fz_catch(ctx)
+		{
+			return ERR_COLORSPACE_METADATA;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	//Decode an image and encode it either to a callback or to a memory buffer.
+	static int write_raster_image(fz_context* ctx, fz_image* image, int output_format, int quality, int convert_to_rgb, writeCallback callback, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length)
+	{
+		fz_pixmap* pix;
+
+		//Render page to a pixmap.
+		fz_try(ctx)
+		{
+			pix = fz_get_unscaled_pixmap_from_image(ctx, image);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_RENDER;
+		}
+
+		if (convert_to_rgb > 0)
+		{
+			// Convert the pixmap to RGB.
+			fz_try(ctx)
+			{
+				fz_colorspace* cs = fz_device_rgb(ctx);
+				fz_pixmap* converted_pixmap = fz_convert_pixmap(ctx, pix, cs, cs, NULL, fz_default_color_params, 0);
+				
+				if (pix != converted_pixmap)
+				{
+					fz_drop_pixmap(ctx, pix);
+					pix = converted_pixmap;
+				}
+			}
+			fz_catch(ctx)
+			{
+				fz_drop_pixmap(ctx, pix);
+				return ERR_CANNOT_RENDER;
+			}
+		}
+
+		//Write the rendered pixmap in the specified format.
+		int result = encode_pixmap(ctx, pix, output_format, quality, callback, out_buffer, out_data, out_length);
+
+		fz_drop_pixmap(ctx, pix);
+
+		return result;
+	}
+
+	DLL_PUBLIC int WriteRasterImage(fz_context* ctx, fz_image *image, int output_format, int quality, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length, int convert_to_rgb)
+	{
+		return write_raster_image(ctx, image, output_format, quality, convert_to_rgb, NULL, out_buffer, out_data, out_length);
+	}
+
+	DLL_PUBLIC int WriteRasterImageToStream(fz_context* ctx, fz_image* image, int output_format, int quality, int convert_to_rgb, writeCallback callback)
+	{
+		return write_raster_image(ctx, image, output_format, quality, convert_to_rgb, callback, NULL, NULL, NULL);
+	}
+
+	DLL_PUBLIC int SaveRasterImage(fz_context *ctx, fz_image *image, const char* file_name, int output_format, int quality, int convert_to_rgb)
+	{
+		fz_pixmap* pix;
+
+		//Render page to a pixmap.
+		fz_try(ctx)
+		{
+			pix = fz_get_unscaled_pixmap_from_image(ctx, image);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_RENDER;
+		}
+
+		if (convert_to_rgb > 0)
+		{
+			// Convert the pixmap to RGB.
+			fz_try(ctx)
+			{
+				fz_colorspace* cs = fz_device_rgb(ctx);
+				fz_pixmap* converted_pixmap = fz_convert_pixmap(ctx, pix, cs, cs, NULL, fz_default_color_params, 0);
+				if (pix != converted_pixmap)
+				{
+					fz_drop_pixmap(ctx, pix);
+					pix = converted_pixmap;
+				}
+			}
+			fz_catch(ctx)
+			{
+				fz_drop_pixmap(ctx, pix);
+				return ERR_CANNOT_RENDER;
+			}
+		}
+
+		//Save the rendered pixmap to the output file in the specified format.
+		fz_try(ctx)
+		{
+			switch (output_format)
+			{
+			case OUT_PNM:
+				fz_save_pixmap_as_pnm(ctx, pix, file_name);
+				break;
+			case OUT_PAM:
+				fz_save_pixmap_as_pam(ctx, pix, file_name);
+				break;
+			case OUT_PNG:
+				fz_save_pixmap_as_png(ctx, pix, file_name);
+				break;
+			case OUT_PSD:
+				fz_save_pixmap_as_psd(ctx, pix, file_name);
+				break;
+			case OUT_JPEG:
+				fz_save_pixmap_as_jpeg(ctx, pix, file_name, quality);
+				break;
+			}
+		}
+		fz_catch(ctx)
+		{
+			fz_drop_pixmap(ctx, pix);
+			return ERR_CANNOT_SAVE;
+		}
+
+		fz_drop_pixmap(ctx, pix);
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC void DisposePixmap(fz_context *ctx, fz_pixmap* pixmap)
+	{
+		fz_drop_pixmap(ctx, pixmap);
+	}
+
+	DLL_PUBLIC int LoadPixmapRGB(fz_context *ctx, fz_image *image, int color_format, fz_pixmap** out_pixmap, unsigned char** out_samples, int* count)
+	{
+		fz_pixmap* base_pixmap;
+		fz_colorspace* cs;
+		int alpha;
+
+		switch (color_format)
+		{
+		case COLOR_RGB:
+			cs = fz_device_rgb(ctx);
+			alpha = 0;
+			break;
+		case COLOR_RGBA:
+			cs = fz_device_rgb(ctx);
+			alpha = 1;
+			break;
+		case COLOR_BGR:
+			cs = fz_device_bgr(ctx);
+			alpha = 0;
+			break;
+		case COLOR_BGRA:
+			cs = fz_device_bgr(ctx);
+			alpha = 1;
+			break;
+		}
+
+		fz_try(ctx)
+		{
+			base_pixmap = fz_get_unscaled_pixmap_from_image(ctx, image);
+
+			*out_pixmap = fz_convert_pixmap(ctx, base_pixmap, cs, cs, NULL, fz_default_color_params, alpha);
+			
+			*out_samples = fz_pixmap_samples(ctx, *out_pixmap);
+			*count = fz_pixmap_height(ctx, *out_pixmap) * fz_pixmap_stride(ctx, *out_pixmap);
+
+			fz_drop_pixmap(ctx, base_pixmap);
+		}
+		fz_always(ctx)
+		{
+			fz_drop_colorspace(ctx, cs);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_RENDER;
+		}
+
+		fz_keep_pixmap(ctx, *out_pixmap);
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int LoadPixmap(fz_context *ctx, fz_image *image, fz_pixmap** out_pixmap, unsigned char** out_samples, int* count)
+	{
+		fz_try(ctx)
+		{
+			*out_pixmap = fz_get_unscaled_pixmap_from_image(ctx, image);
+			*out_samples = fz_pixmap_samples(ctx, *out_pixmap);
+			*count = fz_pixmap_height(ctx, *out_pixmap) * fz_pixmap_stride(ctx, *out_pixmap);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_RENDER;
+		}
+		
+		fz_keep_pixmap(ctx, *out_pixmap);
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetImageMetadata(fz_context *ctx, fz_image *image, int* out_w, int* out_h, int* out_xres, int* out_yres, uint8_t* out_orientation, fz_colorspace** out_colorspace)
+	{
+		*out_w = image->w;
+		*out_h = image->h;
+		*out_colorspace = image->colorspace;
+		fz_keep_colorspace(ctx, image->colorspace);
+
+		fz_try(ctx)
+		{
+			fz_image_resolution(image, out_xres, out_yres);
+			*out_orientation = fz_image_orientation(ctx, image);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_IMAGE_METADATA;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC void DisposeOutline(fz_context* ctx, fz_outline* outline)
+	{
+		fz_drop_outline(ctx, outline);
+	}
+
+	DLL_PUBLIC fz_outline* LoadOutline(fz_context* ctx, fz_document* doc)
+	{
+		return fz_load_outline(ctx, doc);
+	}
+
+	DLL_PUBLIC int GetPermissions(fz_context* ctx, fz_document* doc)
+	{
+		int tbr = 0;
+
+		if (fz_has_permission(ctx, doc, FZ_PERMISSION_PRINT))
+		{
+			tbr = tbr | 1;
+		}
+
+		if (fz_has_permission(ctx, doc, FZ_PERMISSION_COPY))
+		{
+			tbr = tbr | 2;
+		}
+
+		if (fz_has_permission(ctx, doc, FZ_PERMISSION_EDIT))
+		{
+			tbr = tbr | 4;
+		}
+
+		if (fz_has_permission(ctx, doc, FZ_PERMISSION_ANNOTATE))
+		{
+			tbr = tbr | 8;
+		}
+
+		return tbr;
+	}
+
+	DLL_PUBLIC int UnlockWithPassword(fz_context* ctx, fz_document* doc, const char* password)
+	{
+		return fz_authenticate_password(ctx, doc, password);
+	}
+
+	DLL_PUBLIC int CheckIfPasswordNeeded(fz_context* ctx, fz_document* doc)
+	{
+		return fz_needs_password(ctx, doc);
+	}
+
+	DLL_PUBLIC void ResetOutput(int stdoutFD, int stderrFD)
+	{
+		fprintf(stdout, "\n");
+		fprintf(stderr, "\n");
+
+		fflush(stdout);
+		fflush(stderr);
+
+		dup2(stdoutFD, fileno(stdout));
+		dup2(stderrFD, fileno(stderr));
+
+		fflush(stdout);
+		fflush(stderr);
+	}
+
+	DLL_PUBLIC void WriteToFileDescriptor(int fileDescriptor, const char* text, int length)
+	{
+		while (length > 0)
+		{
+			int written = write(fileDescriptor, text, length);
+
+			text += written;
+
+			length -= written;
+		}
+		
+	}
+
+#if defined _WIN32
+	void RedirectToPipe(const char* pipeName, int fd)
+	{
+		HANDLE hPipe = CreateNamedPipe(TEXT(pipeName), PIPE_ACCESS_DUPLEX, PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_ACCEPT_REMOTE_CLIENTS, 1, 1024 * 16, 1024 * 16, NMPWAIT_WAIT_FOREVER, NULL);
+
+		ConnectNamedPipe(hPipe, NULL);
+
+		int newFd = _open_osfhandle((intptr_t)hPipe, _O_WRONLY | _O_TEXT);
+		dup2(newFd, fd);
+	}
+#else
+	void RedirectToPipe(const char* pipeName, int fd)
+	{
+		struct sockaddr_un local;
+
+		int sockFd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+		local.sun_family = AF_UNIX;
+		strcpy(local.sun_path, pipeName);
+		unlink(pipeName);
+
+#if defined __APPLE__
+		int len = strlen(local.sun_path) + sizeof(local.sun_family) + 1;
+#elif defined __linux__
+		int len = strlen(local.sun_path) + sizeof(local.sun_family);
+#endif
+
+		bind(sockFd, (struct sockaddr*)&local, len);
+
+		listen(sockFd, INT32_MAX);
+
+		int newFd = accept(sockFd, NULL, NULL);
+
+		dup2(newFd, fd);
+	}
+#endif
+
+	DLL_PUBLIC void RedirectOutput(int* stdoutFD, int* stderrFD, const char* stdoutPipe, const char* stderrPipe)
+	{
+		fflush(stdout);
+		fflush(stderr);
+
+		*stdoutFD = dup(fileno(stdout));
+		/*FILE* stdoutFile = fopen("stdout.txt", "w");
+		dup2(fileno(stdoutFile), fileno(stdout));*/
+
+		RedirectToPipe(stdoutPipe, fileno(stdout));
+		setvbuf(stdout, NULL, _IONBF, 0);
+
+		*stderrFD = dup(fileno(stderr));
+		/*FILE* stderrFile = fopen("stderr.txt", "w");
+		dup2(fileno(stderrFile), fileno(stderr));*/
+		RedirectToPipe(stderrPipe, fileno(stderr));
+		setvbuf(stderr, NULL, _IONBF, 0);
+
+		fflush(stdout);
+		fflush(stderr);
+	}
+
+
+	DLL_PUBLIC int GetStructuredTextChar(fz_context* ctx, fz_stext_char* character, int* out_c, uint32_t* out_color, float* out_origin_x, float* out_origin_y, float* out_size, float* out_ll_x, float* out_ll_y, float* out_ul_x, float* out_ul_y, float* out_ur_x, float* out_ur_y, float* out_lr_x, float* out_lr_y, int* out_bidi, fz_font** out_font)
+	{
+		*out_c = character->c;
+
+		*out_color = character->argb;
+
+		*out_origin_x = character->origin.x;
+		*out_origin_y = character->origin.y;
+
+		*out_size = character->size;
+
+		*out_ll_x = character->quad.ll.x;
+		*out_ll_y = character->quad.ll.y;
+
+		*out_ul_x = character->quad.ul.x;
+		*out_ul_y = character->quad.ul.y;
+
+		*out_ur_x = character->quad.ur.x;
+		*out_ur_y = character->quad.ur.y;
+
+		*out_lr_x = character->quad.lr.x;
+		*out_lr_y = character->quad.lr.y;
+
+		*out_bidi = character->bidi;
+		*out_font = character->font;
+		fz_keep_font(ctx, character->font);
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetStructuredTextChars(fz_stext_line* line, fz_stext_char** out_chars)
+	{
+		int count = 0;
+
+		fz_stext_char* curr_char = line->first_char;
+
+		while (curr_char != nullptr)
+		{
+			out_chars[count] = curr_char;
+			count++;
+			curr_char = curr_char->next;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetStructuredTextLine(fz_stext_line* line, int* out_wmode, float* out_x0, float* out_y0, float* out_x1, float* out_y1, float* out_x, float* out_y, int* out_char_count)
+	{
+		*out_wmode = line->wmode;
+
+		*out_x0 = line->bbox.x0;
+		*out_y0 = line->bbox.y0;
+		*out_x1 = line->bbox.x1;
+		*out_y1 = line->bbox.y1;
+
+		*out_x = line->dir.x;
+		*out_y = line->dir.y;
+
+		int count = 0;
+
+		fz_stext_char* curr_char = line->first_char;
+
+		while (curr_char != nullptr)
+		{
+			count++;
+			curr_char = curr_char->next;
+		}
+
+		*out_char_count = count;
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetStructuredTextLines(fz_stext_block* block, fz_stext_line** out_lines)
+	{
+		int count = 0;
+
+		fz_stext_line* curr_line = block->u.t.first_line;
+
+		while (curr_line != nullptr)
+		{
+			out_lines[count] = curr_line;
+			count++;
+			curr_line = curr_line->next;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC void GetStructStructuredTextBlockRawStructure(fz_stext_struct* struct_block, int raw_length, char* out_raw)
+	{
+		strncpy(out_raw, struct_block->raw, raw_length);
+	}
+
+	DLL_PUBLIC int GetStructStructuredTextBlock(fz_stext_struct* struct_block, int* out_raw_length, fz_structure* out_standard, fz_stext_struct** out_parent, fz_stext_block** out_blocks)
+	{
+		*out_raw_length = (int)strlen(struct_block->raw);
+		*out_standard = struct_block->standard;
+		*out_parent = struct_block->parent;
+
+		fz_stext_block* curr_block = struct_block->first_block;
+
+		int count = 0;
+
+		while (curr_block != nullptr)
+		{
+			out_blocks[count] = curr_block;
+			count++;
+			curr_block = curr_block->next;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int CountStructStructuredTextBlockChildren(fz_stext_struct* struct_block)
+	{
+		fz_stext_block* curr_block = struct_block->first_block;
+
+		int count = 0;
+
+		while (curr_block != nullptr)
+		{
+			count++;
+			curr_block = curr_block->next;
+		}
+
+		return count;
+	}
+
+	DLL_PUBLIC int GetGridStructuredTextBlock(fz_stext_block* block, int xs_len, int ys_len, int* out_x_max_uncertainty, int* out_y_max_uncertainty, float* out_x_pos, float* out_y_pos, int* out_x_uncertainty, int* out_y_uncertainty)
+	{
+		*out_x_max_uncertainty = block->u.b.xs->max_uncertainty;
+		*out_y_max_uncertainty = block->u.b.ys->max_uncertainty;
+
+		for (int i = 0; i < xs_len; i++)
+		{
+			out_x_pos[i] = block->u.b.xs->list[i].pos;
+			out_x_uncertainty[i] = block->u.b.xs->list[i].uncertainty;
+		}
+
+		for (int i = 0; i < ys_len; i++)
+		{
+			out_y_pos[i] = block->u.b.ys->list[i].pos;
+			out_y_uncertainty[i] = block->u.b.ys->list[i].uncertainty;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetStructuredTextBlock(fz_context* ctx, fz_stext_block* block, int* out_type, float* out_x0, float* out_y0, float* out_x1, float* out_y1, int* out_line_count, fz_image** out_image, float* out_a, float* out_b, float* out_c, float* out_d, float* out_e, float* out_f, uint8_t* out_stroked, uint32_t* out_argb, int* out_xs_len, int* out_ys_len, fz_stext_struct** out_down, int* out_index)
+	{
+		*out_type = block->type;
+
+		*out_x0 = block->bbox.x0;
+		*out_y0 = block->bbox.y0;
+		*out_x1 = block->bbox.x1;
+		*out_y1 = block->bbox.y1;
+
+		if (block->type == FZ_STEXT_BLOCK_IMAGE)
+		{
+			*out_line_count = 0;
+			*out_image = block->u.i.image;
+			fz_keep_image(ctx, block->u.i.image);
+			*out_a = block->u.i.transform.a;
+			*out_b = block->u.i.transform.b;
+			*out_c = block->u.i.transform.c;
+			*out_d = block->u.i.transform.d;
+			*out_e = block->u.i.transform.e;
+			*out_f = block->u.i.transform.f;
+		}
+		else if (block->type == FZ_STEXT_BLOCK_TEXT)
+		{
+			int count = 0;
+
+			fz_stext_line* curr_line = block->u.t.first_line;
+
+			while (curr_line != nullptr)
+			{
+				count++;
+				curr_line = curr_line->next;
+			}
+
+			*out_line_count = count;
+		}
+		else if (block->type == FZ_STEXT_BLOCK_VECTOR)
+		{
+			*out_line_count = 0;
+			*out_stroked = block->u.v.stroked;
+			*out_argb = block->u.v.argb;
+		}
+		else if (block->type == FZ_STEXT_BLOCK_GRID)
+		{
+			*out_line_count = 0;
+			*out_xs_len = block->u.b.xs->len;
+			*out_ys_len = block->u.b.ys->len;
+		}
+		else if (block->type == FZ_STEXT_BLOCK_STRUCT)
+		{
+			*out_line_count = 0;
+			*out_down = block->u.s.down;
+			*out_index = block->u.s.index;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetStructuredTextBlocks(fz_stext_page* page, fz_stext_block** out_blocks)
+	{
+		fz_stext_block* curr_block = page->first_block;
+
+		int count = 0;
+
+		while (curr_block != nullptr)
+		{
+			out_blocks[count] = curr_block;
+			count++;
+			curr_block = curr_block->next;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	typedef int (*progressCallback)(int progress);
+
+	int progressFunction(fz_context* ctx, void* progress_arg, int progress)
+	{
+		return (*((progressCallback*)progress_arg))(progress);
+	}
+
+	DLL_PUBLIC int GetStructuredTextPageWithOCR(fz_context* ctx, fz_display_list* list, int flags, fz_stext_page** out_page, int* out_stext_block_count, float zoom, float x0, float y0, float x1, float y1, char* prefix, char* language, int callback(int))
+	{
+		if (prefix != NULL)
+		{
+			putenv(prefix);
+		}
+
+		fz_stext_page* page;
+		fz_stext_options options;
+		fz_device* device;
+		fz_device* ocr_device;
+		fz_rect bounds;
+		fz_matrix ctm;
+
+		ctm = fz_scale(zoom, zoom);
+
+		bounds.x0 = x0;
+		bounds.y0 = y0;
+		bounds.x1 = x1;
+		bounds.y1 = y1;
+
+		fz_var(page);
+		fz_var(device);
+
+		options.flags = 0;
+
+		fz_try(ctx)
+		{
+			page = fz_new_stext_page(ctx, fz_infinite_rect);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_CREATE_PAGE;
+		}
+
+		fz_try(ctx)
+		{
+			device = fz_new_stext_device(ctx, page, &options);
+
+#if defined _WIN32 && (defined(i386) || defined(__i386__) || defined(__i386) || defined(_M_IX86))
+			ocr_device = fz_new_ocr_device(ctx, device, ctm, bounds, true, language, NULL, NULL, NULL);
+#else
+			ocr_device = fz_new_ocr_device(ctx, device, ctm, bounds, true, language, NULL, progressFunction, &callback);
+#endif
+
+			fz_run_display_list(ctx, list, ocr_device, ctm, fz_infinite_rect, NULL);
+
+			fz_close_device(ctx, ocr_device);
+			fz_drop_device(ctx, ocr_device);
+			ocr_device = NULL;
+
+			fz_close_device(ctx, device);
+			fz_drop_device(ctx, device);
+			device = NULL;
+		}
+		fz_always(ctx)
+		{
+			fz_close_device(ctx, device);
+			fz_drop_device(ctx, device);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_POPULATE_PAGE;
+		}
+
+		*out_page = page;
+
+		int count = 0;
+
+		fz_stext_block* curr_block = page->first_block;
+
+		while (curr_block != nullptr)
+		{
+			count++;
+			curr_block = curr_block->next;
 		}
+
+		*out_stext_block_count = count;
+
+		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC void ReadDefaultOCGConfigNameLength(fz_context* ctx, pdf_document *doc, int* out_name_length, int* out_creator_length)
+	DLL_PUBLIC int GetStructuredTextPage(fz_context* ctx, fz_display_list* list, int flags, fz_stext_page** out_page, int* out_stext_block_count)
 	{
-		pdf_layer_config info;
-		pdf_default_layer_config_info(ctx, doc, &info);
+		fz_stext_page* page;
+		fz_stext_options options;
+		fz_device* device;
 
-		if (info.name != nullptr)
+		fz_try(ctx)
 		{
-			*out_name_length = (int)strlen(info.name);
+			page = fz_new_stext_page(ctx, fz_infinite_rect);
 		}
-		else
+		fz_catch(ctx)
 		{
-			*out_name_length = 0;
+			return ERR_CANNOT_CREATE_PAGE;
 		}
 
-		if (info.creator != nullptr)
+		options.flags = flags;
+
+		fz_try(ctx)
 		{
-			*out_creator_length = (int)strlen(info.creator);
+			device = fz_new_stext_device(ctx, page, &options);
+			fz_run_display_list(ctx, list, device, fz_identity, fz_infinite_rect, NULL);
+			fz_close_device(ctx, device);
 		}
-		else
+		fz_always(ctx)
 		{
-			*out_creator_length = 0;
+			fz_drop_device(ctx, device);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_POPULATE_PAGE;
+		}
+
+		*out_page = page;
+
+		int count = 0;
+
+		fz_stext_block* curr_block = page->first_block;
+
+		while (curr_block != nullptr)
+		{
+			count++;
+			curr_block = curr_block->next;
 		}
+
+		*out_stext_block_count = count;
+
+		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int GetPDFDocument(fz_context* ctx, fz_document* doc, const pdf_document** out_pdf_doc)
+	DLL_PUBLIC int DisposeStructuredTextPage(fz_context* ctx, fz_stext_page* page)
 	{
-		pdf_document* pdfDoc = fz_new_pdf_document_from_fz_document(ctx, doc);
+		fz_drop_stext_page(ctx, page);
+		return EXIT_SUCCESS;
+	}
 
-		if (pdfDoc == nullptr)
+	//Count the text blocks, lines and characters in a list of blocks, descending into structure blocks.
+	static void count_stext_blocks(fz_stext_block* block, int* block_count, int* line_count, int* char_count)
+	{
+		for (; block != nullptr; block = block->next)
 		{
-			return ERR_CANNOT_CONVERT_TO_PDF;
+			if (block->type == FZ_STEXT_BLOCK_TEXT)
+			{
+				(*block_count)++;
+
+				for (fz_stext_line* line = block->u.t.first_line; line != nullptr; line = line->next)
+				{
+					(*line_count)++;
+
+					for (fz_stext_char* ch = line->first_char; ch != nullptr; ch = ch->next)
+					{
+						(*char_count)++;
+					}
+				}
+			}
+			else if (block->type == FZ_STEXT_BLOCK_STRUCT && block->u.s.down != nullptr)
+			{
+				count_stext_blocks(block->u.s.down->first_block, block_count, line_count, char_count);
+			}
 		}
-		else
+	}
+
+	//Copy the text blocks in a list of blocks (descending into structure blocks) into the buffer described by header. The fonts are collected (without duplicates) in the font table.
+	static void fill_stext_blocks(fz_stext_block* block, unsigned char* data, stext_page_data_header* header, int* block_index, int* line_index, int* char_index, int* last_font)
+	{
+		fz_stext_block** block_pointers = (fz_stext_block**)(data + header->block_pointers);
+		int32_t* block_first_lines = (int32_t*)(data + header->block_first_lines);
+		int32_t* block_line_counts = (int32_t*)(data + header->block_line_counts);
+
+		int32_t* line_wmodes = (int32_t*)(data + header->line_wmodes);
+		float* line_bboxes = (float*)(data + header->line_bboxes);
+		float* line_dirs = (float*)(data + header->line_dirs);
+		int32_t* line_first_chars = (int32_t*)(data + header->line_first_chars);
+		int32_t* line_char_counts = (int32_t*)(data + header->line_char_counts);
+
+		int32_t* char_codepoints = (int32_t*)(data + header->char_codepoints);
+		uint32_t* char_colors = (uint32_t*)(data + header->char_colors);
+		int32_t* char_bidis = (int32_t*)(data + header->char_bidis);
+		int32_t* char_fonts = (int32_t*)(data + header->char_fonts);
+		float* char_sizes = (float*)(data + header->char_sizes);
+		float* char_origins = (float*)(data + header->char_origins);
+		float* char_quads = (float*)(data + header->char_quads);
+
+		fz_font** font_pointers = (fz_font**)(data + header->font_pointers);
+
+		for (; block != nullptr; block = block->next)
 		{
-			*out_pdf_doc = pdfDoc;
-			return EXIT_SUCCESS;
+			if (block->type == FZ_STEXT_BLOCK_TEXT)
+			{
+				int b = (*block_index)++;
+
+				block_pointers[b] = block;
+				block_first_lines[b] = *line_index;
+				block_line_counts[b] = 0;
+
+				for (fz_stext_line* line = block->u.t.first_line; line != nullptr; line = line->next)
+				{
+					int l = (*line_index)++;
+					block_line_counts[b]++;
+
+					line_wmodes[l] = line->wmode;
+					line_bboxes[l * 4] = line->bbox.x0;
+					line_bboxes[l * 4 + 1] = line->bbox.y0;
+					line_bboxes[l * 4 + 2] = line->bbox.x1;
+					line_bboxes[l * 4 + 3] = line->bbox.y1;
+					line_dirs[l * 2] = line->dir.x;
+					line_dirs[l * 2 + 1] = line->dir.y;
+					line_first_chars[l] = *char_index;
+					line_char_counts[l] = 0;
+
+					for (fz_stext_char* ch = line->first_char; ch != nullptr; ch = ch->next)
+					{
+						int c = (*char_index)++;
+						line_char_counts[l]++;
+
+						char_codepoints[c] = ch->c;
+						char_colors[c] = ch->argb;
+						char_bidis[c] = ch->bidi;
+						char_sizes[c] = ch->size;
+						char_origins[c * 2] = ch->origin.x;
+						char_origins[c * 2 + 1] = ch->origin.y;
+
+						char_quads[c * 8] = ch->quad.ll.x;
+						char_quads[c * 8 + 1] = ch->quad.ll.y;
+						char_quads[c * 8 + 2] = ch->quad.ul.x;
+						char_quads[c * 8 + 3] = ch->quad.ul.y;
+						char_quads[c * 8 + 4] = ch->quad.ur.x;
+						char_quads[c * 8 + 5] = ch->quad.ur.y;
+						char_quads[c * 8 + 6] = ch->quad.lr.x;
+						char_quads[c * 8 + 7] = ch->quad.lr.y;
+
+						//Consecutive characters almost always share the same font, so check the last one first.
+						int font = -1;
+
+						if (*last_font >= 0 && font_pointers[*last_font] == ch->font)
+						{
+							font = *last_font;
+						}
+						else
+						{
+							for (int i = 0; i < header->font_count; i++)
+							{
+								if (font_pointers[i] == ch->font)
+								{
+									font = i;
+									break;
+								}
+							}
+
+							if (font < 0)
+							{
+								font = header->font_count++;
+								font_pointers[font] = ch->font;
+							}
+						}
+
+						char_fonts[c] = font;
+						*last_font = font;
+					}
+				}
+			}
+			else if (block->type == FZ_STEXT_BLOCK_STRUCT && block->u.s.down != nullptr)
+			{
+				fill_stext_blocks(block->u.s.down->first_block, data, header, block_index, line_index, char_index, last_font);
+			}
 		}
 	}
 
-	DLL_PUBLIC void DisposeFont(fz_context* ctx, fz_font* font)
+	DLL_PUBLIC int GetStructuredTextPageData(fz_context* ctx, fz_stext_page* page, unsigned char** out_data, int64_t* out_length)
 	{
-		fz_drop_font(ctx, font);
+		int block_count = 0;
+		int line_count = 0;
+		int char_count = 0;
+
+		count_stext_blocks(page->first_block, &block_count, &line_count, &char_count);
+
+		stext_page_data_header header;
+		header.version = STEXT_PAGE_DATA_VERSION;
+		header.block_count = block_count;
+		header.line_count = line_count;
+		header.char_count = char_count;
+		header.font_count = 0;
+		header.reserved = 0;
+
+		//Pointer arrays go first, so that every array is suitably aligned.
+		int64_t offset = sizeof(stext_page_data_header);
+
+		header.block_pointers = offset; offset += sizeof(fz_stext_block*) * (int64_t)block_count;
+		header.font_pointers = offset; offset += sizeof(fz_font*) * (int64_t)char_count;
+
+		header.block_first_lines = offset; offset += sizeof(int32_t) * (int64_t)block_count;
+		header.block_line_counts = offset; offset += sizeof(int32_t) * (int64_t)block_count;
+
+		header.line_wmodes = offset; offset += sizeof(int32_t) * (int64_t)line_count;
+		header.line_bboxes = offset; offset += sizeof(float) * 4 * (int64_t)line_count;
+		header.line_dirs = offset; offset += sizeof(float) * 2 * (int64_t)line_count;
+		header.line_first_chars = offset; offset += sizeof(int32_t) * (int64_t)line_count;
+		header.line_char_counts = offset; offset += sizeof(int32_t) * (int64_t)line_count;
+
+		header.char_codepoints = offset; offset += sizeof(int32_t) * (int64_t)char_count;
+		header.char_colors = offset; offset += sizeof(uint32_t) * (int64_t)char_count;
+		header.char_bidis = offset; offset += sizeof(int32_t) * (int64_t)char_count;
+		header.char_fonts = offset; offset += sizeof(int32_t) * (int64_t)char_count;
+		header.char_sizes = offset; offset += sizeof(float) * (int64_t)char_count;
+		header.char_origins = offset; offset += sizeof(float) * 2 * (int64_t)char_count;
+		header.char_quads = offset; offset += sizeof(float) * 8 * (int64_t)char_count;
+
+		unsigned char* data;
+
+		fz_try(ctx)
+		{
+			data = (unsigned char*)fz_malloc(ctx, offset);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_CREATE_BUFFER;
+		}
+
+		int block_index = 0;
+		int line_index = 0;
+		int char_index = 0;
+		int last_font = -1;
+
+		fill_stext_blocks(page->first_block, data, &header, &block_index, &line_index, &char_index, &last_font);
+
+		fz_font** font_pointers = (fz_font**)(data + header.font_pointers);
+
+		for (int i = 0; i < header.font_count; i++)
+		{
+			fz_keep_font(ctx, font_pointers[i]);
+		}
+
+		memcpy(data, &header, sizeof(stext_page_data_header));
+
+		*out_data = data;
+		*out_length = offset;
+
+		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC void DisposeImage(fz_context* ctx, fz_image* image)
+	DLL_PUBLIC void DisposeStructuredTextPageData(fz_context* ctx, unsigned char* data)
 	{
-		fz_drop_image(ctx, image);
+		fz_free(ctx, data);
 	}
 
-	DLL_PUBLIC void DisposeColorSpace(fz_context* ctx, fz_colorspace* cs)
+	//The same characters as char.IsWhiteSpace in .NET, so that the lines that are skipped match those skipped by the managed text extraction.
+	static int is_white_space(int c)
 	{
-		fz_drop_colorspace(ctx, cs);
+		return (c >= 0x09 && c <= 0x0D) || c == 0x20 || c == 0x85 || c == 0xA0 || c == 0x1680 || (c >= 0x2000 && c <= 0x200A) || c == 0x2028 || c == 0x2029 || c == 0x202F || c == 0x205F || c == 0x3000;
 	}
 
-	DLL_PUBLIC int GetT3Procs(fz_context* ctx, fz_font* font, fz_buffer*** out_t3_procs)
+	//Destination of the text produced by append_stext_blocks_text: either a growable buffer (always UTF-8) or a fixed-size buffer provided by the caller.
+	struct text_writer
+	{
+		fz_buffer* buf;
+		int encoding;
+		void* data;
+		int64_t capacity;
+		int64_t length;
+		int full;
+	};
+
+	//Append a code point to the text. Once the caller's buffer is full, nothing else is written to it, but the length keeps growing, so that the caller knows how much space is needed.
+	static void text_writer_append_rune(fz_context* ctx, text_writer* writer, int c)
+	{
+		if (writer->buf != NULL)
+		{
+			fz_append_rune(ctx, writer->buf, c);
+			return;
+		}
+
+		if (writer->encoding == TEXT_ENCODING_UTF16)
+		{
+			uint16_t units[2];
+			int count;
+
+			if (c >= 0x10000 && c <= 0x10FFFF)
+			{
+				c -= 0x10000;
+				units[0] = (uint16_t)(0xD800 + (c >> 10));
+				units[1] = (uint16_t)(0xDC00 + (c & 0x3FF));
+				count = 2;
+			}
+			else if (c < 0 || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF))
+			{
+				units[0] = 0xFFFD;
+				count = 1;
+			}
+			else
+			{
+				units[0] = (uint16_t)c;
+				count = 1;
+			}
+
+			if (!writer->full && writer->length + count <= writer->capacity)
+			{
+				memcpy((uint16_t*)writer->data + writer->length, units, count * sizeof(uint16_t));
+			}
+			else
+			{
+				writer->full = 1;
+			}
+
+			writer->length += count;
+		}
+		else
+		{
+			char bytes[FZ_UTFMAX];
+			int count = fz_runetochar(bytes, c);
+
+			if (!writer->full && writer->length + count <= writer->capacity)
+			{
+				memcpy((unsigned char*)writer->data + writer->length, bytes, count);
+			}
+			else
+			{
+				writer->full = 1;
+			}
+
+			writer->length += count;
+		}
+	}
+
+	//Append a null-terminated UTF-8 string to the text.
+	static void text_writer_append_string(fz_context* ctx, text_writer* writer, const char* str)
+	{
+		if (writer->buf != NULL)
+		{
+			fz_append_string(ctx, writer->buf, str);
+			return;
+		}
+
+		while (*str)
+		{
+			int c;
+			str += fz_chartorune(&c, str);
+			text_writer_append_rune(ctx, writer, c);
+		}
+	}
+
+	//Append the text lines in a list of blocks (descending into structure blocks) to the writer, skipping empty and blank lines. Lines are separated by separator; started is set once the first line has been written.
+	static void append_stext_blocks_text(fz_context* ctx, fz_stext_block* block, const char* separator, text_writer* writer, int* started)
+	{
+		for (; block != nullptr; block = block->next)
+		{
+			if (block->type == FZ_STEXT_BLOCK_TEXT)
+			{
+				for (fz_stext_line* line = block->u.t.first_line; line != nullptr; line = line->next)
+				{
+					int blank = 1;
+
+					for (fz_stext_char* ch = line->first_char; ch != nullptr; ch = ch->next)
+					{
+						if (!is_white_space(ch->c))
+						{
+							blank = 0;
+							break;
+						}
+					}
+
+					if (blank)
+					{
+						continue;
+					}
+
+					if (*started)
+					{
+						text_writer_append_string(ctx, writer, separator);
+					}
+					else
+					{
+						*started = 1;
+					}
+
+					for (fz_stext_char* ch = line->first_char; ch != nullptr; ch = ch->next)
+					{
+						text_writer_append_rune(ctx, writer, ch->c);
+					}
+				}
+			}
+			else if (block->type == FZ_STEXT_BLOCK_STRUCT && block->u.s.down != nullptr)
+			{
+				append_stext_blocks_text(ctx, block->u.s.down->first_block, separator, writer, started);
+			}
+		}
+	}
+
+	DLL_PUBLIC int ExtractPageTextUTF8(fz_context* ctx, fz_page* page, int annotations, int flags, const char* separator, fz_cookie* cookie, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length)
 	{
+		fz_stext_page* text_page = NULL;
+		fz_device* device = NULL;
+		fz_buffer* buf = NULL;
+		fz_stext_options options = { 0 };
+
+		fz_var(text_page);
+		fz_var(device);
+		fz_var(buf);
+
+		options.flags = flags;
+
 		fz_try(ctx)
 		{
-			*out_t3_procs = fz_font_t3_procs(ctx, font);
+			text_page = fz_new_stext_page(ctx, fz_bound_page(ctx, page));
+			device = fz_new_stext_device(ctx, text_page, &options);
+
+			if (annotations)
+			{
+				fz_run_page(ctx, page, device, fz_identity, cookie);
+			}
+			else
+			{
+				fz_run_page_contents(ctx, page, device, fz_identity, cookie);
+			}
+
+			fz_close_device(ctx, device);
+		}
+		fz_always(ctx)
+		{
+			fz_drop_device(ctx, device);
 		}
 		fz_catch(ctx)
-		{			
-			return ERR_FONT_METADATA;
+		{
+			fz_drop_stext_page(ctx, text_page);
+			return ERR_CANNOT_POPULATE_PAGE;
 		}
 
-		return EXIT_SUCCESS;
-	}
-
-	DLL_PUBLIC int GetFTHandle(fz_context* ctx, fz_font* font, void** out_handle)
-	{
 		fz_try(ctx)
 		{
-			*out_handle = fz_font_ft_face(ctx, font);
+			int started = 0;
+
+			buf = fz_new_buffer(ctx, 4096);
+
+			text_writer writer = { 0 };
+			writer.buf = buf;
+
+			append_stext_blocks_text(ctx, text_page->first_block, separator, &writer, &started);
+		}
+		fz_always(ctx)
+		{
+			fz_drop_stext_page(ctx, text_page);
 		}
 		fz_catch(ctx)
-		{			
-			return ERR_FONT_METADATA;
+		{
+			fz_drop_buffer(ctx, buf);
+			return ERR_CANNOT_CREATE_BUFFER;
 		}
 
+		*out_buffer = buf;
+		*out_length = fz_buffer_storage(ctx, buf, (unsigned char**)out_data);
+
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int GetFontName(fz_context* ctx, fz_font* font, int length, char* out_name)
+	DLL_PUBLIC int GetPageText(fz_context* ctx, fz_display_list* list, int flags, const char* separator, int encoding, void* buffer, int64_t buffer_length, int64_t* out_length)
 	{
+		fz_stext_page* text_page = NULL;
+		fz_device* device = NULL;
+		fz_stext_options options = { 0 };
+
+		fz_var(text_page);
+		fz_var(device);
+
+		options.flags = flags;
+
 		fz_try(ctx)
 		{
-			const char* name = fz_font_name(ctx, font);
-			strncpy(out_name, name, length);
+			text_page = fz_new_stext_page(ctx, fz_infinite_rect);
 		}
 		fz_catch(ctx)
 		{
-			return ERR_FONT_METADATA;
+			return ERR_CANNOT_CREATE_PAGE;
 		}
 
-		return EXIT_SUCCESS;
-	}
-
-	DLL_PUBLIC int GetFontMetadata(fz_context* ctx, fz_font* font, int* out_font_name_length, int* out_bold, int* out_italic, int* out_serif, int* out_monospaced)
-	{
 		fz_try(ctx)
 		{
-			*out_font_name_length = (int)strlen(fz_font_name(ctx, font));
-			*out_bold = fz_font_is_bold(ctx, font);
-			*out_italic = fz_font_is_italic(ctx, font);
-			*out_serif = fz_font_is_serif(ctx, font);
-			*out_monospaced = fz_font_is_monospaced(ctx, font);
+			device = fz_new_stext_device(ctx, text_page, &options);
+			fz_run_display_list(ctx, list, device, fz_identity, fz_infinite_rect, NULL);
+			fz_close_device(ctx, device);
+		}
+		fz_always(ctx)
+		{
+			fz_drop_device(ctx, device);
 		}
 		fz_catch(ctx)
 		{
-			return ERR_FONT_METADATA;
+			fz_drop_stext_page(ctx, text_page);
+			return ERR_CANNOT_POPULATE_PAGE;
 		}
 
+		text_writer writer = { 0 };
+		writer.encoding = encoding;
+		writer.data = buffer;
+		writer.capacity = buffer != NULL ? buffer_length : 0;
+
+		int started = 0;
+
+		append_stext_blocks_text(ctx, text_page->first_block, separator, &writer, &started);
+
+		fz_drop_stext_page(ctx, text_page);
+
+		*out_length = writer.length;
+
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int GetColorantName(fz_context* ctx, fz_colorspace* cs, int n, int length, char* out_name)
+	//A character of a structured text page, together with its address as used by MuPDFStructuredTextPage.
+	struct stext_char_address
 	{
-		fz_try(ctx)
+		fz_stext_char* ch;
+		int32_t block;
+		int32_t line;
+		int32_t character;
+	};
+
+	//Collect the characters of a block, descending into structure blocks. All the lines within a top-level block are numbered consecutively.
+	static void collect_stext_char_addresses(fz_stext_block* block, int32_t block_index, int32_t* line_index, stext_char_address* chars, int* char_count)
+	{
+		if (block->type == FZ_STEXT_BLOCK_TEXT)
 		{
-			const char* name = fz_colorspace_colorant(ctx, cs, n);
-			strncpy(out_name, name, length);
+			for (fz_stext_line* line = block->u.t.first_line; line != nullptr; line = line->next)
+			{
+				int32_t char_index = 0;
+
+				for (fz_stext_char* ch = line->first_char; ch != nullptr; ch = ch->next)
+				{
+					stext_char_address* address = &chars[(*char_count)++];
+					address->ch = ch;
+					address->block = block_index;
+					address->line = *line_index;
+					address->character = char_index++;
+				}
+
+				(*line_index)++;
+			}
 		}
-		fz_catch(ctx)
+		else if (block->type == FZ_STEXT_BLOCK_STRUCT && block->u.s.down != nullptr)
 		{
-			return ERR_COLORSPACE_METADATA;
+			for (fz_stext_block* child = block->u.s.down->first_block; child != nullptr; child = child->next)
+			{
+				collect_stext_char_addresses(child, block_index, line_index, chars, char_count);
+			}
 		}
-
-		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int GetColorantNameLength(fz_context* ctx, fz_colorspace* cs, int n, int* out_name_length)
+	//Hits collected by search_callback.
+	struct search_state
 	{
-		fz_try(ctx)
+		fz_quad* quads;
+		int quad_count;
+		int quad_capacity;
+
+		stext_search_hit* hits;
+		int hit_count;
+		int hit_capacity;
+
+		int max_hits;
+	};
+
+	static int search_callback(fz_context* ctx, void* opaque, int num_quads, fz_quad* hit_bbox)
+	{
+		search_state* state = (search_state*)opaque;
+
+		if (state->hit_count == state->hit_capacity)
 		{
-			*out_name_length = (int)strlen(fz_colorspace_colorant(ctx, cs, n));
+			int new_capacity = state->hit_capacity > 0 ? state->hit_capacity * 2 : 16;
+			state->hits = fz_realloc_array(ctx, state->hits, new_capacity, stext_search_hit);
+			state->hit_capacity = new_capacity;
 		}
-		fz_catch(ctx)
+
+		if (state->quad_count + num_quads > state->quad_capacity)
 		{
-			return ERR_COLORSPACE_METADATA;
+			int new_capacity = state->quad_capacity > 0 ? state->quad_capacity * 2 : 16;
+
+			while (new_capacity < state->quad_count + num_quads)
+			{
+				new_capacity *= 2;
+			}
+
+			state->quads = fz_realloc_array(ctx, state->quads, new_capacity, fz_quad);
+			state->quad_capacity = new_capacity;
 		}
 
-		return EXIT_SUCCESS;
+		stext_search_hit* hit = &state->hits[state->hit_count++];
+		hit->first_quad = state->quad_count;
+		hit->quad_count = num_quads;
+
+		memcpy(state->quads + state->quad_count, hit_bbox, num_quads * sizeof(fz_quad));
+		state->quad_count += num_quads;
+
+		return state->max_hits > 0 && state->hit_count >= state->max_hits ? 1 : 0;
 	}
 
-	DLL_PUBLIC int GetColorSpaceName(fz_context* ctx, fz_colorspace* cs, int length, char* out_name)
+	//Find the character where a hit starts (whose left edge matches the start of the quad) or ends (whose right edge matches the end of the quad). MuPDF builds the hit quads
+	//by joining the quads of consecutive characters, so the points match exactly. Since hits are reported in reading order, the search starts from the previous hit and wraps around.
+	static int find_stext_char(stext_char_address* chars, int char_count, int from, const fz_quad* quad, int end)
 	{
-		fz_try(ctx)
+		for (int n = 0; n < char_count; n++)
 		{
-			const char* name = fz_colorspace_name(ctx, cs);
-			strncpy(out_name, name, length);
+			int i = (from + n) % char_count;
+			const fz_quad* q = &chars[i].ch->quad;
+
+			if (end ? (q->ur.x == quad->ur.x && q->ur.y == quad->ur.y && q->lr.x == quad->lr.x && q->lr.y == quad->lr.y) : (q->ll.x == quad->ll.x && q->ll.y == quad->ll.y && q->ul.x == quad->ul.x && q->ul.y == quad->ul.y))
+			{
+				return i;
+			}
 		}
-		fz_catch(ctx)
+
+		return -1;
+	}
+
+	//Check whether the characters of a hit match the needle exactly. White space is compared loosely, like MuPDF does when searching.
+	static int hit_matches_needle(stext_char_address* chars, int start, int end, const char* needle)
+	{
+		int i = start;
+
+		while (1)
 		{
-			return ERR_COLORSPACE_METADATA;
-		}
+			int c = 0;
 
-		return EXIT_SUCCESS;
+			while (*needle)
+			{
+				int n = fz_chartorune(&c, needle);
+
+				if (!is_white_space(c))
+				{
+					break;
+				}
+
+				needle += n;
+			}
+
+			while (i <= end && is_white_space(chars[i].ch->c))
+			{
+				i++;
+			}
+
+			if (!*needle)
+			{
+				return 1;
+			}
+
+			if (i > end)
+			{
+				return 0;
+			}
+
+			needle += fz_chartorune(&c, needle);
+
+			if (c != chars[i].ch->c)
+			{
+				return 0;
+			}
+
+			i++;
+		}
 	}
 
-	DLL_PUBLIC int GetColorSpaceData(fz_context* ctx, fz_colorspace* cs, int* out_cs_type, int* out_name_len, fz_colorspace** out_base_cs, int* out_lookup_size, unsigned char** out_lookup_table)
+	DLL_PUBLIC int SearchStructuredTextPage(fz_context* ctx, fz_stext_page* page, const char* needle, int options, int max_hits, unsigned char** out_data, int* out_hit_count, int* out_quad_count)
 	{
+		search_state state = { 0 };
+		stext_char_address* chars = NULL;
+		unsigned char* data = NULL;
+		int hit_count = 0;
+		int quad_count = 0;
+
+		//Case-sensitive searches discard some of the hits found by MuPDF, so the search cannot stop early; the limit is applied after filtering.
+		state.max_hits = (options & SEARCH_CASE_SENSITIVE) ? 0 : max_hits;
+
+		fz_var(chars);
+		fz_var(data);
+		fz_var(hit_count);
+		fz_var(quad_count);
+
 		fz_try(ctx)
 		{
-			*out_cs_type = fz_colorspace_type(ctx, cs);
-			*out_name_len = (int)strlen(fz_colorspace_name(ctx, cs));
+			fz_search_stext_page_cb(ctx, page, needle, search_callback, &state);
 
-			if (*out_cs_type == FZ_COLORSPACE_INDEXED)
+			if (state.hit_count > 0)
 			{
-				*out_base_cs = fz_base_colorspace(ctx, cs);
-				*out_lookup_size = cs->u.indexed.high;
-				*out_lookup_table = cs ->u.indexed.lookup;
+				int block_count = 0;
+				int line_count = 0;
+				int char_count = 0;
+
+				count_stext_blocks(page->first_block, &block_count, &line_count, &char_count);
+
+				chars = fz_malloc_array(ctx, char_count > 0 ? char_count : 1, stext_char_address);
+				char_count = 0;
+
+				int32_t block_index = 0;
+
+				for (fz_stext_block* block = page->first_block; block != nullptr; block = block->next)
+				{
+					int32_t line_index = 0;
+					collect_stext_char_addresses(block, block_index++, &line_index, chars, &char_count);
+				}
+
+				int cursor = 0;
+
+				//Hits that are discarded leave their quads behind, so the quads are compacted while the hits are mapped to addresses.
+				for (int i = 0; i < state.hit_count && (max_hits <= 0 || hit_count < max_hits); i++)
+				{
+					stext_search_hit* hit = &state.hits[i];
+
+					int start = char_count > 0 ? find_stext_char(chars, char_count, cursor, &state.quads[hit->first_quad], 0) : -1;
+					int end = start >= 0 ? find_stext_char(chars, char_count, start, &state.quads[hit->first_quad + hit->quad_count - 1], 1) : -1;
+
+					if ((options & SEARCH_CASE_SENSITIVE) && start >= 0 && end >= start && !hit_matches_needle(chars, start, end, needle))
+					{
+						continue;
+					}
+
+					stext_search_hit* kept = &state.hits[hit_count++];
+
+					memmove(state.quads + quad_count, state.quads + hit->first_quad, hit->quad_count * sizeof(fz_quad));
+
+					kept->quad_count = hit->quad_count;
+					kept->first_quad = quad_count;
+					quad_count += kept->quad_count;
+
+					if (start >= 0 && end >= 0)
+					{
+						kept->start_block = chars[start].block;
+						kept->start_line = chars[start].line;
+						kept->start_char = chars[start].character;
+						kept->end_block = chars[end].block;
+						kept->end_line = chars[end].line;
+						kept->end_char = chars[end].character;
+						cursor = end;
+					}
+					else
+					{
+						kept->start_block = kept->start_line = kept->start_char = -1;
+						kept->end_block = kept->end_line = kept->end_char = -1;
+					}
+				}
 			}
-			else if (*out_cs_type == FZ_COLORSPACE_SEPARATION)
+
+			if (hit_count > 0)
 			{
-				*out_base_cs = cs->u.separation.base;
-				*out_lookup_size = fz_colorspace_n(ctx, cs);
+				size_t hits_size = sizeof(stext_search_hit) * (size_t)hit_count;
+				data = (unsigned char*)fz_malloc(ctx, hits_size + sizeof(fz_quad) * (size_t)quad_count);
+				memcpy(data, state.hits, hits_size);
+				memcpy(data + hits_size, state.quads, sizeof(fz_quad) * (size_t)quad_count);
 			}
 		}
+		fz_always(ctx)
+		{
+			fz_free(ctx, chars);
+			fz_free(ctx, state.hits);
+			fz_free(ctx, state.quads);
+		}
 		fz_catch(ctx)
 		{
-			return ERR_COLORSPACE_METADATA;
+			return ERR_CANNOT_CREATE_BUFFER;
 		}
 
+		*out_data = data;
+		*out_hit_count = hit_count;
+		*out_quad_count = quad_count;
+
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int WriteRasterImage(fz_context* ctx, fz_image *image, int output_format, int quality, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length, int convert_to_rgb)
+	DLL_PUBLIC int SearchDisplayListText(fz_context* ctx, fz_display_list* list, int flags, const char* needle, int options, int max_hits, unsigned char** out_data, int* out_hit_count, int* out_quad_count)
 	{
-		fz_pixmap* pix;
-		fz_output* out;
-		fz_buffer* buf;
+		fz_stext_page* text_page = NULL;
+		fz_device* device = NULL;
+		fz_stext_options stext_options = { 0 };
+
+		fz_var(text_page);
+		fz_var(device);
+
+		stext_options.flags = flags;
 
 		fz_try(ctx)
 		{
-			buf = fz_new_buffer(ctx, 1024);
-			out = fz_new_output_with_buffer(ctx, buf);
+			text_page = fz_new_stext_page(ctx, fz_infinite_rect);
 		}
 		fz_catch(ctx)
 		{
-			fz_drop_buffer(ctx, buf);
-			return ERR_CANNOT_CREATE_BUFFER;
+			return ERR_CANNOT_CREATE_PAGE;
 		}
 
-		//Render page to a pixmap.
 		fz_try(ctx)
 		{
-			pix = fz_get_unscaled_pixmap_from_image(ctx, image);
+			device = fz_new_stext_device(ctx, text_page, &stext_options);
+			fz_run_display_list(ctx, list, device, fz_identity, fz_infinite_rect, NULL);
+			fz_close_device(ctx, device);
 		}
-		fz_catch(ctx)
+		fz_always(ctx)
 		{
-			fz_drop_output(ctx, out);
-			fz_drop_buffer(ctx, buf);
-			return ERR_CANNOT_RENDER;
+			fz_drop_device(ctx, device);
 		}
-
-		if (convert_to_rgb > 0)
+		fz_catch(ctx)
 		{
-			// Convert the pixmap to RGB.
-			fz_try(ctx)
-			{
-				fz_colorspace* cs = fz_device_rgb(ctx);
-				fz_pixmap* converted_pixmap = fz_convert_pixmap(ctx, pix, cs, cs, NULL, fz_default_color_params, 0);
-				
-				if (pix != converted_pixmap)
-				{
-					fz_drop_pixmap(ctx, pix);
-					pix = converted_pixmap;
-				}
-			}
-			fz_catch(ctx)
-			{
-				fz_drop_pixmap(ctx, pix);
-				return ERR_CANNOT_RENDER;
-			}
+			fz_drop_stext_page(ctx, text_page);
+			return ERR_CANNOT_POPULATE_PAGE;
 		}
 
-		//Write the rendered pixmap to the output buffer in the specified format.
+		int result = SearchStructuredTextPage(ctx, text_page, needle, options, max_hits, out_data, out_hit_count, out_quad_count);
+
+		fz_drop_stext_page(ctx, text_page);
+
+		return result;
+	}
+
+	DLL_PUBLIC void DisposeSearchHits(fz_context* ctx, unsigned char* data)
+	{
+		fz_free(ctx, data);
+	}
+
+
+	DLL_PUBLIC int FinalizeDocumentWriter(fz_context* ctx, fz_document_writer* writ)
+	{
 		fz_try(ctx)
 		{
-			switch (output_format)
-			{
-			case OUT_PNM:
-				fz_write_pixmap_as_pnm(ctx, out, pix);
-				break;
-			case OUT_PAM:
-				fz_write_pixmap_as_pam(ctx, out, pix);
-				break;
-			case OUT_PNG:
-				fz_write_pixmap_as_png(ctx, out, pix);
-				break;
-			case OUT_PSD:
-				fz_write_pixmap_as_psd(ctx, out, pix);
-				break;
-			case OUT_JPEG:
-				fz_write_pixmap_as_jpeg(ctx, out, pix, quality, 1);
-				break;
-			}
+			fz_close_document_writer(ctx, writ);
 		}
 		fz_catch(ctx)
 		{
-			fz_drop_output(ctx, out);
-			fz_drop_buffer(ctx, buf);
-			fz_drop_pixmap(ctx, pix);
-			return ERR_CANNOT_SAVE;
+			return ERR_CANNOT_CLOSE_DOCUMENT;
 		}
 
-		fz_close_output(ctx, out);
-		fz_drop_output(ctx, out);
-		fz_drop_pixmap(ctx, pix);
-
-		*out_buffer = buf;
-		*out_data = buf->data;
-		*out_length = buf->len;
+		fz_drop_document_writer(ctx, writ);
 
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int SaveRasterImage(fz_context *ctx, fz_image *image, const char* file_name, int output_format, int quality, int convert_to_rgb)
+	DLL_PUBLIC int WriteSubDisplayListAsPage(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, fz_document_writer* writ)
 	{
-		fz_pixmap* pix;
+		fz_device* dev;
+		fz_rect rect;
+		fz_matrix ctm;
+
+		ctm = fz_concat(fz_translate(-x0, -y0), fz_scale(zoom, zoom));
+
+		rect.x0 = x0;
+		rect.y0 = y0;
+		rect.x1 = x1;
+		rect.y1 = y1;
+
+		rect = fz_transform_rect(rect, ctm);
+
+		fz_var(dev);
 
-		//Render page to a pixmap.
 		fz_try(ctx)
 		{
-			pix = fz_get_unscaled_pixmap_from_image(ctx, image);
+			dev = fz_begin_page(ctx, writ, rect);
+			fz_run_display_list(ctx, list, dev, ctm, fz_infinite_rect, NULL);
+			fz_end_page(ctx, writ);
 		}
 		fz_catch(ctx)
 		{
 			return ERR_CANNOT_RENDER;
 		}
 
-		if (convert_to_rgb > 0)
-		{
-			// Convert the pixmap to RGB.
-			fz_try(ctx)
-			{
-				fz_colorspace* cs = fz_device_rgb(ctx);
-				fz_pixmap* converted_pixmap = fz_convert_pixmap(ctx, pix, cs, cs, NULL, fz_default_color_params, 0);
-				if (pix != converted_pixmap)
-				{
-					fz_drop_pixmap(ctx, pix);
-					pix = converted_pixmap;
-				}
-			}
-			fz_catch(ctx)
-			{
-				fz_drop_pixmap(ctx, pix);
-				return ERR_CANNOT_RENDER;
-			}
-		}
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int CreateDocumentWriter(fz_context* ctx, const char* file_name, int format, const char* options, const fz_document_writer** out_document_writer)
+	{
+		fz_document_writer* writ;
 
-		//Save the rendered pixmap to the output file in the specified format.
 		fz_try(ctx)
 		{
-			switch (output_format)
+			switch (format)
 			{
-			case OUT_PNM:
-				fz_save_pixmap_as_pnm(ctx, pix, file_name);
+			case OUT_DOC_PDF:
+				writ = fz_new_document_writer(ctx, file_name, "pdf", options);
 				break;
-			case OUT_PAM:
-				fz_save_pixmap_as_pam(ctx, pix, file_name);
+			case OUT_DOC_SVG:
+				writ = fz_new_document_writer(ctx, file_name, "svg", options);
 				break;
-			case OUT_PNG:
-				fz_save_pixmap_as_png(ctx, pix, file_name);
+			case OUT_DOC_CBZ:
+				writ = fz_new_document_writer(ctx, file_name, "cbz", options);
 				break;
-			case OUT_PSD:
-				fz_save_pixmap_as_psd(ctx, pix, file_name);
+			case OUT_DOC_DOCX:
+				writ = fz_new_document_writer(ctx, file_name, "docx", options);
 				break;
-			case OUT_JPEG:
-				fz_save_pixmap_as_jpeg(ctx, pix, file_name, quality);
+			case OUT_DOC_ODT:
+				writ = fz_new_document_writer(ctx, file_name, "odt", options);
+				break;
+			case OUT_DOC_HTML:
+				writ = fz_new_document_writer(ctx, file_name, "html", options);
+				break;
+			case OUT_DOC_XHTML:
+				writ = fz_new_document_writer(ctx, file_name, "xhtml", options);
+				break;
+			case OUT_DOC_TXT:
+				writ = fz_new_document_writer(ctx, file_name, "text", options);
+				break;
+			case OUT_DOC_STEXT:
+				writ = fz_new_document_writer(ctx, file_name, "stext", options);
 				break;
 			}
 		}
 		fz_catch(ctx)
 		{
-			fz_drop_pixmap(ctx, pix);
-			return ERR_CANNOT_SAVE;
+			return ERR_CANNOT_CREATE_WRITER;
 		}
 
-		fz_drop_pixmap(ctx, pix);
+		*out_document_writer = writ;
 
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC void DisposePixmap(fz_context *ctx, fz_pixmap* pixmap)
-	{
-		fz_drop_pixmap(ctx, pixmap);
-	}
-
-	DLL_PUBLIC int LoadPixmapRGB(fz_context *ctx, fz_image *image, int color_format, fz_pixmap** out_pixmap, unsigned char** out_samples, int* count)
+	//Render a display list or a page (if list is NULL) and encode it either to a callback (if callback is not NULL) or to a memory buffer.
+	static int write_image(fz_context* ctx, fz_display_list* list, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, writeCallback callback, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length)
 	{
-		fz_pixmap* base_pixmap;
-		fz_colorspace* cs;
+		fz_matrix ctm;
+		fz_pixmap* pix;
+		fz_rect rect;
 		int alpha;
+		fz_colorspace* cs;
 
-		switch (color_format)
+		ctm = fz_scale(zoom, zoom);
+
+		rect.x0 = x0;
+		rect.y0 = y0;
+		rect.x1 = x1;
+		rect.y1 = y1;
+
+		switch (colorFormat)
 		{
 		case COLOR_RGB:
 			cs = fz_device_rgb(ctx);
@@ -780,1210 +2898,1615 @@ extern "C"
 			break;
 		}
 
-		fz_try(ctx)
-		{
-			base_pixmap = fz_get_unscaled_pixmap_from_image(ctx, image);
-
-			*out_pixmap = fz_convert_pixmap(ctx, base_pixmap, cs, cs, NULL, fz_default_color_params, alpha);
-			
-			*out_samples = fz_pixmap_samples(ctx, *out_pixmap);
-			*count = fz_pixmap_height(ctx, *out_pixmap) * fz_pixmap_stride(ctx, *out_pixmap);
 
-			fz_drop_pixmap(ctx, base_pixmap);
-		}
-		fz_always(ctx)
+		//Render page to an RGB/RGBA pixmap.
+		fz_try(ctx)
 		{
-			fz_drop_colorspace(ctx, cs);
+			if (list != NULL)
+			{
+				pix = new_pixmap_from_display_list_with_separations_bbox(ctx, list, rect, ctm, cs, NULL, alpha);
+			}
+			else
+			{
+				pix = new_pixmap_from_page_with_bbox_and_data(ctx, page, annotations, fz_round_rect(fz_transform_rect(rect, ctm)), ctm, cs, alpha, NULL, NULL);
+			}
 		}
 		fz_catch(ctx)
 		{
 			return ERR_CANNOT_RENDER;
 		}
 
-		fz_keep_pixmap(ctx, *out_pixmap);
-		return EXIT_SUCCESS;
-	}
+		//Write the rendered pixmap in the specified format.
+		int result = encode_pixmap(ctx, pix, output_format, quality, callback, out_buffer, out_data, out_length);
 
-	DLL_PUBLIC int LoadPixmap(fz_context *ctx, fz_image *image, fz_pixmap** out_pixmap, unsigned char** out_samples, int* count)
-	{
-		fz_try(ctx)
-		{
-			*out_pixmap = fz_get_unscaled_pixmap_from_image(ctx, image);
-			*out_samples = fz_pixmap_samples(ctx, *out_pixmap);
-			*count = fz_pixmap_height(ctx, *out_pixmap) * fz_pixmap_stride(ctx, *out_pixmap);
-		}
-		fz_catch(ctx)
-		{
-			return ERR_CANNOT_RENDER;
-		}
-		
-		fz_keep_pixmap(ctx, *out_pixmap);
+		fz_drop_pixmap(ctx, pix);
 
-		return EXIT_SUCCESS;
+		return result;
 	}
 
-	DLL_PUBLIC int GetImageMetadata(fz_context *ctx, fz_image *image, int* out_w, int* out_h, int* out_xres, int* out_yres, uint8_t* out_orientation, fz_colorspace** out_colorspace)
+	DLL_PUBLIC int WriteImage(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length)
 	{
-		*out_w = image->w;
-		*out_h = image->h;
-		*out_colorspace = image->colorspace;
-		fz_keep_colorspace(ctx, image->colorspace);
+		return write_image(ctx, list, NULL, 0, x0, y0, x1, y1, zoom, colorFormat, output_format, quality, NULL, out_buffer, out_data, out_length);
+	}
 
-		fz_try(ctx)
-		{
-			fz_image_resolution(image, out_xres, out_yres);
-			*out_orientation = fz_image_orientation(ctx, image);
-		}
-		fz_catch(ctx)
-		{
-			return ERR_IMAGE_METADATA;
-		}
+	DLL_PUBLIC int WritePageImage(fz_context* ctx, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length)
+	{
+		return write_image(ctx, NULL, page, annotations, x0, y0, x1, y1, zoom, colorFormat, output_format, quality, NULL, out_buffer, out_data, out_length);
+	}
 
-		return EXIT_SUCCESS;
+	DLL_PUBLIC int WriteImageToStream(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, writeCallback callback)
+	{
+		return write_image(ctx, list, NULL, 0, x0, y0, x1, y1, zoom, colorFormat, output_format, quality, callback, NULL, NULL, NULL);
 	}
 
-	DLL_PUBLIC void DisposeOutline(fz_context* ctx, fz_outline* outline)
+	DLL_PUBLIC int WritePageImageToStream(fz_context* ctx, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, writeCallback callback)
 	{
-		fz_drop_outline(ctx, outline);
+		return write_image(ctx, NULL, page, annotations, x0, y0, x1, y1, zoom, colorFormat, output_format, quality, callback, NULL, NULL, NULL);
 	}
 
-	DLL_PUBLIC fz_outline* LoadOutline(fz_context* ctx, fz_document* doc)
+	DLL_PUBLIC int DisposeBuffer(fz_context* ctx, fz_buffer* buf)
 	{
-		return fz_load_outline(ctx, doc);
+		fz_drop_buffer(ctx, buf);
+		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int GetPermissions(fz_context* ctx, fz_document* doc)
+	//Render a display list or a page (if list is NULL) and save it to a file.
+	static int save_image(fz_context* ctx, fz_display_list* list, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int quality)
 	{
-		int tbr = 0;
+		fz_matrix ctm;
+		fz_pixmap* pix;
+		fz_rect rect;
+		int alpha;
+		fz_colorspace* cs;
 
-		if (fz_has_permission(ctx, doc, FZ_PERMISSION_PRINT))
+		switch (colorFormat)
 		{
-			tbr = tbr | 1;
+		case COLOR_RGB:
+			cs = fz_device_rgb(ctx);
+			alpha = 0;
+			break;
+		case COLOR_RGBA:
+			cs = fz_device_rgb(ctx);
+			alpha = 1;
+			break;
+		case COLOR_BGR:
+			cs = fz_device_bgr(ctx);
+			alpha = 0;
+			break;
+		case COLOR_BGRA:
+			cs = fz_device_bgr(ctx);
+			alpha = 1;
+			break;
 		}
 
-		if (fz_has_permission(ctx, doc, FZ_PERMISSION_COPY))
+
+		ctm = fz_scale(zoom, zoom);
+
+		rect.x0 = x0;
+		rect.y0 = y0;
+		rect.x1 = x1;
+		rect.y1 = y1;
+
+		//Render page to an RGB/RGBA pixmap.
+		fz_try(ctx)
 		{
-			tbr = tbr | 2;
+			if (list != NULL)
+			{
+				pix = new_pixmap_from_display_list_with_separations_bbox(ctx, list, rect, ctm, cs, NULL, alpha);
+			}
+			else
+			{
+				pix = new_pixmap_from_page_with_bbox_and_data(ctx, page, annotations, fz_round_rect(fz_transform_rect(rect, ctm)), ctm, cs, alpha, NULL, NULL);
+			}
 		}
-
-		if (fz_has_permission(ctx, doc, FZ_PERMISSION_EDIT))
+		fz_catch(ctx)
 		{
-			tbr = tbr | 4;
+			return ERR_CANNOT_RENDER;
 		}
 
-		if (fz_has_permission(ctx, doc, FZ_PERMISSION_ANNOTATE))
+		//Save the rendered pixmap to the output file in the specified format.
+		fz_try(ctx)
 		{
-			tbr = tbr | 8;
+			switch (output_format)
+			{
+			case OUT_PNM:
+				fz_save_pixmap_as_pnm(ctx, pix, file_name);
+				break;
+			case OUT_PAM:
+				fz_save_pixmap_as_pam(ctx, pix, file_name);
+				break;
+			case OUT_PNG:
+				fz_save_pixmap_as_png(ctx, pix, file_name);
+				break;
+			case OUT_PSD:
+				fz_save_pixmap_as_psd(ctx, pix, file_name);
+				break;
+			case OUT_JPEG:
+				fz_save_pixmap_as_jpeg(ctx, pix, file_name, quality);
+				break;
+			}
+		}
+		fz_catch(ctx)
+		{
+			fz_drop_pixmap(ctx, pix);
+			return ERR_CANNOT_SAVE;
 		}
 
-		return tbr;
+		fz_drop_pixmap(ctx, pix);
+
+		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int UnlockWithPassword(fz_context* ctx, fz_document* doc, const char* password)
+	DLL_PUBLIC int SaveImage(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int quality)
 	{
-		return fz_authenticate_password(ctx, doc, password);
+		return save_image(ctx, list, NULL, 0, x0, y0, x1, y1, zoom, colorFormat, file_name, output_format, quality);
 	}
 
-	DLL_PUBLIC int CheckIfPasswordNeeded(fz_context* ctx, fz_document* doc)
+	DLL_PUBLIC int SavePageImage(fz_context* ctx, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int quality)
 	{
-		return fz_needs_password(ctx, doc);
+		return save_image(ctx, NULL, page, annotations, x0, y0, x1, y1, zoom, colorFormat, file_name, output_format, quality);
 	}
 
-	DLL_PUBLIC void ResetOutput(int stdoutFD, int stderrFD)
+	//Create a band writer for the specified format. JPEG does not support banded output.
+	static fz_band_writer* new_band_writer(fz_context* ctx, fz_output* out, int output_format)
 	{
-		fprintf(stdout, "\n");
-		fprintf(stderr, "\n");
-
-		fflush(stdout);
-		fflush(stderr);
-
-		dup2(stdoutFD, fileno(stdout));
-		dup2(stderrFD, fileno(stderr));
-
-		fflush(stdout);
-		fflush(stderr);
+		switch (output_format)
+		{
+		case OUT_PNM:
+			return fz_new_pnm_band_writer(ctx, out);
+		case OUT_PAM:
+			return fz_new_pam_band_writer(ctx, out);
+		case OUT_PNG:
+			return fz_new_png_band_writer(ctx, out);
+		case OUT_PSD:
+			return fz_new_psd_band_writer(ctx, out);
+		default:
+			fz_throw(ctx, FZ_ERROR_ARGUMENT, "Unsupported format for banded output");
+		}
 	}
 
-	DLL_PUBLIC void WriteToFileDescriptor(int fileDescriptor, const char* text, int length)
+	//Get the colour space and alpha corresponding to a colour format.
+	static fz_colorspace* get_color_format_colorspace(fz_context* ctx, int colorFormat, int* out_alpha)
 	{
-		while (length > 0)
+		switch (colorFormat)
 		{
-			int written = write(fileDescriptor, text, length);
-
-			text += written;
-
-			length -= written;
+		case COLOR_RGBA:
+			*out_alpha = 1;
+			return fz_device_rgb(ctx);
+		case COLOR_BGR:
+			*out_alpha = 0;
+			return fz_device_bgr(ctx);
+		case COLOR_BGRA:
+			*out_alpha = 1;
+			return fz_device_bgr(ctx);
+		default:
+			*out_alpha = 0;
+			return fz_device_rgb(ctx);
 		}
-		
 	}
 
-#if defined _WIN32
-	void RedirectToPipe(const char* pipeName, int fd)
-	{
-		HANDLE hPipe = CreateNamedPipe(TEXT(pipeName), PIPE_ACCESS_DUPLEX, PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_ACCEPT_REMOTE_CLIENTS, 1, 1024 * 16, 1024 * 16, NMPWAIT_WAIT_FOREVER, NULL);
-
-		ConnectNamedPipe(hPipe, NULL);
-
-		int newFd = _open_osfhandle((intptr_t)hPipe, _O_WRONLY | _O_TEXT);
-		dup2(newFd, fd);
-	}
-#else
-	void RedirectToPipe(const char* pipeName, int fd)
+	//Create a writer that encodes an image of the specified size band by band. If owns_output is non-zero, the output is closed and dropped together with the writer.
+	static banded_image_writer* new_banded_image_writer(fz_context* ctx, fz_output* out, int owns_output, int output_format, fz_irect bbox, fz_colorspace* cs, int alpha)
 	{
-		struct sockaddr_un local;
+		banded_image_writer* writer = fz_malloc_struct(ctx, banded_image_writer);
 
-		int sockFd = socket(AF_UNIX, SOCK_STREAM, 0);
+		fz_try(ctx)
+		{
+			writer->band_writer = new_band_writer(ctx, out, output_format);
+		}
+		fz_catch(ctx)
+		{
+			fz_free(ctx, writer);
+			fz_rethrow(ctx);
+		}
 
-		local.sun_family = AF_UNIX;
-		strcpy(local.sun_path, pipeName);
-		unlink(pipeName);
+		writer->out = out;
+		writer->owns_output = owns_output;
+		writer->bbox = bbox;
+		writer->cs = cs;
+		writer->alpha = alpha;
+		writer->next_row = bbox.y0;
 
-#if defined __APPLE__
-		int len = strlen(local.sun_path) + sizeof(local.sun_family) + 1;
-#elif defined __linux__
-		int len = strlen(local.sun_path) + sizeof(local.sun_family);
-#endif
+		return writer;
+	}
 
-		bind(sockFd, (struct sockaddr*)&local, len);
+	//Encode the next band of the image. The band must start at the row following the end of the previous band. The header is written together with the first band,
+	//so that it uses the same resolution and number of components as the rendered pixmaps.
+	static void write_image_band(fz_context* ctx, banded_image_writer* writer, fz_pixmap* band)
+	{
+		if (band->y != writer->next_row || band->w != writer->bbox.x1 - writer->bbox.x0 || band->y + band->h > writer->bbox.y1)
+		{
+			fz_throw(ctx, FZ_ERROR_ARGUMENT, "Bands must be written in order");
+		}
 
-		listen(sockFd, INT32_MAX);
+		if (writer->next_row == writer->bbox.y0)
+		{
+			fz_write_header(ctx, writer->band_writer, writer->bbox.x1 - writer->bbox.x0, writer->bbox.y1 - writer->bbox.y0, band->n, band->alpha, band->xres, band->yres, 0, band->colorspace, NULL);
+		}
 
-		int newFd = accept(sockFd, NULL, NULL);
+		fz_write_band(ctx, writer->band_writer, band->stride, band->h, band->samples);
 
-		dup2(newFd, fd);
+		writer->next_row += band->h;
 	}
-#endif
 
-	DLL_PUBLIC void RedirectOutput(int* stdoutFD, int* stderrFD, const char* stdoutPipe, const char* stderrPipe)
+	//Write the trailer of the image and, if the writer owns it, close the output.
+	static void close_banded_image_writer(fz_context* ctx, banded_image_writer* writer)
 	{
-		fflush(stdout);
-		fflush(stderr);
-
-		*stdoutFD = dup(fileno(stdout));
-		/*FILE* stdoutFile = fopen("stdout.txt", "w");
-		dup2(fileno(stdoutFile), fileno(stdout));*/
-
-		RedirectToPipe(stdoutPipe, fileno(stdout));
-		setvbuf(stdout, NULL, _IONBF, 0);
+		if (writer->next_row != writer->bbox.y1)
+		{
+			fz_throw(ctx, FZ_ERROR_ARGUMENT, "Not all the bands have been written");
+		}
 
-		*stderrFD = dup(fileno(stderr));
-		/*FILE* stderrFile = fopen("stderr.txt", "w");
-		dup2(fileno(stderrFile), fileno(stderr));*/
-		RedirectToPipe(stderrPipe, fileno(stderr));
-		setvbuf(stderr, NULL, _IONBF, 0);
+		fz_close_band_writer(ctx, writer->band_writer);
 
-		fflush(stdout);
-		fflush(stderr);
+		if (writer->owns_output)
+		{
+			fz_close_output(ctx, writer->out);
+		}
 	}
 
-
-	DLL_PUBLIC int GetStructuredTextChar(fz_context* ctx, fz_stext_char* character, int* out_c, uint32_t* out_color, float* out_origin_x, float* out_origin_y, float* out_size, float* out_ll_x, float* out_ll_y, float* out_ul_x, float* out_ul_y, float* out_ur_x, float* out_ur_y, float* out_lr_x, float* out_lr_y, int* out_bidi, fz_font** out_font)
+	static void drop_banded_image_writer(fz_context* ctx, banded_image_writer* writer)
 	{
-		*out_c = character->c;
-
-		*out_color = character->argb;
+		if (writer == NULL)
+		{
+			return;
+		}
 
-		*out_origin_x = character->origin.x;
-		*out_origin_y = character->origin.y;
+		fz_drop_band_writer(ctx, writer->band_writer);
 
-		*out_size = character->size;
+		if (writer->owns_output)
+		{
+			fz_drop_output(ctx, writer->out);
+		}
 
-		*out_ll_x = character->quad.ll.x;
-		*out_ll_y = character->quad.ll.y;
+		fz_free(ctx, writer);
+	}
 
-		*out_ul_x = character->quad.ul.x;
-		*out_ul_y = character->quad.ul.y;
+	//Render a display list or a page (if list is NULL) band_height rows at a time, and feed each band to a band writer. Only one band is held in memory at any time.
+	static int write_image_banded(fz_context* ctx, fz_display_list* list, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, fz_output* out, int output_format, int band_height)
+	{
+		fz_matrix ctm;
+		fz_pixmap* pix = NULL;
+		banded_image_writer* writer = NULL;
+		unsigned char* samples = NULL;
+		fz_rect rect;
+		fz_irect bbox;
+		int alpha;
+		fz_colorspace* cs = get_color_format_colorspace(ctx, colorFormat, &alpha);
 
-		*out_ur_x = character->quad.ur.x;
-		*out_ur_y = character->quad.ur.y;
+		ctm = fz_scale(zoom, zoom);
 
-		*out_lr_x = character->quad.lr.x;
-		*out_lr_y = character->quad.lr.y;
+		rect.x0 = x0;
+		rect.y0 = y0;
+		rect.x1 = x1;
+		rect.y1 = y1;
 
-		*out_bidi = character->bidi;
-		*out_font = character->font;
-		fz_keep_font(ctx, character->font);
+		bbox = fz_round_rect(fz_transform_rect(rect, ctm));
 
-		return EXIT_SUCCESS;
-	}
+		if (band_height <= 0 || band_height > bbox.y1 - bbox.y0)
+		{
+			band_height = bbox.y1 - bbox.y0;
+		}
 
-	DLL_PUBLIC int GetStructuredTextChars(fz_stext_line* line, fz_stext_char** out_chars)
-	{
-		int count = 0;
+		size_t stride = (size_t)(bbox.x1 - bbox.x0) * (fz_colorspace_n(ctx, cs) + alpha);
 
-		fz_stext_char* curr_char = line->first_char;
+		fz_var(pix);
 
-		while (curr_char != nullptr)
+		fz_try(ctx)
 		{
-			out_chars[count] = curr_char;
-			count++;
-			curr_char = curr_char->next;
+			writer = new_banded_image_writer(ctx, out, 0, output_format, bbox, cs, alpha);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_SAVE;
 		}
 
-		return EXIT_SUCCESS;
-	}
+		//The same storage is reused for every band.
+		fz_try(ctx)
+		{
+			samples = (unsigned char*)fz_malloc(ctx, stride * band_height);
+		}
+		fz_catch(ctx)
+		{
+			drop_banded_image_writer(ctx, writer);
+			return ERR_CANNOT_CREATE_BUFFER;
+		}
 
-	DLL_PUBLIC int GetStructuredTextLine(fz_stext_line* line, int* out_wmode, float* out_x0, float* out_y0, float* out_x1, float* out_y1, float* out_x, float* out_y, int* out_char_count)
-	{
-		*out_wmode = line->wmode;
+		int result = EXIT_SUCCESS;
 
-		*out_x0 = line->bbox.x0;
-		*out_y0 = line->bbox.y0;
-		*out_x1 = line->bbox.x1;
-		*out_y1 = line->bbox.y1;
+		for (int band_y = bbox.y0; band_y < bbox.y1; band_y += band_height)
+		{
+			fz_irect band = bbox;
+			band.y0 = band_y;
+			band.y1 = fz_mini(band_y + band_height, bbox.y1);
 
-		*out_x = line->dir.x;
-		*out_y = line->dir.y;
+			fz_try(ctx)
+			{
+				if (list != NULL)
+				{
+					pix = new_pixmap_from_display_list_with_bbox_and_data(ctx, list, band, ctm, cs, alpha, samples, NULL);
+				}
+				else
+				{
+					pix = new_pixmap_from_page_with_bbox_and_data(ctx, page, annotations, band, ctm, cs, alpha, samples, NULL);
+				}
+			}
+			fz_catch(ctx)
+			{
+				result = ERR_CANNOT_RENDER;
+				break;
+			}
 
-		int count = 0;
+			fz_try(ctx)
+			{
+				write_image_band(ctx, writer, pix);
+			}
+			fz_always(ctx)
+			{
+				fz_drop_pixmap(ctx, pix);
+				pix = NULL;
+			}
+			fz_catch(ctx)
+			{
+				result = ERR_CANNOT_SAVE;
+			}
 
-		fz_stext_char* curr_char = line->first_char;
+			if (result != EXIT_SUCCESS)
+			{
+				break;
+			}
+		}
 
-		while (curr_char != nullptr)
+		if (result == EXIT_SUCCESS)
 		{
-			count++;
-			curr_char = curr_char->next;
+			fz_try(ctx)
+			{
+				close_banded_image_writer(ctx, writer);
+			}
+			fz_catch(ctx)
+			{
+				result = ERR_CANNOT_SAVE;
+			}
 		}
 
-		*out_char_count = count;
+		drop_banded_image_writer(ctx, writer);
+		fz_free(ctx, samples);
 
-		return EXIT_SUCCESS;
+		return result;
 	}
 
-	DLL_PUBLIC int GetStructuredTextLines(fz_stext_block* block, fz_stext_line** out_lines)
+	//Render a display list or a page (if list is NULL) in bands and save it to a file.
+	static int save_image_banded(fz_context* ctx, fz_display_list* list, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int band_height)
 	{
-		int count = 0;
+		fz_output* out;
 
-		fz_stext_line* curr_line = block->u.t.first_line;
+		fz_try(ctx)
+		{
+			out = fz_new_output_with_path(ctx, file_name, 0);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_SAVE;
+		}
 
-		while (curr_line != nullptr)
+		int result = write_image_banded(ctx, list, page, annotations, x0, y0, x1, y1, zoom, colorFormat, out, output_format, band_height);
+
+		if (result == EXIT_SUCCESS)
 		{
-			out_lines[count] = curr_line;
-			count++;
-			curr_line = curr_line->next;
+			fz_try(ctx)
+			{
+				fz_close_output(ctx, out);
+			}
+			fz_catch(ctx)
+			{
+				result = ERR_CANNOT_SAVE;
+			}
 		}
 
-		return EXIT_SUCCESS;
+		fz_drop_output(ctx, out);
+
+		return result;
 	}
 
-	DLL_PUBLIC void GetStructStructuredTextBlockRawStructure(fz_stext_struct* struct_block, int raw_length, char* out_raw)
+	DLL_PUBLIC int SaveImageBanded(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int band_height)
 	{
-		strncpy(out_raw, struct_block->raw, raw_length);
+		return save_image_banded(ctx, list, NULL, 0, x0, y0, x1, y1, zoom, colorFormat, file_name, output_format, band_height);
 	}
 
-	DLL_PUBLIC int GetStructStructuredTextBlock(fz_stext_struct* struct_block, int* out_raw_length, fz_structure* out_standard, fz_stext_struct** out_parent, fz_stext_block** out_blocks)
+	DLL_PUBLIC int SavePageImageBanded(fz_context* ctx, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int band_height)
 	{
-		*out_raw_length = (int)strlen(struct_block->raw);
-		*out_standard = struct_block->standard;
-		*out_parent = struct_block->parent;
+		return save_image_banded(ctx, NULL, page, annotations, x0, y0, x1, y1, zoom, colorFormat, file_name, output_format, band_height);
+	}
 
-		fz_stext_block* curr_block = struct_block->first_block;
+	DLL_PUBLIC int CreateBandedImageWriter(fz_context* ctx, const char* file_name, int output_format, float x0, float y0, float x1, float y1, float zoom, int colorFormat, banded_image_writer** out_writer, int* out_width, int* out_height)
+	{
+		fz_output* out;
+		fz_rect rect;
+		int alpha;
+		fz_colorspace* cs = get_color_format_colorspace(ctx, colorFormat, &alpha);
 
-		int count = 0;
+		rect.x0 = x0;
+		rect.y0 = y0;
+		rect.x1 = x1;
+		rect.y1 = y1;
 
-		while (curr_block != nullptr)
+		fz_irect bbox = fz_round_rect(fz_transform_rect(rect, fz_scale(zoom, zoom)));
+
+		fz_try(ctx)
 		{
-			out_blocks[count] = curr_block;
-			count++;
-			curr_block = curr_block->next;
+			out = fz_new_output_with_path(ctx, file_name, 0);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_SAVE;
+		}
+
+		fz_try(ctx)
+		{
+			*out_writer = new_banded_image_writer(ctx, out, 1, output_format, bbox, cs, alpha);
+		}
+		fz_catch(ctx)
+		{
+			fz_drop_output(ctx, out);
+			return ERR_CANNOT_CREATE_WRITER;
 		}
 
+		*out_width = bbox.x1 - bbox.x0;
+		*out_height = bbox.y1 - bbox.y0;
+
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int CountStructStructuredTextBlockChildren(fz_stext_struct* struct_block)
+	DLL_PUBLIC int RenderImageBand(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int first_row, int row_count, unsigned char* pixel_storage, fz_cookie* cookie)
 	{
-		fz_stext_block* curr_block = struct_block->first_block;
-
-		int count = 0;
+		fz_matrix ctm = fz_scale(zoom, zoom);
+		fz_pixmap* pix;
+		fz_rect rect;
+		int alpha;
+		fz_colorspace* cs = get_color_format_colorspace(ctx, colorFormat, &alpha);
 
-		while (curr_block != nullptr)
-		{
-			count++;
-			curr_block = curr_block->next;
-		}
+		rect.x0 = x0;
+		rect.y0 = y0;
+		rect.x1 = x1;
+		rect.y1 = y1;
 
-		return count;
-	}
+		fz_irect bbox = fz_round_rect(fz_transform_rect(rect, ctm));
 
-	DLL_PUBLIC int GetGridStructuredTextBlock(fz_stext_block* block, int xs_len, int ys_len, int* out_x_max_uncertainty, int* out_y_max_uncertainty, float* out_x_pos, float* out_y_pos, int* out_x_uncertainty, int* out_y_uncertainty)
-	{
-		*out_x_max_uncertainty = block->u.b.xs->max_uncertainty;
-		*out_y_max_uncertainty = block->u.b.ys->max_uncertainty;
+		fz_irect band = bbox;
+		band.y0 = bbox.y0 + first_row;
+		band.y1 = fz_mini(band.y0 + row_count, bbox.y1);
 
-		for (int i = 0; i < xs_len; i++)
+		fz_try(ctx)
 		{
-			out_x_pos[i] = block->u.b.xs->list[i].pos;
-			out_x_uncertainty[i] = block->u.b.xs->list[i].uncertainty;
+			pix = new_pixmap_from_display_list_with_bbox_and_data(ctx, list, band, ctm, cs, alpha, pixel_storage, cookie);
 		}
-
-		for (int i = 0; i < ys_len; i++)
+		fz_catch(ctx)
 		{
-			out_y_pos[i] = block->u.b.ys->list[i].pos;
-			out_y_uncertainty[i] = block->u.b.ys->list[i].uncertainty;
+			return ERR_CANNOT_RENDER;
 		}
 
+		fz_drop_pixmap(ctx, pix);
+
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int GetStructuredTextBlock(fz_context* ctx, fz_stext_block* block, int* out_type, float* out_x0, float* out_y0, float* out_x1, float* out_y1, int* out_line_count, fz_image** out_image, float* out_a, float* out_b, float* out_c, float* out_d, float* out_e, float* out_f, uint8_t* out_stroked, uint32_t* out_argb, int* out_xs_len, int* out_ys_len, fz_stext_struct** out_down, int* out_index)
+	DLL_PUBLIC int WriteImageBand(fz_context* ctx, banded_image_writer* writer, int row_count, unsigned char* pixel_storage)
 	{
-		*out_type = block->type;
+		fz_pixmap* pix;
 
-		*out_x0 = block->bbox.x0;
-		*out_y0 = block->bbox.y0;
-		*out_x1 = block->bbox.x1;
-		*out_y1 = block->bbox.y1;
+		fz_irect band = writer->bbox;
+		band.y0 = writer->next_row;
+		band.y1 = band.y0 + row_count;
 
-		if (block->type == FZ_STEXT_BLOCK_IMAGE)
+		fz_try(ctx)
 		{
-			*out_line_count = 0;
-			*out_image = block->u.i.image;
-			fz_keep_image(ctx, block->u.i.image);
-			*out_a = block->u.i.transform.a;
-			*out_b = block->u.i.transform.b;
-			*out_c = block->u.i.transform.c;
-			*out_d = block->u.i.transform.d;
-			*out_e = block->u.i.transform.e;
-			*out_f = block->u.i.transform.f;
+			pix = new_pixmap_with_bbox_and_data(ctx, writer->cs, band, NULL, writer->alpha, pixel_storage);
 		}
-		else if (block->type == FZ_STEXT_BLOCK_TEXT)
+		fz_catch(ctx)
 		{
-			int count = 0;
-
-			fz_stext_line* curr_line = block->u.t.first_line;
+			return ERR_CANNOT_SAVE;
+		}
 
-			while (curr_line != nullptr)
-			{
-				count++;
-				curr_line = curr_line->next;
-			}
+		int result = EXIT_SUCCESS;
 
-			*out_line_count = count;
-		}
-		else if (block->type == FZ_STEXT_BLOCK_VECTOR)
+		fz_try(ctx)
 		{
-			*out_line_count = 0;
-			*out_stroked = block->u.v.stroked;
-			*out_argb = block->u.v.argb;
+			write_image_band(ctx, writer, pix);
 		}
-		else if (block->type == FZ_STEXT_BLOCK_GRID)
+		fz_always(ctx)
 		{
-			*out_line_count = 0;
-			*out_xs_len = block->u.b.xs->len;
-			*out_ys_len = block->u.b.ys->len;
+			fz_drop_pixmap(ctx, pix);
 		}
-		else if (block->type == FZ_STEXT_BLOCK_STRUCT)
+		fz_catch(ctx)
 		{
-			*out_line_count = 0;
-			*out_down = block->u.s.down;
-			*out_index = block->u.s.index;
+			result = ERR_CANNOT_SAVE;
 		}
 
-		return EXIT_SUCCESS;
+		return result;
 	}
 
-	DLL_PUBLIC int GetStructuredTextBlocks(fz_stext_page* page, fz_stext_block** out_blocks)
+	DLL_PUBLIC int CloseBandedImageWriter(fz_context* ctx, banded_image_writer* writer)
 	{
-		fz_stext_block* curr_block = page->first_block;
-
-		int count = 0;
-
-		while (curr_block != nullptr)
+		fz_try(ctx)
 		{
-			out_blocks[count] = curr_block;
-			count++;
-			curr_block = curr_block->next;
+			close_banded_image_writer(ctx, writer);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_SAVE;
 		}
 
 		return EXIT_SUCCESS;
 	}
 
-	typedef int (*progressCallback)(int progress);
+	DLL_PUBLIC int DisposeBandedImageWriter(fz_context* ctx, banded_image_writer* writer)
+	{
+		drop_banded_image_writer(ctx, writer);
+		return EXIT_SUCCESS;
+	}
 
-	int progressFunction(fz_context* ctx, void* progress_arg, int progress)
+	DLL_PUBLIC int CloneContext(fz_context* ctx, int count, fz_context** out_contexts)
 	{
-		return (*((progressCallback*)progress_arg))(progress);
+		for (int i = 0; i < count; i++)
+		{
+			fz_try(ctx)
+			{
+				fz_context* curr_ctx = fz_clone_context(ctx);
+				fz_var(curr_ctx);
+
+				out_contexts[i] = curr_ctx;
+
+				if (!curr_ctx)
+				{
+					for (int j = 0; j < i; j++)
+					{
+						DisposeContext(out_contexts[j]);
+					}
+					return ERR_CANNOT_CLONE_CONTEXT;
+				}
+
+				//The clone shares the lock table with the original context.
+				((mutex_holder*)curr_ctx->locks.user)->refs++;
+			}
+			fz_catch(ctx)
+			{
+				for (int j = 0; j < i; j++)
+				{
+					DisposeContext(out_contexts[j]);
+				}
+				return ERR_CANNOT_CLONE_CONTEXT;
+			}
+		}
+
+		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int GetStructuredTextPageWithOCR(fz_context* ctx, fz_display_list* list, int flags, fz_stext_page** out_page, int* out_stext_block_count, float zoom, float x0, float y0, float x1, float y1, char* prefix, char* language, int callback(int))
+	DLL_PUBLIC int RenderSubDisplayList(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, unsigned char* pixel_storage, int flags, float clip_x0, float clip_y0, float clip_x1, float clip_y1, fz_cookie* cookie)
 	{
-		if (prefix != NULL)
+		if (cookie != NULL && cookie->abort)
 		{
-			putenv(prefix);
+			return EXIT_SUCCESS;
 		}
 
-		fz_stext_page* page;
-		fz_stext_options options;
-		fz_device* device;
-		fz_device* ocr_device;
-		fz_rect bounds;
 		fz_matrix ctm;
+		fz_pixmap* pix;
+		fz_rect rect;
+		int alpha;
+		fz_colorspace* cs;
+		switch (colorFormat)
+		{
+		case COLOR_RGB:
+			cs = fz_device_rgb(ctx);
+			alpha = 0;
+			break;
+		case COLOR_RGBA:
+			cs = fz_device_rgb(ctx);
+			alpha = 1;
+			break;
+		case COLOR_BGR:
+			cs = fz_device_bgr(ctx);
+			alpha = 0;
+			break;
+		case COLOR_BGRA:
+			cs = fz_device_bgr(ctx);
+			alpha = 1;
+			break;
+		}
 
 		ctm = fz_scale(zoom, zoom);
 
-		bounds.x0 = x0;
-		bounds.y0 = y0;
-		bounds.x1 = x1;
-		bounds.y1 = y1;
-
-		fz_var(page);
-		fz_var(device);
-
-		options.flags = 0;
+		rect.x0 = x0;
+		rect.y0 = y0;
+		rect.x1 = x1;
+		rect.y1 = y1;
 
+		//Render page to an RGB/RGBA pixmap.
 		fz_try(ctx)
 		{
-			page = fz_new_stext_page(ctx, fz_infinite_rect);
+			pix = new_pixmap_from_display_list_with_separations_bbox_and_data(ctx, list, rect, ctm, cs, NULL, alpha, pixel_storage, cookie);
 		}
 		fz_catch(ctx)
 		{
-			return ERR_CANNOT_CREATE_PAGE;
+
+			return ERR_CANNOT_RENDER;
 		}
 
-		fz_try(ctx)
+		//Post-process the pixmap while it is still in the cache.
+		if (flags & RENDER_CLIP)
 		{
-			device = fz_new_stext_device(ctx, page, &options);
+			fz_rect clip;
+			clip.x0 = clip_x0;
+			clip.y0 = clip_y0;
+			clip.x1 = clip_x1;
+			clip.y1 = clip_y1;
 
-#if defined _WIN32 && (defined(i386) || defined(__i386__) || defined(__i386) || defined(_M_IX86))
-			ocr_device = fz_new_ocr_device(ctx, device, ctm, bounds, true, language, NULL, NULL, NULL);
-#else
-			ocr_device = fz_new_ocr_device(ctx, device, ctm, bounds, true, language, NULL, progressFunction, &callback);
-#endif
+			clip_pixmap(pix, rect, clip);
+		}
 
-			fz_run_display_list(ctx, list, ocr_device, ctm, fz_infinite_rect, NULL);
+		if (alpha && (flags & RENDER_UNPREMULTIPLY))
+		{
+			unpremultiply_pixels(pix->samples, (size_t)pix->w * pix->h);
+		}
 
-			fz_close_device(ctx, ocr_device);
-			fz_drop_device(ctx, ocr_device);
-			ocr_device = NULL;
+		fz_drop_pixmap(ctx, pix);
 
-			fz_close_device(ctx, device);
-			fz_drop_device(ctx, device);
-			device = NULL;
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int RenderPage(fz_context* ctx, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, unsigned char* pixel_storage, int flags, float clip_x0, float clip_y0, float clip_x1, float clip_y1, int band_height, fz_cookie* cookie)
+	{
+		if (cookie != NULL && cookie->abort)
+		{
+			return EXIT_SUCCESS;
 		}
-		fz_always(ctx)
+
+		fz_matrix ctm;
+		fz_pixmap* pix;
+		fz_rect rect;
+		fz_irect bbox;
+		int alpha;
+		fz_colorspace* cs;
+		switch (colorFormat)
 		{
-			fz_close_device(ctx, device);
-			fz_drop_device(ctx, device);
+		case COLOR_RGB:
+			cs = fz_device_rgb(ctx);
+			alpha = 0;
+			break;
+		case COLOR_RGBA:
+			cs = fz_device_rgb(ctx);
+			alpha = 1;
+			break;
+		case COLOR_BGR:
+			cs = fz_device_bgr(ctx);
+			alpha = 0;
+			break;
+		case COLOR_BGRA:
+			cs = fz_device_bgr(ctx);
+			alpha = 1;
+			break;
 		}
-		fz_catch(ctx)
+
+		ctm = fz_scale(zoom, zoom);
+
+		rect.x0 = x0;
+		rect.y0 = y0;
+		rect.x1 = x1;
+		rect.y1 = y1;
+
+		bbox = fz_round_rect(fz_transform_rect(rect, ctm));
+
+		if (band_height <= 0 || band_height > bbox.y1 - bbox.y0)
 		{
-			return ERR_CANNOT_POPULATE_PAGE;
+			band_height = bbox.y1 - bbox.y0;
+		}
+
+		size_t stride = (size_t)(bbox.x1 - bbox.x0) * (fz_colorspace_n(ctx, cs) + alpha);
+
+		//Render the page one band at a time, straight into the destination buffer. Each band is post-processed while it is still in the cache.
+		for (int band_y = bbox.y0; band_y < bbox.y1; band_y += band_height)
+		{
+			if (cookie != NULL && cookie->abort)
+			{
+				return EXIT_SUCCESS;
+			}
+
+			fz_irect band = bbox;
+			band.y0 = band_y;
+			band.y1 = fz_mini(band_y + band_height, bbox.y1);
+
+			fz_try(ctx)
+			{
+				pix = new_pixmap_from_page_with_bbox_and_data(ctx, page, annotations, band, ctm, cs, alpha, pixel_storage + (size_t)(band_y - bbox.y0) * stride, cookie);
+			}
+			fz_catch(ctx)
+			{
+				return ERR_CANNOT_RENDER;
+			}
+
+			if (alpha && (flags & RENDER_UNPREMULTIPLY))
+			{
+				unpremultiply_pixels(pix->samples, (size_t)pix->w * pix->h);
+			}
+
+			fz_drop_pixmap(ctx, pix);
 		}
 
-		*out_page = page;
+		if (flags & RENDER_CLIP)
+		{
+			fz_rect clip;
+			clip.x0 = clip_x0;
+			clip.y0 = clip_y0;
+			clip.x1 = clip_x1;
+			clip.y1 = clip_y1;
 
-		int count = 0;
+			fz_try(ctx)
+			{
+				pix = new_pixmap_with_bbox_and_data(ctx, cs, bbox, NULL, alpha, pixel_storage);
+			}
+			fz_catch(ctx)
+			{
+				return ERR_CANNOT_RENDER;
+			}
 
-		fz_stext_block* curr_block = page->first_block;
+			clip_pixmap(pix, rect, clip);
 
-		while (curr_block != nullptr)
-		{
-			count++;
-			curr_block = curr_block->next;
+			fz_drop_pixmap(ctx, pix);
 		}
 
-		*out_stext_block_count = count;
-
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int GetStructuredTextPage(fz_context* ctx, fz_display_list* list, int flags, fz_stext_page** out_page, int* out_stext_block_count)
+	DLL_PUBLIC int CreateDisplayList(fz_context* ctx, fz_page* page, int annotations, fz_display_list** out_display_list)
 	{
-		fz_stext_page* page;
-		fz_stext_options options;
-		fz_device* device;
+		fz_display_list* list;
 
 		fz_try(ctx)
 		{
-			page = fz_new_stext_page(ctx, fz_infinite_rect);
+			if (annotations == 1)
+			{
+				list = fz_new_display_list_from_page(ctx, page);
+			}
+			else
+			{
+				list = fz_new_display_list_from_page_contents(ctx, page);
+			}
 		}
 		fz_catch(ctx)
 		{
-			return ERR_CANNOT_CREATE_PAGE;
+			return ERR_CANNOT_RENDER;
 		}
 
-		options.flags = flags;
+		*out_display_list = list;
+
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int GetDisplayListBounds(fz_context* ctx, fz_display_list* list, float* out_x0, float* out_y0, float* out_x1, float* out_y1)
+	{
+		fz_rect bounds;
+		fz_device* bbox;
+
+		fz_var(bbox);
 
 		fz_try(ctx)
 		{
-			device = fz_new_stext_device(ctx, page, &options);
-			fz_run_display_list(ctx, list, device, fz_identity, fz_infinite_rect, NULL);
-			fz_close_device(ctx, device);
+			bbox = fz_new_bbox_device(ctx, &bounds);
+			fz_run_display_list(ctx, list, bbox, fz_identity, fz_infinite_rect, NULL);
+			fz_close_device(ctx, bbox);
 		}
 		fz_always(ctx)
 		{
-			fz_drop_device(ctx, device);
+			fz_drop_device(ctx, bbox);
 		}
 		fz_catch(ctx)
 		{
-			return ERR_CANNOT_POPULATE_PAGE;
+			return ERR_CANNOT_COMPUTE_BOUNDS;
 		}
 
-		*out_page = page;
+		*out_x0 = bounds.x0;
+		*out_y0 = bounds.y0;
+		*out_x1 = bounds.x1;
+		*out_y1 = bounds.y1;
 
-		int count = 0;
+		return EXIT_SUCCESS;
+	}
 
-		fz_stext_block* curr_block = page->first_block;
+	DLL_PUBLIC uint64_t GetDisplayListSize(fz_context* ctx, fz_display_list* list)
+	{
+#if FZ_VERSION_MAJOR == 1 && FZ_VERSION_MINOR == 25
+		//Mirror of the private fz_display_list structure (see source/fitz/list-device.c). Display list nodes
+		//are 32-bit bitfields, and path data, colours, strokes etc. are stored inline in the node array.
+		struct display_list_layout
+		{
+			fz_storable storable;
+			void* list;
+			fz_rect mediabox;
+			size_t max;
+			size_t len;
+		};
 
-		while (curr_block != nullptr)
+		const display_list_layout* layout = (const display_list_layout*)list;
+
+		return sizeof(display_list_layout) + layout->max * sizeof(uint32_t);
+#else
+		return 0;
+#endif
+	}
+
+	DLL_PUBLIC int GetDisplayList(fz_context* ctx, fz_page* page, int annotations, fz_display_list** out_display_list, float* out_x0, float* out_y0, float* out_x1, float* out_y1)
+	{
+		fz_display_list* list;
+
+		int result = CreateDisplayList(ctx, page, annotations, &list);
+
+		if (result != EXIT_SUCCESS)
 		{
-			count++;
-			curr_block = curr_block->next;
+			return result;
 		}
 
-		*out_stext_block_count = count;
+		result = GetDisplayListBounds(ctx, list, out_x0, out_y0, out_x1, out_y1);
+
+		if (result != EXIT_SUCCESS)
+		{
+			return result;
+		}
+
+		*out_display_list = list;
 
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int DisposeStructuredTextPage(fz_context* ctx, fz_stext_page* page)
+	DLL_PUBLIC int DisposeDisplayList(fz_context* ctx, fz_display_list* list)
 	{
-		fz_drop_stext_page(ctx, page);
+		fz_drop_display_list(ctx, list);
 		return EXIT_SUCCESS;
 	}
 
-
-	DLL_PUBLIC int FinalizeDocumentWriter(fz_context* ctx, fz_document_writer* writ)
+	DLL_PUBLIC int GetPageBox(fz_context* ctx, fz_page* page, fz_box_type box, float* out_x, float* out_y, float* out_w, float* out_h)
 	{
+		fz_rect bounds;
+
 		fz_try(ctx)
 		{
-			fz_close_document_writer(ctx, writ);
+			bounds = fz_bound_page_box(ctx, page, box);
 		}
 		fz_catch(ctx)
 		{
-			return ERR_CANNOT_CLOSE_DOCUMENT;
+			return ERR_CANNOT_COMPUTE_BOUNDS;
 		}
 
-		fz_drop_document_writer(ctx, writ);
+		*out_x = bounds.x0;
+		*out_y = bounds.y0;
+		*out_w = bounds.x1 - bounds.x0;
+		*out_h = bounds.y1 - bounds.y0;
 
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int WriteSubDisplayListAsPage(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, fz_document_writer* writ)
+	DLL_PUBLIC int LoadPage(fz_context* ctx, fz_document* doc, int page_number, const fz_page** out_page, float* out_x, float* out_y, float* out_w, float* out_h)
 	{
-		fz_device* dev;
-		fz_rect rect;
-		fz_matrix ctm;
-
-		ctm = fz_concat(fz_translate(-x0, -y0), fz_scale(zoom, zoom));
-
-		rect.x0 = x0;
-		rect.y0 = y0;
-		rect.x1 = x1;
-		rect.y1 = y1;
-
-		rect = fz_transform_rect(rect, ctm);
-
-		fz_var(dev);
+		fz_page* page;
+		fz_rect bounds;
 
 		fz_try(ctx)
 		{
-			dev = fz_begin_page(ctx, writ, rect);
-			fz_run_display_list(ctx, list, dev, ctm, fz_infinite_rect, NULL);
-			fz_end_page(ctx, writ);
+			page = fz_load_page(ctx, doc, page_number);
 		}
 		fz_catch(ctx)
 		{
-			return ERR_CANNOT_RENDER;
+			return ERR_CANNOT_LOAD_PAGE;
 		}
 
-		return EXIT_SUCCESS;
-	}
-
-	DLL_PUBLIC int CreateDocumentWriter(fz_context* ctx, const char* file_name, int format, const char* options, const fz_document_writer** out_document_writer)
-	{
-		fz_document_writer* writ;
-
 		fz_try(ctx)
 		{
-			switch (format)
-			{
-			case OUT_DOC_PDF:
-				writ = fz_new_document_writer(ctx, file_name, "pdf", options);
-				break;
-			case OUT_DOC_SVG:
-				writ = fz_new_document_writer(ctx, file_name, "svg", options);
-				break;
-			case OUT_DOC_CBZ:
-				writ = fz_new_document_writer(ctx, file_name, "cbz", options);
-				break;
-			case OUT_DOC_DOCX:
-				writ = fz_new_document_writer(ctx, file_name, "docx", options);
-				break;
-			case OUT_DOC_ODT:
-				writ = fz_new_document_writer(ctx, file_name, "odt", options);
-				break;
-			case OUT_DOC_HTML:
-				writ = fz_new_document_writer(ctx, file_name, "html", options);
-				break;
-			case OUT_DOC_XHTML:
-				writ = fz_new_document_writer(ctx, file_name, "xhtml", options);
-				break;
-			case OUT_DOC_TXT:
-				writ = fz_new_document_writer(ctx, file_name, "text", options);
-				break;
-			case OUT_DOC_STEXT:
-				writ = fz_new_document_writer(ctx, file_name, "stext", options);
-				break;
-			}
+			bounds = fz_bound_page(ctx, page);
 		}
 		fz_catch(ctx)
 		{
-			return ERR_CANNOT_CREATE_WRITER;
+			fz_drop_page(ctx, page);
+			return ERR_CANNOT_COMPUTE_BOUNDS;
 		}
 
-		*out_document_writer = writ;
+		*out_x = bounds.x0;
+		*out_y = bounds.y0;
+		*out_w = bounds.x1 - bounds.x0;
+		*out_h = bounds.y1 - bounds.y0;
+
+		*out_page = page;
 
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int WriteImage(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length)
+	DLL_PUBLIC int DisposePage(fz_context* ctx, fz_page* page)
 	{
-		fz_matrix ctm;
-		fz_pixmap* pix;
-		fz_output* out;
-		fz_buffer* buf;
-		fz_rect rect;
-		int alpha;
-		fz_colorspace* cs;
-
-		ctm = fz_scale(zoom, zoom);
-
-		rect.x0 = x0;
-		rect.y0 = y0;
-		rect.x1 = x1;
-		rect.y1 = y1;
-
-		fz_var(out);
-		fz_var(buf);
-
+		fz_drop_page(ctx, page);
+		return EXIT_SUCCESS;
+	}
+	
+	DLL_PUBLIC int LayoutDocument(fz_context* ctx, fz_document* doc, float width, float height, float em, int* out_page_count)
+	{
+		fz_layout_document(ctx, doc, width, height, em);
+		
+		//Count the number of pages.
 		fz_try(ctx)
 		{
-			buf = fz_new_buffer(ctx, 1024);
-			out = fz_new_output_with_buffer(ctx, buf);
+			*out_page_count = fz_count_pages(ctx, doc);
 		}
 		fz_catch(ctx)
 		{
-			fz_drop_buffer(ctx, buf);
-			return ERR_CANNOT_CREATE_BUFFER;
+			return ERR_CANNOT_COUNT_PAGES;
 		}
+		
+		return EXIT_SUCCESS;
+	}
 
-		switch (colorFormat)
+	DLL_PUBLIC int CountPages(fz_context* ctx, fz_document* doc, int* out_page_count)
+	{
+		fz_try(ctx)
 		{
-		case COLOR_RGB:
-			cs = fz_device_rgb(ctx);
-			alpha = 0;
-			break;
-		case COLOR_RGBA:
-			cs = fz_device_rgb(ctx);
-			alpha = 1;
-			break;
-		case COLOR_BGR:
-			cs = fz_device_bgr(ctx);
-			alpha = 0;
-			break;
-		case COLOR_BGRA:
-			cs = fz_device_bgr(ctx);
-			alpha = 1;
-			break;
+			*out_page_count = fz_count_pages(ctx, doc);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_COUNT_PAGES;
 		}
 
+		return EXIT_SUCCESS;
+	}
 
-		//Render page to an RGB/RGBA pixmap.
+	DLL_PUBLIC int SetDocumentLayout(fz_context* ctx, fz_document* doc, float width, float height, float em)
+	{
 		fz_try(ctx)
 		{
-			pix = new_pixmap_from_display_list_with_separations_bbox(ctx, list, rect, ctm, cs, NULL, alpha);
+			fz_layout_document(ctx, doc, width, height, em);
 		}
 		fz_catch(ctx)
 		{
-			fz_drop_output(ctx, out);
-			fz_drop_buffer(ctx, buf);
-			return ERR_CANNOT_RENDER;
+			return ERR_CANNOT_COUNT_PAGES;
 		}
 
-		//Write the rendered pixmap to the output buffer in the specified format.
+		return EXIT_SUCCESS;
+	}
+
+	DLL_PUBLIC int CountChapters(fz_context* ctx, fz_document* doc, int* out_chapter_count)
+	{
 		fz_try(ctx)
 		{
-			switch (output_format)
-			{
-			case OUT_PNM:
-				fz_write_pixmap_as_pnm(ctx, out, pix);
-				break;
-			case OUT_PAM:
-				fz_write_pixmap_as_pam(ctx, out, pix);
-				break;
-			case OUT_PNG:
-				fz_write_pixmap_as_png(ctx, out, pix);
-				break;
-			case OUT_PSD:
-				fz_write_pixmap_as_psd(ctx, out, pix);
-				break;
-			case OUT_JPEG:
-				fz_write_pixmap_as_jpeg(ctx, out, pix, quality, 1);
-				break;
-			}
+			*out_chapter_count = fz_count_chapters(ctx, doc);
 		}
 		fz_catch(ctx)
 		{
-			fz_drop_output(ctx, out);
-			fz_drop_buffer(ctx, buf);
-			fz_drop_pixmap(ctx, pix);
-			return ERR_CANNOT_SAVE;
+			return ERR_CANNOT_COUNT_PAGES;
 		}
 
-		fz_close_output(ctx, out);
-		fz_drop_output(ctx, out);
-		fz_drop_pixmap(ctx, pix);
-
-		*out_buffer = buf;
-		*out_data = buf->data;
-		*out_length = buf->len;
-
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int DisposeBuffer(fz_context* ctx, fz_buffer* buf)
+	DLL_PUBLIC int CountChapterPages(fz_context* ctx, fz_document* doc, int chapter, int* out_page_count)
 	{
-		fz_drop_buffer(ctx, buf);
+		fz_try(ctx)
+		{
+			*out_page_count = fz_count_chapter_pages(ctx, doc, chapter);
+		}
+		fz_catch(ctx)
+		{
+			return ERR_CANNOT_COUNT_PAGES;
+		}
+
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int SaveImage(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int quality)
+	//Apply the initial layout to a document that has just been opened (unless layout_width is < 0) and count its pages (unless count_pages is 0, in which case the page count is -1).
+	//For reflowable documents, both operations lay out the whole document, so they should be skipped if the caller is going to change the layout anyway.
+	static int apply_initial_layout(fz_context* ctx, fz_document* doc, float layout_width, float layout_height, float layout_em, int count_pages, int* out_page_count)
 	{
-		fz_matrix ctm;
-		fz_pixmap* pix;
-		fz_rect rect;
-		int alpha;
-		fz_colorspace* cs;
+		if (layout_width >= 0)
+		{
+			fz_layout_document(ctx, doc, layout_width, layout_height, layout_em);
+		}
 
-		switch (colorFormat)
+		if (count_pages == 0)
 		{
-		case COLOR_RGB:
-			cs = fz_device_rgb(ctx);
-			alpha = 0;
-			break;
-		case COLOR_RGBA:
-			cs = fz_device_rgb(ctx);
-			alpha = 1;
-			break;
-		case COLOR_BGR:
-			cs = fz_device_bgr(ctx);
-			alpha = 0;
-			break;
-		case COLOR_BGRA:
-			cs = fz_device_bgr(ctx);
-			alpha = 1;
-			break;
+			*out_page_count = -1;
+			return EXIT_SUCCESS;
 		}
 
+		return CountPages(ctx, doc, out_page_count);
+	}
 
-		ctm = fz_scale(zoom, zoom);
+	//Read the resolution of an image from its header. fz_new_image_from_buffer only parses the header of the image and shares the data of the buffer, so the pixel data is not decoded here.
+	static void read_image_resolution(fz_context* ctx, fz_buffer* buf, float* out_image_xres, float* out_image_yres)
+	{
+		*out_image_xres = -1;
+		*out_image_yres = -1;
 
-		rect.x0 = x0;
-		rect.y0 = y0;
-		rect.x1 = x1;
-		rect.y1 = y1;
+		unsigned char* data;
+		size_t len = fz_buffer_storage(ctx, buf, &data);
 
-		//Render page to an RGB/RGBA pixmap.
-		fz_try(ctx)
+		if (len < 8 || fz_recognize_image_format(ctx, data) == FZ_IMAGE_UNKNOWN)
 		{
-			pix = new_pixmap_from_display_list_with_separations_bbox(ctx, list, rect, ctm, cs, NULL, alpha);
-		}
-		fz_catch(ctx)
-		{
-			return ERR_CANNOT_RENDER;
+			return;
 		}
 
-		//Save the rendered pixmap to the output file in the specified format.
+		fz_image* img = NULL;
+
+		fz_var(img);
+
 		fz_try(ctx)
 		{
-			switch (output_format)
+			img = fz_new_image_from_buffer(ctx, buf);
+
+			if (img != nullptr)
 			{
-			case OUT_PNM:
-				fz_save_pixmap_as_pnm(ctx, pix, file_name);
-				break;
-			case OUT_PAM:
-				fz_save_pixmap_as_pam(ctx, pix, file_name);
-				break;
-			case OUT_PNG:
-				fz_save_pixmap_as_png(ctx, pix, file_name);
-				break;
-			case OUT_PSD:
-				fz_save_pixmap_as_psd(ctx, pix, file_name);
-				break;
-			case OUT_JPEG:
-				fz_save_pixmap_as_jpeg(ctx, pix, file_name, quality);
-				break;
+				*out_image_xres = img->xres;
+				*out_image_yres = img->yres;
 			}
 		}
+		fz_always(ctx)
+		{
+			fz_drop_image(ctx, img);
+		}
 		fz_catch(ctx)
 		{
-			fz_drop_pixmap(ctx, pix);
-			return ERR_CANNOT_SAVE;
+			*out_image_xres = -1;
+			*out_image_yres = -1;
 		}
+	}
 
-		fz_drop_pixmap(ctx, pix);
-
-		return EXIT_SUCCESS;
+	DLL_PUBLIC int CreateDocumentFromFile(fz_context* ctx, const char* file_name, int get_image_resolution, const fz_document** out_doc, int* out_page_count, float* out_image_xres, float* out_image_yres)
+	{
+		int accelerator_state;
+		return CreateDocumentFromFileWithAccelerator(ctx, file_name, NULL, get_image_resolution, 595, 842, 11, 1, out_doc, out_page_count, out_image_xres, out_image_yres, &accelerator_state);
 	}
 
-	DLL_PUBLIC int CloneContext(fz_context* ctx, int count, fz_context** out_contexts)
+	DLL_PUBLIC int CreateDocumentFromFileWithAccelerator(fz_context* ctx, const char* file_name, const char* accelerator_file, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, const fz_document** out_doc, int* out_page_count, float* out_image_xres, float* out_image_yres, int* out_accelerator_state)
 	{
-		for (int i = 0; i < count; i++)
+		*out_accelerator_state = ACCELERATOR_NOT_USED;
+
+		//When the resolution is needed, the file is read only once: the same buffer is used to read the image header and to open the document.
+		fz_buffer* file_buffer = NULL;
+
+		fz_var(file_buffer);
+
+		*out_image_xres = -1;
+		*out_image_yres = -1;
+
+		if (get_image_resolution != 0)
 		{
 			fz_try(ctx)
 			{
-				fz_context* curr_ctx = fz_clone_context(ctx);
-				fz_var(curr_ctx);
+				file_buffer = fz_read_file(ctx, file_name);
+			}
+			fz_catch(ctx)
+			{
+				file_buffer = NULL;
+			}
 
-				out_contexts[i] = curr_ctx;
+			if (file_buffer != NULL)
+			{
+				read_image_resolution(ctx, file_buffer, out_image_xres, out_image_yres);
+			}
+		}
 
-				if (!curr_ctx)
+		fz_document* doc = NULL;
+
+		//Open the document using the accelerator, if there is one.
+		if (accelerator_file != NULL && fz_file_exists(ctx, accelerator_file))
+		{
+			fz_try(ctx)
+			{
+				doc = fz_open_accelerated_document(ctx, file_name, accelerator_file);
+				*out_accelerator_state = ACCELERATOR_LOADED;
+			}
+			fz_catch(ctx)
+			{
+				//The accelerator may be stale or corrupted: open the document normally (the accelerator will be replaced).
+				doc = NULL;
+			}
+		}
+
+		//Open the document.
+		if (doc == NULL)
+		{
+			fz_stream* str = NULL;
+
+			fz_var(str);
+
+			fz_try(ctx)
+			{
+				if (file_buffer != NULL)
 				{
-					for (int j = 0; j < i; j++)
-					{
-						fz_drop_context(out_contexts[j]);
-					}
-					return ERR_CANNOT_CLONE_CONTEXT;
+					str = fz_open_buffer(ctx, file_buffer);
+					doc = fz_open_document_with_stream(ctx, file_name, str);
+				}
+				else
+				{
+					doc = fz_open_document(ctx, file_name);
 				}
 			}
+			fz_always(ctx)
+			{
+				fz_drop_stream(ctx, str);
+				fz_drop_buffer(ctx, file_buffer);
+			}
 			fz_catch(ctx)
 			{
-				for (int j = 0; j < i; j++)
+				return ERR_CANNOT_OPEN_FILE;
+			}
+		}
+		else
+		{
+			fz_drop_buffer(ctx, file_buffer);
+		}
+		
+		//Reflow the document to the initial page size and count the number of pages.
+		if (apply_initial_layout(ctx, doc, layout_width, layout_height, layout_em, count_pages, out_page_count) != EXIT_SUCCESS)
+		{
+			fz_drop_document(ctx, doc);
+			return ERR_CANNOT_COUNT_PAGES;
+		}
+
+		//Save the accelerator for the next time the document is opened. Failing to do so is not an error.
+		if (accelerator_file != NULL && *out_accelerator_state == ACCELERATOR_NOT_USED)
+		{
+			fz_try(ctx)
+			{
+				if (fz_document_supports_accelerator(ctx, doc))
 				{
-					fz_drop_context(out_contexts[j]);
+					fz_save_accelerator(ctx, doc, accelerator_file);
+					*out_accelerator_state = ACCELERATOR_CREATED;
 				}
-				return ERR_CANNOT_CLONE_CONTEXT;
+			}
+			fz_catch(ctx)
+			{
 			}
 		}
 
+		*out_doc = doc;
+
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int RenderSubDisplayList(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, unsigned char* pixel_storage, fz_cookie* cookie)
+	DLL_PUBLIC int CreateDocumentFromStream(fz_context* ctx, const unsigned char* data, const uint64_t data_length, const char* file_type, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, const fz_document** out_doc, const fz_stream** out_str, int* out_page_count, float* out_image_xres, float* out_image_yres)
 	{
-		if (cookie != NULL && cookie->abort)
+
+		fz_stream* str;
+		fz_document* doc;
+
+		fz_try(ctx)
 		{
-			return EXIT_SUCCESS;
+			str = fz_open_memory(ctx, data, data_length);
 		}
-
-		fz_matrix ctm;
-		fz_pixmap* pix;
-		fz_rect rect;
-		int alpha;
-		fz_colorspace* cs;
-		switch (colorFormat)
+		fz_catch(ctx)
 		{
-		case COLOR_RGB:
-			cs = fz_device_rgb(ctx);
-			alpha = 0;
-			break;
-		case COLOR_RGBA:
-			cs = fz_device_rgb(ctx);
-			alpha = 1;
-			break;
-		case COLOR_BGR:
-			cs = fz_device_bgr(ctx);
-			alpha = 0;
-			break;
-		case COLOR_BGRA:
-			cs = fz_device_bgr(ctx);
-			alpha = 1;
-			break;
+			return ERR_CANNOT_OPEN_STREAM;
 		}
 
-		ctm = fz_scale(zoom, zoom);
+		*out_image_xres = -1;
+		*out_image_yres = -1;
 
-		rect.x0 = x0;
-		rect.y0 = y0;
-		rect.x1 = x1;
-		rect.y1 = y1;
+		if (get_image_resolution != 0)
+		{
+			fz_buffer* img_buf = NULL;
 
-		//Render page to an RGB/RGBA pixmap.
+			fz_try(ctx)
+			{
+				img_buf = fz_new_buffer_from_shared_data(ctx, data, data_length);
+			}
+			fz_catch(ctx)
+			{
+				img_buf = NULL;
+			}
+
+			if (img_buf != NULL)
+			{
+				read_image_resolution(ctx, img_buf, out_image_xres, out_image_yres);
+				fz_drop_buffer(ctx, img_buf);
+			}
+		}
+
+		//Open the document.
 		fz_try(ctx)
 		{
-			pix = new_pixmap_from_display_list_with_separations_bbox_and_data(ctx, list, rect, ctm, cs, NULL, alpha, pixel_storage, cookie);
+			doc = fz_open_document_with_stream(ctx, file_type, str);
+		}
+		fz_catch(ctx)
+		{
+
+			fz_drop_stream(ctx, str);
+			return ERR_CANNOT_OPEN_FILE;
+		}
+		
+		//Reflow the document to the initial page size and count the number of pages.
+		if (apply_initial_layout(ctx, doc, layout_width, layout_height, layout_em, count_pages, out_page_count) != EXIT_SUCCESS)
+		{
+			fz_drop_document(ctx, doc);
+			fz_drop_stream(ctx, str);
+			return ERR_CANNOT_COUNT_PAGES;
+		}
+
+		*out_str = str;
+		*out_doc = doc;
+
+		return EXIT_SUCCESS;
+	}
+
+	//A read-only view of a whole file.
+	struct mapped_file
+	{
+		const unsigned char* data;
+		uint64_t length;
+#if defined _WIN32
+		HANDLE file;
+		HANDLE mapping;
+#endif
+	};
+
+	//Map a file in memory (read-only). Returns NULL if the file cannot be opened or mapped (including if it is empty).
+	static mapped_file* map_file(const char* file_name)
+	{
+#if defined _WIN32
+		int wide_length = MultiByteToWideChar(CP_UTF8, 0, file_name, -1, NULL, 0);
+
+		if (wide_length <= 0)
+		{
+			return NULL;
 		}
-		fz_catch(ctx)
-		{
 
-			return ERR_CANNOT_RENDER;
+		wchar_t* wide_file_name = (wchar_t*)malloc(sizeof(wchar_t) * wide_length);
+
+		if (wide_file_name == NULL)
+		{
+			return NULL;
 		}
 
-		fz_drop_pixmap(ctx, pix);
+		MultiByteToWideChar(CP_UTF8, 0, file_name, -1, wide_file_name, wide_length);
 
-		return EXIT_SUCCESS;
-	}
+		HANDLE file = CreateFileW(wide_file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
 
-	DLL_PUBLIC int GetDisplayList(fz_context* ctx, fz_page* page, int annotations, fz_display_list** out_display_list, float* out_x0, float* out_y0, float* out_x1, float* out_y1)
-	{
-		fz_display_list* list;
-		fz_rect bounds;
-		fz_device* bbox;
+		free(wide_file_name);
 
-		fz_try(ctx)
+		if (file == INVALID_HANDLE_VALUE)
 		{
-			if (annotations == 1)
-			{
-				list = fz_new_display_list_from_page(ctx, page);
-			}
-			else
-			{
-				list = fz_new_display_list_from_page_contents(ctx, page);
-			}
+			return NULL;
 		}
-		fz_catch(ctx)
+
+		LARGE_INTEGER size;
+
+		if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0)
 		{
-			return ERR_CANNOT_RENDER;
+			CloseHandle(file);
+			return NULL;
 		}
 
-		fz_var(bbox);
+		HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
 
-		fz_try(ctx)
+		if (mapping == NULL)
 		{
-			bbox = fz_new_bbox_device(ctx, &bounds);
-			fz_run_display_list(ctx, list, bbox, fz_identity, fz_infinite_rect, NULL);
-			fz_close_device(ctx, bbox);
+			CloseHandle(file);
+			return NULL;
 		}
-		fz_always(ctx)
+
+		void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+		if (data == NULL)
 		{
-			fz_drop_device(ctx, bbox);
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return NULL;
 		}
-		fz_catch(ctx)
+
+		mapped_file* tbr = (mapped_file*)malloc(sizeof(mapped_file));
+
+		if (tbr == NULL)
 		{
-			return ERR_CANNOT_COMPUTE_BOUNDS;
+			UnmapViewOfFile(data);
+			CloseHandle(mapping);
+			CloseHandle(file);
+			return NULL;
 		}
 
-		*out_display_list = list;
+		tbr->data = (const unsigned char*)data;
+		tbr->length = (uint64_t)size.QuadPart;
+		tbr->file = file;
+		tbr->mapping = mapping;
 
-		*out_x0 = bounds.x0;
-		*out_y0 = bounds.y0;
-		*out_x1 = bounds.x1;
-		*out_y1 = bounds.y1;
+		return tbr;
+#else
+		int fd = open(file_name, O_RDONLY);
 
-		return EXIT_SUCCESS;
-	}
+		if (fd < 0)
+		{
+			return NULL;
+		}
 
-	DLL_PUBLIC int DisposeDisplayList(fz_context* ctx, fz_display_list* list)
-	{
-		fz_drop_display_list(ctx, list);
-		return EXIT_SUCCESS;
-	}
+		struct stat st;
 
-	DLL_PUBLIC int GetPageBox(fz_context* ctx, fz_page* page, fz_box_type box, float* out_x, float* out_y, float* out_w, float* out_h)
-	{
-		fz_rect bounds;
+		if (fstat(fd, &st) != 0 || st.st_size <= 0)
+		{
+			close(fd);
+			return NULL;
+		}
 
-		fz_try(ctx)
+		void* data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+		//The mapping keeps its own reference to the file.
+		close(fd);
+
+		if (data == MAP_FAILED)
 		{
-			bounds = fz_bound_page_box(ctx, page, box);
+			return NULL;
 		}
-		fz_catch(ctx)
+
+		mapped_file* tbr = (mapped_file*)malloc(sizeof(mapped_file));
+
+		if (tbr == NULL)
 		{
-			return ERR_CANNOT_COMPUTE_BOUNDS;
+			munmap(data, (size_t)st.st_size);
+			return NULL;
 		}
 
-		*out_x = bounds.x0;
-		*out_y = bounds.y0;
-		*out_w = bounds.x1 - bounds.x0;
-		*out_h = bounds.y1 - bounds.y0;
+		tbr->data = (const unsigned char*)data;
+		tbr->length = (uint64_t)st.st_size;
 
-		return EXIT_SUCCESS;
+		return tbr;
+#endif
 	}
 
-	DLL_PUBLIC int LoadPage(fz_context* ctx, fz_document* doc, int page_number, const fz_page** out_page, float* out_x, float* out_y, float* out_w, float* out_h)
+	DLL_PUBLIC int CreateDocumentFromMappedFile(fz_context* ctx, const char* file_name, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, const fz_document** out_doc, const fz_stream** out_str, int* out_page_count, float* out_image_xres, float* out_image_yres, mapped_file** out_mapping, const unsigned char** out_data, uint64_t* out_length)
 	{
-		fz_page* page;
-		fz_rect bounds;
+		mapped_file* mapping = map_file(file_name);
 
-		fz_try(ctx)
-		{
-			page = fz_load_page(ctx, doc, page_number);
-		}
-		fz_catch(ctx)
+		if (mapping == NULL)
 		{
-			return ERR_CANNOT_LOAD_PAGE;
+			return ERR_CANNOT_OPEN_FILE;
 		}
 
-		fz_try(ctx)
-		{
-			bounds = fz_bound_page(ctx, page);
-		}
-		fz_catch(ctx)
+		//The file name is used as the magic, so that the document type is determined in the same way as fz_open_document.
+		int result = CreateDocumentFromStream(ctx, mapping->data, mapping->length, file_name, get_image_resolution, layout_width, layout_height, layout_em, count_pages, out_doc, out_str, out_page_count, out_image_xres, out_image_yres);
+
+		if (result != EXIT_SUCCESS)
 		{
-			fz_drop_page(ctx, page);
-			return ERR_CANNOT_COMPUTE_BOUNDS;
+			DisposeMappedFile(mapping);
+			return result;
 		}
 
-		*out_x = bounds.x0;
-		*out_y = bounds.y0;
-		*out_w = bounds.x1 - bounds.x0;
-		*out_h = bounds.y1 - bounds.y0;
-
-		*out_page = page;
+		*out_mapping = mapping;
+		*out_data = mapping->data;
+		*out_length = mapping->length;
 
 		return EXIT_SUCCESS;
 	}
 
-	DLL_PUBLIC int DisposePage(fz_context* ctx, fz_page* page)
-	{
-		fz_drop_page(ctx, page);
-		return EXIT_SUCCESS;
-	}
-	
-	DLL_PUBLIC int LayoutDocument(fz_context* ctx, fz_document* doc, float width, float height, float em, int* out_page_count)
+	DLL_PUBLIC void DisposeMappedFile(mapped_file* mapping)
 	{
-		fz_layout_document(ctx, doc, width, height, em);
-		
-		//Count the number of pages.
-		fz_try(ctx)
+		if (mapping == NULL)
 		{
-			*out_page_count = fz_count_pages(ctx, doc);
-		}
-		fz_catch(ctx)
-		{
-			return ERR_CANNOT_COUNT_PAGES;
+			return;
 		}
-		
-		return EXIT_SUCCESS;
+
+#if defined _WIN32
+		UnmapViewOfFile(mapping->data);
+		CloseHandle(mapping->mapping);
+		CloseHandle(mapping->file);
+#else
+		munmap((void*)mapping->data, (size_t)mapping->length);
+#endif
+
+		free(mapping);
 	}
 
-	DLL_PUBLIC int CreateDocumentFromFile(fz_context* ctx, const char* file_name, int get_image_resolution, const fz_document** out_doc, int* out_page_count, float* out_image_xres, float* out_image_yres)
+	//A block of data read from a callback stream.
+	struct callback_stream_block
 	{
-		if (get_image_resolution != 0)
+		int64_t index;
+		int64_t length;
+		uint64_t last_used;
+		unsigned char* data;
+	};
+
+	//State of a stream that reads blocks of data through a callback, keeping the most recently used blocks in a bounded cache.
+	struct callback_stream_state
+	{
+		readCallback read;
+		int64_t length;
+		int64_t block_size;
+		int block_count;
+		uint64_t tick;
+		unsigned char dummy;
+		callback_stream_block* blocks;
+	};
+
+	//Get the block with the specified index, reading it through the callback (and replacing the least recently used block) if it is not in the cache.
+	//The memory for each block is only allocated the first time the block is used (blocks that have never been used have last_used == 0, so they are picked before any block
+	//is evicted), so that small documents do not allocate the whole cache.
+	static callback_stream_block* get_callback_stream_block(fz_context* ctx, callback_stream_state* state, int64_t index)
+	{
+		callback_stream_block* lru = &state->blocks[0];
+
+		for (int i = 0; i < state->block_count; i++)
 		{
-			fz_image* img;
+			if (state->blocks[i].index == index)
+			{
+				state->blocks[i].last_used = ++state->tick;
+				return &state->blocks[i];
+			}
 
-			fz_try(ctx)
+			if (state->blocks[i].last_used < lru->last_used)
 			{
-				img = fz_new_image_from_file(ctx, file_name);
+				lru = &state->blocks[i];
+			}
+		}
 
-				if (img != nullptr)
-				{
-					*out_image_xres = img->xres;
-					*out_image_yres = img->yres;
-				}
-				else
-				{
-					*out_image_xres = -1;
-					*out_image_yres = -1;
-				}
+		int64_t offset = index * state->block_size;
+		int64_t length = state->length - offset < state->block_size ? state->length - offset : state->block_size;
+
+		//Invalidate the block first, so that it is not reused if the read fails.
+		lru->index = -1;
+		lru->last_used = 0;
+
+		if (lru->data == NULL)
+		{
+			lru->data = (unsigned char*)fz_malloc(ctx, state->block_size);
+		}
+
+		int64_t read = 0;
 
-				fz_drop_image(ctx, img);
+		while (read < length)
+		{
+			int result = state->read(lru->data + read, offset + read, (int)(length - read));
+
+			if (result < 0)
+			{
+				fz_throw(ctx, FZ_ERROR_SYSTEM, "cannot read from the input stream");
 			}
-			fz_catch(ctx)
+			else if (result == 0)
 			{
-				*out_image_xres = -1;
-				*out_image_yres = -1;
+				break;
 			}
-		}
-		else
-		{
-			*out_image_xres = -1;
-			*out_image_yres = -1;
+
+			read += result;
 		}
 
-		fz_document* doc;
+		lru->index = index;
+		lru->length = read;
+		lru->last_used = ++state->tick;
 
-		//Open the document.
-		fz_try(ctx)
+		return lru;
+	}
+
+	static int next_callback_stream(fz_context* ctx, fz_stream* stm, size_t max)
+	{
+		callback_stream_state* state = (callback_stream_state*)stm->state;
+
+		if (stm->pos >= state->length)
 		{
-			doc = fz_open_document(ctx, file_name);
+			stm->rp = stm->wp = &state->dummy;
+			return EOF;
 		}
-		fz_catch(ctx)
+
+		callback_stream_block* block = get_callback_stream_block(ctx, state, stm->pos / state->block_size);
+
+		int64_t start = stm->pos - block->index * state->block_size;
+
+		if (start >= block->length)
 		{
-			return ERR_CANNOT_OPEN_FILE;
+			stm->rp = stm->wp = &state->dummy;
+			return EOF;
 		}
-		
-		//Reflow the document to an A4 page size.
-		fz_layout_document(ctx, doc, 595, 842, 11);
 
-		//Count the number of pages.
-		fz_try(ctx)
+		stm->rp = block->data + start;
+		stm->wp = block->data + block->length;
+		stm->pos += block->length - start;
+
+		return *stm->rp++;
+	}
+
+	static void seek_callback_stream(fz_context* ctx, fz_stream* stm, int64_t offset, int whence)
+	{
+		callback_stream_state* state = (callback_stream_state*)stm->state;
+
+		//fz_seek converts SEEK_CUR into SEEK_SET before calling this.
+		int64_t position = whence == SEEK_END ? state->length + offset : offset;
+
+		if (position < 0)
 		{
-			*out_page_count = fz_count_pages(ctx, doc);
+			position = 0;
 		}
-		fz_catch(ctx)
+		else if (position > state->length)
 		{
-			fz_drop_document(ctx, doc);
-			return ERR_CANNOT_COUNT_PAGES;
+			position = state->length;
 		}
 
-		*out_doc = doc;
-
-		return EXIT_SUCCESS;
+		stm->pos = position;
+		stm->rp = stm->wp = &state->dummy;
 	}
 
-	DLL_PUBLIC int CreateDocumentFromStream(fz_context* ctx, const unsigned char* data, const uint64_t data_length, const char* file_type, int get_image_resolution, const fz_document** out_doc, const fz_stream** out_str, int* out_page_count, float* out_image_xres, float* out_image_yres)
+	static void drop_callback_stream(fz_context* ctx, void* state_ptr)
 	{
+		callback_stream_state* state = (callback_stream_state*)state_ptr;
 
-		fz_stream* str;
+		if (state->blocks != NULL)
+		{
+			for (int i = 0; i < state->block_count; i++)
+			{
+				fz_free(ctx, state->blocks[i].data);
+			}
+
+			fz_free(ctx, state->blocks);
+		}
+
+		fz_free(ctx, state);
+	}
+
+	DLL_PUBLIC int CreateDocumentFromCallbackStream(fz_context* ctx, readCallback read, int64_t length, int block_size, int block_count, const char* file_type, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, const fz_document** out_doc, const fz_stream** out_str, int* out_page_count, float* out_image_xres, float* out_image_yres)
+	{
+		fz_stream* str = NULL;
 		fz_document* doc;
 
+		callback_stream_state* state = NULL;
+
+		fz_var(state);
+
 		fz_try(ctx)
 		{
-			str = fz_open_memory(ctx, data, data_length);
+			state = fz_malloc_struct(ctx, callback_stream_state);
+			state->read = read;
+			state->length = length;
+			state->block_size = block_size;
+			state->block_count = block_count;
+			state->blocks = fz_malloc_struct_array(ctx, block_count, callback_stream_block);
+
+			//The data of each block is allocated when the block is first used.
+			for (int i = 0; i < block_count; i++)
+			{
+				state->blocks[i].index = -1;
+			}
+
+			str = fz_new_stream(ctx, state, next_callback_stream, drop_callback_stream);
+			str->seek = seek_callback_stream;
 		}
 		fz_catch(ctx)
 		{
+			if (state != NULL)
+			{
+				drop_callback_stream(ctx, state);
+			}
+
 			return ERR_CANNOT_OPEN_STREAM;
 		}
 
+		*out_image_xres = -1;
+		*out_image_yres = -1;
+
 		if (get_image_resolution != 0)
 		{
-			fz_image* img;
-			fz_buffer* img_buf;
+			//Image documents read the whole stream in memory anyway: read it only once, get the resolution from the header and open the document from the same buffer.
+			fz_buffer* img_buf = NULL;
+			fz_stream* img_str = NULL;
 
-			int bufferCreated = 0;
+			fz_var(img_buf);
+			fz_var(img_str);
 
 			fz_try(ctx)
 			{
-				img_buf = fz_new_buffer_from_shared_data(ctx, data, data_length);
-				bufferCreated = 1;
+				img_buf = fz_read_all(ctx, str, (size_t)length);
+				img_str = fz_open_buffer(ctx, img_buf);
 			}
-			fz_catch(ctx)
+			fz_always(ctx)
 			{
-				bufferCreated = 0;
+				fz_drop_stream(ctx, str);
 			}
-
-			if (bufferCreated == 1)
+			fz_catch(ctx)
 			{
-				fz_try(ctx)
-				{
-					img = fz_new_image_from_buffer(ctx, img_buf);
-
-					if (img != nullptr)
-					{
-						*out_image_xres = img->xres;
-						*out_image_yres = img->yres;
-					}
-					else
-					{
-						*out_image_xres = -1;
-						*out_image_yres = -1;
-					}
-
-					fz_drop_image(ctx, img);
-				}
-				fz_catch(ctx)
-				{
-					*out_image_xres = -1;
-					*out_image_yres = -1;
-				}
-
 				fz_drop_buffer(ctx, img_buf);
+				return ERR_CANNOT_OPEN_STREAM;
 			}
-			else
-			{
-				*out_image_xres = -1;
-				*out_image_yres = -1;
-			}
-		}
-		else
-		{
-			*out_image_xres = -1;
-			*out_image_yres = -1;
+
+			read_image_resolution(ctx, img_buf, out_image_xres, out_image_yres);
+			fz_drop_buffer(ctx, img_buf);
+
+			str = img_str;
 		}
 
 		//Open the document.
@@ -1993,22 +4516,13 @@ extern "C"
 		}
 		fz_catch(ctx)
 		{
-
 			fz_drop_stream(ctx, str);
 			return ERR_CANNOT_OPEN_FILE;
 		}
-		
-		//Reflow the document to an A4 page size.
-		fz_layout_document(ctx, doc, 595, 842, 11);
 
-		//Count the number of pages.
-		fz_try(ctx)
-		{
-			*out_page_count = fz_count_pages(ctx, doc);
-		}
-		fz_catch(ctx)
+		//Reflow the document to the initial page size and count the number of pages.
+		if (apply_initial_layout(ctx, doc, layout_width, layout_height, layout_em, count_pages, out_page_count) != EXIT_SUCCESS)
 		{
-
 			fz_drop_document(ctx, doc);
 			fz_drop_stream(ctx, str);
 			return ERR_CANNOT_COUNT_PAGES;
@@ -2078,12 +4592,37 @@ extern "C"
 	}
 
 	DLL_PUBLIC int CreateContext(uint64_t store_size, const fz_context** out_ctx)
+	{
+		return CreateContextWithAllocator(store_size, ALLOC_SYSTEM, out_ctx);
+	}
+
+	DLL_PUBLIC void ReleasePooledMemory()
+	{
+		pool_release_cache();
+	}
+
+	DLL_PUBLIC int CreateContextWithAllocator(uint64_t store_size, int allocator, const fz_context** out_ctx)
 	{
 		fz_context* ctx;
 		fz_locks_context locks;
+		fz_alloc_context alloc;
+
+		alloc.user = NULL;
+		alloc.malloc = pool_malloc;
+		alloc.realloc = pool_realloc;
+		alloc.free = pool_free;
+
+		//Create lock objects necessary for multithreaded context operations. Each new context gets its own lock table.
+		mutex_holder* mutexes = new (std::nothrow) mutex_holder();
+
+		if (!mutexes)
+		{
+			return ERR_CANNOT_INIT_MUTEX;
+		}
 
-		//Create lock objects necessary for multithreaded context operations.
-		locks.user = &global_mutex;
+		mutexes->refs = 1;
+
+		locks.user = mutexes;
 		locks.lock = lock_mutex;
 		locks.unlock = unlock_mutex;
 
@@ -2091,9 +4630,10 @@ extern "C"
 		unlock_mutex(locks.user, 0);
 
 		//Create a context to hold the exception stack and various caches.
-		ctx = fz_new_context(NULL, &locks, store_size);
+		ctx = fz_new_context(allocator == ALLOC_POOL ? &alloc : NULL, &locks, store_size);
 		if (!ctx)
 		{
+			delete mutexes;
 			return ERR_CANNOT_CREATE_CONTEXT;
 		}
 
@@ -2106,7 +4646,7 @@ extern "C"
 		}
 		fz_catch(ctx)
 		{
-			fz_drop_context(ctx);
+			DisposeContext(ctx);
 
 			return ERR_CANNOT_REGISTER_HANDLERS;
 		}
@@ -2118,7 +4658,16 @@ extern "C"
 
 	DLL_PUBLIC int DisposeContext(fz_context* ctx)
 	{
+		mutex_holder* mutexes = (mutex_holder*)ctx->locks.user;
+
+		//Dropping the context may still need the locks, so the lock table can only be released afterwards.
 		fz_drop_context(ctx);
+
+		if (--mutexes->refs == 0)
+		{
+			delete mutexes;
+		}
+
 		return EXIT_SUCCESS;
 	}
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -58,6 +58,121 @@ enum
 	COLOR_BGRA = 3
 };
 
+//Post-processing options for RenderSubDisplayList
+enum
+{
+	RENDER_UNPREMULTIPLY = 1,
+	RENDER_CLIP = 2
+};
+
+//Native allocators
+enum
+{
+	ALLOC_SYSTEM = 0,
+	ALLOC_POOL = 1
+};
+
+//State of an image that is being encoded one band at a time (defined in MuPDFWrapper.cpp).
+struct banded_image_writer;
+
+//Whether CreateDocumentFromFileWithAccelerator used an accelerator file
+enum
+{
+	ACCELERATOR_NOT_USED = 0,
+	ACCELERATOR_LOADED = 1,
+	ACCELERATOR_CREATED = 2
+};
+
+//A file mapped in memory by CreateDocumentFromMappedFile (defined in MuPDFWrapper.cpp).
+struct mapped_file;
+
+//Text encodings supported by GetPageText
+enum
+{
+	TEXT_ENCODING_UTF8 = 0,
+	TEXT_ENCODING_UTF16 = 1
+};
+
+//Callback used to push encoded data to the caller while it is being written. It should return 0 on success and a non-zero value if the data could not be written.
+typedef int (*writeCallback)(const unsigned char* data, uint64_t length);
+
+//Callback used to pull data from the caller when a document is opened with CreateDocumentFromCallbackStream. It should copy up to length bytes starting at offset into the buffer, and return the number of bytes that were copied, or -1 if the data could not be read.
+typedef int (*readCallback)(unsigned char* buffer, int64_t offset, int length);
+
+//Version of the layout of the buffer produced by GetStructuredTextPageData. This must be increased whenever the layout changes.
+#define STEXT_PAGE_DATA_VERSION 1
+
+//Header of the buffer produced by GetStructuredTextPageData. The header is followed by the arrays, whose offsets (in bytes from the start of the buffer) are stored here.
+//Text blocks are listed in depth-first order (including those nested within structure blocks); lines and characters are stored contiguously for each block/line.
+struct stext_page_data_header
+{
+	int32_t version;
+	int32_t block_count;
+	int32_t line_count;
+	int32_t char_count;
+	int32_t font_count;
+	int32_t reserved;
+
+	//fz_stext_block*[block_count]
+	int64_t block_pointers;
+	//int32_t[block_count]
+	int64_t block_first_lines;
+	//int32_t[block_count]
+	int64_t block_line_counts;
+
+	//int32_t[line_count]
+	int64_t line_wmodes;
+	//float[line_count * 4] (x0, y0, x1, y1)
+	int64_t line_bboxes;
+	//float[line_count * 2] (x, y)
+	int64_t line_dirs;
+	//int32_t[line_count]
+	int64_t line_first_chars;
+	//int32_t[line_count]
+	int64_t line_char_counts;
+
+	//int32_t[char_count]
+	int64_t char_codepoints;
+	//uint32_t[char_count]
+	int64_t char_colors;
+	//int32_t[char_count]
+	int64_t char_bidis;
+	//int32_t[char_count], index in the font table.
+	int64_t char_fonts;
+	//float[char_count]
+	int64_t char_sizes;
+	//float[char_count * 2] (x, y)
+	int64_t char_origins;
+	//float[char_count * 8] (ll, ul, ur, lr)
+	int64_t char_quads;
+
+	//fz_font*[font_count]
+	int64_t font_pointers;
+};
+
+//Options for SearchStructuredTextPage and SearchDisplayListText
+enum
+{
+	//Only keep the hits whose characters match the needle exactly (MuPDF's own search ignores case).
+	SEARCH_CASE_SENSITIVE = 1
+};
+
+//A search hit, as stored in the buffer produced by SearchStructuredTextPage and SearchDisplayListText. The buffer contains hit_count hits, followed by quad_count quads (float[8], ll, ul, ur, lr).
+//Addresses use the same block, line and character indices as MuPDFStructuredTextPage (lines within a structure block are numbered in depth-first order). They are -1 if the hit could not be mapped to the characters of the page.
+struct stext_search_hit
+{
+	int32_t first_quad;
+	int32_t quad_count;
+
+	int32_t start_block;
+	int32_t start_line;
+	int32_t start_char;
+
+	int32_t end_block;
+	int32_t end_line;
+	int32_t end_char;
+};
+
 
 //Macros to define the exported functions.
 #define BUILDING_DLL 1
@@ -89,15 +204,18 @@ enum
 #endif
 
 //A structure to hold the mutexes used by the locking mechanism. An array might have been a better choice, but this is more easily manageable.
+//Each context created by CreateContext gets its own lock table, which is shared with its clones (these share the same store and caches) and freed when the last of them is disposed.
+//This way, unrelated contexts never contend for the same locks. The exception is FZ_LOCK_FREETYPE, which also protects state that MuPDF keeps in global variables
+//(e.g., the HarfBuzz allocator), and is therefore mapped to a single process-wide mutex (see lock_mutex).
 struct mutex_holder
 {
 	std::mutex mutex0;
-	std::mutex mutex1;
 	std::mutex mutex2;
 	std::mutex mutex3;
-};
 
-mutex_holder global_mutex;
+	//Number of live contexts using this lock table.
+	std::atomic<int> refs;
+};
 
 //Copied here from store.c
 typedef struct fz_item
@@ -530,6 +648,18 @@ extern "C"
 	/// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
 	DLL_PUBLIC int WriteRasterImage(fz_context* ctx, fz_image *image, int output_format, int quality, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length, int convert_to_rgb);
 
+	/// <summary>
+	/// Write an image in the specified format, passing the encoded data to a callback in chunks as it is produced, rather than accumulating it in a buffer.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="image">A pointer to the image.</param>
+	/// <param name="output_format">The output format.</param>
+	/// <param name="quality">For JPEG output, the quality value.</param>
+	/// <param name="convert_to_rgb">If this is 1, the image is converted to the RGB colour space before being exported.</param>
+	/// <param name="callback">The function that receives the encoded data. If this returns a non-zero value, writing is aborted and ERR_CANNOT_SAVE is returned.</param>
+	/// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int WriteRasterImageToStream(fz_context* ctx, fz_image* image, int output_format, int quality, int convert_to_rgb, writeCallback callback);
+
 	/// <summary>
 	/// Save an image to a file in the specified format.
 	/// </summary>
@@ -816,6 +946,89 @@ extern "C"
 	/// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
 	DLL_PUBLIC int DisposeStructuredTextPage(fz_context* ctx, fz_stext_page* page);
 
+	/// <summary>
+	/// Serialise the text blocks, lines and characters of a structured text page into a single flat buffer (see stext_page_data_header). Each distinct font is kept once and stored in a font table.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="page">The structured text page to serialise.</param>
+	/// <param name="out_data">The address of the buffer, which must be freed using DisposeStructuredTextPageData.</param>
+	/// <param name="out_length">The length in bytes of the buffer.</param>
+	/// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int GetStructuredTextPageData(fz_context* ctx, fz_stext_page* page, unsigned char** out_data, int64_t* out_length);
+
+	/// <summary>
+	/// Free a buffer produced by GetStructuredTextPageData. This does not drop the fonts in the font table.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="data">The buffer to free.</param>
+	DLL_PUBLIC void DisposeStructuredTextPageData(fz_context* ctx, unsigned char* data);
+
+	/// <summary>
+	/// Extract the plain text of a page as UTF-8, without creating a structured text representation for the caller. Text lines that are empty or only contain white space are skipped.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="page">The page whose text should be extracted.</param>
+	/// <param name="annotations">If this is 1, the text of the annotations is included. Otherwise, only the page contents are used.</param>
+	/// <param name="flags">An integer equivalent to <see cref="StructuredText.StructuredTextFlags"/>, specifying flags for the structured text creation.</param>
+	/// <param name="separator">A null-terminated UTF-8 string that is written between consecutive text lines.</param>
+	/// <param name="cookie">A cookie that can be used to abort the operation (can be NULL).</param>
+	/// <param name="out_buffer">The address of the buffer containing the text, which must be freed using DisposeBuffer.</param>
+	/// <param name="out_data">The address of the text data within the buffer (not null-terminated).</param>
+	/// <param name="out_length">The length in bytes of the text data.</param>
+	/// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int ExtractPageTextUTF8(fz_context* ctx, fz_page* page, int annotations, int flags, const char* separator, fz_cookie* cookie, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length);
+
+	/// <summary>
+	/// Extract the plain text of a display list directly into a buffer provided by the caller, without creating a structured text representation for the caller. Text lines that are empty or only contain white space are skipped.
+	/// If the buffer is too small, only the text that fits (up to the last whole character) is written; the returned length is always the length of the full text.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="list">The display list whose text should be extracted.</param>
+	/// <param name="flags">An integer equivalent to <see cref="StructuredText.StructuredTextFlags"/>, specifying flags for the structured text creation.</param>
+	/// <param name="separator">A null-terminated UTF-8 string that is written between consecutive text lines.</param>
+	/// <param name="encoding">The encoding of the text (TEXT_ENCODING_UTF8 or TEXT_ENCODING_UTF16).</param>
+	/// <param name="buffer">The buffer where the text is written (not null-terminated). This can be NULL, to determine the length of the text.</param>
+	/// <param name="buffer_length">The size of the buffer, in code units (bytes for UTF-8, 16-bit values for UTF-16).</param>
+	/// <param name="out_length">The length of the full text, in code units.</param>
+	/// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int GetPageText(fz_context* ctx, fz_display_list* list, int flags, const char* separator, int encoding, void* buffer, int64_t buffer_length, int64_t* out_length);
+
+	/// <summary>
+	/// Search for the occurrences of a string in a structured text page, using fz_search_stext_page_cb. The hits, their quads and their addresses are returned in a single buffer (see stext_search_hit).
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="page">The structured text page to search.</param>
+	/// <param name="needle">The null-terminated UTF-8 string to search for.</param>
+	/// <param name="options">A combination of SEARCH_* options.</param>
+	/// <param name="max_hits">The maximum number of hits to return, or 0 to return all of them.</param>
+	/// <param name="out_data">The address of the buffer containing the hits, which must be freed using DisposeSearchHits. This is NULL if there are no hits.</param>
+	/// <param name="out_hit_count">The number of hits.</param>
+	/// <param name="out_quad_count">The total number of quads.</param>
+	/// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int SearchStructuredTextPage(fz_context* ctx, fz_stext_page* page, const char* needle, int options, int max_hits, unsigned char** out_data, int* out_hit_count, int* out_quad_count);
+
+	/// <summary>
+	/// Create a structured text page from a display list, search it for the occurrences of a string (see SearchStructuredTextPage), and free it.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="list">The display list to search.</param>
+	/// <param name="flags">An integer equivalent to <see cref="StructuredText.StructuredTextFlags"/>, specifying flags for the structured text creation.</param>
+	/// <param name="needle">The null-terminated UTF-8 string to search for.</param>
+	/// <param name="options">A combination of SEARCH_* options.</param>
+	/// <param name="max_hits">The maximum number of hits to return, or 0 to return all of them.</param>
+	/// <param name="out_data">The address of the buffer containing the hits, which must be freed using DisposeSearchHits. This is NULL if there are no hits.</param>
+	/// <param name="out_hit_count">The number of hits.</param>
+	/// <param name="out_quad_count">The total number of quads.</param>
+	/// <returns>An integer equivalent to <see cref="ExitCodes"/> detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int SearchDisplayListText(fz_context* ctx, fz_display_list* list, int flags, const char* needle, int options, int max_hits, unsigned char** out_data, int* out_hit_count, int* out_quad_count);
+
+	/// <summary>
+	/// Free a buffer produced by SearchStructuredTextPage or SearchDisplayListText.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="data">The buffer to free.</param>
+	DLL_PUBLIC void DisposeSearchHits(fz_context* ctx, unsigned char* data);
+
 	/// <summary>
 	/// Finalise a document writer, closing the file and freeing all resources.
 	/// </summary>
@@ -868,6 +1081,61 @@ extern "C"
 	/// <returns>An integer detailing whether any errors occurred.</returns>
 	DLL_PUBLIC int WriteImage(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length);
 
+	/// <summary>
+	/// Write (part of) a page to an image buffer in the specified format, running the page directly into the draw device without creating a display list.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="page">The page to render.</param>
+	/// <param name="annotations">An integer indicating whether annotations should be rendered (1) or not (any other value).</param>
+	/// <param name="x0">The left coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="y0">The top coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="x1">The right coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="y1">The bottom coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+	/// <param name="colorFormat">The pixel data format.</param>
+	/// <param name="output_format">An integer specifying the output format.</param>
+	/// <param name="quality">Quality level for the output format (where applicable).</param>
+	/// <param name="out_buffer">The address of the buffer on which the data has been written (only useful for disposing the buffer later).</param>
+	/// <param name="out_data">The address of the byte array where the data has been actually written.</param>
+	/// <param name="out_length">The length in bytes of the image data.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int WritePageImage(fz_context* ctx, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, const fz_buffer** out_buffer, const unsigned char** out_data, uint64_t* out_length);
+
+	/// <summary>
+	/// Write (part of) a display list as an image in the specified format, passing the encoded data to a callback in chunks as it is produced, rather than accumulating it in a buffer.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="list">The display list to render.</param>
+	/// <param name="x0">The left coordinate in page units of the region of the display list that should be rendererd.</param>
+	/// <param name="y0">The top coordinate in page units of the region of the display list that should be rendererd.</param>
+	/// <param name="x1">The right coordinate in page units of the region of the display list that should be rendererd.</param>
+	/// <param name="y1">The bottom coordinate in page units of the region of the display list that should be rendererd.</param>
+	/// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+	/// <param name="colorFormat">The pixel data format.</param>
+	/// <param name="output_format">An integer specifying the output format.</param>
+	/// <param name="quality">Quality level for the output format (where applicable).</param>
+	/// <param name="callback">The function that receives the encoded data. If this returns a non-zero value, writing is aborted and ERR_CANNOT_SAVE is returned.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int WriteImageToStream(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, writeCallback callback);
+
+	/// <summary>
+	/// Write (part of) a page as an image in the specified format, running the page directly into the draw device and passing the encoded data to a callback in chunks as it is produced.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="page">The page to render.</param>
+	/// <param name="annotations">An integer indicating whether annotations should be rendered (1) or not (any other value).</param>
+	/// <param name="x0">The left coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="y0">The top coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="x1">The right coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="y1">The bottom coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+	/// <param name="colorFormat">The pixel data format.</param>
+	/// <param name="output_format">An integer specifying the output format.</param>
+	/// <param name="quality">Quality level for the output format (where applicable).</param>
+	/// <param name="callback">The function that receives the encoded data. If this returns a non-zero value, writing is aborted and ERR_CANNOT_SAVE is returned.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int WritePageImageToStream(fz_context* ctx, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int output_format, int quality, writeCallback callback);
+
 	/// <summary>
 	/// Free a native buffer and its associated resources.
 	/// </summary>
@@ -893,6 +1161,121 @@ extern "C"
 	/// <returns>An integer detailing whether any errors occurred.</returns>
 	DLL_PUBLIC int SaveImage(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int quality);
 
+	/// <summary>
+	/// Save (part of) a page to an image file in the specified format, running the page directly into the draw device without creating a display list.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="page">The page to render.</param>
+	/// <param name="annotations">An integer indicating whether annotations should be rendered (1) or not (any other value).</param>
+	/// <param name="x0">The left coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="y0">The top coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="x1">The right coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="y1">The bottom coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+	/// <param name="colorFormat">The pixel data format.</param>
+	/// <param name="file_name">The path to the output file.</param>
+	/// <param name="output_format">An integer specifying the output format.</param>
+	/// <param name="quality">Quality level for the output format (where applicable).</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int SavePageImage(fz_context* ctx, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int quality);
+
+	/// <summary>
+	/// Save (part of) a display list to an image file in the specified format, rendering and encoding it one band of rows at a time. Only a single band is held in memory, regardless of the size of the image.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="list">The display list to render.</param>
+	/// <param name="x0">The left coordinate in page units of the region of the display list that should be rendererd.</param>
+	/// <param name="y0">The top coordinate in page units of the region of the display list that should be rendererd.</param>
+	/// <param name="x1">The right coordinate in page units of the region of the display list that should be rendererd.</param>
+	/// <param name="y1">The bottom coordinate in page units of the region of the display list that should be rendererd.</param>
+	/// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+	/// <param name="colorFormat">The pixel data format.</param>
+	/// <param name="file_name">The path to the output file.</param>
+	/// <param name="output_format">An integer specifying the output format. JPEG is not supported.</param>
+	/// <param name="band_height">The height in pixels of each band. If this is less than or equal to 0, the whole image is rendered as a single band.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int SaveImageBanded(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int band_height);
+
+	/// <summary>
+	/// Save (part of) a page to an image file in the specified format, running the page directly into the draw device one band of rows at a time. Only a single band is held in memory, regardless of the size of the image.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="page">The page to render.</param>
+	/// <param name="annotations">An integer indicating whether annotations should be rendered (1) or not (any other value).</param>
+	/// <param name="x0">The left coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="y0">The top coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="x1">The right coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="y1">The bottom coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+	/// <param name="colorFormat">The pixel data format.</param>
+	/// <param name="file_name">The path to the output file.</param>
+	/// <param name="output_format">An integer specifying the output format. JPEG is not supported.</param>
+	/// <param name="band_height">The height in pixels of each band. If this is less than or equal to 0, the whole image is rendered as a single band.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int SavePageImageBanded(fz_context* ctx, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, const char* file_name, int output_format, int band_height);
+
+	/// <summary>
+	/// Create a writer that saves an image to a file band by band, with the bands being supplied by the caller (e.g. after rendering them in parallel using <see cref="RenderImageBand"/>).
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="file_name">The path to the output file.</param>
+	/// <param name="output_format">An integer specifying the output format. JPEG is not supported.</param>
+	/// <param name="x0">The left coordinate in page units of the region that will be rendered.</param>
+	/// <param name="y0">The top coordinate in page units of the region that will be rendered.</param>
+	/// <param name="x1">The right coordinate in page units of the region that will be rendered.</param>
+	/// <param name="y1">The bottom coordinate in page units of the region that will be rendered.</param>
+	/// <param name="zoom">How much the region will be scaled when rendering.</param>
+	/// <param name="colorFormat">The pixel data format.</param>
+	/// <param name="out_writer">The newly created writer.</param>
+	/// <param name="out_width">The width in pixels of the image.</param>
+	/// <param name="out_height">The height in pixels of the image.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int CreateBandedImageWriter(fz_context* ctx, const char* file_name, int output_format, float x0, float y0, float x1, float y1, float zoom, int colorFormat, banded_image_writer** out_writer, int* out_width, int* out_height);
+
+	/// <summary>
+	/// Render a band of rows of (part of) a display list. The rows are counted from the top of the rendered region, whose size is determined in the same way as <see cref="CreateBandedImageWriter"/>.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="list">The display list to render.</param>
+	/// <param name="x0">The left coordinate in page units of the region being rendered.</param>
+	/// <param name="y0">The top coordinate in page units of the region being rendered.</param>
+	/// <param name="x1">The right coordinate in page units of the region being rendered.</param>
+	/// <param name="y1">The bottom coordinate in page units of the region being rendered.</param>
+	/// <param name="zoom">How much the region is scaled when rendering.</param>
+	/// <param name="colorFormat">The pixel data format.</param>
+	/// <param name="first_row">The first row of the band.</param>
+	/// <param name="row_count">The number of rows in the band.</param>
+	/// <param name="pixel_storage">The address of the buffer where the pixel data will be written. There must be enough space available to write the values for all the pixels in the band.</param>
+	/// <param name="cookie">A cookie object that can be used to track progress and/or abort rendering. Can be null.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int RenderImageBand(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, int first_row, int row_count, unsigned char* pixel_storage, fz_cookie* cookie);
+
+	/// <summary>
+	/// Encode the next band of an image. Bands must be written in order, from the top of the image to the bottom.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="writer">The writer created by <see cref="CreateBandedImageWriter"/>.</param>
+	/// <param name="row_count">The number of rows in the band.</param>
+	/// <param name="pixel_storage">The pixel data of the band, with premultiplied alpha.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int WriteImageBand(fz_context* ctx, banded_image_writer* writer, int row_count, unsigned char* pixel_storage);
+
+	/// <summary>
+	/// Finish writing a banded image and close the output file. All the bands must have been written.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="writer">The writer created by <see cref="CreateBandedImageWriter"/>.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int CloseBandedImageWriter(fz_context* ctx, banded_image_writer* writer);
+
+	/// <summary>
+	/// Free a banded image writer and its associated resources.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="writer">The writer created by <see cref="CreateBandedImageWriter"/>.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int DisposeBandedImageWriter(fz_context* ctx, banded_image_writer* writer);
+
 	/// <summary>
 	/// Create cloned contexts that can be used in multithreaded rendering.
 	/// </summary>
@@ -914,9 +1297,38 @@ extern "C"
 	/// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
 	/// <param name="colorFormat">The pixel data format.</param>
 	/// <param name="pixel_storage">A pointer indicating where the pixel bytes will be written. There must be enough space available!</param>
+	/// <param name="flags">A combination of RENDER_UNPREMULTIPLY (convert the colour values of images with an alpha channel to straight alpha; otherwise, they are premultiplied) and RENDER_CLIP (clear the pixels outside of the clip rectangle).</param>
+	/// <param name="clip_x0">The left coordinate in page units of the clip rectangle (only used with RENDER_CLIP).</param>
+	/// <param name="clip_y0">The top coordinate in page units of the clip rectangle (only used with RENDER_CLIP).</param>
+	/// <param name="clip_x1">The right coordinate in page units of the clip rectangle (only used with RENDER_CLIP).</param>
+	/// <param name="clip_y1">The bottom coordinate in page units of the clip rectangle (only used with RENDER_CLIP).</param>
 	/// <param name="cookie">A pointer to a cookie object that can be used to track progress and/or abort rendering. Can be null.</param>
 	/// <returns>An integer detailing whether any errors occurred.</returns>
-	DLL_PUBLIC int RenderSubDisplayList(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, unsigned char* pixel_storage, fz_cookie* cookie);
+	DLL_PUBLIC int RenderSubDisplayList(fz_context* ctx, fz_display_list* list, float x0, float y0, float x1, float y1, float zoom, int colorFormat, unsigned char* pixel_storage, int flags, float clip_x0, float clip_y0, float clip_x1, float clip_y1, fz_cookie* cookie);
+
+	/// <summary>
+	/// Render (part of) a page to an array of bytes starting at the specified pointer, running the page directly into the draw device without creating a display list.
+	/// This is faster than creating a display list and rendering it, if the page is only rendered once.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="page">The page to render.</param>
+	/// <param name="annotations">An integer indicating whether annotations should be rendered (1) or not (any other value).</param>
+	/// <param name="x0">The left coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="y0">The top coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="x1">The right coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="y1">The bottom coordinate in page units of the region of the page that should be rendererd.</param>
+	/// <param name="zoom">How much the specified region should be scaled when rendering. This determines the size in pixels of the rendered image.</param>
+	/// <param name="colorFormat">The pixel data format.</param>
+	/// <param name="pixel_storage">A pointer indicating where the pixel bytes will be written. There must be enough space available!</param>
+	/// <param name="flags">A combination of RENDER_UNPREMULTIPLY (convert the colour values of images with an alpha channel to straight alpha; otherwise, they are premultiplied) and RENDER_CLIP (clear the pixels outside of the clip rectangle).</param>
+	/// <param name="clip_x0">The left coordinate in page units of the clip rectangle (only used with RENDER_CLIP).</param>
+	/// <param name="clip_y0">The top coordinate in page units of the clip rectangle (only used with RENDER_CLIP).</param>
+	/// <param name="clip_x1">The right coordinate in page units of the clip rectangle (only used with RENDER_CLIP).</param>
+	/// <param name="clip_y1">The bottom coordinate in page units of the clip rectangle (only used with RENDER_CLIP).</param>
+	/// <param name="band_height">If this is greater than 0, the page is rendered in horizontal bands of this height (in pixels), running the page once for each band. This reduces the size of the temporary buffers used by the draw device.</param>
+	/// <param name="cookie">A pointer to a cookie object that can be used to track progress and/or abort rendering. Can be null.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int RenderPage(fz_context* ctx, fz_page* page, int annotations, float x0, float y0, float x1, float y1, float zoom, int colorFormat, unsigned char* pixel_storage, int flags, float clip_x0, float clip_y0, float clip_x1, float clip_y1, int band_height, fz_cookie* cookie);
 
 	/// <summary>
 	/// Create a display list from a page.
@@ -932,6 +1344,36 @@ extern "C"
 	/// <returns>An integer detailing whether any errors occurred.</returns>
 	DLL_PUBLIC int GetDisplayList(fz_context* ctx, fz_page* page, int annotations, fz_display_list** out_display_list, float* out_x0, float* out_y0, float* out_x1, float* out_y1);
 
+	/// <summary>
+	/// Create a display list from a page, without computing its bounds.
+	/// </summary>
+	/// <param name="ctx">A pointer to the context used to create the document.</param>
+	/// <param name="page">A pointer to the page that should be used to create the display list.</param>
+	/// <param name="annotations">An integer indicating whether annotations should be included in the display list (1) or not (any other value).</param>
+	/// <param name="out_display_list">A pointer to the newly-created display list.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int CreateDisplayList(fz_context* ctx, fz_page* page, int annotations, fz_display_list** out_display_list);
+
+	/// <summary>
+	/// Compute the bounds of the contents of a display list. This requires running the whole display list through a bounding box device.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="list">The display list whose bounds should be computed.</param>
+	/// <param name="out_x0">The left coordinate of the display list's bounds.</param>
+	/// <param name="out_y0">The top coordinate of the display list's bounds.</param>
+	/// <param name="out_x1">The right coordinate of the display list's bounds.</param>
+	/// <param name="out_y1">The bottom coordinate of the display list's bounds.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int GetDisplayListBounds(fz_context* ctx, fz_display_list* list, float* out_x0, float* out_y0, float* out_x1, float* out_y1);
+
+	/// <summary>
+	/// Estimate the amount of memory used by a display list. Resources that are shared with other objects (e.g., images and fonts) are not included.
+	/// </summary>
+	/// <param name="ctx">A context to hold the exception stack and the cached resources.</param>
+	/// <param name="list">The display list whose size should be estimated.</param>
+	/// <returns>The estimated size of the display list in bytes, or 0 if the size cannot be estimated with this version of MuPDF.</returns>
+	DLL_PUBLIC uint64_t GetDisplayListSize(fz_context* ctx, fz_display_list* list);
+
 	/// <summary>
 	/// Free a display list.
 	/// </summary>
@@ -987,6 +1429,45 @@ extern "C"
 	/// <returns>An integer detailing whether any errors occurred.</returns>
 	DLL_PUBLIC int LayoutDocument(fz_context* ctx, fz_document* doc, float width, float height, float em, int* out_page_count);
 
+	/// <summary>
+	/// Count the pages in a document, using its current layout.
+	/// </summary>
+	/// <param name="ctx">The context to which the document belongs.</param>
+	/// <param name="doc">The document whose pages should be counted.</param>
+	/// <param name="out_page_count">The number of pages in the document.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int CountPages(fz_context* ctx, fz_document* doc, int* out_page_count);
+
+	/// <summary>
+	/// Set the layout of a reflowable document, without counting its pages. For document types that lay out their chapters on demand (e.g., EPUB), this does not lay out the whole document.
+	/// </summary>
+	/// <param name="ctx">The context to which the document belongs.</param>
+	/// <param name="doc">The document to layout.</param>
+	/// <param name="width">The page width.</param>
+	/// <param name="height">The page height.</param>
+	/// <param name="em">The default font size, in points.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int SetDocumentLayout(fz_context* ctx, fz_document* doc, float width, float height, float em);
+
+	/// <summary>
+	/// Count the chapters in a document.
+	/// </summary>
+	/// <param name="ctx">The context to which the document belongs.</param>
+	/// <param name="doc">The document whose chapters should be counted.</param>
+	/// <param name="out_chapter_count">The number of chapters in the document.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int CountChapters(fz_context* ctx, fz_document* doc, int* out_chapter_count);
+
+	/// <summary>
+	/// Count the pages in a chapter of a document, using its current layout. For document types that lay out their chapters on demand (e.g., EPUB), this only lays out the specified chapter.
+	/// </summary>
+	/// <param name="ctx">The context to which the document belongs.</param>
+	/// <param name="doc">The document containing the chapter.</param>
+	/// <param name="chapter">The index of the chapter (starting at 0).</param>
+	/// <param name="out_page_count">The number of pages in the chapter.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int CountChapterPages(fz_context* ctx, fz_document* doc, int chapter, int* out_page_count);
+
 	/// <summary>
 	/// Create a new document from a file name.
 	/// </summary>
@@ -1000,6 +1481,25 @@ extern "C"
 	/// <returns>An integer detailing whether any errors occurred.</returns>
 	DLL_PUBLIC int CreateDocumentFromFile(fz_context* ctx, const char* file_name, int get_image_resolution, const fz_document** out_doc, int* out_page_count, float* out_image_xres, float* out_image_yres);
 
+	/// <summary>
+	/// Create a new document from a file name, using an accelerator file to speed up opening it. If the accelerator file exists, the document is opened using it (falling back to opening the document normally if this fails);
+	/// otherwise, the document is opened normally and, if the document type supports it, the accelerator file is created.
+	/// </summary>
+	/// <param name="ctx">The context to which the document will belong.</param>
+	/// <param name="file_name">The path of the file to open.</param>
+	/// <param name="accelerator_file">The path of the accelerator file. If this is NULL, no accelerator is used.</param>
+	/// <param name="get_image_resolution">If this is not 0, try opening the file as an image and return the actual resolution (in DPI) of the image. Otherwise (or if trying to open the file as an image fails), the returned resolution will be -1.</param>
+	/// <param name="layout_width">The page width used to lay out reflowable documents after they have been opened. If this is &lt; 0, the document is not laid out.</param>
+	/// <param name="layout_height">The page height used to lay out reflowable documents after they have been opened.</param>
+	/// <param name="layout_em">The default font size (in points) used to lay out reflowable documents after they have been opened.</param>
+	/// <param name="count_pages">If this is 0, the pages are not counted, and out_page_count is set to -1.</param>
+	/// <param name="out_page_count">The number of pages in the document.</param>
+	/// <param name="out_image_xres">If the document is an image file, the horizontal resolution of the image.</param>
+	/// <param name="out_image_yres">If the document is an image file, the vertical resolution of the image.</param>
+	/// <param name="out_accelerator_state">ACCELERATOR_LOADED if the accelerator file was used, ACCELERATOR_CREATED if it was created, or ACCELERATOR_NOT_USED otherwise.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int CreateDocumentFromFileWithAccelerator(fz_context* ctx, const char* file_name, const char* accelerator_file, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, const fz_document** out_doc, int* out_page_count, float* out_image_xres, float* out_image_yres, int* out_accelerator_state);
+
 	/// <summary>
 	/// Create a new document from a stream.
 	/// </summary>
@@ -1008,13 +1508,66 @@ extern "C"
 	/// <param name="data_length">The length in bytes of the data that makes up the document.</param>
 	/// <param name="file_type">The type (extension) of the document.</param>
 	/// <param name="get_image_resolution">If this is not 0, try opening the stream as an image and return the actual resolution (in DPI) of the image. Otherwise (or if trying to open the stream as an image fails), the returned resolution will be -1.</param>
+	/// <param name="layout_width">The page width used to lay out reflowable documents after they have been opened. If this is &lt; 0, the document is not laid out.</param>
+	/// <param name="layout_height">The page height used to lay out reflowable documents after they have been opened.</param>
+	/// <param name="layout_em">The default font size (in points) used to lay out reflowable documents after they have been opened.</param>
+	/// <param name="count_pages">If this is 0, the pages are not counted, and out_page_count is set to -1.</param>
 	/// <param name="out_doc">The newly created document.</param>
 	/// <param name="out_str">The newly created stream (so that it can be disposed later).</param>
 	/// <param name="out_page_count">The number of pages in the document.</param>
 	/// <param name="out_image_xres">If the document is an image file, the horizontal resolution of the image.</param>
 	/// <param name="out_image_yres">If the document is an image file, the vertical resolution of the image.</param>
 	/// <returns>An integer detailing whether any errors occurred.</returns>
-	DLL_PUBLIC int CreateDocumentFromStream(fz_context* ctx, const unsigned char* data, const uint64_t data_length, const char* file_type, int get_image_resolution, const fz_document** out_doc, const fz_stream** out_str, int* out_page_count, float* out_image_xres, float* out_image_yres);
+	DLL_PUBLIC int CreateDocumentFromStream(fz_context* ctx, const unsigned char* data, const uint64_t data_length, const char* file_type, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, const fz_document** out_doc, const fz_stream** out_str, int* out_page_count, float* out_image_xres, float* out_image_yres);
+
+	/// <summary>
+	/// Create a new document from a file, by mapping the file in memory (read-only) and opening the mapped data. The mapping must be kept alive while the document is in use, and freed with DisposeMappedFile after the document and the stream have been disposed.
+	/// </summary>
+	/// <param name="ctx">The context to which the document will belong.</param>
+	/// <param name="file_name">The path of the file to open. This is also used to determine the type of the document.</param>
+	/// <param name="get_image_resolution">If this is not 0, try opening the file as an image and return the actual resolution (in DPI) of the image. Otherwise (or if trying to open the file as an image fails), the returned resolution will be -1.</param>
+	/// <param name="layout_width">The page width used to lay out reflowable documents after they have been opened. If this is &lt; 0, the document is not laid out.</param>
+	/// <param name="layout_height">The page height used to lay out reflowable documents after they have been opened.</param>
+	/// <param name="layout_em">The default font size (in points) used to lay out reflowable documents after they have been opened.</param>
+	/// <param name="count_pages">If this is 0, the pages are not counted, and out_page_count is set to -1.</param>
+	/// <param name="out_doc">The newly created document.</param>
+	/// <param name="out_str">The newly created stream (so that it can be disposed later).</param>
+	/// <param name="out_page_count">The number of pages in the document.</param>
+	/// <param name="out_image_xres">If the document is an image file, the horizontal resolution of the image.</param>
+	/// <param name="out_image_yres">If the document is an image file, the vertical resolution of the image.</param>
+	/// <param name="out_mapping">The file mapping.</param>
+	/// <param name="out_data">The address of the mapped data.</param>
+	/// <param name="out_length">The length of the mapped data.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int CreateDocumentFromMappedFile(fz_context* ctx, const char* file_name, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, const fz_document** out_doc, const fz_stream** out_str, int* out_page_count, float* out_image_xres, float* out_image_yres, mapped_file** out_mapping, const unsigned char** out_data, uint64_t* out_length);
+
+	/// <summary>
+	/// Free a file mapping created by CreateDocumentFromMappedFile.
+	/// </summary>
+	/// <param name="mapping">The mapping to free.</param>
+	DLL_PUBLIC void DisposeMappedFile(mapped_file* mapping);
+
+	/// <summary>
+	/// Create a new document from data that is read on demand through a callback. The data is read in blocks of block_size bytes, and at most block_count blocks are cached at any time.
+	/// </summary>
+	/// <param name="ctx">The context to which the document will belong.</param>
+	/// <param name="read">The callback used to read the data. This must remain valid until the stream is disposed.</param>
+	/// <param name="length">The total length in bytes of the data.</param>
+	/// <param name="block_size">The size in bytes of each block.</param>
+	/// <param name="block_count">The maximum number of blocks that are cached. The memory for each block is only allocated when the block is first used.</param>
+	/// <param name="file_type">The type (extension) of the document.</param>
+	/// <param name="get_image_resolution">If this is not 0, the whole stream is read in memory (once), the actual resolution (in DPI) of the image is read from its header, and the document is opened from the data in memory. Otherwise (or if the data is not an image), the returned resolution will be -1.</param>
+	/// <param name="layout_width">The page width used to lay out reflowable documents after they have been opened. If this is &lt; 0, the document is not laid out.</param>
+	/// <param name="layout_height">The page height used to lay out reflowable documents after they have been opened.</param>
+	/// <param name="layout_em">The default font size (in points) used to lay out reflowable documents after they have been opened.</param>
+	/// <param name="count_pages">If this is 0, the pages are not counted, and out_page_count is set to -1.</param>
+	/// <param name="out_doc">The newly created document.</param>
+	/// <param name="out_str">The newly created stream (so that it can be disposed later).</param>
+	/// <param name="out_page_count">The number of pages in the document.</param>
+	/// <param name="out_image_xres">If the document is an image file, the horizontal resolution of the image.</param>
+	/// <param name="out_image_yres">If the document is an image file, the vertical resolution of the image.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int CreateDocumentFromCallbackStream(fz_context* ctx, readCallback read, int64_t length, int block_size, int block_count, const char* file_type, int get_image_resolution, float layout_width, float layout_height, float layout_em, int count_pages, const fz_document** out_doc, const fz_stream** out_str, int* out_page_count, float* out_image_xres, float* out_image_yres);
 
 	/// <summary>
 	/// Free a stream and its associated resources.
@@ -1088,9 +1641,23 @@ extern "C"
 	DLL_PUBLIC int CreateContext(uint64_t store_size, const fz_context** out_ctx);
 
 	/// <summary>
-	/// Free a context and its global store.
+	/// Create a MuPDF context object with the specified store size, using the specified allocator for all of its (and its clones') allocations.
+	/// </summary>
+	/// <param name="store_size">Maximum size in bytes of the resource store.</param>
+	/// <param name="allocator">The allocator to use (ALLOC_SYSTEM or ALLOC_POOL).</param>
+	/// <param name="out_ctx">A pointer to the native context object.</param>
+	/// <returns>An integer detailing whether any errors occurred.</returns>
+	DLL_PUBLIC int CreateContextWithAllocator(uint64_t store_size, int allocator, const fz_context** out_ctx);
+
+	/// <summary>
+	/// Return to the system all the memory blocks that are cached by the pooled allocator for the calling thread. Blocks that are still in use are not affected.
+	/// </summary>
+	DLL_PUBLIC void ReleasePooledMemory();
+
+	/// <summary>
+	/// Free a context and its global store. The lock table of the context is freed when the last context sharing it (i.e. the original context and all of its clones) is disposed.
 	/// </summary>
 	/// <param name="ctx">A pointer to the native context to free.</param>
 	/// <returns>An integer detailing whether any errors occurred.</returns>
 	DLL_PUBLIC int DisposeContext(fz_context* ctx);
-}
\ No newline at end of file
+}
\ No newline at end of file